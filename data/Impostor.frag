@@ -0,0 +1,44 @@
+#version 330
+
+// 5 inputs (texCoord, and the frame of the quad in camera space)
+smooth in vec2 texCoord;
+smooth in vec3 cameraPos;
+flat in vec3 rightAxis;
+flat in vec3 upAxis;
+flat in float radius;
+
+// 1 output (outputColor)
+out vec4 outputColor;
+
+// 6 input uniform (atlas textures, matrix of projection, and light parameters)
+uniform sampler2D colorAtlas;       // Diffuse color of the views (alpha 0 outside of the Mesh)
+uniform sampler2D normalDepthAtlas; // Normal in view space (xyz) and depth (w) of the views
+uniform mat4 cameraToClipMatrix;    // "Camera to Clip" matrix,  defining the perspective projection
+uniform vec3 dirToLight;            // Vector of directional light orientation (oriented toward the light)
+uniform vec4 lightIntensity;        // Directional light intensity and color
+uniform vec4 ambientIntensity;      // Ambiant light intensity and color
+
+void main()
+{
+    vec4 diffuseColor = texture(colorAtlas, texCoord);
+    if (diffuseColor.a < 0.5)
+    {
+        discard;
+    }
+    vec4 normalDepth = texture(normalDepthAtlas, texCoord);
+
+    // Normal and position of the surface, from the view space of the atlas to camera space
+    vec3 frontAxis    = cross(rightAxis, upAxis);
+    vec3 normal       = normalDepth.xyz * 2.0 - 1.0;
+    vec3 normCamSpace = normalize(rightAxis * normal.x + upAxis * normal.y + frontAxis * normal.z);
+    vec4 clipPos      = cameraToClipMatrix * vec4(cameraPos + frontAxis * (radius * (1.0 - 2.0 * normalDepth.w)), 1.0);
+    gl_FragDepth      = (clipPos.z / clipPos.w) * 0.5 + 0.5;
+
+    // Light incidence
+    float cosAngIncidence = dot(normCamSpace, dirToLight);
+    cosAngIncidence = clamp(cosAngIncidence, 0, 1);
+
+    // Resulting color
+    outputColor = (diffuseColor * lightIntensity * cosAngIncidence)
+                + (diffuseColor * ambientIntensity);
+}
@@ -0,0 +1,28 @@
+#version 330
+
+// 2 input streams "attributes" (corner of the quad, and instance data)
+layout(location = 0) in vec2 corner;    // Corner of the unit quad, in [-1,1]
+layout(location = 1) in mat4 impostor;  // Center and radius, right axis, up axis, and view in the atlas (locations 1 to 4)
+
+// 5 output streams (default gl_Position, texCoord, and the frame of the quad in camera space)
+smooth out vec2 texCoord;
+smooth out vec3 cameraPos;
+flat out vec3 rightAxis;
+flat out vec3 upAxis;
+flat out float radius;
+
+// 1 input uniform (matrix of projection)
+uniform mat4 cameraToClipMatrix;    // "Camera to Clip" matrix,  defining the perspective projection
+
+void main()
+{
+    // Quad facing the camera, covering the bounding sphere
+    radius    = impostor[0].w;
+    rightAxis = impostor[1].xyz;
+    upAxis    = impostor[2].xyz;
+    cameraPos = impostor[0].xyz + (rightAxis * corner.x + upAxis * corner.y) * radius;
+    gl_Position = cameraToClipMatrix * vec4(cameraPos, 1.0);
+
+    // View of the atlas
+    texCoord = impostor[3].xy + (corner * 0.5 + 0.5) * impostor[3].z;
+}
@@ -0,0 +1,16 @@
+#version 330
+
+// 2 inputs (smoothColor and smoothNormal)
+smooth in vec4 smoothColor;
+smooth in vec3 smoothNormal;
+
+// 2 outputs (into the color and the normal/depth textures of the atlas)
+layout(location = 0) out vec4 outputColor;
+layout(location = 1) out vec4 outputNormalDepth;
+
+void main()
+{
+    // Alpha 1 marks the texels covered by the Mesh
+    outputColor       = vec4(smoothColor.rgb, 1.0);
+    outputNormalDepth = vec4(normalize(smoothNormal) * 0.5 + 0.5, gl_FragCoord.z);
+}
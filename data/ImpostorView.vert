@@ -0,0 +1,24 @@
+#version 330
+
+// 4 input streams "attributes" (model vertex position, color and normals, and view matrix)
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec4 diffuseColor;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in mat4 modelToCameraMatrix; // "Model to Camera" matrix of the view (uses locations 3 to 6)
+
+// 3 output streams (default gl_Position, smoothColor and smoothNormal)
+smooth out vec4 smoothColor;
+smooth out vec3 smoothNormal;
+
+// 1 input uniform (matrix of orthographic projection of the bounding sphere)
+uniform mat4 cameraToClipMatrix;    // "Camera to Clip" matrix, defining the orthographic projection
+
+void main()
+{
+    // Vertex positions
+    gl_Position = cameraToClipMatrix * (modelToCameraMatrix * position);
+
+    // Unlit color and normal in view space: impostors are lit when drawn
+    smoothColor  = diffuseColor;
+    smoothNormal = mat3(modelToCameraMatrix) * normal;
+}
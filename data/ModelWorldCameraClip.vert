@@ -1,15 +1,25 @@
 #version 330
 
-// 3 input streams "attributes" (model vertex position, color and normals)
+// Permutations (see ShaderPermutations):
+// - NO_VERTEX_COLOR: ignore the vertex colors, use a constant grey instead
+// - DEPTH_ONLY: only compute the position (no lighting), for depth only passes
+// - OVERDRAW: (fragment shader only) constant color accumulated by additive blending
+
+// 4 input streams "attributes" (model vertex position, color and normals, and instance matrix)
 layout(location = 0) in vec4 position;
+#ifndef NO_VERTEX_COLOR
 layout(location = 1) in vec4 diffuseColor;
+#endif
 layout(location = 2) in vec3 normal;
+layout(location = 3) in mat4 modelToCameraMatrix; // "Model to Camera" matrix of the instance (uses locations 3 to 6)
 
 // 2 output streams (default gl_Position, and smoothColor)
 smooth out vec4 smoothColor;
+// The position is computed identically by all permutations, so that the GL_EQUAL depth test of the color pass
+// matches exactly the depth written by the "DEPTH_ONLY" pre-pass
+invariant gl_Position;
 
-// 5 input uniform (matrix of transformation, and light parameters)
-uniform mat4 modelToCameraMatrix;   // "Model to Camera" matrix, positioning the model into camera space (the "view" matrix)
+// 4 input uniform (matrix of projection, and light parameters)
 uniform mat4 cameraToClipMatrix;    // "Camera to Clip" matrix,  defining the perspective projection
 uniform vec3 dirToLight;            // Vector of directional light orientation (oriented toward the light)
 uniform vec4 lightIntensity;        // Directional light intensity and color
@@ -21,6 +31,13 @@ void main()
     vec4 cameraPos   = modelToCameraMatrix * position;   // Convert model position into camera space coordinates
          gl_Position = cameraToClipMatrix  * cameraPos;  // Convert camera position into clip space coordinates
 
+#ifdef DEPTH_ONLY
+    smoothColor = vec4(0.0);
+#else
+#ifdef NO_VERTEX_COLOR
+    const vec4 diffuseColor = vec4(0.8, 0.8, 0.8, 1.0);
+#endif
+
     // Vertex normals
     vec3 normCamSpace = normalize(mat3(modelToCameraMatrix) * normal);
 
@@ -32,4 +49,5 @@ void main()
     // TODO HDR (divide by a max value)
     smoothColor = (diffuseColor * lightIntensity * cosAngIncidence)
                 + (diffuseColor * ambientIntensity);
+#endif
 }
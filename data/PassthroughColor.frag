@@ -8,5 +8,10 @@ out vec4 outputColor;
 
 void main()
 {
+#ifdef OVERDRAW
+    // Each fragment shaded adds a constant color (additive blending): the brighter, the more overdraw
+    outputColor = vec4(0.1, 0.05, 0.02, 1.0);
+#else
     outputColor = smoothColor;
+#endif
 }
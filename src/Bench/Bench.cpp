@@ -0,0 +1,521 @@
+/**
+ * @file    Bench.cpp
+ * @ingroup Bench
+ * @brief   Micro-benchmarks of the core engine, run in isolation without any OpenGL context.
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Bench/Benchmark.h"
+
+#include "Main/DrawList.h"
+#include "Main/LodSelector.h"
+#include "Main/MatrixStack.h"
+#include "Main/Mesh.h"
+#include "Main/MeshSimplifier.h"
+#include "Main/NativeLoader.h"
+#include "Main/Node.h"
+#include "Main/RenderStats.h"
+#include "Main/ResourceManager.h"
+#include "Main/Scene.h"
+#include "Main/SceneGenerator.h"
+#include "Main/VertexAttributes.h"
+#include "Utils/Time.h"
+
+#include "LoggerCpp/LoggerCpp.h"
+
+#include <assimp/Importer.hpp>  // Open Asset Importer
+#include <assimp/postprocess.h> // Post processing flags
+
+#include <fstream>      // NOLINT(readability/streams) for the result file
+#include <iostream>     // NOLINT(readability/streams) for the standard output
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>   // std::bind, std::cref
+#include <cstdlib>
+#include <cstring>
+
+/// Number of samples measured for each benchmark
+static const unsigned int   _nbSamples      = 25;
+/// Minimum duration of a sample, in microseconds
+static const time_t         _minSampleUs    = 10000;
+
+/// Models of the "data/" directory used to benchmark the mesh conversion
+static const char* _modelFiles[] = {
+    "data/cube.dae",
+    "data/hierarchy.dae",
+    "data/cockpit.dae",
+    "data/suzanne.dae",
+    "data/teapot.dae",
+    "data/dragon_vrip_res4.ply",
+    "data/bunny_zipper.ply",
+    "data/Dassault_Rafale_M.obj"
+};
+
+/**
+ * @brief Tell if a benchmark is selected by the filter given on the command line
+ *
+ * @param[in] apName    Name of the benchmark
+ * @param[in] apFilter  Sub-string to search in the name (or nullptr for all benchmarks)
+ */
+static bool isSelected(const char* apName, const char* apFilter) {
+    return (nullptr == apFilter) || (nullptr != strstr(apName, apFilter));
+}
+
+/**
+ * @brief Recursively push the matrix stack and multiply it, to mimic a hierarchy traversal
+ *
+ * @param[in,out] aMatrixStack  Matrix stack to operate
+ * @param[in]     aMatrix       Matrix to multiply at each level
+ * @param[in]     aDepth        Number of levels to push
+ */
+static void pushMultiply(MatrixStack& aMatrixStack, const glm::mat4& aMatrix, unsigned int aDepth) {
+    MatrixStack::Push push(aMatrixStack); // RAII Push/Pop MatrixStack
+    aMatrixStack.multiply(aMatrix);
+    Bench::keep(aMatrixStack.top());
+    if (1 < aDepth) {
+        pushMultiply(aMatrixStack, aMatrix, aDepth - 1);
+    }
+}
+
+/**
+ * @brief Benchmark the Utils::Time tick functions
+ */
+static void benchTime(Bench::Benchmark& aBenchmark, const char* apFilter) {
+    if (isSelected("Time::getTickUs", apFilter)) {
+        aBenchmark.run("Time::getTickUs", [] () {
+            Bench::keep(Utils::Time::getTickUs());
+        });
+    }
+    if (isSelected("Time::getTickMs", apFilter)) {
+        aBenchmark.run("Time::getTickMs", [] () {
+            Bench::keep(Utils::Time::getTickMs());
+        });
+    }
+}
+
+/**
+ * @brief Benchmark the cached and re-calculated Node matrix
+ */
+static void benchNode(Bench::Benchmark& aBenchmark, const char* apFilter) {
+    Node node("node");
+    node.setTranslationVector(1.0f, 2.0f, 3.0f);
+    node.yaw(0.5f);
+
+    if (isSelected("Node::getMatrix/cached", apFilter)) {
+        aBenchmark.run("Node::getMatrix/cached", [&node] () {
+            Bench::keep(node.getMatrix());
+        });
+    }
+    if (isSelected("Node::getMatrix/dirty", apFilter)) {
+        // Setting the translation only flags the matrix as dirty, so that it is re-calculated each time
+        aBenchmark.run("Node::getMatrix/dirty", [&node] () {
+            node.setTranslationVector(1.0f, 2.0f, 3.0f);
+            Bench::keep(node.getMatrix());
+        });
+    }
+}
+
+/**
+ * @brief Benchmark the MatrixStack push/multiply/pop
+ */
+static void benchMatrixStack(Bench::Benchmark& aBenchmark, const char* apFilter) {
+    MatrixStack     matrixStack(glm::mat4(1.0f));
+    const glm::mat4 matrix = glm::mat4_cast(glm::angleAxis(0.1f, Node::UNIT_Y_UP));
+
+    if (isSelected("MatrixStack::push-multiply-pop", apFilter)) {
+        aBenchmark.run("MatrixStack::push-multiply-pop", [&matrixStack, &matrix] () {
+            MatrixStack::Push push(matrixStack);
+            matrixStack.multiply(matrix);
+            Bench::keep(matrixStack.top());
+        });
+    }
+    if (isSelected("MatrixStack::depth16", apFilter)) {
+        aBenchmark.run("MatrixStack::depth16", [&matrixStack, &matrix] () {
+            pushMultiply(matrixStack, matrix, 16);
+        }, 16);
+    }
+}
+
+/**
+ * @brief Benchmark Scene::move, and Scene::update of its retained draw list, on generated scenes of various shapes
+ */
+static void benchSceneMove(Bench::Benchmark& aBenchmark, const char* apFilter) {
+    /// Shapes of the generated scenes: instances, depth, fan-out, and percentage of moving Nodes
+    static const unsigned int _shapes[][4] = {
+        {1,         1,  1000,   100},   // flat
+        {1,         3,  10,     100},   // wide
+        {1,         10, 2,      100},   // deep
+        {10,        0,  0,      10},    // scaling from 10...
+        {1000,      0,  0,      10},
+        {100000,    0,  0,      10},    // ... to 100k Nodes
+        {1000,      2,  10,     10}     // 100k Nodes in small hierarchies
+    };
+    for (size_t idxShape = 0; idxShape < sizeof(_shapes)/sizeof(_shapes[0]); ++idxShape) {
+        SceneGenerator::Config config;
+        config.mNbInstances = _shapes[idxShape][0];
+        config.mDepth       = _shapes[idxShape][1];
+        config.mFanOut      = _shapes[idxShape][2];
+        config.mMovingRatio = _shapes[idxShape][3] / 100.0f;
+        std::ostringstream name;
+        name << "Scene::move/instances" << config.mNbInstances << "-depth" << config.mDepth
+             << "-fanout" << config.mFanOut << "-moving" << _shapes[idxShape][3];
+        if (isSelected(name.str().c_str(), apFilter)) {
+            Scene           scene;
+            SceneGenerator  generator(config);
+            const unsigned int nbNodes = generator.generate(scene);
+            aBenchmark.run(name.str().c_str(), [&scene] () {
+                scene.move(0.016f);
+            }, nbNodes);
+        }
+        // the same scene, moved and then its world matrices updated by its retained draw list
+        std::ostringstream updateName;
+        updateName << "Scene::update/instances" << config.mNbInstances << "-depth" << config.mDepth
+                   << "-fanout" << config.mFanOut << "-moving" << _shapes[idxShape][3];
+        if (isSelected(updateName.str().c_str(), apFilter)) {
+            Scene           scene;
+            SceneGenerator  generator(config);
+            const unsigned int nbNodes = generator.generate(scene);
+            aBenchmark.run(updateName.str().c_str(), [&scene] () {
+                scene.move(0.016f);
+                scene.update();
+            }, nbNodes);
+        }
+    }
+}
+
+/**
+ * @brief Create a Node of a generated scene, with the given Mesh (see SceneGenerator::Factory)
+ */
+static Node::Ptr createMeshNode(const Mesh::Ptr& aMeshPtr) {
+    Node::Ptr NodePtr(new Node("generated"));
+    NodePtr->addMesh(aMeshPtr);
+    return NodePtr;
+}
+
+/**
+ * @brief Benchmark the per-frame collect of the draws of both eyes, reporting the RenderStats counters it produces
+ *
+ *  Every Node of the generated scenes shares a Mesh of 1000 triangles with two levels of detail, never uploaded
+ * (collecting the draws makes no OpenGL call): the counters, averaged per frame, are logged and written into
+ * the JSON results along with the timings.
+ */
+static void benchSceneCollect(Bench::Benchmark& aBenchmark, const char* apFilter, Log::Logger& aLog) {
+    /// Shapes of the generated scenes: instances, depth, fan-out, and percentage of moving Nodes
+    static const unsigned int _shapes[][4] = {
+        {1000,      0,  0,      10},
+        {10000,     0,  0,      10},
+        {1000,      2,  10,     10}     // 100k Nodes in small hierarchies
+    };
+    Mesh::Ptr MeshPtr(new Mesh("generated", GL_TRIANGLES, 3000, GL_UNSIGNED_SHORT, 0));
+    MeshPtr->addLod(1500, 3000 * sizeof(GLshort), 0.01f);
+    MeshPtr->addLod(750, 4500 * sizeof(GLshort), 0.05f);
+    const SceneGenerator::Factory factory = std::bind(createMeshNode, std::cref(MeshPtr));
+    // Eyes 64mm apart, and a 1080 pixels high viewport under a 45 degrees vertical field of view
+    glm::mat4 worldToCameraMatrices[2] = {glm::mat4(1.0f), glm::mat4(1.0f)};
+    worldToCameraMatrices[0][3].x = 0.032f;
+    worldToCameraMatrices[1][3].x = -0.032f;
+    LodSelector lodSelector(1.0f, 0.0f, 0.25f);
+    lodSelector.setPixelsPerUnit(1303.0f);
+
+    for (size_t idxShape = 0; idxShape < sizeof(_shapes)/sizeof(_shapes[0]); ++idxShape) {
+        SceneGenerator::Config config;
+        config.mNbInstances = _shapes[idxShape][0];
+        config.mDepth       = _shapes[idxShape][1];
+        config.mFanOut      = _shapes[idxShape][2];
+        config.mMovingRatio = _shapes[idxShape][3] / 100.0f;
+        std::ostringstream name;
+        name << "Scene::collect/instances" << config.mNbInstances << "-depth" << config.mDepth
+             << "-fanout" << config.mFanOut << "-moving" << _shapes[idxShape][3];
+        if (isSelected(name.str().c_str(), apFilter)) {
+            Scene           scene;
+            SceneGenerator  generator(config);
+            const unsigned int nbNodes = generator.generate(scene, factory);
+            scene.update();
+            RenderStats renderStats;
+            DrawList    drawList;
+            aBenchmark.run(name.str().c_str(),
+                           [&scene, &renderStats, &drawList, &lodSelector, &worldToCameraMatrices] () {
+                renderStats.beginFrame();
+                for (int idxEye = 0; idxEye < RenderStats::NB_EYES; ++idxEye) {
+                    renderStats.setEye(idxEye);
+                    lodSelector.setEye(idxEye);
+                    drawList.clear();
+                    scene.collect(worldToCameraMatrices[idxEye], lodSelector, drawList, renderStats);
+                    Bench::keep(drawList.size());
+                }
+                renderStats.setEye(-1);
+                renderStats.endFrame();
+            }, nbNodes);
+            aLog.notice() << name.str() << " RenderStats (" << renderStats.getNbFrames() << " frames) "
+                          << renderStats.toString();
+            for (int idxCounter = 0; idxCounter < RenderStats::eNbCounters; ++idxCounter) {
+                const RenderStats::Counter counter = static_cast<RenderStats::Counter>(idxCounter);
+                if (0 < renderStats.getMax(counter)) {
+                    aBenchmark.addCounter(RenderStats::getName(counter), renderStats.getAverage(counter));
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Benchmark the Assimp to vertex data conversion of ResourceManager::loadNode on the "data/" models
+ */
+static void benchConvertMesh(Bench::Benchmark& aBenchmark, const char* apFilter, Log::Logger& aLog) {
+    for (size_t idxFile = 0; idxFile < sizeof(_modelFiles)/sizeof(_modelFiles[0]); ++idxFile) {
+        std::string name = std::string("ResourceManager::convertMesh/") + _modelFiles[idxFile];
+        if (isSelected(name.c_str(), apFilter)) {
+            Assimp::Importer    importer;
+            const aiScene*      pScene = importer.ReadFile(_modelFiles[idxFile], aiProcessPreset_TargetRealtime_Fast);
+            if ((nullptr == pScene) || (0 != (pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE))) {
+                aLog.warning() << name << " skipped: '" << importer.GetErrorString() << "'";
+                continue;
+            }
+            unsigned int nbVertices = 0;
+            for (unsigned int idxMesh = 0; idxMesh < pScene->mNumMeshes; ++idxMesh) {
+                nbVertices += pScene->mMeshes[idxMesh]->mNumVertices;
+            }
+            Mesh::VertexData    vertexData;
+            Mesh::IndexData     indexData;
+            try {
+                aBenchmark.run(name.c_str(), [pScene, &vertexData, &indexData] () {
+                    for (unsigned int idxMesh = 0; idxMesh < pScene->mNumMeshes; ++idxMesh) {
+                        ResourceManager::convertMesh(pScene->mMeshes[idxMesh], vertexData, indexData);
+                        Bench::keep(vertexData.size());
+                    }
+                }, nbVertices);
+            } catch (std::exception& e) {
+                aLog.warning() << name << " skipped: '" << e.what() << "'";
+            }
+        }
+    }
+}
+
+/**
+ * @brief Count the vertices of the Meshes of an imported model
+ */
+static unsigned int countVertices(const ModelData& aModelData) {
+    size_t nbVertices = 0;
+    for (size_t idxMesh = 0; idxMesh < aModelData.mMeshes.size(); ++idxMesh) {
+        nbVertices += aModelData.mMeshes[idxMesh].mVertexData.size() / 3;
+    }
+    return static_cast<unsigned int>(nbVertices);
+}
+
+/**
+ * @brief Benchmark the whole import of the "data/" models: Assimp versus the NativeLoader for PLY and OBJ files
+ */
+static void benchImport(Bench::Benchmark& aBenchmark, const char* apFilter, Log::Logger& aLog) {
+    for (size_t idxFile = 0; idxFile < sizeof(_modelFiles)/sizeof(_modelFiles[0]); ++idxFile) {
+        const std::string filename = _modelFiles[idxFile];
+        ModelData modelData;
+        std::string name = "Import/assimp/" + filename;
+        if (isSelected(name.c_str(), apFilter)) {
+            try {
+                ResourceManager::importAssimpFile(filename, ResourceManager::DEFAULT_IMPORT_FLAGS, modelData);
+                aBenchmark.run(name.c_str(), [&filename, &modelData] () {
+                    ResourceManager::importAssimpFile(filename, ResourceManager::DEFAULT_IMPORT_FLAGS, modelData);
+                }, countVertices(modelData));
+            } catch (std::exception& e) {
+                aLog.warning() << name << " skipped: '" << e.what() << "'";
+            }
+        }
+        name = "Import/native/" + filename;
+        if (NativeLoader::isSupported(filename) && isSelected(name.c_str(), apFilter)) {
+            try {
+                NativeLoader::importFile(filename, modelData);
+                aBenchmark.run(name.c_str(), [&filename, &modelData] () {
+                    NativeLoader::importFile(filename, modelData);
+                }, countVertices(modelData));
+            } catch (std::exception& e) {
+                aLog.warning() << name << " skipped: '" << e.what() << "'";
+            }
+        }
+    }
+}
+
+/**
+ * @brief Benchmark the generation of the levels of detail of the "data/" models (see MeshSimplifier)
+ */
+static void benchGenerateLods(Bench::Benchmark& aBenchmark, const char* apFilter, Log::Logger& aLog) {
+    for (size_t idxFile = 0; idxFile < sizeof(_modelFiles)/sizeof(_modelFiles[0]); ++idxFile) {
+        const std::string filename = _modelFiles[idxFile];
+        const std::string name = "MeshSimplifier::generateLods/" + filename;
+        if (isSelected(name.c_str(), apFilter)) {
+            try {
+                // Import the full resolution only, without the levels of detail generated by ResourceManager
+                ModelData modelData;
+                if (NativeLoader::isSupported(filename)) {
+                    NativeLoader::importFile(filename, modelData);
+                } else {
+                    ResourceManager::importAssimpFile(filename, ResourceManager::DEFAULT_IMPORT_FLAGS, modelData);
+                }
+                size_t nbTriangles = 0;
+                for (size_t idxMesh = 0; idxMesh < modelData.mMeshes.size(); ++idxMesh) {
+                    nbTriangles += modelData.mMeshes[idxMesh].mIndexData.size() / 3;
+                }
+                Mesh::IndexData indexData;
+                Mesh::LodList   lods;
+                aBenchmark.run(name.c_str(), [&modelData, &indexData, &lods] () {
+                    for (size_t idxMesh = 0; idxMesh < modelData.mMeshes.size(); ++idxMesh) {
+                        indexData = modelData.mMeshes[idxMesh].mIndexData;
+                        MeshSimplifier::generateLods(modelData.mMeshes[idxMesh].mVertexData, indexData, lods);
+                        Bench::keep(lods.size());
+                    }
+                }, static_cast<unsigned int>(nbTriangles));
+            } catch (std::exception& e) {
+                aLog.warning() << name << " skipped: '" << e.what() << "'";
+            }
+        }
+    }
+}
+
+/**
+ * @brief Convert the triangles of an Assimp mesh into a RawMesh, without normals nor colors
+ */
+static void toRawMesh(const aiMesh* apMesh, RawMesh& aRawMesh) {
+    aRawMesh.mPositions.resize(apMesh->mNumVertices);
+    for (unsigned int idxVertex = 0; idxVertex < apMesh->mNumVertices; ++idxVertex) {
+        const aiVector3D& position = apMesh->mVertices[idxVertex];
+        aRawMesh.mPositions[idxVertex] = glm::vec3(position.x, position.y, position.z);
+    }
+    for (unsigned int idxFace = 0; idxFace < apMesh->mNumFaces; ++idxFace) {
+        const aiFace& face = apMesh->mFaces[idxFace];
+        if (3 == face.mNumIndices) {
+            aRawMesh.mIndices.insert(aRawMesh.mIndices.end(), face.mIndices, face.mIndices + 3);
+        }
+    }
+}
+
+/**
+ * @brief Benchmark the generation of the normals of the "data/" models: Assimp versus VertexAttributes
+ *
+ *  Both start from the same raw triangles, read by Assimp without joining identical vertices (each triangle
+ * having its own three vertices): Assimp "GenSmoothNormals" versus the welding and the normals of VertexAttributes.
+ */
+static void benchNormals(Bench::Benchmark& aBenchmark, const char* apFilter, Log::Logger& aLog) {
+    for (size_t idxFile = 0; idxFile < sizeof(_modelFiles)/sizeof(_modelFiles[0]); ++idxFile) {
+        const std::string filename      = _modelFiles[idxFile];
+        const std::string assimpName    = "Normals/assimp/" + filename;
+        const std::string nativeName    = "Normals/native/" + filename;
+        if (!isSelected(assimpName.c_str(), apFilter) && !isSelected(nativeName.c_str(), apFilter)) {
+            continue;
+        }
+        Assimp::Importer    importer;
+        const aiScene*      pScene = importer.ReadFile(filename.c_str(), aiProcess_Triangulate | aiProcess_SortByPType);
+        if ((nullptr == pScene) || (0 != (pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE))) {
+            aLog.warning() << filename << " skipped: '" << importer.GetErrorString() << "'";
+            continue;
+        }
+        // Raw triangles of each Mesh, copied before the Assimp benchmark modifies the scene
+        std::vector<RawMesh> rawMeshes(pScene->mNumMeshes);
+        unsigned int nbVertices = 0;
+        for (unsigned int idxMesh = 0; idxMesh < pScene->mNumMeshes; ++idxMesh) {
+            toRawMesh(pScene->mMeshes[idxMesh], rawMeshes[idxMesh]);
+            nbVertices += pScene->mMeshes[idxMesh]->mNumVertices;
+        }
+
+        if (isSelected(assimpName.c_str(), apFilter)) {
+            try {
+                aBenchmark.run(assimpName.c_str(), [pScene, &importer] () {
+                    // The "GenSmoothNormals" step does nothing on a Mesh which already has normals
+                    for (unsigned int idxMesh = 0; idxMesh < pScene->mNumMeshes; ++idxMesh) {
+                        delete[] pScene->mMeshes[idxMesh]->mNormals;
+                        pScene->mMeshes[idxMesh]->mNormals = nullptr;
+                    }
+                    Bench::keep(importer.ApplyPostProcessing(aiProcess_GenSmoothNormals));
+                }, nbVertices);
+            } catch (std::exception& e) {
+                aLog.warning() << assimpName << " skipped: '" << e.what() << "'";
+            }
+        }
+        if (isSelected(nativeName.c_str(), apFilter)) {
+            try {
+                RawMesh rawMesh;
+                aBenchmark.run(nativeName.c_str(), [&rawMeshes, &rawMesh] () {
+                    for (size_t idxMesh = 0; idxMesh < rawMeshes.size(); ++idxMesh) {
+                        rawMesh = rawMeshes[idxMesh];
+                        VertexAttributes::weld(rawMesh, 1e-6f);
+                        VertexAttributes::computeNormals(rawMesh);
+                        if (false == rawMesh.mNormals.empty()) {
+                            Bench::keep(rawMesh.mNormals[0]);
+                        }
+                    }
+                }, nbVertices);
+            } catch (std::exception& e) {
+                aLog.warning() << nativeName << " skipped: '" << e.what() << "'";
+            }
+        }
+    }
+}
+
+/**
+ * @brief Main method - entry point of the micro-benchmarks
+ *
+ *  Usage: glExperiments_bench [-o results.json] [-s samples] [filter]
+ *
+ *  Results are written in JSON format, to the standard output by default. Must be run from the root directory,
+ * to find the "data/" models.
+ *
+ * @param[in] argc   Number or argument given on the command line (starting with 1, the executable itself)
+ * @param[in] argv   Array of pointers of strings containing the arguments
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int main(int argc, char** argv) {
+    const char*     pOutputFilename = nullptr;
+    const char*     pFilter         = nullptr;
+    unsigned int    nbSamples       = _nbSamples;
+
+    for (int idxArg = 1; idxArg < argc; ++idxArg) {
+        if ((0 == strcmp(argv[idxArg], "-o")) && (idxArg + 1 < argc)) {
+            pOutputFilename = argv[++idxArg];
+        } else if ((0 == strcmp(argv[idxArg], "-s")) && (idxArg + 1 < argc)) {
+            nbSamples = static_cast<unsigned int>(atoi(argv[++idxArg]));
+        } else {
+            pFilter = argv[idxArg];
+        }
+    }
+
+    // Keep the standard output clean for the JSON results if no output file is given
+    Log::Manager::setDefaultLevel((nullptr != pOutputFilename) ? Log::Log::eNotice : Log::Log::eWarning);
+    Log::Config::Vector configList;
+    Log::Config::addOutput(configList, "OutputConsole");
+    Log::Manager::configure(configList);
+    Log::Logger log("bench");
+
+    Bench::Benchmark benchmark(nbSamples, _minSampleUs);
+    benchTime(benchmark, pFilter);
+    benchNode(benchmark, pFilter);
+    benchMatrixStack(benchmark, pFilter);
+    benchSceneMove(benchmark, pFilter);
+    benchSceneCollect(benchmark, pFilter, log);
+    benchConvertMesh(benchmark, pFilter, log);
+    benchImport(benchmark, pFilter, log);
+    benchGenerateLods(benchmark, pFilter, log);
+    benchNormals(benchmark, pFilter, log);
+
+    const std::vector<Bench::Result>& results = benchmark.getResults();
+    for (size_t idx = 0; idx < results.size(); ++idx) {
+        log.notice() << results[idx].mName << ": median " << results[idx].mMedianNs << "ns (min "
+                     << results[idx].mMinNs << "ns, stddev " << results[idx].mStdDevNs << "ns)";
+    }
+
+    if (nullptr != pOutputFilename) {
+        std::ofstream outputFile(pOutputFilename);
+        if (false == outputFile.is_open()) {
+            log.critic() << "unable to write \"" << pOutputFilename << "\"";
+            return EXIT_FAILURE;
+        }
+        benchmark.writeJson(outputFile);
+    } else {
+        benchmark.writeJson(std::cout);
+    }
+
+    return EXIT_SUCCESS;
+}
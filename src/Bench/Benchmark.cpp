@@ -0,0 +1,123 @@
+/**
+ * @file    Benchmark.cpp
+ * @ingroup Bench
+ * @brief   Minimal micro-benchmark harness with statistically stable timings.
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Bench/Benchmark.h"
+
+#include <algorithm>    // std::sort
+#include <cmath>        // sqrt
+#include <iomanip>
+#include <string>
+#include <vector>
+
+namespace Bench {
+
+volatile char _sink = 0;
+
+/**
+ * @brief Constructor
+ *
+ * @param[in] aNbSamples    Number of samples to measure for each benchmark
+ * @param[in] aMinSampleUs  Minimum duration of a sample, in microseconds
+ */
+Benchmark::Benchmark(unsigned int aNbSamples, time_t aMinSampleUs) :
+    mNbSamples((0 < aNbSamples) ? aNbSamples : 1),
+    mMinSampleUs(aMinSampleUs) {
+}
+
+/**
+ * @brief Destructor
+ */
+Benchmark::~Benchmark() {
+}
+
+/**
+ * @brief Compute statistics from the samples, and store them into a new Result
+ *
+ * @param[in]     apName        Name of the benchmark
+ * @param[in]     aIterations   Number of iterations per sample
+ * @param[in]     aNbItems      Number of items processed by one iteration
+ * @param[in,out] aSamplesNs    Duration of each sample, per iteration, in nanoseconds (sorted by this method)
+ *
+ * @return Result of the benchmark
+ */
+const Result& Benchmark::addResult(const char* apName, unsigned int aIterations, unsigned int aNbItems,
+                                   std::vector<double>& aSamplesNs) {
+    Result result;
+    result.mName        = apName;
+    result.mIterations  = aIterations;
+    result.mSamples     = static_cast<unsigned int>(aSamplesNs.size());
+    result.mItems       = (0 < aNbItems) ? aNbItems : 1;
+
+    std::sort(aSamplesNs.begin(), aSamplesNs.end());
+    const size_t nbSamples = aSamplesNs.size();
+    result.mMinNs       = aSamplesNs.front();
+    result.mMedianNs    = (0 == (nbSamples % 2)) ? ((aSamplesNs[nbSamples/2 - 1] + aSamplesNs[nbSamples/2]) / 2.0)
+                                                 : aSamplesNs[nbSamples/2];
+    double sum = 0.0;
+    for (size_t idx = 0; idx < nbSamples; ++idx) {
+        sum += aSamplesNs[idx];
+    }
+    result.mMeanNs      = sum / nbSamples;
+    double sumSquares = 0.0;
+    for (size_t idx = 0; idx < nbSamples; ++idx) {
+        sumSquares += (aSamplesNs[idx] - result.mMeanNs) * (aSamplesNs[idx] - result.mMeanNs);
+    }
+    result.mStdDevNs    = (1 < nbSamples) ? sqrt(sumSquares / (nbSamples - 1)) : 0.0;
+
+    mResults.push_back(result);
+    return mResults.back();
+}
+
+/**
+ * @brief Add a counter to the result of the last benchmark run (written along with its timings by writeJson())
+ *
+ * @param[in] apName    Name of the counter
+ * @param[in] aValue    Value of the counter, per iteration
+ */
+void Benchmark::addCounter(const char* apName, double aValue) {
+    if (false == mResults.empty()) {
+        mResults.back().mCounters.push_back(Result::Counter(apName, aValue));
+    }
+}
+
+/**
+ * @brief Write all results in JSON format
+ *
+ * @param[in] aStream   Output stream where to write the JSON document
+ */
+void Benchmark::writeJson(std::ostream& aStream) const {
+    aStream << "{\n  \"benchmarks\": [\n";
+    aStream << std::fixed << std::setprecision(3);
+    for (size_t idx = 0; idx < mResults.size(); ++idx) {
+        const Result& result = mResults[idx];
+        aStream << "    {\"name\": \"" << result.mName << "\""
+                << ", \"iterations\": " << result.mIterations
+                << ", \"samples\": " << result.mSamples
+                << ", \"items\": " << result.mItems
+                << ", \"min_ns\": " << result.mMinNs
+                << ", \"median_ns\": " << result.mMedianNs
+                << ", \"mean_ns\": " << result.mMeanNs
+                << ", \"stddev_ns\": " << result.mStdDevNs
+                << ", \"median_ns_per_item\": " << (result.mMedianNs / result.mItems);
+        if (false == result.mCounters.empty()) {
+            aStream << ", \"counters\": {";
+            for (size_t idxCounter = 0; idxCounter < result.mCounters.size(); ++idxCounter) {
+                aStream << ((0 < idxCounter) ? ", " : "") << "\"" << result.mCounters[idxCounter].first << "\": "
+                        << result.mCounters[idxCounter].second;
+            }
+            aStream << "}";
+        }
+        aStream << "}" << ((idx + 1 < mResults.size()) ? "," : "") << "\n";
+    }
+    aStream << "  ]\n}\n";
+}
+
+} // namespace Bench
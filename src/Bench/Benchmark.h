@@ -0,0 +1,164 @@
+/**
+ * @file    Benchmark.h
+ * @ingroup Bench
+ * @brief   Minimal micro-benchmark harness with statistically stable timings.
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+/**
+ * @defgroup  Bench Bench
+ * @brief     Micro-benchmarks of the core engine.
+ */
+/**
+ * @dir     Bench Bench
+ * @brief   Micro-benchmarks of the core engine.
+ * @ingroup Bench
+ */
+#pragma once
+
+#include "Utils/Utils.h"
+#include "Utils/Measure.h"
+
+#include <ostream>      // NOLINT(readability/streams) for the JSON output
+#include <string>
+#include <vector>
+#include <utility>      // std::pair
+
+/**
+ * @brief   Micro-benchmarks of the core engine.
+ * @ingroup Bench
+ */
+namespace Bench {
+
+/// Sink used to prevent the compiler from optimizing away benchmarked computations
+extern volatile char _sink;
+
+/**
+ * @brief Prevent the compiler from optimizing away the computation of the given value
+ *
+ * @param[in] aValue    Result of a benchmarked computation
+ */
+template <typename T>
+inline void keep(const T& aValue) {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&aValue) : "memory");
+#else
+    _sink = *reinterpret_cast<const volatile char*>(&aValue);
+#endif
+}
+
+/**
+ * @brief   Timing statistics of a benchmark, for one iteration, in nanoseconds.
+ * @ingroup Bench
+ */
+struct Result {
+    /// Named value measured by a benchmark along with its timings (like a RenderStats counter), per iteration
+    typedef std::pair<std::string, double>  Counter;
+
+    std::string     mName;          ///< Name of the benchmark
+    unsigned int    mIterations;    ///< Number of iterations per sample
+    unsigned int    mSamples;       ///< Number of samples measured
+    unsigned int    mItems;         ///< Number of items processed by one iteration (nodes, vertices...)
+    double          mMinNs;         ///< Fastest sample, per iteration
+    double          mMedianNs;      ///< Median sample, per iteration
+    double          mMeanNs;        ///< Average of samples, per iteration
+    double          mStdDevNs;      ///< Standard deviation of samples, per iteration
+    std::vector<Counter> mCounters; ///< Counters measured by the benchmark, per iteration (see addCounter())
+};
+
+/**
+ * @brief   Minimal micro-benchmark harness with statistically stable timings.
+ * @ingroup Bench
+ *
+ *  The number of iterations of each sample is first calibrated so that a sample lasts at least the given duration,
+ * far above the microsecond resolution of Utils::Time, which also serves as a warm-up. Then,
+ * the configured number of samples is measured, and the min/median/mean/stddev of them are computed.
+ *  The median is the value to compare, the standard deviation tells how stable the measurement was.
+ */
+class Benchmark {
+public:
+    Benchmark(unsigned int aNbSamples, time_t aMinSampleUs);
+    ~Benchmark(); // not virtual because no virtual methods and class not derived
+
+    // Run the given function enough times to get statistically stable results
+    template <typename Function>
+    const Result& run(const char* apName, Function aFunction, unsigned int aNbItems = 1);
+
+    // Add a counter to the result of the last benchmark run
+    void addCounter(const char* apName, double aValue);
+
+    // Getter
+    inline const std::vector<Result>& getResults() const;
+
+    // Write all results in JSON format
+    void writeJson(std::ostream& aStream) const;
+
+private:
+    // Compute statistics from the samples, and store them into a new Result
+    const Result& addResult(const char* apName, unsigned int aIterations, unsigned int aNbItems,
+                            std::vector<double>& aSamplesNs);
+
+private:
+    const unsigned int  mNbSamples;     ///< Number of samples to measure for each benchmark
+    const time_t        mMinSampleUs;   ///< Minimum duration of a sample, in microseconds
+
+    std::vector<Result> mResults;       ///< Results of all benchmarks already run
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(Benchmark);
+};
+
+
+/**
+ * @brief Run the given function enough times to get statistically stable results
+ *
+ * @param[in] apName    Name of the benchmark
+ * @param[in] aFunction Function (or functor/lambda) to benchmark, taking no argument
+ * @param[in] aNbItems  Number of items processed by one call to the function (nodes, vertices...)
+ *
+ * @return Result of the benchmark (also stored for writeJson())
+ */
+template <typename Function>
+const Result& Benchmark::run(const char* apName, Function aFunction, unsigned int aNbItems /* = 1 */) {
+    Utils::Measure measure;
+
+    // Calibration: double the number of iterations until a sample lasts long enough
+    unsigned int iterations = 1;
+    for (;;) {
+        measure.restart();
+        for (unsigned int idx = 0; idx < iterations; ++idx) {
+            aFunction();
+        }
+        if ((measure.diff() >= mMinSampleUs) || (iterations >= (1U << 30))) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    // Measurement: the calibration above served as a warm-up
+    std::vector<double> samplesNs;
+    samplesNs.reserve(mNbSamples);
+    for (unsigned int idxSample = 0; idxSample < mNbSamples; ++idxSample) {
+        measure.restart();
+        for (unsigned int idx = 0; idx < iterations; ++idx) {
+            aFunction();
+        }
+        const time_t diffUs = measure.diff();
+        samplesNs.push_back((diffUs * 1000.0) / iterations);
+    }
+
+    return addResult(apName, iterations, aNbItems, samplesNs);
+}
+
+/**
+ * @brief Get the results of all benchmarks already run
+ */
+inline const std::vector<Result>& Benchmark::getResults() const {
+    return mResults;
+}
+
+} // namespace Bench
@@ -11,17 +11,42 @@
 
 #include "Main/App.h"
 #include "Utils/FPS.h"
+#include "Utils/Exception.h"
 
 #include <cassert>
+#include <iomanip>  // std::setprecision
 
 /**
  * @brief Constructor
  *
  * @param[in] apWindow  Pointer to the GLFW window
+ * @param[in] aOptions  Command line options
  */
-App::App(GLFWwindow* apWindow) :
+App::App(GLFWwindow* apWindow, const Options& aOptions) :
     mLog("App"),
-    mpWindow(apWindow) {
+    mRenderer(aOptions),
+    mOculusHMD(aOptions.mbFakeHmd),
+    mpWindow(apWindow),
+    mNbFrames(aOptions.mNbFrames) {
+    if (false == aOptions.mOutputFilename.empty()) {
+        mOutputFile.open(aOptions.mOutputFilename.c_str());
+        if (false == mOutputFile.is_open()) {
+            UTILS_THROW("App: unable to open output file \"" << aOptions.mOutputFilename << "\"");
+        }
+        mOutputFile << "nodes,frames,fps,avg_frame_ms,worst_frame_ms,cpu_render_ms,gpu_ms,fence_wait_ms,"
+                       "frames_in_flight,draws,triangles,lod_saved_triangles,impostors,state_calls,state_elided,"
+                       "static_meshes,overdraw,occluded_nodes,occluded_triangles,occlusion_queries,occlusion_cpu_ms,"
+                       "soft_tested_nodes,soft_occluded_nodes,mask_coverage,masked_eyes\n";
+    }
+    if (aOptions.mbHiddenArea) {
+        // The hidden area is generated from the lens distortion of the HMD (or of its fake profile)
+        OculusHMD::Distortion distortion;
+        if (mOculusHMD.getDistortion(distortion)) {
+            mRenderer.setHiddenArea(distortion);
+        } else {
+            mLog.warning() << "App: no HMD to generate the hidden area of its lenses (see --fake-hmd)";
+        }
+    }
 }
 /**
  * @brief Destructor
@@ -46,6 +71,7 @@ void App::loop() {
     mRenderer.reshape(width, height);
 
     mLog.info() << "Loop";
+    unsigned int nbFrames = 0;
     while (!glfwWindowShouldClose(mpWindow)) {
         // FPS and frame duration calculations
         bool bNewCalculatedFPS = FPS.start(static_cast<float>(glfwGetTime()));
@@ -55,6 +81,32 @@ void App::loop() {
                           << FPS.getWorstInterFrame()*1000.0f << "ms) RenderTime "
                           << FPS.getLastRenderTime()*1000.0f << "ms ("
                           << FPS.getLastRenderTime()*100.0f/FPS.getElapsedTime() << "%)";
+
+            // Statistics counters and GPU time aggregated over the same FPS interval
+            RenderStats& renderStats = mRenderer.getRenderStats();
+            GpuTimer& gpuTimer = mRenderer.getGpuTimer();
+            FramePacer& framePacer = mRenderer.getFramePacer();
+            OverdrawMeter& overdrawMeter = mRenderer.getOverdrawMeter();
+            SoftwareOcclusion& softwareOcclusion = mRenderer.getSoftwareOcclusion();
+            CockpitMask& cockpitMask = mRenderer.getCockpitMask();
+            mLog.info() << "RenderStats (" << renderStats.getNbFrames() << " frames) " << renderStats.toString()
+                        << " GPU " << gpuTimer.getAverageMs() << "ms"
+                        << " wait " << framePacer.getAverageWaitMs() << "ms"
+                        << " overdraw " << overdrawMeter.getAverage()
+                        << " occlusionCpu " << softwareOcclusion.getAverageMs() << "ms ("
+                        << softwareOcclusion.getNbTriangles() << " occluder triangles)"
+                        << " mask " << cockpitMask.getAverageCoverage() << " (" << cockpitMask.getNbMaskedEyes()
+                        << " eyes masked)";
+            writeMeasures(FPS);
+            renderStats.reset();
+            gpuTimer.reset();
+            framePacer.reset();
+            overdrawMeter.reset();
+            softwareOcclusion.reset();
+            cockpitMask.reset();
+
+            // Free the GPU memory of the models whose last instance went away during this interval
+            mRenderer.getResourceManager().purge();
         }
 
         // Check current key pressed, and move/orient models accordingly
@@ -77,6 +129,50 @@ void App::loop() {
 
         // Process events
         glfwPollEvents();
+
+        // Exit after the requested number of frames (for automated measurements)
+        ++nbFrames;
+        if ((0 < mNbFrames) && (nbFrames >= mNbFrames)) {
+            glfwSetWindowShouldClose(mpWindow, GL_TRUE);
+        }
+    }
+}
+
+/**
+ * @brief Write the measurements of the last FPS interval into the CSV output file (if any)
+ *
+ * @param[in] aFPS  FPS calculation, with a new value just calculated
+ */
+void App::writeMeasures(const Utils::FPS& aFPS) {
+    if (mOutputFile.is_open()) {
+        const RenderStats& renderStats = mRenderer.getRenderStats();
+        mOutputFile << std::fixed << std::setprecision(3)
+                    << renderStats.getEyeAverage(0, RenderStats::eNodes) << ","
+                    << renderStats.getNbFrames() << ","
+                    << aFPS.getCalculatedFPS() << ","
+                    << aFPS.getAverageInterFrame()*1000.0f << ","
+                    << aFPS.getWorstInterFrame()*1000.0f << ","
+                    << aFPS.getAverageRenderTime()*1000.0f << ","
+                    << mRenderer.getGpuTimer().getAverageMs() << ","
+                    << mRenderer.getFramePacer().getAverageWaitMs() << ","
+                    << mRenderer.getFramePacer().getNbFramesInFlight() << ","
+                    << renderStats.getAverage(RenderStats::eDrawCalls) << ","
+                    << renderStats.getAverage(RenderStats::eTriangles) << ","
+                    << renderStats.getAverage(RenderStats::eLodSavedTriangles) << ","
+                    << renderStats.getAverage(RenderStats::eImpostors) << ","
+                    << renderStats.getAverage(RenderStats::eStateCalls) << ","
+                    << renderStats.getAverage(RenderStats::eStateElided) << ","
+                    << renderStats.getEyeAverage(0, RenderStats::eStaticMeshes) << ","
+                    << mRenderer.getOverdrawMeter().getAverage() << ","
+                    << renderStats.getEyeAverage(0, RenderStats::eOccludedNodes) << ","
+                    << renderStats.getAverage(RenderStats::eOccludedTriangles) << ","
+                    << renderStats.getAverage(RenderStats::eOcclusionQueries) << ","
+                    << mRenderer.getSoftwareOcclusion().getAverageMs() << ","
+                    << renderStats.getAverage(RenderStats::eSoftTestedNodes) << ","
+                    << renderStats.getAverage(RenderStats::eSoftOccludedNodes) << ","
+                    << mRenderer.getCockpitMask().getAverageCoverage() << ","
+                    << mRenderer.getCockpitMask().getNbMaskedEyes() << "\n";
+        mOutputFile.flush();
     }
 }
 
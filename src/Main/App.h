@@ -17,17 +17,24 @@
 #include <GLFW/glfw3.h>
 
 #include "Main/Renderer.h"
+#include "Main/Options.h"
 
 #include "Utils/Utils.h"
 
 #include "Main/OculusHMD.h"
 
+#include <fstream>  // NOLINT(readability/streams) for the CSV output file
+
+namespace Utils {
+    class FPS;
+}
+
 /**
  * @brief Application managing the lifecycle of GLFW window and inputs.
  */
 class App {
 public:
-    explicit App(GLFWwindow* apWindow);
+    App(GLFWwindow* apWindow, const Options& aOptions);
     ~App();
 
     // Application main loop
@@ -39,6 +46,9 @@ private:
 
     inline bool isKeyPressed(int aKey) const;
 
+    // Write the measurements of the last FPS interval into the CSV output file
+    void writeMeasures(const Utils::FPS& aFPS);
+
 private:
     Log::Logger mLog;       ///< Logger object to output runtime information
 
@@ -46,6 +56,9 @@ private:
     OculusHMD   mOculusHMD; ///< Manage Oculus Head Mounted Display inputs
     GLFWwindow* mpWindow;   ///< Pointer to the GLFW window
 
+    unsigned int    mNbFrames;      ///< Number of frames to render before exiting (0 for no limit)
+    std::ofstream   mOutputFile;    ///< CSV file where to write measurements at each FPS interval
+
 private:
     /// disallow copy constructor and assignment operator
     DISALLOW_COPY_AND_ASSIGN(App);
@@ -0,0 +1,222 @@
+/**
+ * @file    AssetStreamer.cpp
+ * @ingroup Main
+ * @brief   Background loading of models: import on worker threads, GPU upload under a per-frame budget
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/AssetStreamer.h"
+#include "Utils/Measure.h"
+
+#include <functional>   // std::bind
+#include <algorithm>    // std::max
+#include <limits>       // std::numeric_limits
+#include <stdexcept>    // std::exception
+#include <string>
+#include <vector>
+
+/**
+ * @brief Constructor: start the worker threads
+ *
+ * @param[in] aResourceManager  Models loaded once, shared by all their instances
+ * @param[in] aNbThreads        Number of worker threads (0 for the number of hardware threads)
+ */
+AssetStreamer::AssetStreamer(ResourceManager& aResourceManager, unsigned int aNbThreads) :
+    mLog("AssetStreamer"),
+    mResourceManager(aResourceManager),
+    mbStopping(false),
+    mNbPending(0) {
+    if (0 == aNbThreads) {
+        aNbThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    for (unsigned int idxThread = 0; idxThread < aNbThreads; ++idxThread) {
+        mThreads.push_back(std::thread(std::bind(&AssetStreamer::work, this)));
+    }
+    mLog.notice() << aNbThreads << " worker thread(s)";
+}
+
+/**
+ * @brief Destructor: stop the worker threads (requests not imported yet are dropped)
+ */
+AssetStreamer::~AssetStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mbStopping = true;
+        mImportQueue.clear();
+    }
+    mCondition.notify_all();
+    for (std::vector<std::thread>::iterator iThread = mThreads.begin(); iThread != mThreads.end(); ++iThread) {
+        iThread->join();
+    }
+}
+
+/**
+ * @brief Request a model to be loaded in the background
+ *
+ *  If the model is already loaded, it is instantiated without any import, and delivered by the next update().
+ *
+ * @param[in] aFilename     Name of the model file to load (must be supported by assimp)
+ * @param[in] aCallback     Callback receiving the new instance of the model, called by update()
+ * @param[in] aImportFlags  Assimp post-processing flags (part of the identity of the resource)
+ * @param[in] abRetainData  Keep the data of the Meshes in CPU memory (for the occluders, see SoftwareOcclusion);
+ *                          has no effect if the model has already been loaded without it
+ */
+void AssetStreamer::request(const std::string& aFilename, const Callback& aCallback,
+                            unsigned int aImportFlags /* = DEFAULT */, bool abRetainData /* = false */) {
+    RequestPtr NewRequestPtr(new Request());
+    NewRequestPtr->mFilename    = aFilename;
+    NewRequestPtr->mImportFlags = aImportFlags;
+    NewRequestPtr->mbRetainData = abRetainData;
+    NewRequestPtr->mCallback    = aCallback;
+    NewRequestPtr->mNbUploaded  = 0;
+    NewRequestPtr->mImportUs    = 0;
+    NewRequestPtr->mUploadUs    = 0;
+    ++mNbPending;
+
+    mLog.info() << "request(" << aFilename << ")";
+    const bool bLoaded = mResourceManager.isLoaded(aFilename, aImportFlags);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (bLoaded) {
+            // No need to import anything: go directly to the upload queue
+            mUploadQueue.push_back(NewRequestPtr);
+        } else {
+            mImportQueue.push_back(NewRequestPtr);
+        }
+    }
+    mCondition.notify_one();
+}
+
+/**
+ * @brief Loop of a worker thread: import the requested models, and queue them for upload
+ */
+void AssetStreamer::work() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (false == mbStopping) {
+        if (mImportQueue.empty()) {
+            mCondition.wait(lock);
+        } else {
+            RequestPtr ImportPtr = mImportQueue.front();
+            mImportQueue.pop_front();
+
+            // Import the model without holding the lock (this is the long part)
+            lock.unlock();
+            Utils::Measure measure;
+            try {
+                ResourceManager::importFile(ImportPtr->mFilename, ImportPtr->mImportFlags, ImportPtr->mModelData);
+            } catch (std::exception& e) {
+                ImportPtr->mError = e.what();
+            }
+            ImportPtr->mImportUs = measure.diff();
+            lock.lock();
+
+            mUploadQueue.push_back(ImportPtr);
+            mImportedCondition.notify_one();
+        }
+    }
+}
+
+/**
+ * @brief Upload the Meshes imported by the workers under a budget, and deliver the models ready
+ *
+ *  To be called once per frame by the render thread, owning the OpenGL context.
+ * At least one Mesh is uploaded per call, even if it exceeds the budget, so that any model is eventually delivered.
+ *
+ * @param[in] aBudgetBytes  Maximum size of the Meshes to upload, in bytes
+ * @param[in] aBudgetUs     Maximum time spent uploading, in microseconds
+ *
+ * @return Number of models delivered
+ */
+unsigned int AssetStreamer::update(size_t aBudgetBytes, time_t aBudgetUs) {
+    Utils::Measure  measure;
+    unsigned int    nbDelivered = 0;
+    size_t          nbBytes     = 0;
+    bool            bBudgetLeft = (0 < mNbPending);
+
+    while (bBudgetLeft) {
+        if (!mUploadingPtr) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (false == mUploadQueue.empty()) {
+                mUploadingPtr = mUploadQueue.front();
+                mUploadQueue.pop_front();
+            }
+        }
+        if (!mUploadingPtr) {
+            // Nothing imported yet
+            bBudgetLeft = false;
+        } else if (false == mUploadingPtr->mError.empty()) {
+            mLog.error() << "update: " << mUploadingPtr->mError;
+            mUploadingPtr.reset();
+            --mNbPending;
+        } else {
+            Request&                        request     = *mUploadingPtr;
+            const std::vector<MeshData>&    meshesData  = request.mModelData.mMeshes;
+            if (mResourceManager.isLoaded(request.mFilename, request.mImportFlags)) {
+                // Already loaded (by another request or synchronously): no need for any upload
+                request.mNbUploaded = meshesData.size();
+            }
+            request.mMeshes.resize(meshesData.size());
+
+            // Upload one Mesh at a time, while some budget is left
+            while ((request.mNbUploaded < meshesData.size()) && bBudgetLeft) {
+                const MeshData& meshData = meshesData[request.mNbUploaded];
+                Utils::Measure  uploadMeasure;
+                request.mMeshes[request.mNbUploaded] = mResourceManager.uploadMesh(meshData, true,
+                                                                                   request.mbRetainData);
+                request.mUploadUs += uploadMeasure.diff();
+                ++request.mNbUploaded;
+                nbBytes += meshData.getNbBytes();
+                bBudgetLeft = (nbBytes < aBudgetBytes) && (measure.diff() < aBudgetUs);
+            }
+
+            if (request.mNbUploaded >= meshesData.size()) {
+                // All Meshes are on the GPU: register the model and deliver a new instance of it
+                Node::Ptr NodePtr = (request.mModelData.mFilename.empty())
+                                  ? mResourceManager.instantiate(request.mFilename, request.mImportFlags)
+                                  : mResourceManager.instantiate(request.mModelData, request.mMeshes);
+                mLog.notice() << "update: \"" << request.mFilename << "\" ready ("
+                              << request.mModelData.getNbBytes() / 1024 << "KB) import "
+                              << request.mImportUs / 1000 << "ms, upload " << request.mUploadUs / 1000 << "ms, total "
+                              << request.mLatency.diff() / 1000 << "ms";
+                request.mCallback(NodePtr);
+                mUploadingPtr.reset();
+                --mNbPending;
+                ++nbDelivered;
+                bBudgetLeft = bBudgetLeft && (0 < mNbPending);
+            }
+        }
+    }
+
+    if (0 < nbBytes) {
+        time_t diffUs = measure.diff();
+        mLog.debug() << "update: " << nbBytes / 1024 << "KB uploaded in " << diffUs << "us";
+    }
+
+    return nbDelivered;
+}
+
+/**
+ * @brief Wait for all the requests to be imported, upload them without any budget, and deliver them
+ *
+ *  Used at startup, when the rendering has not started yet: the models are imported concurrently by the workers,
+ * and uploaded as soon as each one is ready.
+ */
+void AssetStreamer::finish() {
+    Utils::Measure measure;
+    while (0 < mNbPending) {
+        update(std::numeric_limits<size_t>::max(), std::numeric_limits<time_t>::max());
+        if (0 < mNbPending) {
+            // Wait for the next model to be imported
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (mUploadQueue.empty()) {
+                mImportedCondition.wait(lock);
+            }
+        }
+    }
+    time_t diffUs = measure.diff();
+    mLog.notice() << "finish: done in " << diffUs/1000 << "ms";
+}
@@ -0,0 +1,124 @@
+/**
+ * @file    AssetStreamer.h
+ * @ingroup Main
+ * @brief   Background loading of models: import on worker threads, GPU upload under a per-frame budget
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "LoggerCpp/LoggerCpp.h"
+
+#include "Main/Node.h"
+#include "Main/Mesh.h"
+#include "Main/ModelData.h"
+#include "Main/ResourceManager.h"
+#include "Utils/Utils.h"
+#include "Utils/Measure.h"
+
+#include <deque>                // std::deque
+#include <vector>               // std::vector
+#include <string>               // std::string
+#include <memory>               // std::shared_ptr
+#include <functional>           // std::function
+#include <thread>               // std::thread
+#include <mutex>                // std::mutex
+#include <condition_variable>   // std::condition_variable
+#include <cstddef>              // size_t
+#include <ctime>                // time_t
+
+/**
+ * @brief   Background loading of models: import on worker threads, GPU upload under a per-frame budget
+ * @ingroup Main
+ *
+ *  Loading a model synchronously freezes the rendering for the whole file reading, Assimp post-processing
+ * and conversion. Here, a request is queued to a pool of worker threads doing all this CPU work
+ * (see ResourceManager::importFile()), and the resulting vertex and index data are queued back to the render thread.
+ *
+ *  Once per frame, the render thread calls update() which uploads the converted Meshes to the GPU
+ * until a budget in bytes or in time is spent (always at least one Mesh, to guarantee progress).
+ * When all the Meshes of a model are uploaded, the model is registered into the ResourceManager,
+ * and the callback of the request receives a new instance of it, to add it to the Scene.
+ *
+ *  Callbacks are only called by update() and finish(), on the render thread.
+ *
+ *  At startup, many models can be requested at once and waited for with finish(): they are imported
+ * concurrently, so that the loading time is bounded by the slowest model instead of the sum of all of them.
+ * The import, upload, and total time of each model are logged when it is delivered.
+ */
+class AssetStreamer {
+public:
+    /// Callback receiving a new instance of a requested model, when ready
+    typedef std::function<void(const Node::Ptr&)> Callback;
+
+public:
+    AssetStreamer(ResourceManager& aResourceManager, unsigned int aNbThreads);
+    ~AssetStreamer(); // not virtual because no virtual methods and class not derived
+
+    // Request a model to be loaded in the background (render thread)
+    void request(const std::string& aFilename, const Callback& aCallback,
+                 unsigned int aImportFlags = ResourceManager::DEFAULT_IMPORT_FLAGS, bool abRetainData = false);
+
+    // Upload the Meshes imported by the workers under a budget, and deliver the models ready (render thread)
+    unsigned int update(size_t aBudgetBytes, time_t aBudgetUs);
+
+    // Wait for all the requests to be imported, upload them without any budget, and deliver them (render thread)
+    void finish();
+
+    // Number of requests not delivered yet
+    inline size_t getNbPending() const;
+
+private:
+    /**
+     * @brief Request of a model, going from the import queue to the upload queue
+     */
+    struct Request {
+        std::string     mFilename;      ///< Name of the model file to load
+        unsigned int    mImportFlags;   ///< Assimp post-processing flags
+        bool            mbRetainData;   ///< Keep the data of the Meshes in CPU memory (see ResourceManager)
+        Callback        mCallback;      ///< Callback receiving the new instance of the model
+        ModelData       mModelData;     ///< CPU side data, filled by a worker thread
+        std::string     mError;         ///< Error message of the import, if it failed
+        Mesh::List      mMeshes;        ///< Meshes uploaded to the GPU, by index in mModelData.mMeshes
+        size_t          mNbUploaded;    ///< Number of Meshes of mModelData already processed by the upload
+        Utils::Measure  mLatency;       ///< Time since the request
+        time_t          mImportUs;      ///< Time spent importing the model by a worker, in microseconds
+        time_t          mUploadUs;      ///< Time spent uploading the model by the render thread, in microseconds
+    };
+    /// Shared pointer to a Request
+    typedef std::shared_ptr<Request> RequestPtr;
+
+    // Loop of a worker thread: import the requested models
+    void work();
+
+private:
+    Log::Logger                 mLog;               ///< Logger object to output runtime information
+
+    ResourceManager&            mResourceManager;   ///< Models loaded once, shared by all their instances
+
+    std::vector<std::thread>    mThreads;           ///< Worker threads importing the requested models
+    std::mutex                  mMutex;             ///< Protect the queues, and the stop flag
+    std::condition_variable     mCondition;         ///< Signal a new request, or the stop of the workers
+    std::condition_variable     mImportedCondition; ///< Signal a new request imported, ready to upload
+    std::deque<RequestPtr>      mImportQueue;       ///< Requests to import (protected by mMutex)
+    std::deque<RequestPtr>      mUploadQueue;       ///< Requests imported, to upload (protected by mMutex)
+    bool                        mbStopping;         ///< Tell the workers to exit (protected by mMutex)
+
+    RequestPtr                  mUploadingPtr;      ///< Request partially uploaded (render thread only)
+    size_t                      mNbPending;         ///< Requests not delivered yet (render thread only)
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(AssetStreamer);
+};
+
+
+/**
+ * @brief Get the number of requests not delivered yet (importing or uploading)
+ */
+inline size_t AssetStreamer::getNbPending() const {
+    return mNbPending;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file    CockpitMask.cpp
+ * @ingroup Main
+ * @brief   Stencil mask of the cockpit, rejecting the pixels of the outside world it covers
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/CockpitMask.h"
+#include "Main/RenderStats.h"
+#include "Main/StateCache.h"
+
+
+/// Stencil value of the pixels covered by the mask (the stencil is cleared to 0 each frame)
+static const GLint _masked = 1;
+/// Distance of the quad in front of the camera (beyond the near plane), and half of its thickness
+static const float _quadDistance    = 1.0f;
+static const float _quadThickness   = 0.01f;
+/// Margin of the quad around the borders of the view
+static const float _quadMargin      = 1.1f;
+
+
+/**
+ * @brief Constructor (disabled until init())
+ */
+CockpitMask::CockpitMask() :
+    mIdxQuery(0),
+    mbConditional(false),
+    mNbSamples(0),
+    mSumCoverage(0.0),
+    mNbResults(0),
+    mNbMaskedEyes(0) {
+    for (int idxQuery = 0; idxQuery < NB_QUERIES; ++idxQuery) {
+        for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+            mQueries[idxQuery][idxEye] = 0;
+            mbPending[idxQuery][idxEye] = false;
+        }
+    }
+}
+
+/**
+ * @brief Destructor: delete the queries
+ */
+CockpitMask::~CockpitMask() {
+    if (isEnabled()) {
+        glDeleteQueries(2 * NB_QUERIES, &mQueries[0][0]);
+    }
+}
+
+/**
+ * @brief Enable the mask, generating the queries (requires a current OpenGL context)
+ *
+ * @param[in] aQuadPtr  Unit cube [-1,1] (see OcclusionCuller::makeBox()), flattened by getQuadMatrix()
+ */
+void CockpitMask::init(const Mesh::Ptr& aQuadPtr) {
+    if (false == isEnabled()) {
+        glGenQueries(2 * NB_QUERIES, &mQueries[0][0]);
+    }
+    mQuadPtr = aQuadPtr;
+}
+
+/**
+ * @brief "Quad to Camera" matrix placing the unit cube over the whole view, just in front of the camera
+ *
+ *  The cube is flattened into a slab at a fixed distance, scaled beyond the borders of the frustum at this distance.
+ *
+ * @param[in] aCameraToClipMatrix   "Camera to Clip" matrix of the perspective projection
+ *
+ * @return "Quad to Camera" matrix, the same for both eyes
+ */
+glm::mat4 CockpitMask::getQuadMatrix(const glm::mat4& aCameraToClipMatrix) {
+    glm::mat4 quadToCamera(1.0f);
+    quadToCamera[0][0] = _quadMargin * _quadDistance / aCameraToClipMatrix[0][0];
+    quadToCamera[1][1] = _quadMargin * _quadDistance / aCameraToClipMatrix[1][1];
+    quadToCamera[2][2] = _quadThickness;
+    // The camera looks toward -Z
+    quadToCamera[3] = glm::vec4(0.0f, 0.0f, -_quadDistance, 1.0f);
+    return quadToCamera;
+}
+
+/**
+ * @brief Start the mask pass of an eye: the following draws write their depth and 1 into the stencil, without color
+ *
+ *  The program, the viewport, and the depth writes (off for an authored mask only Mesh) are left to the caller.
+ */
+void CockpitMask::beginMask() {
+    StateCache::enable(GL_STENCIL_TEST, true);
+    StateCache::stencilFunc(GL_ALWAYS, _masked, 0xFF);
+    StateCache::stencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    StateCache::colorMask(false);
+}
+
+/**
+ * @brief Stop the mask pass of an eye, counting the samples left uncovered by the quad covering the viewport
+ *
+ * @param[in] aIdxEye           Index of the eye (0 for left, 1 for right)
+ * @param[in] aMatrixAttrib     Location of the "modelToCameraMatrix" per-instance vertex shader attribute
+ * @param[in] aMatrixBuffer     Buffer of the per-instance matrices
+ * @param[in] aQuadOffset       Offset in bytes of the "Quad to Camera" matrix in the buffer (see getQuadMatrix())
+ * @param[in,out] aRenderStats  Statistics counters of the current frame
+ */
+void CockpitMask::endMask(int aIdxEye, GLuint aMatrixAttrib, GLuint aMatrixBuffer, size_t aQuadOffset,
+                          RenderStats& aRenderStats) {
+    // Read the result of the oldest query before reusing it (available since long, in practice)
+    collect(mIdxQuery, aIdxEye, true);
+
+    StateCache::stencilFunc(GL_EQUAL, 0, 0xFF);
+    StateCache::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    StateCache::enable(GL_DEPTH_TEST, false);
+    glBeginQuery(GL_SAMPLES_PASSED, mQueries[mIdxQuery][aIdxEye]);
+    mQuadPtr->draw(aMatrixAttrib, aMatrixBuffer, aQuadOffset, 1, 0, aRenderStats, true);
+    glEndQuery(GL_SAMPLES_PASSED);
+    mbPending[mIdxQuery][aIdxEye] = true;
+
+    StateCache::enable(GL_DEPTH_TEST, true);
+    StateCache::colorMask(true);
+    StateCache::enable(GL_STENCIL_TEST, false);
+}
+
+/**
+ * @brief Start the world draws of an eye: rejected where masked, and skipped by the GPU if the whole eye is masked
+ *
+ *  The per-Node conditional renders of the occlusion culling cannot be nested inside (see isConditional()):
+ * their draws are then emitted unconditionally.
+ *
+ * @param[in] aIdxEye   Index of the eye (0 for left, 1 for right)
+ */
+void CockpitMask::beginWorld(int aIdxEye) {
+    StateCache::enable(GL_STENCIL_TEST, true);
+    StateCache::stencilFunc(GL_NOTEQUAL, _masked, 0xFF);
+    StateCache::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    glBeginConditionalRender(mQueries[mIdxQuery][aIdxEye], GL_QUERY_WAIT);
+    mbConditional = true;
+}
+
+/**
+ * @brief Stop the world draws of an eye
+ */
+void CockpitMask::endWorld() {
+    glEndConditionalRender();
+    mbConditional = false;
+    StateCache::enable(GL_STENCIL_TEST, false);
+}
+
+/**
+ * @brief End of the frame: move to the next queries of the ring, and read the results already available
+ */
+void CockpitMask::endFrame() {
+    mIdxQuery = (mIdxQuery + 1) % NB_QUERIES;
+    for (int idxQuery = 0; idxQuery < NB_QUERIES; ++idxQuery) {
+        for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+            collect(idxQuery, idxEye, false);
+        }
+    }
+}
+
+/**
+ * @brief Read the result of a pending query
+ *
+ * @param[in] aIdxQuery Index of the queries in the ring
+ * @param[in] aIdxEye   Index of the eye (0 for left, 1 for right)
+ * @param[in] abWait    Wait for the result if not yet available
+ */
+void CockpitMask::collect(int aIdxQuery, int aIdxEye, bool abWait) {
+    if (mbPending[aIdxQuery][aIdxEye]) {
+        const GLuint query = mQueries[aIdxQuery][aIdxEye];
+        GLint bAvailable = GL_FALSE;
+        if (false == abWait) {
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+        }
+        if (abWait || (GL_FALSE != bAvailable)) {
+            GLuint64 nbUncovered = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nbUncovered);
+            if (0 < mNbSamples) {
+                const double uncovered = static_cast<double>(nbUncovered) / mNbSamples;
+                mSumCoverage += (uncovered < 1.0) ? (1.0 - uncovered) : 0.0;
+                ++mNbResults;
+            }
+            if (0 == nbUncovered) {
+                ++mNbMaskedEyes;
+            }
+            mbPending[aIdxQuery][aIdxEye] = false;
+        }
+    }
+}
@@ -0,0 +1,137 @@
+/**
+ * @file    CockpitMask.h
+ * @ingroup Main
+ * @brief   Stencil mask of the cockpit, rejecting the pixels of the outside world it covers
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Main/Mesh.h"
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::mat4 (GLM_FORCE_RADIANS defined at the project level)
+
+#include <cstddef>          // size_t
+
+class RenderStats;
+
+/**
+ * @brief   Stencil mask of the cockpit, rejecting the pixels of the outside world it covers
+ * @ingroup Main
+ *
+ *  The cockpit surrounds the eyes and covers a large part of the view: the Meshes of the models marked "mask"
+ * (the cockpit interior, or an authored mask Mesh, see SceneManifest) are drawn first into each eye, by the depth
+ * only program, writing 1 into the stencil buffer and their depth. The outside world is then drawn with a stencil
+ * test rejecting these pixels before any shading, even without any depth pre-pass.
+ *
+ *  At the end of the mask pass of each eye, a quad covering the whole viewport is drawn without any depth test
+ * nor any write, where the stencil is still 0, inside a GL_SAMPLES_PASSED query: it counts the samples left
+ * uncovered by the mask. The world draws of the eye are then emitted under a conditional render on this query,
+ * so that the GPU skips all of them when the mask covers the whole eye, without any CPU stall.
+ *  Like the OverdrawMeter, the queries are a ring read a few frames later, to measure the average coverage.
+ */
+class CockpitMask {
+public:
+    CockpitMask();
+    ~CockpitMask(); // not virtual because no virtual methods and class not derived
+
+    // Generate the queries, with the unit cube [-1,1] flattened into the quad covering the viewport
+    void init(const Mesh::Ptr& aQuadPtr);
+    inline bool isEnabled() const;
+    // Set the number of samples of the viewport of an eye
+    inline void setNbSamples(unsigned int aNbSamples);
+
+    // "Quad to Camera" matrix placing the unit cube over the whole view, just in front of the camera
+    static glm::mat4 getQuadMatrix(const glm::mat4& aCameraToClipMatrix);
+
+    // Mask pass of an eye: the draws between beginMask() and endMask() write 1 into the stencil
+    void beginMask();
+    void endMask(int aIdxEye, GLuint aMatrixAttrib, GLuint aMatrixBuffer, size_t aQuadOffset,
+                 RenderStats& aRenderStats);
+    // World draws of an eye: rejected where masked, and skipped by the GPU if the whole eye is masked
+    void beginWorld(int aIdxEye);
+    void endWorld();
+    inline bool isConditional() const;
+    // End of the frame: move to the next queries of the ring
+    void endFrame();
+
+    // Average fraction of the samples covered by the mask, and number of eyes fully masked, since the last reset()
+    inline float        getAverageCoverage() const;
+    inline unsigned int getNbMaskedEyes() const;
+    inline void         reset();
+
+private:
+    // Read the result of a pending query
+    void collect(int aIdxQuery, int aIdxEye, bool abWait);
+
+private:
+    /// Number of queries per eye in the ring, enough to never wait for a result
+    static const int NB_QUERIES = 4;
+
+    Mesh::Ptr       mQuadPtr;                   ///< Unit cube [-1,1] flattened into the quad covering the viewport
+    GLuint          mQueries[NB_QUERIES][2];    ///< Ring of queries of the samples left uncovered, for each eye
+    bool            mbPending[NB_QUERIES][2];   ///< Tell if the result of a query is still to be read
+    int             mIdxQuery;                  ///< Index of the queries of the current frame
+    bool            mbConditional;              ///< Tell if the world draws are under a conditional render
+
+    unsigned int    mNbSamples;                 ///< Number of samples of the viewport of an eye
+    double          mSumCoverage;               ///< Sum of the fraction of the samples masked, since reset()
+    unsigned int    mNbResults;                 ///< Number of results measured since reset()
+    unsigned int    mNbMaskedEyes;              ///< Number of results without any sample uncovered, since reset()
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(CockpitMask);
+};
+
+
+/**
+ * @brief Tell if the cockpit mask is enabled (see init())
+ */
+inline bool CockpitMask::isEnabled() const {
+    return (nullptr != mQuadPtr.get());
+}
+
+/**
+ * @brief Set the number of samples of the viewport of an eye, on each reshape (pixels times multisampling)
+ */
+inline void CockpitMask::setNbSamples(unsigned int aNbSamples) {
+    mNbSamples = aNbSamples;
+}
+
+/**
+ * @brief Tell if the world draws are under the conditional render of the mask (which cannot be nested)
+ */
+inline bool CockpitMask::isConditional() const {
+    return mbConditional;
+}
+
+/**
+ * @brief Get the average fraction of the samples covered by the mask, since the last reset()
+ */
+inline float CockpitMask::getAverageCoverage() const {
+    return (0 < mNbResults) ? static_cast<float>(mSumCoverage / mNbResults) : 0.0f;
+}
+
+/**
+ * @brief Get the number of eyes fully covered by the mask (whose world draws were skipped), since the last reset()
+ */
+inline unsigned int CockpitMask::getNbMaskedEyes() const {
+    return mNbMaskedEyes;
+}
+
+/**
+ * @brief Reset the average coverage (start a new interval)
+ */
+inline void CockpitMask::reset() {
+    mSumCoverage    = 0.0;
+    mNbResults      = 0;
+    mNbMaskedEyes   = 0;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file    DrawList.h
+ * @ingroup Main
+ * @brief   Flat list of the draw calls of a frame, collected from the Scene hierarchy
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLsizei, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::mat4
+
+#include <vector>           // std::vector
+#include <utility>          // std::pair
+#include <functional>       // std::hash
+#include <cstddef>          // size_t
+
+class Mesh;
+
+/**
+ * @brief   Draw call of a Mesh, with its "Model to Camera" matrix
+ * @ingroup Main
+ *
+ *  Collecting all draw calls of a frame first lets the draws of a same Mesh be grouped into one instanced
+ * draw call, and all the matrices be written into the UploadRing at once, before any draw call
+ * (which is required when the ring is not persistently mapped).
+ */
+struct DrawItem {
+    const Mesh*     mpMesh;             ///< Mesh to draw
+    unsigned int    mLod;               ///< Level of detail of the Mesh to draw
+    glm::mat4   mModelToCameraMatrix;   ///< "Model to Camera" matrix of the instance
+    GLuint          mQuery;             ///< Occlusion query of the conditional render of the instance (or 0)
+};
+
+/// Flat list of the draw calls of a frame, in the order of the Scene hierarchy traversal
+typedef std::vector<DrawItem> DrawList;
+
+/**
+ * @brief   Instanced draw call of a Mesh, with the contiguous matrices of its instances in the matrix buffer
+ * @ingroup Main
+ */
+struct DrawBatch {
+    const Mesh* mpMesh;         ///< Mesh to draw
+    unsigned int mLod;          ///< Level of detail of the Mesh to draw
+    size_t      mMatrixOffset;  ///< Offset in bytes of the matrix of the first instance in the matrix buffer
+    GLsizei     mNbInstances;   ///< Number of instances to draw
+    GLuint      mQuery;         ///< Occlusion query of the conditional render of the draw call (or 0)
+};
+
+/// List of the instanced draw calls of a frame, in the order of the first occurrence of each Mesh
+typedef std::vector<DrawBatch> DrawBatchList;
+
+/**
+ * @brief   Instanced draw call of the impostors of a frame, with their contiguous data in the matrix buffer
+ * @ingroup Main
+ *
+ *  The impostors of all Meshes are drawn at once, sampling the same atlas (see ImpostorAtlas).
+ */
+struct ImpostorBatch {
+    size_t      mInstanceOffset;    ///< Offset in bytes of the data of the first impostor in the matrix buffer
+    GLsizei     mNbInstances;       ///< Number of impostors to draw
+};
+
+/// Key of a DrawBatch: instances of a same Mesh are grouped by level of detail
+typedef std::pair<const Mesh*, unsigned int> DrawBatchKey;
+
+/**
+ * @brief   Hash of a DrawBatchKey, for std::unordered_map
+ * @ingroup Main
+ */
+struct DrawBatchKeyHash {
+    /// Levels of detail are few: mix them into the low bits of the hash of the Mesh
+    inline size_t operator()(const DrawBatchKey& aKey) const {
+        return std::hash<const Mesh*>()(aKey.first) ^ aKey.second;
+    }
+};
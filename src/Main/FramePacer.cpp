@@ -0,0 +1,77 @@
+/**
+ * @file    FramePacer.cpp
+ * @ingroup Main
+ * @brief   Bound the number of frames in flight between the CPU and the GPU with fence sync objects
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/FramePacer.h"
+#include "Utils/Measure.h"
+
+#include <algorithm>    // std::min, std::max
+
+/// Timeout of a single wait for a fence, in nanoseconds (then, the wait is logged and started again)
+static const GLuint64 _waitTimeoutNs = 1000000000;
+
+/**
+ * @brief Constructor
+ *
+ * @param[in] aNbFramesInFlight Number of frames in flight (clamped between 1 and MAX_FRAMES_IN_FLIGHT)
+ */
+FramePacer::FramePacer(unsigned int aNbFramesInFlight) :
+    mLog("FramePacer"),
+    mNbFramesInFlight(std::max(1U, std::min(aNbFramesInFlight, MAX_FRAMES_IN_FLIGHT))),
+    mFrameIndex(0),
+    mSumWaitUs(0),
+    mNbWaits(0) {
+    for (unsigned int idxSlot = 0; idxSlot < MAX_FRAMES_IN_FLIGHT; ++idxSlot) {
+        mFences[idxSlot] = nullptr;
+    }
+    mLog.notice() << mNbFramesInFlight << " frame(s) in flight";
+}
+
+/**
+ * @brief Destructor
+ */
+FramePacer::~FramePacer() {
+    for (unsigned int idxSlot = 0; idxSlot < MAX_FRAMES_IN_FLIGHT; ++idxSlot) {
+        if (nullptr != mFences[idxSlot]) {
+            glDeleteSync(mFences[idxSlot]);
+        }
+    }
+}
+
+/**
+ * @brief Start a new frame: wait for the GPU to complete the frame previously submitted in the same slot
+ */
+void FramePacer::beginFrame() {
+    GLsync& fence = mFences[getFrameSlot()];
+    if (nullptr != fence) {
+        Utils::Measure measure;
+        // Flush the command stream, so that the fence is sure to be signaled in a finite time
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, _waitTimeoutNs);
+        while (GL_TIMEOUT_EXPIRED == result) {
+            mLog.warning() << "beginFrame: frame " << mFrameIndex - mNbFramesInFlight << " not completed after 1s";
+            result = glClientWaitSync(fence, 0, _waitTimeoutNs);
+        }
+        if (GL_WAIT_FAILED == result) {
+            mLog.error() << "beginFrame: glClientWaitSync failed";
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+        mSumWaitUs += measure.diff();
+    }
+    ++mNbWaits;
+}
+
+/**
+ * @brief End the current frame: insert a fence after its commands, and go to the next frame slot
+ */
+void FramePacer::endFrame() {
+    mFences[getFrameSlot()] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++mFrameIndex;
+}
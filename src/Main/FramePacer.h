@@ -0,0 +1,104 @@
+/**
+ * @file    FramePacer.h
+ * @ingroup Main
+ * @brief   Bound the number of frames in flight between the CPU and the GPU with fence sync objects
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "LoggerCpp/LoggerCpp.h"
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLsync, and OpenGL 3.3 core function APIs
+
+/**
+ * @brief   Bound the number of frames in flight between the CPU and the GPU with fence sync objects
+ * @ingroup Main
+ *
+ *  A fence is inserted at the end of each frame into the GPU command stream. Before starting a new frame,
+ * the CPU waits for the fence of the frame submitted "frames in flight" frames ago, so that:
+ * - with 1 frame in flight, the CPU waits for the GPU to finish the previous frame (lowest latency, for VR),
+ * - with 2 or 3 frames in flight, the CPU can prepare the next frames while the GPU works (best throughput).
+ *
+ *  The frame slot (between 0 and "frames in flight" - 1) is used to index per-frame buffer rings:
+ * when beginFrame() returns, the data written for this slot "frames in flight" frames ago are no more in use.
+ */
+class FramePacer {
+public:
+    /// Maximum number of frames in flight
+    static const unsigned int MAX_FRAMES_IN_FLIGHT = 3;
+
+public:
+    explicit FramePacer(unsigned int aNbFramesInFlight);
+    ~FramePacer(); // not virtual because no virtual methods and class not derived
+
+    // Frame boundaries: wait for the slot of the new frame to be available, and insert the fence of the frame
+    void beginFrame();
+    void endFrame();
+
+    // Getters
+    inline unsigned int getNbFramesInFlight() const;
+    inline unsigned int getFrameIndex() const;
+    inline unsigned int getFrameSlot() const;
+
+    // Average time spent waiting for the GPU since the last reset()
+    inline float getAverageWaitMs() const;
+    inline void  reset();
+
+private:
+    Log::Logger     mLog;                           ///< Logger object to output runtime information
+
+    const unsigned int  mNbFramesInFlight;          ///< Number of frames in flight (between 1 and 3)
+    GLsync          mFences[MAX_FRAMES_IN_FLIGHT];  ///< Fence of the last frame submitted in each slot
+    unsigned int    mFrameIndex;                    ///< Index of the current frame, since the start
+
+    time_t          mSumWaitUs;                     ///< Sum of the time waiting since reset(), in microseconds
+    unsigned int    mNbWaits;                       ///< Number of frames since reset()
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(FramePacer);
+};
+
+
+/**
+ * @brief Get the number of frames in flight
+ */
+inline unsigned int FramePacer::getNbFramesInFlight() const {
+    return mNbFramesInFlight;
+}
+
+/**
+ * @brief Get the index of the current frame, since the start
+ */
+inline unsigned int FramePacer::getFrameIndex() const {
+    return mFrameIndex;
+}
+
+/**
+ * @brief Get the slot of the current frame, to index per-frame buffer rings
+ */
+inline unsigned int FramePacer::getFrameSlot() const {
+    return (mFrameIndex % mNbFramesInFlight);
+}
+
+/**
+ * @brief Get the average time spent waiting for the GPU since the last reset()
+ */
+inline float FramePacer::getAverageWaitMs() const {
+    return (0 < mNbWaits) ? (mSumWaitUs / 1000.0f / mNbWaits) : 0.0f;
+}
+
+/**
+ * @brief Reset the average waiting time (start a new interval)
+ */
+inline void FramePacer::reset() {
+    mSumWaitUs  = 0;
+    mNbWaits    = 0;
+}
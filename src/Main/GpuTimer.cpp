@@ -0,0 +1,77 @@
+/**
+ * @file    GpuTimer.cpp
+ * @ingroup Main
+ * @brief   Non-blocking measurement of the GPU frame time with OpenGL timer queries
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/GpuTimer.h"
+
+/**
+ * @brief Constructor: generate the queries (requires a current OpenGL context)
+ */
+GpuTimer::GpuTimer() :
+    mIdxQuery(0),
+    mSumMs(0.0),
+    mNbResults(0) {
+    glGenQueries(NB_QUERIES, mQueries);
+    for (int idxQuery = 0; idxQuery < NB_QUERIES; ++idxQuery) {
+        mbPending[idxQuery] = false;
+    }
+}
+
+/**
+ * @brief Destructor
+ */
+GpuTimer::~GpuTimer() {
+    glDeleteQueries(NB_QUERIES, mQueries);
+}
+
+/**
+ * @brief Start the timer query of the current frame
+ */
+void GpuTimer::begin() {
+    // Read the result of the oldest query before reusing it (available since long, in practice)
+    collect(mIdxQuery, true);
+    glBeginQuery(GL_TIME_ELAPSED, mQueries[mIdxQuery]);
+}
+
+/**
+ * @brief Stop the timer query of the current frame
+ */
+void GpuTimer::end() {
+    glEndQuery(GL_TIME_ELAPSED);
+    mbPending[mIdxQuery] = true;
+    mIdxQuery = (mIdxQuery + 1) % NB_QUERIES;
+
+    // Read already available results, to keep the average up to date
+    for (int idxQuery = 0; idxQuery < NB_QUERIES; ++idxQuery) {
+        collect(idxQuery, false);
+    }
+}
+
+/**
+ * @brief Read the result of a pending query
+ *
+ * @param[in] aIdxQuery Index of the query in the ring
+ * @param[in] abWait    Wait for the result if not yet available
+ */
+void GpuTimer::collect(int aIdxQuery, bool abWait) {
+    if (mbPending[aIdxQuery]) {
+        GLint bAvailable = GL_FALSE;
+        if (false == abWait) {
+            glGetQueryObjectiv(mQueries[aIdxQuery], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+        }
+        if (abWait || (GL_FALSE != bAvailable)) {
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(mQueries[aIdxQuery], GL_QUERY_RESULT, &elapsedNs);
+            mSumMs += elapsedNs / 1000000.0;
+            ++mNbResults;
+            mbPending[aIdxQuery] = false;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * @file    GpuTimer.h
+ * @ingroup Main
+ * @brief   Non-blocking measurement of the GPU frame time with OpenGL timer queries
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+
+/**
+ * @brief   Non-blocking measurement of the GPU frame time with OpenGL timer queries
+ * @ingroup Main
+ *
+ *  Uses a ring of GL_TIME_ELAPSED queries (core since OpenGL 3.3), so that the result of a frame
+ * is only read a few frames later, when the GPU is done with it, without stalling the CPU.
+ *  Results are averaged until the next call to reset(), typically at the same interval as the FPS calculation.
+ */
+class GpuTimer {
+public:
+    GpuTimer();
+    ~GpuTimer(); // not virtual because no virtual methods and class not derived
+
+    // Frame boundaries: start and stop the timer query of the current frame
+    void begin();
+    void end();
+
+    // Average GPU time of the frames measured since the last reset()
+    inline float getAverageMs() const;
+    inline void  reset();
+
+private:
+    // Read the result of a pending query
+    void collect(int aIdxQuery, bool abWait);
+
+private:
+    /// Number of queries in the ring, enough to never wait for a result
+    static const int NB_QUERIES = 4;
+
+    GLuint          mQueries[NB_QUERIES];   ///< Ring of timer queries
+    bool            mbPending[NB_QUERIES];  ///< Tell if the result of a query is still to be read
+    int             mIdxQuery;              ///< Index of the query of the current frame
+
+    double          mSumMs;                 ///< Sum of the GPU time measured since reset(), in milliseconds
+    unsigned int    mNbResults;             ///< Number of results measured since reset()
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(GpuTimer);
+};
+
+
+/**
+ * @brief Get the average GPU time of the frames measured since the last reset()
+ */
+inline float GpuTimer::getAverageMs() const {
+    return (0 < mNbResults) ? static_cast<float>(mSumMs / mNbResults) : 0.0f;
+}
+
+/**
+ * @brief Reset the average GPU time (start a new interval)
+ */
+inline void GpuTimer::reset() {
+    mSumMs      = 0.0;
+    mNbResults  = 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file    HiddenArea.cpp
+ * @ingroup Main
+ * @brief   Hidden area of the lenses of the HMD: pixels of each eye never seen through the lens distortion
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/HiddenArea.h"
+
+#include <cmath>    // fabs
+
+
+/// Relative margin pushing the outline outward, so that the chords between two rays never hide a pixel seen
+static const float _outlineMargin   = 1.02f;
+/// Distance of the hidden area relative to the near plane (just beyond it, to never be clipped)
+static const float _nearMargin      = 1.001f;
+
+
+/**
+ * @brief Constructor (disabled until setMesh())
+ */
+HiddenArea::HiddenArea() {
+}
+
+/**
+ * @brief Destructor
+ */
+HiddenArea::~HiddenArea() {
+}
+
+/**
+ * @brief Make the Mesh of the hidden area of an eye from the lens distortion, to be uploaded like any other Mesh
+ *
+ *  Works in the space of the lens: centered on the lens, with y divided by the aspect ratio, where the distortion
+ * is radial. A point of the border of the viewport at the radius r is seen through the lens at the radius
+ * r.(K0 + K1.r^2 + K2.r^4 + K3.r^6) / scale of the rendered image: when nearer than r, the rendered pixels
+ * between them along this ray are hidden.
+ *
+ * @param[in]  aDistortion  Lens distortion of the left eye (mirrored for the right eye)
+ * @param[in]  aIdxEye      Index of the eye (0 for left, 1 for right)
+ * @param[out] aMeshData    Vertex data (position, color, and normal) and indices of the hidden area, in the
+ *                          normalized device coordinates of the viewport of the eye
+ *
+ * @return Fraction of the viewport hidden (between 0 and 1)
+ */
+float HiddenArea::make(const OculusHMD::Distortion& aDistortion, int aIdxEye, MeshData& aMeshData) {
+    aMeshData.mName = (0 == aIdxEye) ? "hidden area left" : "hidden area right";
+    aMeshData.mVertexData.clear();
+    aMeshData.mIndexData.clear();
+    aMeshData.mLods.clear();
+
+    // Corners of the viewport in the space of the lens, counter clockwise
+    const float center = (0 == aIdxEye) ? aDistortion.mCenterOffset : -aDistortion.mCenterOffset;
+    const float halfHeight = 1.0f / aDistortion.mAspect;
+    const glm::vec2 corners[4] = {
+        glm::vec2(-1.0f - center, -halfHeight), glm::vec2(1.0f - center, -halfHeight),
+        glm::vec2(1.0f - center, halfHeight), glm::vec2(-1.0f - center, halfHeight)
+    };
+
+    // Points of the border where the rays cross it, and the fraction of their radius seen through the lens
+    const int nbRays = 4 * NB_RAYS_PER_SIDE;
+    glm::vec2 borders[4 * NB_RAYS_PER_SIDE];
+    float     outlines[4 * NB_RAYS_PER_SIDE];
+    for (int idxRay = 0; idxRay < nbRays; ++idxRay) {
+        const int side = idxRay / NB_RAYS_PER_SIDE;
+        const float step = static_cast<float>(idxRay % NB_RAYS_PER_SIDE) / NB_RAYS_PER_SIDE;
+        borders[idxRay] = glm::mix(corners[side], corners[(side + 1) % 4], step);
+        const float rSq = glm::dot(borders[idxRay], borders[idxRay]);
+        const float* pK = aDistortion.mK;
+        const float seen = (pK[0] + rSq * (pK[1] + rSq * (pK[2] + rSq * pK[3]))) / aDistortion.mScale;
+        outlines[idxRay] = (seen * _outlineMargin < 1.0f) ? seen * _outlineMargin : 1.0f;
+    }
+
+    // A quad between the outline and the border for each pair of rays, back in normalized device coordinates
+    float area = 0.0f;
+    for (int idxRay = 0; idxRay < nbRays; ++idxRay) {
+        const int idxNext = (idxRay + 1) % nbRays;
+        if ((1.0f <= outlines[idxRay]) && (1.0f <= outlines[idxNext])) {
+            continue;
+        }
+        const glm::vec2 quad[4] = {
+            borders[idxRay] * outlines[idxRay], borders[idxRay], borders[idxNext], borders[idxNext] * outlines[idxNext]
+        };
+        const GLshort firstVertex = static_cast<GLshort>(aMeshData.mVertexData.size() / 3);
+        glm::vec2 positions[4];
+        for (int idxVertex = 0; idxVertex < 4; ++idxVertex) {
+            positions[idxVertex] = glm::vec2(quad[idxVertex].x + center, quad[idxVertex].y * aDistortion.mAspect);
+            aMeshData.mVertexData.push_back(glm::vec3(positions[idxVertex], 0.0f));
+            aMeshData.mVertexData.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+            aMeshData.mVertexData.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+        }
+        // Two triangles, counter clockwise seen from the camera
+        const GLshort indices[6] = {0, 1, 2, 0, 2, 3};
+        for (int idxIndex = 0; idxIndex < 6; ++idxIndex) {
+            aMeshData.mIndexData.push_back(static_cast<GLshort>(firstVertex + indices[idxIndex]));
+        }
+        const glm::vec2 diagonal = positions[2] - positions[0];
+        const glm::vec2 side1 = positions[1] - positions[0];
+        const glm::vec2 side3 = positions[3] - positions[0];
+        area += 0.5f * (fabs(side1.x * diagonal.y - side1.y * diagonal.x)
+                      + fabs(diagonal.x * side3.y - diagonal.y * side3.x));
+    }
+
+    // The viewport spans [-1,1] in both directions
+    return area / 4.0f;
+}
+
+/**
+ * @brief "Hidden Area to Camera" matrix placing the normalized device coordinates just beyond the near plane
+ *
+ *  Its depth is nearly the nearest one: the fragments of the Scene behind it fail the early depth test.
+ *
+ * @param[in] aCameraToClipMatrix   "Camera to Clip" matrix of the perspective projection
+ * @param[in] aNearDistance         Distance of the near plane of the frustum
+ *
+ * @return "Hidden Area to Camera" matrix, the same for both eyes
+ */
+glm::mat4 HiddenArea::getMatrix(const glm::mat4& aCameraToClipMatrix, float aNearDistance) {
+    const float distance = aNearDistance * _nearMargin;
+    glm::mat4 hiddenToCamera(1.0f);
+    hiddenToCamera[0][0] = distance / aCameraToClipMatrix[0][0];
+    hiddenToCamera[1][1] = distance / aCameraToClipMatrix[1][1];
+    // The camera looks toward -Z
+    hiddenToCamera[3] = glm::vec4(0.0f, 0.0f, -distance, 1.0f);
+    return hiddenToCamera;
+}
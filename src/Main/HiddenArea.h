@@ -0,0 +1,84 @@
+/**
+ * @file    HiddenArea.h
+ * @ingroup Main
+ * @brief   Hidden area of the lenses of the HMD: pixels of each eye never seen through the lens distortion
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Main/Mesh.h"
+#include "Main/ModelData.h"
+#include "Main/OculusHMD.h"
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::mat4 (GLM_FORCE_RADIANS defined at the project level)
+
+/**
+ * @brief   Hidden area of the lenses of the HMD: pixels of each eye never seen through the lens distortion
+ * @ingroup Main
+ *
+ *  The distortion of the lenses is radial around their center: each pixel of the screen samples the rendered
+ * image of its eye further away from the lens center (see OculusHMD::Distortion). The screen only samples the
+ * rendered image inside the distorted outline of its own viewport, so the rendered pixels beyond this outline
+ * (along the side of the nose and in the corners) are never seen, but would still be rasterized and shaded.
+ *
+ *  make() generates the Mesh of this hidden area for each eye: rays from the lens center through points along
+ * the border of the viewport give the radius of the outline in each direction, and each pair of rays gives
+ * a quad between the outline and the border. The Mesh is in the normalized device coordinates of the viewport,
+ * and is placed just beyond the near plane by getMatrix(), so that it hides the Scene behind it from the early
+ * depth test when drawn first into each eye (as well as from the stencil test of the CockpitMask).
+ */
+class HiddenArea {
+public:
+    HiddenArea();
+    ~HiddenArea(); // not virtual because no virtual methods and class not derived
+
+    // Make the Mesh of the hidden area of an eye from the lens distortion, returning the fraction of the viewport
+    static float make(const OculusHMD::Distortion& aDistortion, int aIdxEye, MeshData& aMeshData);
+    // "Hidden Area to Camera" matrix placing the normalized device coordinates just beyond the near plane
+    static glm::mat4 getMatrix(const glm::mat4& aCameraToClipMatrix, float aNearDistance);
+
+    // Mesh of each eye (uploaded from make())
+    inline void setMesh(int aIdxEye, const Mesh::Ptr& aMeshPtr);
+    inline const Mesh& getMesh(int aIdxEye) const;
+    inline bool isEnabled() const;
+
+private:
+    /// Number of rays through each side of the viewport
+    static const int NB_RAYS_PER_SIDE = 32;
+
+    Mesh::Ptr   mMeshPtrs[2];   ///< Mesh of the hidden area of each eye (empty if disabled)
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(HiddenArea);
+};
+
+
+/**
+ * @brief Set the Mesh of the hidden area of an eye (uploaded from make())
+ */
+inline void HiddenArea::setMesh(int aIdxEye, const Mesh::Ptr& aMeshPtr) {
+    mMeshPtrs[aIdxEye] = aMeshPtr;
+}
+
+/**
+ * @brief Get the Mesh of the hidden area of an eye
+ */
+inline const Mesh& HiddenArea::getMesh(int aIdxEye) const {
+    return *mMeshPtrs[aIdxEye];
+}
+
+/**
+ * @brief Tell if the hidden area is enabled (Meshes of both eyes set)
+ */
+inline bool HiddenArea::isEnabled() const {
+    return mMeshPtrs[0] && mMeshPtrs[1];
+}
@@ -0,0 +1,487 @@
+/**
+ * @file    ImpostorAtlas.cpp
+ * @ingroup Main
+ * @brief   Atlas of octahedral views of Meshes, drawn as camera-facing quads when far away
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/ImpostorAtlas.h"
+#include "Main/Mesh.h"
+#include "Main/ShaderProgram.h"
+#include "Main/StateCache.h"
+#include "Utils/Exception.h"
+
+#include <glm/gtc/matrix_transform.hpp> // glm::lookAt, glm::ortho
+
+#include <vector>
+#include <algorithm>    // std::min, std::max
+#include <cmath>        // fabs
+
+static const int    _nbViews            = 8;    ///< Number of views per side of the octahedral grid of a slot
+static const int    _viewSize           = 32;   ///< Size of a view in texels
+static const int    _slotSize           = _nbViews * _viewSize; ///< Size of a slot in texels
+static const int    _atlasSize          = 2048; ///< Size of the atlas textures in texels
+static const int    _nbSlotsPerSide     = _atlasSize / _slotSize;   ///< Number of slots per side of the atlas
+static const int    _maxRendersPerFrame = 2;    ///< Maximum number of Meshes whose views are rendered each frame
+
+static const GLuint _cornerAttrib       = 0;    ///< layout(location = 0) in vec2 corner;
+static const GLuint _instanceAttrib     = 1;    ///< layout(location = 1) in mat4 impostor;
+
+/// Uniforms of the program drawing the impostors, in the order of ImpostorAtlas::ImpostorUniform
+static const ProgramInterface::Descriptor _impostorUniforms[] = {
+    {"cameraToClipMatrix",  GL_FLOAT_MAT4,  -1, true},
+    {"dirToLight",          GL_FLOAT_VEC3,  -1, true},
+    {"lightIntensity",      GL_FLOAT_VEC4,  -1, true},
+    {"ambientIntensity",    GL_FLOAT_VEC4,  -1, true},
+    {"colorAtlas",          GL_SAMPLER_2D,  -1, true},
+    {"normalDepthAtlas",    GL_SAMPLER_2D,  -1, true}
+};
+/// Uniforms of the program rendering the views, in the order of ImpostorAtlas::ViewUniform
+static const ProgramInterface::Descriptor _viewUniforms[] = {
+    {"cameraToClipMatrix",  GL_FLOAT_MAT4,  -1, true}
+};
+
+/**
+ * @brief Octahedral mapping of a unit direction to [0,1]x[0,1]
+ *
+ *  The upper hemisphere (z >= 0) fills the inner diamond, and the lower one is folded over the corners.
+ */
+static glm::vec2 encodeOctahedral(const glm::vec3& aDirection) {
+    const float sum = fabs(aDirection.x) + fabs(aDirection.y) + fabs(aDirection.z);
+    float x = aDirection.x / sum;
+    float y = aDirection.y / sum;
+    if (0.0f > aDirection.z) {
+        const float foldedX = (1.0f - fabs(y)) * ((0.0f <= x) ? 1.0f : -1.0f);
+        const float foldedY = (1.0f - fabs(x)) * ((0.0f <= y) ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    return glm::vec2(x * 0.5f + 0.5f, y * 0.5f + 0.5f);
+}
+
+/**
+ * @brief Unit direction of a point of [0,1]x[0,1], inverse of the octahedral mapping
+ */
+static glm::vec3 decodeOctahedral(const glm::vec2& aCoords) {
+    glm::vec3 direction(aCoords.x * 2.0f - 1.0f, aCoords.y * 2.0f - 1.0f, 0.0f);
+    direction.z = 1.0f - fabs(direction.x) - fabs(direction.y);
+    if (0.0f > direction.z) {
+        const float fold = -direction.z;
+        direction.x += (0.0f <= direction.x) ? -fold : fold;
+        direction.y += (0.0f <= direction.y) ? -fold : fold;
+    }
+    return glm::normalize(direction);
+}
+
+
+/**
+ * @brief Constructor: compile the programs and allocate the atlas (requires a current OpenGL context)
+ */
+ImpostorAtlas::ImpostorAtlas() :
+    mLog("ImpostorAtlas"),
+    mProgram(0),
+    mRenderProgram(0),
+    mColorTexture(0),
+    mNormalDepthTexture(0),
+    mDepthRenderbuffer(0),
+    mFramebuffer(0),
+    mViewMatrixBuffer(0),
+    mQuadBuffer(0),
+    mQuadVertexArray(0),
+    mSlots(_nbSlotsPerSide * _nbSlotsPerSide),
+    mFrame(0) {
+    // Direction and axes of each view, at the center of its cell of the octahedral grid
+    for (int idxRow = 0; idxRow < _nbViews; ++idxRow) {
+        for (int idxColumn = 0; idxColumn < _nbViews; ++idxColumn) {
+            const glm::vec3 direction = decodeOctahedral(glm::vec2((idxColumn + 0.5f) / _nbViews,
+                                                                   (idxRow + 0.5f) / _nbViews));
+            const glm::vec3 up = (0.99f > fabs(direction.y)) ? glm::vec3(0.0f, 1.0f, 0.0f)
+                                                             : glm::vec3(0.0f, 0.0f, 1.0f);
+            const glm::vec3 right = glm::normalize(glm::cross(up, direction));
+            mViewDirs.push_back(direction);
+            mViewRights.push_back(right);
+            mViewUps.push_back(glm::cross(direction, right));
+        }
+    }
+    for (size_t idxSlot = 0; idxSlot < mSlots.size(); ++idxSlot) {
+        const Slot freeSlot = {std::weak_ptr<const Mesh>(), nullptr, 0, false};
+        mSlots[idxSlot] = freeSlot;
+    }
+
+    initPrograms();
+    initFramebuffer();
+    initQuad();
+    mLog.info() << mSlots.size() << " slots of " << _nbViews << "x" << _nbViews << " views of "
+                << _viewSize << "x" << _viewSize << " texels";
+}
+
+/**
+ * @brief Destructor
+ */
+ImpostorAtlas::~ImpostorAtlas() {
+    StateCache::deleteVertexArray(mQuadVertexArray);
+    StateCache::deleteBuffer(mQuadBuffer);
+    StateCache::deleteBuffer(mViewMatrixBuffer);
+    glDeleteFramebuffers(1, &mFramebuffer);
+    glDeleteRenderbuffers(1, &mDepthRenderbuffer);
+    glDeleteTextures(1, &mNormalDepthTexture);
+    glDeleteTextures(1, &mColorTexture);
+    glDeleteProgram(mRenderProgram);
+    glDeleteProgram(mProgram);
+}
+
+/**
+ * @brief Compile the program drawing the impostors, and the one rendering their views
+ */
+void ImpostorAtlas::initPrograms() {
+    static_assert(sizeof(_impostorUniforms) / sizeof(_impostorUniforms[0]) == eNbImpostorUniforms,
+                  "one Descriptor per slot");
+    static_assert(sizeof(_viewUniforms) / sizeof(_viewUniforms[0]) == eNbViewUniforms, "one Descriptor per slot");
+
+    ShaderProgram impostorProgram;
+    mProgram = impostorProgram.makeProgram("data/Impostor.vert", "data/Impostor.frag");
+    mInterface.reflect(mProgram);
+    mInterface.bindUniforms(_impostorUniforms, eNbImpostorUniforms);
+    StateCache::useProgram(mProgram);
+    mInterface.setUniform(eColorAtlasUnif, 0);       // GL_TEXTURE0
+    mInterface.setUniform(eNormalDepthAtlasUnif, 1); // GL_TEXTURE1
+
+    ShaderProgram renderProgram;
+    mRenderProgram = renderProgram.makeProgram("data/ImpostorView.vert", "data/ImpostorView.frag");
+    mRenderInterface.reflect(mRenderProgram);
+    mRenderInterface.bindUniforms(_viewUniforms, eNbViewUniforms);
+}
+
+/**
+ * @brief Allocate the textures of the atlas, and the framebuffer rendering into them
+ *
+ * @throw a std::exception if the framebuffer is not complete
+ */
+void ImpostorAtlas::initFramebuffer() {
+    // No mipmaps: impostors are drawn at about the size of their views
+    GLuint* pTextures[] = {&mColorTexture, &mNormalDepthTexture};
+    for (size_t idxTexture = 0; idxTexture < sizeof(pTextures)/sizeof(pTextures[0]); ++idxTexture) {
+        glGenTextures(1, pTextures[idxTexture]);
+        glBindTexture(GL_TEXTURE_2D, *pTextures[idxTexture]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _atlasSize, _atlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &mDepthRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, mDepthRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, _atlasSize, _atlasSize);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &mFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mColorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, mNormalDepthTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthRenderbuffer);
+    const GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, drawBuffers);
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (GL_FRAMEBUFFER_COMPLETE == status) {
+        // Empty slots are transparent
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (GL_FRAMEBUFFER_COMPLETE != status) {
+        UTILS_THROW("ImpostorAtlas: incomplete framebuffer (" << status << ")");
+    }
+
+    glGenBuffers(1, &mViewMatrixBuffer);
+}
+
+/**
+ * @brief Create the unit quad of the impostors, with its per-instance data (given at each draw call)
+ */
+void ImpostorAtlas::initQuad() {
+    // Triangle strip of the corners of the quad
+    const GLfloat corners[] = {-1.0f, -1.0f,   1.0f, -1.0f,   -1.0f, 1.0f,   1.0f, 1.0f};
+    glGenBuffers(1, &mQuadBuffer);
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, mQuadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+    glGenVertexArrays(1, &mQuadVertexArray);
+    StateCache::bindVertexArray(mQuadVertexArray);
+    glEnableVertexAttribArray(_cornerAttrib);
+    glVertexAttribPointer(_cornerAttrib, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), reinterpret_cast<void*>(0));
+    // The per-instance data uses 4 consecutive locations (one per column), like the "Model to Camera" matrices
+    for (GLuint idxColumn = 0; idxColumn < 4; ++idxColumn) {
+        glEnableVertexAttribArray(_instanceAttrib + idxColumn);
+        glVertexAttribDivisor(_instanceAttrib + idxColumn, 1);
+    }
+    StateCache::bindVertexArray(0);
+}
+
+/**
+ * @brief Set the lighting of the impostors (constant intensities)
+ *
+ * @param[in] aLightIntensity   Directional light intensity and color
+ * @param[in] aAmbientIntensity Ambiant light intensity and color
+ */
+void ImpostorAtlas::setLighting(const glm::vec4& aLightIntensity, const glm::vec4& aAmbientIntensity) {
+    StateCache::useProgram(mProgram);
+    mInterface.setUniform(eLightIntensityUnif, aLightIntensity);
+    mInterface.setUniform(eAmbientIntensityUnif, aAmbientIntensity);
+}
+
+/**
+ * @brief Set the perspective projection of the impostors
+ *
+ * @param[in] aCameraToClipMatrix   "Camera to Clip" matrix, the same as the one of the Meshes
+ */
+void ImpostorAtlas::setCameraToClipMatrix(const glm::mat4& aCameraToClipMatrix) {
+    StateCache::useProgram(mProgram);
+    mInterface.setUniform(eCameraToClipMatrixUnif, aCameraToClipMatrix);
+}
+
+/**
+ * @brief Find the slot of the impostor of a Mesh, requesting it if not yet rendered
+ *
+ *  A Mesh without a slot takes a free one (or the one of a freed Mesh), or else the least recently used
+ * one not requested during the last frame (so that a slot still in use is never reassigned); when there
+ * is none, the request is made again by the next frame.
+ *
+ * @param[in] aMesh Mesh to draw as an impostor
+ *
+ * @return Slot of the impostor, or -1 if its views are not yet rendered (draw the Mesh instead)
+ */
+int ImpostorAtlas::request(const Mesh& aMesh) {
+    int idxSlot = -1;
+    SlotIndexMap::const_iterator iSlotIndex = mSlotIndexes.find(&aMesh);
+    if ((mSlotIndexes.end() != iSlotIndex) && mSlots[iSlotIndex->second].mMeshPtr.expired()) {
+        // A freed Mesh, at the address now reused by this one: its views are not those of this Mesh
+        release(iSlotIndex->second);
+        iSlotIndex = mSlotIndexes.end();
+    }
+    if (mSlotIndexes.end() != iSlotIndex) {
+        Slot& slot = mSlots[iSlotIndex->second];
+        slot.mLastUsedFrame = mFrame;
+        if (slot.mbRendered) {
+            idxSlot = iSlotIndex->second;
+        }
+    } else {
+        int idxFree = -1;
+        for (size_t idxCandidate = 0; idxCandidate < mSlots.size(); ++idxCandidate) {
+            const Slot& candidate = mSlots[idxCandidate];
+            if (candidate.mMeshPtr.expired()) {
+                idxFree = static_cast<int>(idxCandidate);
+                break;
+            } else if ((1 < mFrame - candidate.mLastUsedFrame) &&
+                       ((-1 == idxFree) || (candidate.mLastUsedFrame < mSlots[idxFree].mLastUsedFrame))) {
+                idxFree = static_cast<int>(idxCandidate);
+            }
+        }
+        if (-1 != idxFree) {
+            release(idxFree);
+            Slot& slot = mSlots[idxFree];
+            slot.mMeshPtr       = aMesh.shared_from_this();
+            slot.mpMesh         = &aMesh;
+            slot.mLastUsedFrame = mFrame;
+            slot.mbRendered     = false;
+            mSlotIndexes[&aMesh] = idxFree;
+        }
+    }
+    return idxSlot;
+}
+
+/**
+ * @brief Index of the view nearest to a direction in model space
+ *
+ * @param[in] aDirection    Direction toward the camera, in model space (not necessarily normalized)
+ */
+int ImpostorAtlas::getView(const glm::vec3& aDirection) {
+    const float length = glm::length(aDirection);
+    const glm::vec2 coords = encodeOctahedral((0.0f < length) ? (aDirection / length) : glm::vec3(0.0f, 0.0f, 1.0f));
+    const int idxColumn = std::min(static_cast<int>(coords.x * _nbViews), _nbViews - 1);
+    const int idxRow    = std::min(static_cast<int>(coords.y * _nbViews), _nbViews - 1);
+    return idxRow * _nbViews + idxColumn;
+}
+
+/**
+ * @brief Compute the per-instance data of an impostor of a Mesh
+ *
+ *  The quad faces the camera, centered on the bounding sphere, keeping the up axis of the view nearest
+ * to the direction of the camera. The data is packed into the 4 columns of a matrix:
+ * - center of the bounding sphere in camera space, and its radius,
+ * - right axis of the quad in camera space,
+ * - up axis of the quad in camera space,
+ * - texture coordinates of the bottom left corner of the view in the atlas, and its size.
+ *
+ * @param[in]  aMesh                Mesh drawn as an impostor
+ * @param[in]  aSlot                Slot of the impostor (see request())
+ * @param[in]  aModelToCameraMatrix "Model to Camera" matrix of the instance (rigid transformation)
+ * @param[out] aInstance            Per-instance data of the impostor
+ */
+void ImpostorAtlas::getInstance(const Mesh& aMesh, int aSlot, const glm::mat4& aModelToCameraMatrix,
+                                glm::mat4& aInstance) const {
+    const glm::mat3 rotation(aModelToCameraMatrix);
+    const glm::vec3 center(aModelToCameraMatrix * glm::vec4(aMesh.getBoundingCenter(), 1.0f));
+    const float     distance = glm::length(center);
+    const glm::vec3 front = (0.0f < distance) ? (-center / distance) : glm::vec3(0.0f, 0.0f, 1.0f);
+
+    // The inverse of the rotation is its transpose
+    const int idxView = getView(glm::transpose(rotation) * front);
+    const glm::vec3 viewUp = rotation * mViewUps[idxView];
+    const glm::vec3 up = glm::normalize(viewUp - glm::dot(viewUp, front) * front);
+    const glm::vec3 right = glm::cross(up, front);
+
+    const int x = (aSlot % _nbSlotsPerSide) * _slotSize + (idxView % _nbViews) * _viewSize;
+    const int y = (aSlot / _nbSlotsPerSide) * _slotSize + (idxView / _nbViews) * _viewSize;
+    aInstance = glm::mat4(glm::vec4(center, aMesh.getBoundingRadius()),
+                          glm::vec4(right, 0.0f),
+                          glm::vec4(up, 0.0f),
+                          glm::vec4(static_cast<float>(x) / _atlasSize, static_cast<float>(y) / _atlasSize,
+                                    static_cast<float>(_viewSize) / _atlasSize, 0.0f));
+}
+
+/**
+ * @brief Render the views of the requested Meshes (under a budget), and start a new frame
+ *
+ * @param[in] aMatrixAttrib     Location of the "modelToCameraMatrix" per-instance vertex shader attribute
+ * @param[in,out] aRenderStats  Statistics counters of the current frame
+ */
+void ImpostorAtlas::update(GLuint aMatrixAttrib, RenderStats& aRenderStats) {
+    // Release the slots of the Meshes freed since the last frame (see ResourceManager::purge())
+    for (size_t idxSlot = 0; idxSlot < mSlots.size(); ++idxSlot) {
+        if ((nullptr != mSlots[idxSlot].mpMesh) && mSlots[idxSlot].mMeshPtr.expired()) {
+            release(static_cast<int>(idxSlot));
+        }
+    }
+    int nbRenders = 0;
+    for (size_t idxSlot = 0; (idxSlot < mSlots.size()) && (nbRenders < _maxRendersPerFrame); ++idxSlot) {
+        if ((nullptr != mSlots[idxSlot].mpMesh) && (false == mSlots[idxSlot].mbRendered)) {
+            render(static_cast<int>(idxSlot), aMatrixAttrib, aRenderStats);
+            ++nbRenders;
+        }
+    }
+    ++mFrame;
+}
+
+/**
+ * @brief Render the views of a Mesh into its slot
+ *
+ *  Each view is an orthographic projection of the bounding sphere, the camera looking at its center from
+ * twice its radius, so that the depth [0,1] spans the diameter of the sphere.
+ *
+ * @param[in] aSlot             Slot of the Mesh
+ * @param[in] aMatrixAttrib     Location of the "modelToCameraMatrix" per-instance vertex shader attribute
+ * @param[in,out] aRenderStats  Statistics counters of the current frame
+ */
+void ImpostorAtlas::render(int aSlot, GLuint aMatrixAttrib, RenderStats& aRenderStats) {
+    Slot& slot = mSlots[aSlot];
+    const std::shared_ptr<const Mesh> MeshPtr = slot.mMeshPtr.lock();
+    if (!MeshPtr) {
+        release(aSlot);
+        return;
+    }
+    const glm::vec3& center = MeshPtr->getBoundingCenter();
+    const float radius = std::max(MeshPtr->getBoundingRadius(), 0.001f);
+    mLog.debug() << "render(" << aSlot << ") " << MeshPtr->getName();
+
+    // "Model to Camera" matrix of each view
+    std::vector<glm::mat4> viewMatrices(mViewDirs.size());
+    for (size_t idxView = 0; idxView < mViewDirs.size(); ++idxView) {
+        viewMatrices[idxView] = glm::lookAt(center + mViewDirs[idxView] * (2.0f * radius), center, mViewUps[idxView]);
+    }
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, mViewMatrixBuffer);
+    glBufferData(GL_ARRAY_BUFFER, viewMatrices.size() * sizeof(glm::mat4), &viewMatrices[0], GL_STREAM_DRAW);
+
+    const int x = (aSlot % _nbSlotsPerSide) * _slotSize;
+    const int y = (aSlot / _nbSlotsPerSide) * _slotSize;
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    StateCache::enable(GL_BLEND, false); // the alpha of the normal texture is the depth (left disabled afterward)
+    StateCache::enable(GL_SCISSOR_TEST, true);
+    glScissor(x, y, _slotSize, _slotSize);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    StateCache::enable(GL_SCISSOR_TEST, false);
+
+    if (StateCache::useProgram(mRenderProgram)) {
+        aRenderStats.incr(RenderStats::eProgramBinds);
+    }
+    const glm::mat4 cameraToClipMatrix = glm::ortho(-radius, radius, -radius, radius, radius, 3.0f * radius);
+    if (mRenderInterface.setUniform(eViewCameraToClipMatrixUnif, cameraToClipMatrix)) {
+        aRenderStats.incr(RenderStats::eUniformUploads);
+    }
+    for (int idxView = 0; idxView < _nbViews * _nbViews; ++idxView) {
+        StateCache::viewport(x + (idxView % _nbViews) * _viewSize, y + (idxView / _nbViews) * _viewSize,
+                             _viewSize, _viewSize);
+        MeshPtr->draw(aMatrixAttrib, mViewMatrixBuffer, idxView * sizeof(glm::mat4), 1, 0, aRenderStats);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    slot.mbRendered = true;
+}
+
+/**
+ * @brief Free a slot, and forget its Mesh
+ *
+ *  Its key is erased before the address of the Mesh can be reused by a new Mesh, which would otherwise
+ * get the views of the freed one.
+ *
+ * @param[in] aSlot Slot to free
+ */
+void ImpostorAtlas::release(int aSlot) {
+    Slot& slot = mSlots[aSlot];
+    if (nullptr != slot.mpMesh) {
+        mSlotIndexes.erase(slot.mpMesh);
+    }
+    slot.mMeshPtr.reset();
+    slot.mpMesh         = nullptr;
+    slot.mLastUsedFrame = 0;
+    slot.mbRendered     = false;
+}
+
+/**
+ * @brief Draw instances of impostors, with their per-instance data read from a buffer
+ *
+ *  Uses its own program: the caller has to use its program again afterward.
+ *
+ * @param[in] aDirToLight       Vector of directional light orientation in camera space (toward the light)
+ * @param[in] aInstanceBuffer   Buffer containing the per-instance data (see getInstance())
+ * @param[in] aInstanceOffset   Offset in bytes of the data of the first instance in the buffer
+ * @param[in] aNbInstances      Number of instances to draw
+ * @param[in,out] aRenderStats  Statistics counters of the current frame
+ */
+void ImpostorAtlas::draw(const glm::vec3& aDirToLight, GLuint aInstanceBuffer, size_t aInstanceOffset,
+                         GLsizei aNbInstances, RenderStats& aRenderStats) {
+    if (StateCache::useProgram(mProgram)) {
+        aRenderStats.incr(RenderStats::eProgramBinds);
+    }
+    if (mInterface.setUniform(eDirToLightUnif, aDirToLight)) {
+        aRenderStats.incr(RenderStats::eUniformUploads);
+    }
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, mNormalDepthTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mColorTexture);
+
+    if (StateCache::bindVertexArray(mQuadVertexArray)) {
+        aRenderStats.incr(RenderStats::eVaoBinds);
+    }
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, aInstanceBuffer);
+    for (GLuint idxColumn = 0; idxColumn < 4; ++idxColumn) {
+        glVertexAttribPointer(_instanceAttrib + idxColumn, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              reinterpret_cast<void*>(aInstanceOffset + idxColumn * sizeof(glm::vec4)));
+    }
+
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, aNbInstances);
+    aRenderStats.incr(RenderStats::eDrawCalls);
+    aRenderStats.incr(RenderStats::eInstances, aNbInstances);
+    aRenderStats.incr(RenderStats::eTriangles, 2 * aNbInstances);
+    aRenderStats.incr(RenderStats::eImpostors, aNbInstances);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,142 @@
+/**
+ * @file    ImpostorAtlas.h
+ * @ingroup Main
+ * @brief   Atlas of octahedral views of Meshes, drawn as camera-facing quads when far away
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "LoggerCpp/LoggerCpp.h"
+
+#include "Main/RenderStats.h"
+#include "Main/ProgramInterface.h"
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::mat4, glm::vec3... (GLM_FORCE_RADIANS defined at the project level)
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+class Mesh;
+
+/**
+ * @brief   Atlas of octahedral views of Meshes, drawn as camera-facing quads when far away
+ * @ingroup Main
+ *
+ *  Each slot of the atlas holds a grid of views of one Mesh, taken with an orthographic projection of its
+ * bounding sphere from directions spread over the whole sphere by an octahedral mapping: the view
+ * of the cell (u,v) looks from the direction decoded from (u,v), so the nearest view of any direction is
+ * found in constant time by encoding it. Two textures are rendered at once: the diffuse color (alpha 0
+ * outside of the Mesh) and the normal in view space along with the depth, so that impostors are lit
+ * like the Mesh and write a correct depth.
+ *
+ *  Slots are filled lazily: a Mesh is requested when first selected as an impostor (see LodSelector),
+ * drawn at its coarsest level until its views are rendered, under a budget of a few Meshes per frame,
+ * and the least recently used slot is reassigned when the atlas is full.
+ *
+ *  An instance of an impostor is a quad facing the camera, sampling the view nearest to the direction
+ * of the camera; its per-instance data is packed into a glm::mat4, to be streamed along with the
+ * "Model to Camera" matrices of the Meshes.
+ */
+class ImpostorAtlas {
+public:
+    ImpostorAtlas();
+    ~ImpostorAtlas(); // not virtual because no virtual methods and class not derived
+
+    // Set the lighting of the impostors (constant intensities)
+    void setLighting(const glm::vec4& aLightIntensity, const glm::vec4& aAmbientIntensity);
+    // Set the perspective projection of the impostors
+    void setCameraToClipMatrix(const glm::mat4& aCameraToClipMatrix);
+
+    // Find the slot of the impostor of a Mesh, requesting it if not yet rendered (-1)
+    int request(const Mesh& aMesh);
+
+    // Compute the per-instance data of an impostor of a Mesh
+    void getInstance(const Mesh& aMesh, int aSlot, const glm::mat4& aModelToCameraMatrix,
+                     glm::mat4& aInstance) const;
+
+    // Render the views of the requested Meshes (under a budget), and start a new frame
+    void update(GLuint aMatrixAttrib, RenderStats& aRenderStats);
+
+    // Draw instances of impostors, with their per-instance data read from a buffer
+    void draw(const glm::vec3& aDirToLight, GLuint aInstanceBuffer, size_t aInstanceOffset, GLsizei aNbInstances,
+              RenderStats& aRenderStats);
+
+private:
+    /**
+     * @brief Slot of the atlas, containing the views of a Mesh
+     */
+    struct Slot {
+        std::weak_ptr<const Mesh> mMeshPtr; ///< Mesh of the slot (expired if free, or if the Mesh was freed)
+        const Mesh*     mpMesh;             ///< Key of the slot in mSlotIndexes (never dereferenced, or nullptr)
+        unsigned int    mLastUsedFrame;     ///< Last frame the impostor was requested
+        bool            mbRendered;         ///< Tell if the views of the Mesh are rendered
+    };
+
+    /// Slot of each Mesh (an address only matches while the weak pointer of its slot is not expired)
+    typedef std::unordered_map<const Mesh*, int> SlotIndexMap;
+
+    /// Slots of the uniforms of the program drawing the impostors (see ProgramInterface)
+    enum ImpostorUniform {
+        eCameraToClipMatrixUnif,    ///< "Camera to Clip" matrix, defining the perspective projection
+        eDirToLightUnif,            ///< Vector of directional light orientation, in camera space
+        eLightIntensityUnif,        ///< Directional light intensity and color
+        eAmbientIntensityUnif,      ///< Ambiant light intensity and color
+        eColorAtlasUnif,            ///< Texture unit of the color of the views
+        eNormalDepthAtlasUnif,      ///< Texture unit of the normal and depth of the views
+        eNbImpostorUniforms
+    };
+    /// Slots of the uniforms of the program rendering the views (see ProgramInterface)
+    enum ViewUniform {
+        eViewCameraToClipMatrixUnif,    ///< "Camera to Clip" matrix, defining the orthographic projection
+        eNbViewUniforms
+    };
+
+private:
+    void initPrograms();
+    void initFramebuffer();
+    void initQuad();
+
+    // Render the views of a Mesh into its slot
+    void render(int aSlot, GLuint aMatrixAttrib, RenderStats& aRenderStats);
+    // Free a slot, and forget its Mesh
+    void release(int aSlot);
+
+    // Index of the view nearest to a direction in model space
+    static int getView(const glm::vec3& aDirection);
+
+private:
+    Log::Logger mLog;                       ///< Logger object to output runtime information
+
+    GLuint      mProgram;                   ///< Program drawing the impostors
+    ProgramInterface mInterface;            ///< Slots of the uniforms of mProgram
+    GLuint      mRenderProgram;             ///< Program rendering the views of the Meshes into the atlas
+    ProgramInterface mRenderInterface;      ///< Slots of the uniforms of mRenderProgram
+
+    GLuint      mColorTexture;              ///< Diffuse color of the views (alpha 0 outside of the Mesh)
+    GLuint      mNormalDepthTexture;        ///< Normal in view space (xyz) and depth (w) of the views
+    GLuint      mDepthRenderbuffer;         ///< Depth buffer used while rendering the views
+    GLuint      mFramebuffer;               ///< Framebuffer rendering into both textures at once
+    GLuint      mViewMatrixBuffer;          ///< "Model to Camera" matrix of each view of the Mesh being rendered
+    GLuint      mQuadBuffer;                ///< Corners of the unit quad of an impostor
+    GLuint      mQuadVertexArray;           ///< Vertex Array Object of the quad and its per-instance data
+
+    std::vector<glm::vec3>  mViewDirs;      ///< Direction (toward the camera) of each view, in model space
+    std::vector<glm::vec3>  mViewRights;    ///< Right axis of each view, in model space
+    std::vector<glm::vec3>  mViewUps;       ///< Up axis of each view, in model space
+
+    std::vector<Slot>   mSlots;             ///< Slots of the atlas
+    SlotIndexMap        mSlotIndexes;       ///< Slot of each Mesh
+    unsigned int        mFrame;             ///< Index of the current frame
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(ImpostorAtlas);
+};
@@ -0,0 +1,84 @@
+/**
+ * @file    LodSelector.cpp
+ * @ingroup Main
+ * @brief   Selection of the level of detail of a Mesh from its projected screen-space error
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/LodSelector.h"
+#include "Main/Mesh.h"
+
+#include <algorithm>    // std::min, std::max
+
+/// Minimum distance of a Mesh from the eye (the near plane), to keep the projected error finite
+static const float      _minDistance            = 0.1f;
+/// Minimum number of triangles of a Mesh to be drawn as an impostor (a simpler Mesh is cheaper to draw)
+static const GLuint     _minImpostorTriangles   = 256;
+
+/**
+ * @brief Constructor
+ *
+ * @param[in] aMaxPixelError        Maximum projected error in pixels (0 to always draw the full resolution)
+ * @param[in] aImpostorPixelSize    Projected size in pixels under which to draw an impostor (0 for never)
+ * @param[in] aHysteresis           Relative margin around the thresholds before switching levels (like 0.2)
+ */
+LodSelector::LodSelector(float aMaxPixelError, float aImpostorPixelSize, float aHysteresis) :
+    mMaxPixelError(aMaxPixelError),
+    mImpostorPixelSize(aImpostorPixelSize),
+    mHysteresis(aHysteresis),
+    mPixelsPerUnit(1.0f),
+    mIdxEye(0) {
+}
+
+/**
+ * @brief Destructor
+ */
+LodSelector::~LodSelector() {
+}
+
+/**
+ * @brief Select the level of detail of a Mesh, from the one used at the previous frame
+ *
+ *  Nodes only have rigid transformations (rotation and translation), so the radius of the bounding sphere
+ * and the geometric errors are the same in camera space as in model space.
+ *
+ * @param[in] aMesh                 Mesh to draw
+ * @param[in] aModelToCameraMatrix  "Model to Camera" matrix of the instance of the Mesh
+ * @param[in] aCurrentLod           Level of detail of the instance at the previous frame
+ *
+ * @return Level of detail to draw (0 for the full resolution, or IMPOSTOR)
+ */
+unsigned int LodSelector::select(const Mesh& aMesh, const glm::mat4& aModelToCameraMatrix,
+                                 unsigned int aCurrentLod) const {
+    const unsigned int nbLods = aMesh.getNbLods();
+    const bool bImpostor = (0.0f < mImpostorPixelSize) && (_minImpostorTriangles <= aMesh.getNbTriangles(0));
+    unsigned int lod = 0;
+    if (((1 < nbLods) && (0.0f < mMaxPixelError)) || bImpostor) {
+        const glm::vec3 center(aModelToCameraMatrix * glm::vec4(aMesh.getBoundingCenter(), 1.0f));
+        const float centerDistance = glm::length(center);
+        // Diameter of the bounding sphere projected at the distance of its center
+        const float size = 2.0f * aMesh.getBoundingRadius() * mPixelsPerUnit / std::max(centerDistance, _minDistance);
+        const float impostorMargin = (IMPOSTOR == aCurrentLod) ? (1.0f + mHysteresis) : (1.0f - mHysteresis);
+        if (bImpostor && (size < mImpostorPixelSize * impostorMargin)) {
+            lod = IMPOSTOR;
+        } else {
+            // Distance from the eye to the nearest point of the bounding sphere
+            const float distance = std::max(centerDistance - aMesh.getBoundingRadius(), _minDistance);
+            // Geometric error projected to the maximum number of pixels at this distance
+            const float maxError = mMaxPixelError * distance / mPixelsPerUnit;
+
+            lod = std::min(aCurrentLod, nbLods - 1);
+            while ((0 < lod) && (aMesh.getLodError(lod) > maxError * (1.0f + mHysteresis))) {
+                --lod;
+            }
+            while ((lod + 1 < nbLods) && (aMesh.getLodError(lod + 1) < maxError * (1.0f - mHysteresis))) {
+                ++lod;
+            }
+        }
+    }
+    return lod;
+}
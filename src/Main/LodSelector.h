@@ -0,0 +1,91 @@
+/**
+ * @file    LodSelector.h
+ * @ingroup Main
+ * @brief   Selection of the level of detail of a Mesh from its projected screen-space error
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::mat4 (GLM_FORCE_RADIANS defined at the project level)
+
+class Mesh;
+
+/**
+ * @brief   Selection of the level of detail of a Mesh from its projected screen-space error
+ * @ingroup Main
+ *
+ *  The geometric error of a level of detail (see MeshSimplifier) is projected at the distance of the bounding
+ * sphere of the Mesh from the eye, and the coarsest level staying under the maximum error in pixels is drawn.
+ *
+ *  Beyond the coarsest level, a Mesh whose bounding sphere projects under a given size in pixels
+ * is drawn as an impostor instead (see ImpostorAtlas).
+ *
+ *  To avoid popping back and forth when the distance stays around a threshold, a Mesh only switches to
+ * a finer level when its error goes above the maximum plus the hysteresis margin, and to a coarser one
+ * when its error goes below the maximum minus the margin.
+ */
+class LodSelector {
+public:
+    /// Level of detail of a Mesh drawn as an impostor (fits into the unsigned char stored by each Node)
+    static const unsigned int IMPOSTOR = 255;
+
+public:
+    LodSelector(float aMaxPixelError, float aImpostorPixelSize, float aHysteresis);
+    ~LodSelector(); // not virtual because no virtual methods and class not derived
+
+    // Set the projection of the viewport: number of pixels covered by one unit at a distance of one unit
+    inline void setPixelsPerUnit(float aPixelsPerUnit);
+
+    // Set the eye of the following selections
+    inline void setEye(int aIdxEye);
+    inline int  getEye() const;
+
+    // Select the level of detail of a Mesh
+    unsigned int select(const Mesh& aMesh, const glm::mat4& aModelToCameraMatrix, unsigned int aCurrentLod) const;
+
+private:
+    float   mMaxPixelError;     ///< Maximum projected error in pixels (0 to always draw the full resolution)
+    float   mImpostorPixelSize; ///< Projected size in pixels under which to draw an impostor (0 for never)
+    float   mHysteresis;        ///< Relative margin around the maximum error before switching levels
+    float   mPixelsPerUnit;     ///< Number of pixels covered by one unit at a distance of one unit
+    int     mIdxEye;            ///< Index of the eye of the selections (0: left, 1: right)
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(LodSelector);
+};
+
+
+/**
+ * @brief Set the projection of the viewport
+ *
+ * @param[in] aPixelsPerUnit    Number of pixels covered by one unit at a distance of one unit (height of the viewport
+ *                              divided by twice the tangent of half its vertical field of view)
+ */
+inline void LodSelector::setPixelsPerUnit(float aPixelsPerUnit) {
+    mPixelsPerUnit = aPixelsPerUnit;
+}
+
+/**
+ * @brief Set the eye of the following selections (each eye keeps its own level of each Mesh)
+ *
+ * @param[in] aIdxEye   Index of the eye (0: left, 1: right)
+ */
+inline void LodSelector::setEye(int aIdxEye) {
+    mIdxEye = aIdxEye;
+}
+
+/**
+ * @brief Get the eye of the selections
+ */
+inline int LodSelector::getEye() const {
+    return mIdxEye;
+}
@@ -19,6 +19,7 @@
  */
 
 #include "Main/App.h"
+#include "Main/Options.h"
 
 // NOTE: OpengGL 3.3 pointers to core function APIs need to be loaded before any GL function is used
 #include <glload/gl_load.hpp>   // LoadFunctions() Load pointers for function APIs declared in <glload/gl_3_3.h>s
@@ -75,6 +76,13 @@ int main(int argc, char** argv) {
     Log::Manager::configure(configList);
     Log::Logger log("main");
 
+    // Parse the command line options (scene generation, automated measurements...)
+    Options options;
+    if (false == options.parse(argc, argv)) {
+        log.critic() << "invalid arguments\n" << Options::getUsage();
+        return EXIT_FAILURE;
+    }
+
     log.info() << "glfw starting...";
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit()) {
@@ -95,22 +103,29 @@ int main(int argc, char** argv) {
     // Ask for vertical synch (not working by default under Windows Vista/7/8)
     // glfwSwapInterval(1);
 
-    // get the list of monitors (at least one monitor shall be detected)
-    int monitorCount = 0;
-    GLFWmonitor** pMonitorList = glfwGetMonitors(&monitorCount);
-    assert(0 < monitorCount);
-    // if there is only one monitor, use it, but if there is more than one, use the last one
-    // (Oculus Rift is expected to be the second monitor, extending the primary one
-    GLFWmonitor* pMonitor = pMonitorList[monitorCount-1];
-
-    // get the current screen resolution and colour depth of the choosen monitor
-    const GLFWvidmode* pCurrentVideoMod = glfwGetVideoMode(pMonitor);
-    int width = pCurrentVideoMod->width;
-    int height = pCurrentVideoMod->height;
-    log.info() << "fullscreen (" << width << " x " << height << ")";
-
-    // Open a fullscreen window on the last monitor
-    window = glfwCreateWindow(width, height, "Simple example", pMonitor, NULL);
+    if (options.mbHeadless) {
+        // Render into a hidden window (for automated measurements, without taking over the display)
+        glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+        log.info() << "headless (1280 x 800)";
+        window = glfwCreateWindow(1280, 800, "Simple example", NULL, NULL);
+    } else {
+        // get the list of monitors (at least one monitor shall be detected)
+        int monitorCount = 0;
+        GLFWmonitor** pMonitorList = glfwGetMonitors(&monitorCount);
+        assert(0 < monitorCount);
+        // if there is only one monitor, use it, but if there is more than one, use the last one
+        // (Oculus Rift is expected to be the second monitor, extending the primary one
+        GLFWmonitor* pMonitor = pMonitorList[monitorCount-1];
+
+        // get the current screen resolution and colour depth of the choosen monitor
+        const GLFWvidmode* pCurrentVideoMod = glfwGetVideoMode(pMonitor);
+        int width = pCurrentVideoMod->width;
+        int height = pCurrentVideoMod->height;
+        log.info() << "fullscreen (" << width << " x " << height << ")";
+
+        // Open a fullscreen window on the last monitor
+        window = glfwCreateWindow(width, height, "Simple example", pMonitor, NULL);
+    }
     if (!window) {
         glfwTerminate();
         return EXIT_FAILURE;
@@ -130,7 +145,7 @@ int main(int argc, char** argv) {
         try {
             // Create and initialize the application
             // and try to detect an Oculus Rift Head Mounted Display
-            App app(window);
+            App app(window, options);
 
             // Application main Loop
             log.notice() << "main loop starting...";
@@ -10,7 +10,10 @@
  */
 
 #include "Main/Mesh.h"
+#include "Main/RenderStats.h"
+#include "Main/StateCache.h"
 
+#include <vector>
 
 /**
  * @brief Constructor
@@ -30,14 +33,17 @@ Mesh::Mesh(const char* apName,
     mVertexBufferObject(0),
     mIndexBufferObject(0),
     mVertexArrayObject(0),
-    mDrawCall(aPrimitiveType,
-              aElementCount,
-              aIndexDataType,
-              aStartPosition) {
+    mDepthVertexBufferObject(0),
+    mDepthVertexArrayObject(0),
+    mBoundingCenter(0.0f, 0.0f, 0.0f),
+    mBoundingRadius(0.0f) {
+    // The full resolution is the first level of detail
+    mDrawCalls.push_back(IndexedDrawCall(aPrimitiveType, aElementCount, aIndexDataType, aStartPosition));
+    mLodErrors.push_back(0.0f);
 }
 
 /**
- * @brief Initialize the Vertex Buffer, Index Buffer and Vertex Array Objects
+ * @brief Initialize the Vertex Buffer, Index Buffer and Vertex Array Objects, with the full floating point format
  *
  *  Init the VBO (Vertex Buffer Object) with the data of our mesh (vertex positions, colors, and normals),
  * same for the IBO (Index Buffer Object) with short integers pointing to vertex data (forming triangle list),
@@ -48,29 +54,43 @@ Mesh::Mesh(const char* apName,
  * @param[in] aPositionAttrib   Location of the "position" vertex shader attribute (input stream)
  * @param[in] aColorAttrib      Location of the "diffuseColor" vertex shader attribute (input stream)
  * @param[in] aNormalAttrib     Location of the "normal" vertex shader attribute (input stream)
+ * @param[in] aMatrixAttrib     Location of the "modelToCameraMatrix" per-instance vertex shader attribute
  */
 void Mesh::genOpenGlObjects(const VertexData&   aVertexData,
                             const IndexData&    aIndexData,
                             GLuint              aPositionAttrib,
                             GLuint              aColorAttrib,
-                            GLuint              aNormalAttrib) {
+                            GLuint              aNormalAttrib,
+                            GLuint              aMatrixAttrib) {
+    // The interleaved vertex data has exactly the layout of the full floating point vertex structure
+    genOpenGlObjects(reinterpret_cast<const VertexFormat::PositionColorNormal*>(aVertexData.data()),
+                     aVertexData.size() / 3, aIndexData, aPositionAttrib, aColorAttrib, aNormalAttrib, aMatrixAttrib);
+}
+
+/**
+ * @brief Generate the vertex and index buffers, and bind a new Vertex Array Object along with the vertex buffer
+ *
+ * @param[in] apVertices    Vertices, in one of the VertexFormat structures
+ * @param[in] aNbBytes      Size of the vertices in bytes
+ * @param[in] aIndexData    Index data (triangle list)
+ */
+void Mesh::genBuffers(const void* apVertices, size_t aNbBytes, const IndexData& aIndexData) {
     // Generate a VBO: Ask for a buffer of GPU memory
     glGenBuffers(1, &mVertexBufferObject);
     assert(0 != mVertexBufferObject); /// @todo test buffers != 0 with a dedicated ASSERT_VBO
 
     // Allocate GPU memory and copy our data onto this new buffer
-    glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-    /// @todo use templates to get size and buffer
-    glBufferData(GL_ARRAY_BUFFER, aVertexData.size() * sizeof(aVertexData[0]), &aVertexData[0], GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    // here aVertexData is of no more use (dynamic memory will be deallocated)
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+    glBufferData(GL_ARRAY_BUFFER, aNbBytes, apVertices, GL_STATIC_DRAW);
+    // here the vertices are of no more use (dynamic memory will be deallocated)
 
     // Generate a IBO: Ask for a buffer of GPU memory
     glGenBuffers(1, &mIndexBufferObject);
 
     // Allocate GPU memory and copy our data onto this new buffer
+    // (the index buffer binding is part of the Vertex Array Object: unbind the one left bound by the last draw)
+    StateCache::bindVertexArray(0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBufferObject);
-    /// @todo use templates to get size and start of buffer
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, aIndexData.size() * sizeof(aIndexData[0]), &aIndexData[0], GL_STATIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     // here _indexData is of no more use (dynamic memory could be deallocated)
@@ -79,42 +99,137 @@ void Mesh::genOpenGlObjects(const VertexData&   aVertexData,
     glGenVertexArrays(1, &mVertexArrayObject);
 
     // Bind the vertex array, so that it can memorize the following states
-    glBindVertexArray(mVertexArrayObject);
-
-    // Bind the vertex buffer, and init vertex position and colors input streams (shader attributes)
-    glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-    glEnableVertexAttribArray(aPositionAttrib); // layout(location = 0) in vec4 position;
-    glEnableVertexAttribArray(aColorAttrib);    // layout(location = 1) in vec4 diffuseColor;
-    glEnableVertexAttribArray(aNormalAttrib);   // layout(location = 2) in vec3 normal;
-
-    // this tells the GPU witch part of the buffer to route to which attribute (shader input stream)
-    const size_t vertexDim = 3;
-    glVertexAttribPointer(aPositionAttrib,  vertexDim, GL_FLOAT, GL_FALSE, 3 * sizeof(aVertexData[0]),
-            reinterpret_cast<void*>(0));
-    glVertexAttribPointer(aColorAttrib,     vertexDim, GL_FLOAT, GL_FALSE, 3 * sizeof(aVertexData[0]),
-            reinterpret_cast<void*>(sizeof(aVertexData[0])));
-    glVertexAttribPointer(aNormalAttrib,    vertexDim, GL_FLOAT, GL_FALSE, 3 * sizeof(aVertexData[0]),
-            reinterpret_cast<void*>(2*sizeof(aVertexData[0])));
+    StateCache::bindVertexArray(mVertexArrayObject);
+
+    // Bind the vertex buffer, to init the vertex input streams (shader attributes) of the vertex format
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+}
+
+/**
+ * @brief Enable the per-instance matrix attribute and the index buffer, and unbind the Vertex Array Object
+ *
+ * @param[in] aMatrixAttrib     Location of the "modelToCameraMatrix" per-instance vertex shader attribute
+ */
+void Mesh::endVertexArray(GLuint aMatrixAttrib) {
+    // The per-instance "Model to Camera" matrix uses 4 consecutive locations (one per column),
+    // advancing once per instance instead of once per vertex (its buffer is given at each draw call)
+    for (GLuint idxColumn = 0; idxColumn < 4; ++idxColumn) {
+        glEnableVertexAttribArray(aMatrixAttrib + idxColumn); // layout(location = 3) in mat4 modelToCameraMatrix;
+        glVertexAttribDivisor(aMatrixAttrib + idxColumn, 1);
+    }
     // this tells OpenGL that vertex are pointed by index
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBufferObject);
 
-    glBindVertexArray(0);
+    StateCache::bindVertexArray(0);
 }
 
 /**
- * @brief Indexed Draw Call glDrawElements()
+ * @brief Generate a position only vertex buffer and its Vertex Array Object, for depth only passes
  *
- * @param[in] aVertexArrayObject    VAO: Vertex Array Object retaining the states needed for the render calls
+ *  A depth only pass fetches only the positions: reading them from a tightly packed stream of 12 bytes per vertex
+ * instead of the interleaved vertices saves most of the vertex fetch bandwidth. The index buffer is shared.
+ *
+ * @param[in] aPositions        Positions of the vertices (see VertexFormat::convert())
+ * @param[in] aPositionAttrib   Location of the "position" vertex shader attribute (input stream)
+ * @param[in] aMatrixAttrib     Location of the "modelToCameraMatrix" per-instance vertex shader attribute
  */
-void Mesh::IndexedDrawCall::draw(GLuint aVertexArrayObject) const {
+void Mesh::genDepthOpenGlObjects(const std::vector<VertexFormat::Position>& aPositions,
+                                 GLuint aPositionAttrib, GLuint aMatrixAttrib) {
+    glGenBuffers(1, &mDepthVertexBufferObject);
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, mDepthVertexBufferObject);
+    glBufferData(GL_ARRAY_BUFFER, aPositions.size() * sizeof(VertexFormat::Position), aPositions.data(),
+                 GL_STATIC_DRAW);
+
+    glGenVertexArrays(1, &mDepthVertexArrayObject);
+    StateCache::bindVertexArray(mDepthVertexArrayObject);
+    // (only the position is enabled: the other input streams keep their constant default value)
+    const GLuint locations[VertexFormat::eNbAttribs] = {aPositionAttrib, VertexFormat::NO_LOCATION,
+                                                        VertexFormat::NO_LOCATION};
+    VertexFormat::Layout<VertexFormat::Position>::enable(locations);
+    for (GLuint idxColumn = 0; idxColumn < 4; ++idxColumn) {
+        glEnableVertexAttribArray(aMatrixAttrib + idxColumn);
+        glVertexAttribDivisor(aMatrixAttrib + idxColumn, 1);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBufferObject);
+
+    StateCache::bindVertexArray(0);
+}
+
+/**
+ * @brief Add a coarser level of detail, drawing a range of the index buffer with the same vertices
+ *
+ * @param[in] aElementCount     Number of indexed vertex to draw
+ * @param[in] aStartPosition    Offset in bytes from where start indices in the buffer
+ * @param[in] aError            Geometric error of the level (maximum distance to the full resolution surface)
+ */
+void Mesh::addLod(GLuint aElementCount, GLuint aStartPosition, float aError) {
+    const IndexedDrawCall& fullResolution = mDrawCalls.front();
+    mDrawCalls.push_back(IndexedDrawCall(fullResolution.getPrimitiveType(), aElementCount,
+                                         fullResolution.getIndexDataType(), aStartPosition));
+    mLodErrors.push_back(aError);
+}
+
+/**
+ * @brief Keep a copy of the vertex and index data in CPU memory, to be baked into static batches
+ *
+ *  Only small Meshes with a single level of detail are retained (see ResourceManager::setStaticBatching()):
+ * a static batch draws them at full resolution, pre-transformed into world space (see RetainedDrawList).
+ * The full resolution of the occluders is also retained, whatever their size, to be rasterized on the CPU
+ * (see SoftwareOcclusion).
+ *
+ * @param[in] aVertexData   Vertex data (vertex positions, colors, and normals)
+ * @param[in] aIndexData    Index data (triangle list)
+ */
+void Mesh::retainData(const VertexData& aVertexData, const IndexData& aIndexData) {
+    mVertexData = aVertexData;
+    mIndexData  = aIndexData;
+}
+
+/**
+ * @brief Instanced Draw Call glDrawElementsInstanced(), with per-instance matrices read from a buffer
+ *
+ * @param[in] aMatrixAttrib     Location of the "modelToCameraMatrix" per-instance vertex shader attribute
+ * @param[in] aMatrixBuffer     Buffer containing the "Model to Camera" matrices of the instances
+ * @param[in] aMatrixOffset     Offset in bytes of the matrix of the first instance in the buffer
+ * @param[in] aNbInstances      Number of instances to draw
+ * @param[in] aLod              Level of detail to draw (0 for the full resolution)
+ * @param[in,out] aRenderStats  Statistics counters of the current frame
+ * @param[in] abDepthOnly       Read only the positions, if a position only stream has been generated
+ */
+void Mesh::draw(GLuint aMatrixAttrib, GLuint aMatrixBuffer, size_t aMatrixOffset, GLsizei aNbInstances,
+                unsigned int aLod, RenderStats& aRenderStats, bool abDepthOnly /* = false */) const {
     // Bind the Vertex Array Object, bound to buffers with vertex position and colors
-    glBindVertexArray(aVertexArrayObject);
+    // (left bound afterward, so that drawing the same Mesh again does not bind it again)
+    const GLuint vertexArray = (abDepthOnly && (0 != mDepthVertexArrayObject)) ? mDepthVertexArrayObject
+                                                                                : mVertexArrayObject;
+    if (StateCache::bindVertexArray(vertexArray)) {
+        aRenderStats.incr(RenderStats::eVaoBinds);
+    }
 
-    // Emit the OpenGL draw call
-    glDrawElements(mPrimitiveType, mElementCount, mIndexDataType, reinterpret_cast<void*>(mStartPosition));
+    // Point the per-instance matrix attribute to the matrices of this batch
+    // (no base instance in OpenGL 3.3, so the attribute offset is changed instead)
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, aMatrixBuffer);
+    for (GLuint idxColumn = 0; idxColumn < 4; ++idxColumn) {
+        glVertexAttribPointer(aMatrixAttrib + idxColumn, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              reinterpret_cast<void*>(aMatrixOffset + idxColumn * sizeof(glm::vec4)));
+    }
+
+    mDrawCalls[aLod].draw(aNbInstances, aRenderStats);
+}
 
-    // Unbind the Vertex Array Object
-    glBindVertexArray(0);
+/**
+ * @brief Instanced Indexed Draw Call glDrawElementsInstanced()
+ *
+ * @param[in] aNbInstances          Number of instances to draw
+ * @param[in,out] aRenderStats      Statistics counters of the current frame
+ */
+void Mesh::IndexedDrawCall::draw(GLsizei aNbInstances, RenderStats& aRenderStats) const {
+    // Emit the OpenGL draw call
+    glDrawElementsInstanced(mPrimitiveType, mElementCount, mIndexDataType, reinterpret_cast<void*>(mStartPosition),
+                            aNbInstances);
+    aRenderStats.incr(RenderStats::eDrawCalls);
+    aRenderStats.incr(RenderStats::eInstances, aNbInstances);
+    aRenderStats.incr(RenderStats::eTriangles, getNbTriangles() * aNbInstances);
 }
 
 
@@ -122,9 +237,16 @@ void Mesh::IndexedDrawCall::draw(GLuint aVertexArrayObject) const {
  * @brief Uninitialize the vertex buffer and vertex array objects
  */
 void Mesh::deleteOpenGlObjects(void) {
-    glDeleteBuffers(1, &mVertexBufferObject);
-    glDeleteBuffers(1, &mIndexBufferObject);
-    glDeleteVertexArrays(1, &mVertexArrayObject);
+    // (a Mesh never uploaded, like the ones of the micro-benchmarks, has no OpenGL object nor any context)
+    if (0 != mVertexArrayObject) {
+        StateCache::deleteBuffer(mVertexBufferObject);
+        StateCache::deleteBuffer(mIndexBufferObject);
+        StateCache::deleteVertexArray(mVertexArrayObject);
+    }
+    if (0 != mDepthVertexArrayObject) {
+        StateCache::deleteBuffer(mDepthVertexBufferObject);
+        StateCache::deleteVertexArray(mDepthVertexArrayObject);
+    }
 }
 
 /**
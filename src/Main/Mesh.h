@@ -10,7 +10,9 @@
  */
 #pragma once
 
-#include <memory>           // std::unique_ptr
+#include "Main/VertexFormat.h"
+
+#include <memory>           // std::shared_ptr, std::enable_shared_from_this
 
 // NOTE: Needs to be included before any other gl/glfw/freeglut header
 #include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
@@ -18,19 +20,38 @@
 
 #include <vector>           // std::vector
 #include <string>           // std::string
+#include <algorithm>        // std::max
+
+class RenderStats;
 
 /**
  * @brief Description of a mesh/model at a Node of the Scene
+ *
+ *  Always owned by a Mesh::Ptr, so that a weak pointer can follow its lifetime (see ImpostorAtlas).
+ *
  * @ingroup Main
  */
-class Mesh {
+class Mesh : public std::enable_shared_from_this<Mesh> {
 public:
-    typedef std::unique_ptr<Mesh>   Ptr;        ///< Unique (unshared) Smart Pointer to a Mesh
+    typedef std::shared_ptr<Mesh>   Ptr;        ///< Shared Smart Pointer to a Mesh (shared by Nodes instances)
     typedef std::vector<Ptr>        List;       ///< List (std::vector) of pointers to Meshes
 
     typedef std::vector<glm::vec3>  VertexData; ///< A Vector of Vertex data composed of 3 float elements
     typedef std::vector<GLshort>    IndexData;  ///< A Vector of Index data composed of short elements
 
+    /**
+     * @brief Level of detail: a triangle list in the index data, and its geometric error
+     *
+     *  All levels share the same vertices (simplified by collapsing edges onto existing vertices),
+     * so a level is only a range of the index buffer.
+     */
+    struct Lod {
+        GLuint  mFirstIndex;    ///< Index of the first index of the level in the index data
+        GLuint  mNbIndices;     ///< Number of indices of the level
+        float   mError;         ///< Maximum distance to the full resolution surface, in model units
+    };
+    typedef std::vector<Lod>        LodList;    ///< Levels of detail, from the full resolution to the coarsest
+
 public:
     Mesh(const char* apName,
          GLenum aPrimitiveType,
@@ -39,25 +60,54 @@ public:
          GLuint aStartPosition);
     ~Mesh();
 
-    // Generate OpenGL objects
+    // Generate OpenGL objects, with the full floating point vertex format
     void genOpenGlObjects(const VertexData& aVertexData,
                           const IndexData&  aIndexData,
                           GLuint            aPositionAttrib,
                           GLuint            aColorAttrib,
-                          GLuint            aNormalAttrib);
+                          GLuint            aNormalAttrib,
+                          GLuint            aMatrixAttrib);
+    // Generate OpenGL objects, with the layout of the given vertex structure (see VertexFormat)
+    template<typename Vertex>
+    void genOpenGlObjects(const Vertex*     apVertices,
+                          size_t            aNbVertices,
+                          const IndexData&  aIndexData,
+                          GLuint            aPositionAttrib,
+                          GLuint            aColorAttrib,
+                          GLuint            aNormalAttrib,
+                          GLuint            aMatrixAttrib);
+    // Generate a position only vertex buffer and its Vertex Array Object, for depth only passes
+    void genDepthOpenGlObjects(const std::vector<VertexFormat::Position>& aPositions,
+                               GLuint aPositionAttrib, GLuint aMatrixAttrib);
     void deleteOpenGlObjects();
 
-    /**
-     * @brief Indexed Draw Call glDrawElements()
-     */
-    inline void draw() const {
-        mDrawCall.draw(mVertexArrayObject);
-    }
+    // Add a coarser level of detail, drawing a range of the index buffer
+    void addLod(GLuint aElementCount, GLuint aStartPosition, float aError);
+
+    // Keep a copy of the vertex and index data in CPU memory, to be baked into static batches
+    void retainData(const VertexData& aVertexData, const IndexData& aIndexData);
 
-    // Getter
+    // Instanced Draw Call glDrawElementsInstanced(), with per-instance matrices read from a buffer
+    void draw(GLuint aMatrixAttrib, GLuint aMatrixBuffer, size_t aMatrixOffset, GLsizei aNbInstances,
+              unsigned int aLod, RenderStats& aRenderStats, bool abDepthOnly = false) const;
+
+    // Getters
     inline const std::string& getName() const;
+    inline unsigned int getNbLods() const;
+    inline float        getLodError(unsigned int aLod) const;
+    inline GLuint       getNbTriangles(unsigned int aLod) const;
+    inline const glm::vec3& getBoundingCenter() const;
+    inline float        getBoundingRadius() const;
+    inline bool         hasData() const;
+    inline const VertexData& getVertexData() const;
+    inline const IndexData&  getIndexData() const;
 
 private:
+    // Generate the vertex and index buffers, and bind a new Vertex Array Object along with the vertex buffer
+    void genBuffers(const void* apVertices, size_t aNbBytes, const IndexData& aIndexData);
+    // Enable the per-instance matrix attribute and the index buffer, and unbind the Vertex Array Object
+    void endVertexArray(GLuint aMatrixAttrib);
+
     /**
      * @brief Public structure managing an OpenGL indexed draw call
      */
@@ -81,7 +131,35 @@ private:
             mStartPosition(aStartPosition) {
         }
 
-        void draw(GLuint aVertexArrayObject) const;
+        void draw(GLsizei aNbInstances, RenderStats& aRenderStats) const;
+
+        /**
+         * @brief GL_TRIANGLES, GL_TRIANGLE_STRIP...
+         */
+        inline GLenum getPrimitiveType() const {
+            return mPrimitiveType;
+        }
+
+        /**
+         * @brief GL_UNSIGNED_SHORT...
+         */
+        inline GLenum getIndexDataType() const {
+            return mIndexDataType;
+        }
+
+        /**
+         * @brief Number of triangles rendered by the draw call
+         */
+        inline GLuint getNbTriangles() const {
+            GLuint nbTriangles = 0;
+            if (GL_TRIANGLES == mPrimitiveType) {
+                nbTriangles = mElementCount / 3;
+            } else if (((GL_TRIANGLE_STRIP == mPrimitiveType) || (GL_TRIANGLE_FAN == mPrimitiveType))
+                       && (3 <= mElementCount)) {
+                nbTriangles = mElementCount - 2;
+            }
+            return nbTriangles;
+        }
 
      private:
         GLenum mPrimitiveType;  ///< GL_TRIANGLES, GL_TRIANGLE_STRIP...
@@ -96,10 +174,65 @@ private:
     GLuint mVertexBufferObject; ///< VBO: Vertex Buffer Object containing the data of our Mesh (vertices, normals, UVs)
     GLuint mIndexBufferObject;  ///< IBO: Index Buffer Object containing the indices of vertices of our Mesh
     GLuint mVertexArrayObject;  ///< VAO: Vertex Array Object retaining the states needed for the render calls
+    GLuint mDepthVertexBufferObject;    ///< VBO of the positions only, for depth only passes (or 0)
+    GLuint mDepthVertexArrayObject;     ///< VAO reading only the positions, for depth only passes (or 0)
+
+    std::vector<IndexedDrawCall> mDrawCalls;    ///< Indexed draw call of each level of detail of the Mesh
+    std::vector<float>           mLodErrors;    ///< Geometric error of each level of detail, in model units
 
-    IndexedDrawCall mDrawCall;  ///< Indexed draw call of the current Mesh
+    glm::vec3   mBoundingCenter;    ///< Center of the bounding sphere of the vertices, in model space
+    float       mBoundingRadius;    ///< Radius of the bounding sphere of the vertices
+
+    VertexData  mVertexData;        ///< Copy of the vertex data retained for static batching (or empty)
+    IndexData   mIndexData;         ///< Copy of the index data retained for static batching (or empty)
 };
 
+/**
+ * @brief Initialize the Vertex Buffer, Index Buffer and Vertex Array Objects, with the layout of a vertex structure
+ *
+ *  The setup of the vertex attributes of the VAO (offsets, types, normalization and stride) is generated
+ * at compile time from the VertexFormat::Layout of the vertex structure.
+ *
+ * @param[in] apVertices        Vertices, in one of the VertexFormat structures
+ * @param[in] aNbVertices       Number of vertices
+ * @param[in] aIndexData        Index data (triangle list)
+ * @param[in] aPositionAttrib   Location of the "position" vertex shader attribute (input stream)
+ * @param[in] aColorAttrib      Location of the "diffuseColor" vertex shader attribute (input stream)
+ * @param[in] aNormalAttrib     Location of the "normal" vertex shader attribute (input stream)
+ * @param[in] aMatrixAttrib     Location of the "modelToCameraMatrix" per-instance vertex shader attribute
+ */
+template<typename Vertex>
+void Mesh::genOpenGlObjects(const Vertex*       apVertices,
+                            size_t              aNbVertices,
+                            const IndexData&    aIndexData,
+                            GLuint              aPositionAttrib,
+                            GLuint              aColorAttrib,
+                            GLuint              aNormalAttrib,
+                            GLuint              aMatrixAttrib) {
+    // Bounding sphere of the vertex positions, centered on their bounding box
+    if (0 < aNbVertices) {
+        glm::vec3 min = apVertices[0].mPosition;
+        glm::vec3 max = apVertices[0].mPosition;
+        for (size_t idxVertex = 1; idxVertex < aNbVertices; ++idxVertex) {
+            min = glm::min(min, apVertices[idxVertex].mPosition);
+            max = glm::max(max, apVertices[idxVertex].mPosition);
+        }
+        mBoundingCenter = 0.5f * (min + max);
+        for (size_t idxVertex = 0; idxVertex < aNbVertices; ++idxVertex) {
+            const float distance = glm::distance(mBoundingCenter, apVertices[idxVertex].mPosition);
+            mBoundingRadius = std::max(mBoundingRadius, distance);
+        }
+    }
+
+    genBuffers(apVertices, aNbVertices * sizeof(Vertex), aIndexData);
+
+    // this tells the GPU witch part of the buffer to route to which attribute (shader input stream)
+    const GLuint locations[VertexFormat::eNbAttribs] = {aPositionAttrib, aColorAttrib, aNormalAttrib};
+    VertexFormat::Layout<Vertex>::enable(locations);
+
+    endVertexArray(aMatrixAttrib);
+}
+
 /**
  * @brief   Get the Name of the current Node
  *
@@ -108,3 +241,63 @@ private:
 inline const std::string& Mesh::getName() const {
     return mName;
 }
+
+/**
+ * @brief   Get the number of levels of detail of the Mesh (at least one, the full resolution)
+ */
+inline unsigned int Mesh::getNbLods() const {
+    return static_cast<unsigned int>(mDrawCalls.size());
+}
+
+/**
+ * @brief   Get the geometric error of a level of detail (maximum distance to the full resolution surface)
+ *
+ * @param[in] aLod  Index of the level of detail (0 for the full resolution)
+ */
+inline float Mesh::getLodError(unsigned int aLod) const {
+    return mLodErrors[aLod];
+}
+
+/**
+ * @brief   Get the number of triangles of a level of detail
+ *
+ * @param[in] aLod  Index of the level of detail (0 for the full resolution)
+ */
+inline GLuint Mesh::getNbTriangles(unsigned int aLod) const {
+    return mDrawCalls[aLod].getNbTriangles();
+}
+
+/**
+ * @brief   Get the center of the bounding sphere of the vertices, in model space
+ */
+inline const glm::vec3& Mesh::getBoundingCenter() const {
+    return mBoundingCenter;
+}
+
+/**
+ * @brief   Get the radius of the bounding sphere of the vertices
+ */
+inline float Mesh::getBoundingRadius() const {
+    return mBoundingRadius;
+}
+
+/**
+ * @brief   Tell if the vertex and index data are retained in CPU memory (see retainData())
+ */
+inline bool Mesh::hasData() const {
+    return (false == mIndexData.empty());
+}
+
+/**
+ * @brief   Get the vertex data retained in CPU memory (positions, colors, and normals, in model space)
+ */
+inline const Mesh::VertexData& Mesh::getVertexData() const {
+    return mVertexData;
+}
+
+/**
+ * @brief   Get the index data retained in CPU memory (triangle list of the full resolution)
+ */
+inline const Mesh::IndexData& Mesh::getIndexData() const {
+    return mIndexData;
+}
@@ -0,0 +1,430 @@
+/**
+ * @file    MeshSimplifier.cpp
+ * @ingroup Main
+ * @brief   Generation of levels of detail of a Mesh, by edge collapses ordered by quadric error metrics
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/MeshSimplifier.h"
+
+#include <algorithm>        // std::sort, std::max
+#include <vector>
+#include <unordered_map>
+#include <utility>          // std::swap
+#include <cmath>            // sqrt
+#include <cstdint>          // uint64_t
+
+/// Maximum number of levels of detail of a Mesh (including the full resolution)
+static const size_t _maxLods            = 6;
+/// Minimum number of triangles of a level of detail (smaller Meshes get no level of detail)
+static const size_t _minLodTriangles    = 128;
+/// Weight of the planes keeping the boundary edges in place, relative to the planes of the triangles
+static const double _boundaryWeight     = 4.0;
+/// Minimum cosine of the rotation of the normal of a triangle by a collapse (rejecting flips and slivers)
+static const float  _minCosine          = 0.25f;
+
+/**
+ * @brief Order vertices by position (lexicographic order of their coordinates)
+ */
+class PositionLess {
+public:
+    explicit PositionLess(const Mesh::VertexData& aVertexData) :
+        mVertexData(aVertexData) {
+    }
+
+    /// Compare the positions of two vertices
+    bool operator()(unsigned int aVertex1, unsigned int aVertex2) const {
+        const glm::vec3& position1 = mVertexData[aVertex1 * 3];
+        const glm::vec3& position2 = mVertexData[aVertex2 * 3];
+        if (position1.x != position2.x) {
+            return (position1.x < position2.x);
+        } else if (position1.y != position2.y) {
+            return (position1.y < position2.y);
+        }
+        return (position1.z < position2.z);
+    }
+
+private:
+    const Mesh::VertexData& mVertexData;    ///< Interleaved vertex data of the Mesh
+};
+
+/**
+ * @brief Key of an undirected edge between two positions
+ */
+static uint64_t getEdgeKey(unsigned int aPosition1, unsigned int aPosition2) {
+    return (aPosition1 < aPosition2) ? ((static_cast<uint64_t>(aPosition1) << 32) | aPosition2)
+                                     : ((static_cast<uint64_t>(aPosition2) << 32) | aPosition1);
+}
+
+/**
+ * @brief Set the quadric of a plane, giving the (weighted) squared distance of a point to the plane
+ *
+ * @param[in] aNormal   Unit normal of the plane
+ * @param[in] aDistance Distance of the plane from the origin, along its normal (d in ax+by+cz+d=0)
+ * @param[in] aWeight   Weight of the plane
+ */
+void MeshSimplifier::Quadric::setPlane(const glm::vec3& aNormal, float aDistance, double aWeight) {
+    const double a = aNormal.x;
+    const double b = aNormal.y;
+    const double c = aNormal.z;
+    const double d = aDistance;
+    mA2 = aWeight * a * a;  mAB = aWeight * a * b;  mAC = aWeight * a * c;  mAD = aWeight * a * d;
+    mB2 = aWeight * b * b;  mBC = aWeight * b * c;  mBD = aWeight * b * d;
+    mC2 = aWeight * c * c;  mCD = aWeight * c * d;
+    mD2 = aWeight * d * d;
+}
+
+/**
+ * @brief Add a quadric (sum of the squared distances to the planes of both)
+ */
+void MeshSimplifier::Quadric::add(const Quadric& aQuadric) {
+    mA2 += aQuadric.mA2;    mAB += aQuadric.mAB;    mAC += aQuadric.mAC;    mAD += aQuadric.mAD;
+    mB2 += aQuadric.mB2;    mBC += aQuadric.mBC;    mBD += aQuadric.mBD;
+    mC2 += aQuadric.mC2;    mCD += aQuadric.mCD;
+    mD2 += aQuadric.mD2;
+}
+
+/**
+ * @brief Evaluate the quadric at a point: sum of the squared distances to its planes
+ */
+double MeshSimplifier::Quadric::evaluate(const glm::vec3& aPosition) const {
+    const double x = aPosition.x;
+    const double y = aPosition.y;
+    const double z = aPosition.z;
+    return (mA2 * x * x) + (2.0 * mAB * x * y) + (2.0 * mAC * x * z) + (2.0 * mAD * x)
+         + (mB2 * y * y) + (2.0 * mBC * y * z) + (2.0 * mBD * y)
+         + (mC2 * z * z) + (2.0 * mCD * z)
+         + mD2;
+}
+
+/**
+ * @brief Prepare the simplification of a Mesh: merge vertices by position, and evaluate all edges
+ *
+ * @param[in] aVertexData   Interleaved vertex data of the Mesh (positions, colors, and normals)
+ * @param[in] aIndexData    Triangle list of the full resolution
+ */
+MeshSimplifier::MeshSimplifier(const Mesh::VertexData& aVertexData, const Mesh::IndexData& aIndexData) :
+    mVertexData(aVertexData),
+    mNbTriangles(0),
+    mError(0.0f) {
+    const unsigned int nbVertices = static_cast<unsigned int>(aVertexData.size() / 3);
+
+    // Merge the vertices at the same position (seams of normals or colors), sorting them by position
+    std::vector<unsigned int> sortedVertices(nbVertices);
+    for (unsigned int idxVertex = 0; idxVertex < nbVertices; ++idxVertex) {
+        sortedVertices[idxVertex] = idxVertex;
+    }
+    const PositionLess positionLess(aVertexData);
+    std::sort(sortedVertices.begin(), sortedVertices.end(), positionLess);
+    mVertexPositions.resize(nbVertices);
+    for (unsigned int idxSorted = 0; idxSorted < nbVertices; ++idxSorted) {
+        const unsigned int vertex = sortedVertices[idxSorted];
+        if ((0 == idxSorted) || positionLess(sortedVertices[idxSorted - 1], vertex)) {
+            mPositionVertices.push_back(std::vector<unsigned int>());
+        }
+        mVertexPositions[vertex] = static_cast<unsigned int>(mPositionVertices.size() - 1);
+        mPositionVertices.back().push_back(vertex);
+    }
+    const size_t nbPositions = mPositionVertices.size();
+    mQuadrics.resize(nbPositions);  // value-initialized to zero
+    mVersions.assign(nbPositions, 0);
+    mbCollapsed.assign(nbPositions, false);
+    mPositionTriangles.resize(nbPositions);
+
+    // Keep the non-degenerated triangles, accumulating their plane into the quadric of their positions
+    std::vector<glm::vec3>                      normals;
+    std::unordered_map<uint64_t, unsigned int>  edgeCounts;
+    for (size_t idxIndex = 0; idxIndex + 2 < aIndexData.size(); idxIndex += 3) {
+        unsigned int vertices[3];
+        unsigned int positions[3];
+        for (int idxCorner = 0; idxCorner < 3; ++idxCorner) {
+            vertices[idxCorner] = static_cast<unsigned short>(aIndexData[idxIndex + idxCorner]);
+            positions[idxCorner] = mVertexPositions[vertices[idxCorner]];
+        }
+        if ((positions[0] == positions[1]) || (positions[1] == positions[2]) || (positions[2] == positions[0])) {
+            continue;
+        }
+        const glm::vec3& position0 = getPosition(vertices[0]);
+        glm::vec3 normal = glm::cross(getPosition(vertices[1]) - position0, getPosition(vertices[2]) - position0);
+        const float length = glm::length(normal);
+        if (0.0f < length) {
+            normal = normal / length;
+            Quadric quadric;
+            quadric.setPlane(normal, -glm::dot(normal, position0), 1.0);
+            for (int idxCorner = 0; idxCorner < 3; ++idxCorner) {
+                mQuadrics[positions[idxCorner]].add(quadric);
+            }
+        }
+        const unsigned int idxTriangle = static_cast<unsigned int>(normals.size());
+        normals.push_back(normal);
+        for (int idxCorner = 0; idxCorner < 3; ++idxCorner) {
+            mTriangles.push_back(vertices[idxCorner]);
+            mPositionTriangles[positions[idxCorner]].push_back(idxTriangle);
+            ++edgeCounts[getEdgeKey(positions[idxCorner], positions[(idxCorner + 1) % 3])];
+        }
+    }
+    mNbTriangles = normals.size();
+    mbRemoved.assign(mNbTriangles, false);
+
+    // Boundary edges (of a single triangle) get a plane perpendicular to their triangle, to keep the silhouette
+    for (size_t idxTriangle = 0; idxTriangle < mNbTriangles; ++idxTriangle) {
+        for (int idxCorner = 0; idxCorner < 3; ++idxCorner) {
+            const unsigned int vertex1 = mTriangles[idxTriangle * 3 + idxCorner];
+            const unsigned int vertex2 = mTriangles[idxTriangle * 3 + (idxCorner + 1) % 3];
+            const unsigned int position1 = mVertexPositions[vertex1];
+            const unsigned int position2 = mVertexPositions[vertex2];
+            if (1 == edgeCounts[getEdgeKey(position1, position2)]) {
+                glm::vec3 normal = glm::cross(getPosition(vertex2) - getPosition(vertex1), normals[idxTriangle]);
+                const float length = glm::length(normal);
+                if (0.0f < length) {
+                    normal = normal / length;
+                    Quadric quadric;
+                    quadric.setPlane(normal, -glm::dot(normal, getPosition(vertex1)), _boundaryWeight);
+                    mQuadrics[position1].add(quadric);
+                    mQuadrics[position2].add(quadric);
+                }
+            }
+        }
+    }
+
+    // Evaluate the collapse of all edges
+    for (size_t idxTriangle = 0; idxTriangle < mNbTriangles; ++idxTriangle) {
+        for (int idxCorner = 0; idxCorner < 3; ++idxCorner) {
+            pushCandidate(mVertexPositions[mTriangles[idxTriangle * 3 + idxCorner]],
+                          mVertexPositions[mTriangles[idxTriangle * 3 + (idxCorner + 1) % 3]]);
+        }
+    }
+}
+
+/**
+ * @brief Destructor
+ */
+MeshSimplifier::~MeshSimplifier() {
+}
+
+/**
+ * @brief Collapse edges, by increasing error, until at most the given number of triangles remain
+ *
+ *  Can be called again with a smaller number of triangles, to continue the simplification.
+ *
+ * @param[in] aNbTriangles  Number of triangles to reach (not reached if no more edge can be collapsed)
+ *
+ * @return Geometric error of the current level of simplification (maximum distance to the full resolution surface)
+ */
+float MeshSimplifier::simplify(size_t aNbTriangles) {
+    while ((mNbTriangles > aNbTriangles) && (false == mCandidates.empty())) {
+        const Candidate candidate = mCandidates.top();
+        mCandidates.pop();
+        // Skip the outdated candidates: any change of the quadric or of the triangles of a position
+        // pushed new candidates for all its edges
+        if (mbCollapsed[candidate.mFrom] || mbCollapsed[candidate.mTo]
+            || (mVersions[candidate.mFrom] != candidate.mFromVersion)
+            || (mVersions[candidate.mTo] != candidate.mToVersion)) {
+            continue;
+        }
+        if (canCollapse(candidate.mFrom, candidate.mTo)) {
+            collapse(candidate.mFrom, candidate.mTo);
+            // The quadric error is a sum of squared distances to the planes of the original triangles
+            mError = std::max(mError, static_cast<float>(sqrt(std::max(candidate.mCost, 0.0))));
+        }
+    }
+    return mError;
+}
+
+/**
+ * @brief Append the triangle list of the current level of simplification
+ *
+ * @param[in,out] aIndexData    Index data to append the triangle list to
+ */
+void MeshSimplifier::getIndexData(Mesh::IndexData& aIndexData) const {
+    for (size_t idxTriangle = 0; idxTriangle < mbRemoved.size(); ++idxTriangle) {
+        if (false == mbRemoved[idxTriangle]) {
+            for (size_t idxCorner = 0; idxCorner < 3; ++idxCorner) {
+                aIndexData.push_back(static_cast<GLshort>(mTriangles[idxTriangle * 3 + idxCorner]));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Evaluate both directions of collapse of an edge, and push them as candidates
+ *
+ * @param[in] aPosition1    First position of the edge
+ * @param[in] aPosition2    Second position of the edge
+ */
+void MeshSimplifier::pushCandidate(unsigned int aPosition1, unsigned int aPosition2) {
+    Quadric quadric = mQuadrics[aPosition1];
+    quadric.add(mQuadrics[aPosition2]);
+
+    Candidate candidate;
+    candidate.mFrom         = aPosition1;
+    candidate.mTo           = aPosition2;
+    candidate.mFromVersion  = mVersions[aPosition1];
+    candidate.mToVersion    = mVersions[aPosition2];
+    candidate.mCost         = quadric.evaluate(getPosition(mPositionVertices[aPosition2].front()));
+    mCandidates.push(candidate);
+
+    std::swap(candidate.mFrom, candidate.mTo);
+    std::swap(candidate.mFromVersion, candidate.mToVersion);
+    candidate.mCost         = quadric.evaluate(getPosition(mPositionVertices[aPosition1].front()));
+    mCandidates.push(candidate);
+}
+
+/**
+ * @brief Tell if collapsing a position into another keeps the orientation of the remaining triangles
+ *
+ * @param[in] aFrom Position collapsed
+ * @param[in] aTo   Position kept
+ *
+ * @return false if a triangle would be flipped, degenerated, or rotated too much
+ */
+bool MeshSimplifier::canCollapse(unsigned int aFrom, unsigned int aTo) const {
+    const glm::vec3& target = getPosition(mPositionVertices[aTo].front());
+    const std::vector<unsigned int>& triangles = mPositionTriangles[aFrom];
+    for (size_t idxTriangle = 0; idxTriangle < triangles.size(); ++idxTriangle) {
+        const unsigned int triangle = triangles[idxTriangle];
+        if (mbRemoved[triangle]) {
+            continue;
+        }
+        int     idxFrom = -1;
+        bool    bHasTo = false;
+        for (int idxCorner = 0; idxCorner < 3; ++idxCorner) {
+            const unsigned int position = mVertexPositions[mTriangles[triangle * 3 + idxCorner]];
+            if (aFrom == position) {
+                idxFrom = idxCorner;
+            } else if (aTo == position) {
+                bHasTo = true;
+            }
+        }
+        if (bHasTo || (0 > idxFrom)) {
+            continue; // the triangle is removed by the collapse
+        }
+        const glm::vec3& position0 = getPosition(mTriangles[triangle * 3 + idxFrom]);
+        const glm::vec3& position1 = getPosition(mTriangles[triangle * 3 + (idxFrom + 1) % 3]);
+        const glm::vec3& position2 = getPosition(mTriangles[triangle * 3 + (idxFrom + 2) % 3]);
+        const glm::vec3 before  = glm::cross(position1 - position0, position2 - position0);
+        const glm::vec3 after   = glm::cross(position1 - target, position2 - target);
+        // Compare the cosine of the angle between the normals, without normalizing them
+        if (glm::dot(before, after) <= _minCosine * sqrt(glm::dot(before, before) * glm::dot(after, after))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Collapse a position into another: remove the triangles of the edge, and move the others
+ *
+ * @param[in] aFrom Position collapsed
+ * @param[in] aTo   Position kept
+ */
+void MeshSimplifier::collapse(unsigned int aFrom, unsigned int aTo) {
+    std::vector<unsigned int>& triangles = mPositionTriangles[aTo];
+    const std::vector<unsigned int>& fromTriangles = mPositionTriangles[aFrom];
+    for (size_t idxTriangle = 0; idxTriangle < fromTriangles.size(); ++idxTriangle) {
+        const unsigned int triangle = fromTriangles[idxTriangle];
+        if (mbRemoved[triangle]) {
+            continue;
+        }
+        bool bHasTo = false;
+        for (int idxCorner = 0; idxCorner < 3; ++idxCorner) {
+            bHasTo = bHasTo || (aTo == mVertexPositions[mTriangles[triangle * 3 + idxCorner]]);
+        }
+        if (bHasTo) {
+            mbRemoved[triangle] = true;
+            --mNbTriangles;
+        } else {
+            for (int idxCorner = 0; idxCorner < 3; ++idxCorner) {
+                unsigned int& vertex = mTriangles[triangle * 3 + idxCorner];
+                if (aFrom == mVertexPositions[vertex]) {
+                    vertex = getClosestVertex(aTo, vertex);
+                }
+            }
+            triangles.push_back(triangle);
+        }
+    }
+    std::vector<unsigned int>().swap(mPositionTriangles[aFrom]);
+    mQuadrics[aTo].add(mQuadrics[aFrom]);
+    mbCollapsed[aFrom] = true;
+    ++mVersions[aTo];
+
+    // Forget the removed triangles, and evaluate again all the edges of the position kept
+    size_t nbKept = 0;
+    for (size_t idxTriangle = 0; idxTriangle < triangles.size(); ++idxTriangle) {
+        const unsigned int triangle = triangles[idxTriangle];
+        if (false == mbRemoved[triangle]) {
+            triangles[nbKept] = triangle;
+            ++nbKept;
+            for (int idxCorner = 0; idxCorner < 3; ++idxCorner) {
+                const unsigned int position = mVertexPositions[mTriangles[triangle * 3 + idxCorner]];
+                if (aTo != position) {
+                    pushCandidate(aTo, position);
+                }
+            }
+        }
+    }
+    triangles.resize(nbKept);
+}
+
+/**
+ * @brief Get the vertex of a position with the normal closest to the one of the given vertex
+ *
+ * @param[in] aPosition Position of the vertices to choose from
+ * @param[in] aVertex   Vertex to replace
+ */
+unsigned int MeshSimplifier::getClosestVertex(unsigned int aPosition, unsigned int aVertex) const {
+    const std::vector<unsigned int>& vertices = mPositionVertices[aPosition];
+    unsigned int    closestVertex = vertices.front();
+    float           closestCosine = glm::dot(getNormal(aVertex), getNormal(closestVertex));
+    for (size_t idxVertex = 1; idxVertex < vertices.size(); ++idxVertex) {
+        const float cosine = glm::dot(getNormal(aVertex), getNormal(vertices[idxVertex]));
+        if (cosine > closestCosine) {
+            closestVertex = vertices[idxVertex];
+            closestCosine = cosine;
+        }
+    }
+    return closestVertex;
+}
+
+/**
+ * @brief Generate the levels of detail of a Mesh, appending their indices to its index data
+ *
+ *  Each level has half the triangles of the previous one, down to 128 triangles, with at most 6 levels.
+ * The chain stops early when collapses are blocked (by flipped triangles). Meshes too small for a single level
+ * of detail get an empty list.
+ *
+ * @param[in]     aVertexData   Interleaved vertex data of the Mesh (positions, colors, and normals)
+ * @param[in,out] aIndexData    Triangle list of the full resolution, followed by the ones of each level
+ * @param[out]    aLods         Levels of detail, from the full resolution to the coarsest
+ */
+void MeshSimplifier::generateLods(const Mesh::VertexData& aVertexData, Mesh::IndexData& aIndexData,
+                                  Mesh::LodList& aLods) {
+    aLods.clear();
+    const size_t nbTriangles = aIndexData.size() / 3;
+    if (nbTriangles / 2 >= _minLodTriangles) {
+        MeshSimplifier  simplifier(aVertexData, aIndexData);
+        Mesh::IndexData lodIndexData;
+        const Mesh::Lod fullResolution = {0, static_cast<GLuint>(aIndexData.size()), 0.0f};
+        aLods.push_back(fullResolution);
+        size_t nbLodTriangles = nbTriangles;
+        while ((aLods.size() < _maxLods) && (nbLodTriangles / 2 >= _minLodTriangles)) {
+            const float error = simplifier.simplify(nbLodTriangles / 2);
+            if (simplifier.getNbTriangles() * 4 > nbLodTriangles * 3) {
+                break; // less than a quarter of the triangles removed: not worth a level
+            }
+            nbLodTriangles = simplifier.getNbTriangles();
+            const Mesh::Lod lod = {static_cast<GLuint>(aIndexData.size() + lodIndexData.size()),
+                                   static_cast<GLuint>(nbLodTriangles * 3), error};
+            aLods.push_back(lod);
+            simplifier.getIndexData(lodIndexData);
+        }
+        aIndexData.insert(aIndexData.end(), lodIndexData.begin(), lodIndexData.end());
+        if (1 == aLods.size()) {
+            aLods.clear();
+        }
+    }
+}
@@ -0,0 +1,142 @@
+/**
+ * @file    MeshSimplifier.h
+ * @ingroup Main
+ * @brief   Generation of levels of detail of a Mesh, by edge collapses ordered by quadric error metrics
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Main/Mesh.h"
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::vec3 (GLM_FORCE_RADIANS defined at the project level)
+
+#include <vector>           // std::vector
+#include <queue>            // std::priority_queue
+#include <functional>       // std::greater
+#include <cstddef>          // size_t
+
+/**
+ * @brief   Generation of levels of detail of a Mesh, by edge collapses ordered by quadric error metrics
+ * @ingroup Main
+ *
+ *  Garland & Heckbert quadric error metrics: each vertex accumulates the planes of its triangles
+ * (and planes perpendicular to the boundary edges, to keep the silhouette of open surfaces), and the edge
+ * of least squared distance to these planes is collapsed first.
+ *
+ *  An edge is collapsed onto one of its existing vertices (half-edge collapse), so that all levels of detail
+ * share the vertices of the full resolution, and only need a new triangle list. Vertices at the same position
+ * (seams of normals or colors) are collapsed together, each corner switching to the vertex of closest normal,
+ * so that seams do not open. Collapses flipping a triangle are rejected.
+ */
+class MeshSimplifier {
+public:
+    MeshSimplifier(const Mesh::VertexData& aVertexData, const Mesh::IndexData& aIndexData);
+    ~MeshSimplifier(); // not virtual because no virtual methods and class not derived
+
+    // Collapse edges until at most the given number of triangles remain, or no edge can be collapsed
+    float simplify(size_t aNbTriangles);
+
+    // Append the triangle list of the current level of simplification
+    void getIndexData(Mesh::IndexData& aIndexData) const;
+
+    // Number of triangles of the current level of simplification
+    inline size_t getNbTriangles() const;
+
+    // Generate the levels of detail of a Mesh, appending their indices to its index data
+    static void generateLods(const Mesh::VertexData& aVertexData, Mesh::IndexData& aIndexData,
+                             Mesh::LodList& aLods);
+
+private:
+    /**
+     * @brief Symmetric 4x4 matrix of a quadric, giving the sum of squared distances of a point to a set of planes
+     */
+    struct Quadric {
+        double mA2, mAB, mAC, mAD, mB2, mBC, mBD, mC2, mCD, mD2;    ///< Upper half of the matrix
+
+        // Quadric of the plane ax+by+cz+d=0 (of unit normal), with a weight
+        void setPlane(const glm::vec3& aNormal, float aDistance, double aWeight);
+        void add(const Quadric& aQuadric);
+        double evaluate(const glm::vec3& aPosition) const;
+    };
+
+    /**
+     * @brief Edge collapse candidate (invalidated when any of its vertices changed since it was evaluated)
+     */
+    struct Candidate {
+        double          mCost;          ///< Quadric error of the collapse
+        unsigned int    mFrom;          ///< Position collapsed
+        unsigned int    mTo;            ///< Position kept
+        unsigned int    mFromVersion;   ///< Version of the position collapsed when evaluated
+        unsigned int    mToVersion;     ///< Version of the position kept when evaluated
+
+        /// Order of the priority queue (least cost first)
+        inline bool operator>(const Candidate& aCandidate) const {
+            return (mCost > aCandidate.mCost);
+        }
+    };
+
+    // Get the position of a vertex, and its normal
+    inline const glm::vec3& getPosition(unsigned int aVertex) const;
+    inline const glm::vec3& getNormal(unsigned int aVertex) const;
+
+    // Evaluate both directions of collapse of an edge, and push them as candidates
+    void pushCandidate(unsigned int aPosition1, unsigned int aPosition2);
+    // Tell if collapsing a position into another would flip or degenerate a triangle
+    bool canCollapse(unsigned int aFrom, unsigned int aTo) const;
+    // Collapse a position into another
+    void collapse(unsigned int aFrom, unsigned int aTo);
+    // Get the vertex of a position with the normal closest to the one of the given vertex
+    unsigned int getClosestVertex(unsigned int aPosition, unsigned int aVertex) const;
+
+private:
+    const Mesh::VertexData&                 mVertexData;        ///< Interleaved vertex data of the Mesh
+
+    std::vector<unsigned int>               mVertexPositions;   ///< Position of each vertex (merged by position)
+    std::vector<std::vector<unsigned int> > mPositionVertices;  ///< Vertices of each position
+    std::vector<Quadric>                    mQuadrics;          ///< Quadric of each position
+    std::vector<unsigned int>               mVersions;          ///< Number of changes of each position
+    std::vector<bool>                       mbCollapsed;        ///< Tell if each position has been collapsed
+    std::vector<std::vector<unsigned int> > mPositionTriangles; ///< Triangles around each position (lazily updated)
+
+    std::vector<unsigned int>               mTriangles;         ///< 3 vertices of each triangle
+    std::vector<bool>                       mbRemoved;          ///< Tell if each triangle has been removed
+    size_t                                  mNbTriangles;       ///< Number of triangles not removed
+
+    /// Edge collapse candidates, by increasing cost
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate> > mCandidates;
+
+    float                                   mError;             ///< Maximum error of the collapses done
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(MeshSimplifier);
+};
+
+
+/**
+ * @brief Number of triangles of the current level of simplification
+ */
+inline size_t MeshSimplifier::getNbTriangles() const {
+    return mNbTriangles;
+}
+
+/**
+ * @brief Get the position of a vertex (first element of the interleaved vertex data)
+ */
+inline const glm::vec3& MeshSimplifier::getPosition(unsigned int aVertex) const {
+    return mVertexData[aVertex * 3];
+}
+
+/**
+ * @brief Get the normal of a vertex (third element of the interleaved vertex data)
+ */
+inline const glm::vec3& MeshSimplifier::getNormal(unsigned int aVertex) const {
+    return mVertexData[aVertex * 3 + 2];
+}
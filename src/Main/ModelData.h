@@ -0,0 +1,88 @@
+/**
+ * @file    ModelData.h
+ * @ingroup Main
+ * @brief   CPU side data of an imported model, ready to be uploaded to the GPU
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Main/Mesh.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>          // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>              // glm::vec3 (GLM_FORCE_RADIANS defined at the project level)
+#include <glm/gtc/quaternion.hpp>   // glm::fquat
+
+#include <vector>                   // std::vector
+#include <string>                   // std::string
+#include <cstddef>                  // size_t
+
+/**
+ * @brief   CPU side data of a Mesh: interleaved vertex data and triangle list indices
+ * @ingroup Main
+ *
+ *  Levels of detail are generated at import time (see MeshSimplifier), their indices following
+ * the full resolution triangle list, so that they are all uploaded into the same index buffer.
+ */
+struct MeshData {
+    std::string         mName;          ///< Name of the Mesh
+    Mesh::VertexData    mVertexData;    ///< Vertex data (vertex positions, colors, and normals)
+    Mesh::IndexData     mIndexData;     ///< Index data (triangle list of each level of detail, one after the other)
+    Mesh::LodList       mLods;          ///< Levels of detail in mIndexData (empty if only the full resolution)
+
+    /**
+     * @brief Tell if the Mesh has been converted (only the Meshes used by a Node are)
+     */
+    inline bool isConverted() const {
+        return (false == mIndexData.empty());
+    }
+
+    /**
+     * @brief Size of the data to upload to the GPU, in bytes
+     */
+    inline size_t getNbBytes() const {
+        return mVertexData.size() * sizeof(Mesh::VertexData::value_type)
+             + mIndexData.size() * sizeof(Mesh::IndexData::value_type);
+    }
+};
+
+/**
+ * @brief   CPU side data of a Node: relative position, Meshes (by index in the model), and children
+ * @ingroup Main
+ */
+struct NodeData {
+    std::string                 mName;          ///< Name of the Node
+    glm::fquat                  mOrientation;   ///< Quaternion of relative orientation of the Node
+    glm::vec3                   mTranslation;   ///< Vector of relative translation of the Node
+    std::vector<unsigned int>   mMeshes;        ///< Index of each Mesh of the Node in ModelData::mMeshes
+    std::vector<NodeData>       mChildren;      ///< Children of the Node
+};
+
+/**
+ * @brief   CPU side data of an imported model, ready to be uploaded to the GPU
+ * @ingroup Main
+ *
+ *  Produced by ResourceManager::importFile() without any OpenGL call, so that the import of a model
+ * can be done on a worker thread, leaving only the upload of its Meshes to the render thread.
+ */
+struct ModelData {
+    std::string             mFilename;      ///< Name of the model file
+    unsigned int            mImportFlags;   ///< Assimp post-processing flags used for the import
+    std::vector<MeshData>   mMeshes;        ///< Meshes of the file, by Assimp index (shared between Nodes)
+    NodeData                mRoot;          ///< Root of the hierarchy of Nodes
+
+    /**
+     * @brief Size of the data of all the Meshes to upload to the GPU, in bytes
+     */
+    inline size_t getNbBytes() const {
+        size_t nbBytes = 0;
+        for (std::vector<MeshData>::const_iterator iMesh = mMeshes.begin(); iMesh != mMeshes.end(); ++iMesh) {
+            nbBytes += iMesh->getNbBytes();
+        }
+        return nbBytes;
+    }
+};
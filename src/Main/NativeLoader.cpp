@@ -0,0 +1,229 @@
+/**
+ * @file    NativeLoader.cpp
+ * @ingroup Main
+ * @brief   Dedicated loaders of the PLY and OBJ formats, parsing memory mapped files by chunks in parallel
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/NativeLoader.h"
+#include "Main/VertexAttributes.h"
+#include "Utils/Exception.h"
+#include "Utils/MappedFile.h"
+
+#include <algorithm>    // std::min, std::max, std::transform
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>       // std::thread
+#include <atomic>       // std::atomic
+#include <functional>   // std::ref, std::cref
+#include <stdexcept>    // std::exception
+#include <cstring>      // memchr
+#include <cctype>       // tolower
+
+/// Minimum size of a chunk of text parsed by a thread, in bytes (smaller files are not worth splitting)
+static const size_t         _minChunkSize   = 256 * 1024;
+/// Maximum number of vertices of a Mesh, addressable with 16 bits indices
+static const unsigned int   _maxMeshVertices = 65536;
+/// Number of imports running concurrently (see NativeLoader::Import)
+static std::atomic<unsigned int> _nbImports(0);
+
+/**
+ * @brief Get the lower case extension of a file name (without the dot)
+ */
+static std::string getExtension(const std::string& aFilename) {
+    std::string extension;
+    const size_t dot = aFilename.find_last_of('.');
+    if (std::string::npos != dot) {
+        extension = aFilename.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    }
+    return extension;
+}
+
+/**
+ * @brief Tell if a file can be loaded by a dedicated loader (by its extension)
+ *
+ * @param[in] aFilename Name of the model file
+ */
+bool NativeLoader::isSupported(const std::string& aFilename) {
+    const std::string extension = getExtension(aFilename);
+    return (0 == extension.compare("ply")) || (0 == extension.compare("obj"));
+}
+
+/**
+ * @brief Load a PLY or OBJ file, without any OpenGL call
+ *
+ * @param[in]  aFilename    Name of the model file (PLY or OBJ, see isSupported())
+ * @param[out] aModelData   CPU side data of the model: a single Node with one or more Meshes
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+void NativeLoader::importFile(const std::string& aFilename, ModelData& aModelData) {
+    RawMesh             rawMesh;
+    Utils::MappedFile   file(aFilename);
+
+    if (0 == getExtension(aFilename).compare("ply")) {
+        PlyLoader::load(file.getData(), file.getSize(), rawMesh);
+    } else {
+        ObjLoader::load(file.getData(), file.getSize(), rawMesh);
+    }
+    if (rawMesh.mIndices.empty()) {
+        UTILS_THROW("NativeLoader: no triangle in \"" << aFilename << "\"");
+    }
+
+    // Name the Node and its Meshes after the file
+    const size_t slash = aFilename.find_last_of("/\\");
+    const std::string name = aFilename.substr((std::string::npos != slash) ? (slash + 1) : 0);
+    buildModel(rawMesh, name, aModelData);
+}
+
+/**
+ * @brief Convert a RawMesh into Meshes of 16 bits indices of a single Node
+ *
+ *  Triangles are added in order to the current Mesh until it would exceed 65536 vertices,
+ * so that the vertices of a Mesh stay close to each other as in the file.
+ *
+ * @param[in,out] aRawMesh      Raw mesh read from a file (vertices are welded and normals generated if missing)
+ * @param[in]     aName         Name of the Node (and base name of the Meshes)
+ * @param[out]    aModelData    CPU side data of the model
+ */
+void NativeLoader::buildModel(RawMesh& aRawMesh, const std::string& aName, ModelData& aModelData) {
+    if (aRawMesh.mNormals.size() != aRawMesh.mPositions.size()) {
+        VertexAttributes vertexAttributes;
+        vertexAttributes.generateNormals(aRawMesh);
+    }
+    const bool bColors = (aRawMesh.mColors.size() == aRawMesh.mPositions.size());
+
+    aModelData.mMeshes.clear();
+    aModelData.mRoot = NodeData();
+    aModelData.mRoot.mName = aName;
+
+    std::vector<int>            localIndices(aRawMesh.mPositions.size(), -1);
+    std::vector<unsigned int>   usedVertices;
+    for (size_t idxIndex = 0; idxIndex < aRawMesh.mIndices.size(); idxIndex += 3) {
+        // Start a new Mesh when the current one could not take the 3 vertices of the next triangle
+        if (aModelData.mMeshes.empty() || (usedVertices.size() + 3 > _maxMeshVertices)) {
+            for (size_t idxUsed = 0; idxUsed < usedVertices.size(); ++idxUsed) {
+                localIndices[usedVertices[idxUsed]] = -1;
+            }
+            usedVertices.clear();
+            aModelData.mRoot.mMeshes.push_back(static_cast<unsigned int>(aModelData.mMeshes.size()));
+            aModelData.mMeshes.push_back(MeshData());
+            std::ostringstream meshName;
+            meshName << aName << "#" << aModelData.mMeshes.size() - 1;
+            aModelData.mMeshes.back().mName = meshName.str();
+        }
+        MeshData& meshData = aModelData.mMeshes.back();
+        for (size_t idxCorner = idxIndex; idxCorner < idxIndex + 3; ++idxCorner) {
+            const unsigned int idxVertex = aRawMesh.mIndices[idxCorner];
+            if (0 > localIndices[idxVertex]) {
+                // First use of the vertex by this Mesh: interleave its position, color and normal
+                localIndices[idxVertex] = static_cast<int>(usedVertices.size());
+                usedVertices.push_back(idxVertex);
+                meshData.mVertexData.push_back(aRawMesh.mPositions[idxVertex]);
+                meshData.mVertexData.push_back(bColors ? aRawMesh.mColors[idxVertex] : glm::vec3(1.0f, 1.0f, 1.0f));
+                meshData.mVertexData.push_back(aRawMesh.mNormals[idxVertex]);
+            }
+            meshData.mIndexData.push_back(static_cast<GLshort>(localIndices[idxVertex]));
+        }
+    }
+}
+
+/**
+ * @brief Split a text buffer at line boundaries into chunks to parse in parallel
+ *
+ *  There is one chunk per thread available to the import (see getNbThreads()), but no chunk smaller than 256KB.
+ *
+ * @param[in]  apData   Start of the text buffer
+ * @param[in]  aSize    Size of the text buffer, in bytes
+ * @param[out] aChunks  Boundaries of the chunks: chunk N goes from aChunks[N] to aChunks[N+1]
+ */
+void NativeLoader::splitLines(const char* apData, size_t aSize, std::vector<const char*>& aChunks) {
+    const size_t nbThreads  = getNbThreads();
+    const size_t nbChunks   = std::max(static_cast<size_t>(1), std::min(nbThreads, aSize / _minChunkSize));
+    const char*  pEnd       = apData + aSize;
+
+    aChunks.clear();
+    aChunks.push_back(apData);
+    for (size_t idxChunk = 1; idxChunk < nbChunks; ++idxChunk) {
+        // Move the boundary just after the next end of line
+        const char* pBoundary = std::max(aChunks.back(), apData + (aSize * idxChunk) / nbChunks);
+        const char* pEol = static_cast<const char*>(memchr(pBoundary, '\n', pEnd - pBoundary));
+        if (nullptr == pEol) {
+            break;
+        }
+        aChunks.push_back(pEol + 1);
+    }
+    aChunks.push_back(pEnd);
+}
+
+/**
+ * @brief Run a function on a chunk, catching any exception (which must not escape a thread)
+ *
+ * @param[in]  aFunction    Function to call with the index of the chunk
+ * @param[in]  aIdxChunk    Index of the chunk
+ * @param[out] aError       Error message of the exception thrown, if any
+ */
+static void runChunk(const std::function<void(size_t)>& aFunction, size_t aIdxChunk, std::string& aError) {
+    try {
+        aFunction(aIdxChunk);
+    } catch (std::exception& e) {
+        aError = e.what();
+    }
+}
+
+/**
+ * @brief Run a function on each chunk, in parallel (the first chunk on the calling thread)
+ *
+ * @param[in] aNbChunks     Number of chunks
+ * @param[in] aFunction     Function to call with the index of each chunk
+ *
+ * @throw a std::exception if the function threw for any chunk (std::runtime_error).
+ */
+void NativeLoader::runChunks(size_t aNbChunks, const std::function<void(size_t)>& aFunction) {
+    std::vector<std::string> errors(aNbChunks);
+    std::vector<std::thread> threads;
+    for (size_t idxChunk = 1; idxChunk < aNbChunks; ++idxChunk) {
+        threads.push_back(std::thread(runChunk, std::cref(aFunction), idxChunk, std::ref(errors[idxChunk])));
+    }
+    if (0 < aNbChunks) {
+        runChunk(aFunction, 0, errors[0]);
+    }
+    for (std::vector<std::thread>::iterator iThread = threads.begin(); iThread != threads.end(); ++iThread) {
+        iThread->join();
+    }
+    for (size_t idxChunk = 0; idxChunk < aNbChunks; ++idxChunk) {
+        if (false == errors[idxChunk].empty()) {
+            UTILS_THROW(errors[idxChunk]);
+        }
+    }
+}
+
+/**
+ * @brief Number of threads available to the chunks of an import
+ *
+ *  The hardware threads are shared evenly by the imports running concurrently (see Import), at least one each.
+ */
+size_t NativeLoader::getNbThreads() {
+    const unsigned int nbImports = std::max(1U, _nbImports.load());
+    return std::max(1U, std::thread::hardware_concurrency() / nbImports);
+}
+
+/**
+ * @brief Count one more import running
+ */
+void NativeLoader::startImport() {
+    ++_nbImports;
+}
+
+/**
+ * @brief Count one less import running
+ */
+void NativeLoader::endImport() {
+    --_nbImports;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file    NativeLoader.h
+ * @ingroup Main
+ * @brief   Dedicated loaders of the PLY and OBJ formats, parsing memory mapped files by chunks in parallel
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Main/ModelData.h"
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::vec3 (GLM_FORCE_RADIANS defined at the project level)
+
+#include <vector>           // std::vector
+#include <string>           // std::string
+#include <functional>       // std::function
+#include <cstddef>          // size_t
+
+/**
+ * @brief   Triangle mesh as read from a file, with 32 bits indices and separate vertex attributes
+ * @ingroup Main
+ */
+struct RawMesh {
+    std::vector<glm::vec3>      mPositions; ///< Position of each vertex
+    std::vector<glm::vec3>      mNormals;   ///< Normal of each vertex (empty if not in the file)
+    std::vector<glm::vec3>      mColors;    ///< Color of each vertex (empty if not in the file)
+    std::vector<unsigned int>   mIndices;   ///< Triangle list of indices of vertices
+};
+
+/**
+ * @brief   Dedicated loaders of the PLY and OBJ formats, parsing memory mapped files by chunks in parallel
+ * @ingroup Main
+ *
+ *  Assimp generic importers read these simple but big text files line by line through its IOSystem,
+ * with a locale dependent float parsing, and then need post-processing to get an indexed triangle list.
+ * Here, the file is memory mapped (see Utils::MappedFile), split into chunks at line boundaries parsed in parallel,
+ * with the allocation-free number parsers of Utils/Parse.h, directly into a RawMesh.
+ *
+ *  The RawMesh is then split into Meshes of at most 65536 vertices (16 bits indices, see Mesh::IndexData),
+ * with smooth normals generated in parallel if the file has none (see VertexAttributes).
+ */
+class NativeLoader {
+public:
+    /**
+     * @brief   RAII scope of an import, sharing the hardware threads with the other imports running concurrently
+     * @ingroup Main
+     *
+     *  The AssetStreamer runs one import per worker thread: without this, each of them would split its file
+     * into one chunk per hardware thread, and loading several big files would run N^2 threads at once.
+     */
+    class Import {
+     public:
+        /**
+         * @brief Constructor: count one more import running
+         */
+        Import() {
+            startImport();
+        }
+        /**
+         * @brief Destructor: count one less import running
+         */
+        ~Import() {
+            endImport();
+        }
+
+     private:
+        /// disallow copy constructor and assignment operator
+        DISALLOW_COPY_AND_ASSIGN(Import);
+    };
+
+public:
+    // Tell if a file can be loaded by a dedicated loader (by its extension)
+    static bool isSupported(const std::string& aFilename);
+
+    // Load a PLY or OBJ file (no OpenGL call, thread-safe)
+    static void importFile(const std::string& aFilename, ModelData& aModelData);
+
+    // Convert a RawMesh into Meshes of 16 bits indices of a single Node
+    static void buildModel(RawMesh& aRawMesh, const std::string& aName, ModelData& aModelData);
+
+    // Split a text buffer at line boundaries into chunks to parse in parallel
+    static void splitLines(const char* apData, size_t aSize, std::vector<const char*>& aChunks);
+
+    // Run a function on each chunk, in parallel
+    static void runChunks(size_t aNbChunks, const std::function<void(size_t)>& aFunction);
+    // Number of threads available to the chunks of an import (hardware threads shared by the imports running)
+    static size_t getNbThreads();
+
+private:
+    // Count the imports running (see Import)
+    static void startImport();
+    static void endImport();
+};
+
+/**
+ * @brief   Loader of the PLY ("Polygon File Format" or "Stanford Triangle Format") file format, ASCII or binary
+ * @ingroup Main
+ */
+class PlyLoader {
+public:
+    // Parse the content of a PLY file
+    static void load(const char* apData, size_t aSize, RawMesh& aRawMesh);
+};
+
+/**
+ * @brief   Loader of the OBJ (Wavefront) file format: vertices, normals and polygonal faces only
+ * @ingroup Main
+ */
+class ObjLoader {
+public:
+    // Parse the content of an OBJ file
+    static void load(const char* apData, size_t aSize, RawMesh& aRawMesh);
+};
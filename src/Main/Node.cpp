@@ -10,7 +10,6 @@
  */
 
 #include "Main/Node.h"
-#include "Main/MatrixStack.h"
 
 #include <glm/gtc/matrix_transform.hpp> // glm::perspective, glm::rotate, glm::translate
 #include <glm/gtc/type_ptr.hpp>         // glm::value_ptr
@@ -30,7 +29,8 @@ const glm::vec3 Node::UNIT_Z_FRONT(0.0f, 0.0f, 1.0f);   // "front of the world"
  */
 Node::Node(const char* apName) :
     mName(apName),
-    mbMatrixDirty(false) {
+    mbMatrixDirty(false),
+    mMatrixVersion(0) {
 }
 
 /**
@@ -103,7 +103,7 @@ void Node::roll(float aAngle) {
  *
  * @return  Vector of children of the current Node
  */
-inline const glm::mat4& Node::getMatrix() const {
+const glm::mat4& Node::getMatrix() const {
     if (mbMatrixDirty) {
         // Translation matrix
         glm::mat4 translation   = glm::translate(glm::mat4(1.0f), mTranslationVector);
@@ -111,6 +111,8 @@ inline const glm::mat4& Node::getMatrix() const {
         glm::mat4 rotation      = glm::mat4_cast(mOrientationQuaternion);
         // Calculate the new relative "modelToWorldMatrix" (from right to left: rotation , then translation )
         mMatrix                 = (translation  * rotation );
+        mbMatrixDirty           = false;
+        ++mMatrixVersion;
     }
 
     return mMatrix;
@@ -137,30 +139,34 @@ void Node::move(float aDeltaTime) {
 }
 
 /**
- * @brief Draw the node and its children
+ * @brief Clone the hierarchy: new Nodes with the same position, orientation and motion, sharing the same Meshes
  *
- * @param[in] aModelToCameraMatrixStack "Model to Camera" matrix stack
- * @param[in] aModelToCameraMatrixUnif  Location of the "modelToCameraMatrix" vertex shader uniform input variable
+ * @return A pointer to the new Node
  */
-void Node::draw(MatrixStack& aModelToCameraMatrixStack, GLuint aModelToCameraMatrixUnif) const {
-    MatrixStack::Push push(aModelToCameraMatrixStack); // RAII Push/Pop MatrixStack
-
-    // Re-calculate the relative Model to World transformations matrix, and right-multiply it to the stack
-    // => this effectively build the absolute "modelToCameraMatrix"
-    aModelToCameraMatrixStack.multiply(getMatrix());
-
-    // Set uniform values with this new "modelToCameraMatrix" matrix
-    glUniformMatrix4fv(aModelToCameraMatrixUnif, 1, GL_FALSE, glm::value_ptr(aModelToCameraMatrixStack.top()));
-
-    // Draw meshes of the current Node
-    for (Mesh::List::const_iterator iMesh = mMeshesList.begin(); iMesh != mMeshesList.end(); ++iMesh) {
-        (*iMesh)->draw();
+Node::Ptr Node::clone() const {
+    Node::Ptr NodePtr(new Node(mName.c_str()));
+    NodePtr->mPhysic                = mPhysic;
+    NodePtr->mOrientationQuaternion = mOrientationQuaternion;
+    NodePtr->mTranslationVector     = mTranslationVector;
+    NodePtr->mbMatrixDirty          = true;
+    NodePtr->mMeshesList            = mMeshesList;
+    for (List::const_iterator iChild = mChildrenList.begin(); iChild != mChildrenList.end(); ++iChild) {
+        NodePtr->addChildNode((*iChild)->clone());
     }
+    return NodePtr;
+}
 
-    // And ask children Nodes to draw themselves
+/**
+ * @brief Count the Nodes of the hierarchy
+ *
+ * @return Number of Nodes (this Node and all its descendants)
+ */
+unsigned int Node::getNbNodes() const {
+    unsigned int nbNodes = 1;
     for (List::const_iterator iChild = mChildrenList.begin(); iChild != mChildrenList.end(); ++iChild) {
-        (*iChild)->draw(aModelToCameraMatrixStack, aModelToCameraMatrixUnif);
+        nbNodes += (*iChild)->getNbNodes();
     }
+    return nbNodes;
 }
 
 /**
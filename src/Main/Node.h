@@ -24,8 +24,6 @@
 #include <vector>                   // std::vector
 #include <string>                   // std::string
 
-class MatrixStack;
-
 /**
  * @brief Node of a Scene graph
  * @ingroup Main
@@ -57,6 +55,7 @@ public:
     // Set speeds
     inline void setLinearSpeed(const glm::vec3& aLinearSpeed);
     inline void setRotationalSpeed(const glm::vec3& aRotationalSpeed);
+    inline bool isInMotion() const;
 
     // Explicit setters (used at load time with Assimp)
     inline void setOrientationQuaternion(float w, float x, float y, float z);
@@ -64,18 +63,24 @@ public:
 
     // Calculate and return the current Rotations & Translations matrix
     const glm::mat4& getMatrix() const;
+    // Version of the matrix, incremented each time it is recalculated
+    inline unsigned int getMatrixVersion() const;
 
     // Calculate new position and orientation given current Node movements
     void move(float aDeltaTime);
 
-    // Draw
-    void draw(MatrixStack& aModelToCameraMatrixStack, GLuint aModelToWorldMatrixUnif) const;
+    // Clone the hierarchy, sharing the Meshes
+    Ptr clone() const;
+
+    // Number of Nodes of the hierarchy (this Node and all its descendants)
+    unsigned int getNbNodes() const;
 
     // Getters/Setters
     inline const std::string& getName() const;
     inline const List&  getChildren() const;
     inline       void   addChildNode(const Node::Ptr& aChildNodePtr);
-    inline       void   addMesh(Mesh::Ptr& aMeshPtr);
+    inline const Mesh::List& getMeshes() const;
+    inline       void   addMesh(const Mesh::Ptr& aMeshPtr);
 
     // Rotate a given quaternion by an axis and an angle
     static void rotateRightMultiply(glm::fquat& aCameraOrientation, float aAngRad, const glm::vec3 &aAxis);
@@ -95,6 +100,7 @@ private:
     // Mutable to enable updating in const getter
     mutable glm::mat4   mMatrix;                ///< Composed resulting Matrix of orientation and translation
     mutable bool        mbMatrixDirty;          ///< Tell if the composed Matrix is up to date or need recalculation
+    mutable unsigned int mMatrixVersion;        ///< Incremented each time the composed Matrix is recalculated
 
 private:
     /// disallow copy constructor and assignment operator (needs an explicit clone() method to handle hierarchy)
@@ -120,6 +126,13 @@ inline void Node::setRotationalSpeed(const glm::vec3& aRotationalSpeed) {
     mPhysic.setRotationalSpeed(aRotationalSpeed);
 }
 
+/**
+ * @brief   Tell if the Node has any linear or rotational speed (moving by itself each frame)
+ */
+inline bool Node::isInMotion() const {
+    return mPhysic.isInMotion();
+}
+
 /**
  * @brief   Set the relative orientation of the Node (from its parent)
  *
@@ -152,6 +165,15 @@ inline void Node::setTranslationVector(float x, float y, float z) {
     mbMatrixDirty = true;
 }
 
+/**
+ * @brief   Get the version of the composed Matrix, incremented each time it is recalculated by getMatrix()
+ *
+ *  Lets the RetainedDrawList of the Scene detect the Nodes which moved since its last update.
+ */
+inline unsigned int Node::getMatrixVersion() const {
+    return mMatrixVersion;
+}
+
 /**
  * @brief   Get the Name of the current Node
  *
@@ -173,6 +195,8 @@ inline const Node::List& Node::getChildren() const {
 /**
  * @brief   Add a child Node to the current Node
  *
+ *  To add a child to a Node already part of a Scene, use Scene::addChildNode() to update its RetainedDrawList.
+ *
  * @param[in] aChildNodePtr Child Node to add 
  */
 inline void Node::addChildNode(const Node::Ptr& aChildNodePtr) {
@@ -180,10 +204,19 @@ inline void Node::addChildNode(const Node::Ptr& aChildNodePtr) {
 }
 
 /**
- * @brief   Add a draw call to the current Node
+ * @brief   Get the list of Meshes of the current Node
+ *
+ * @return  Const Vector of Meshes of the current Node
+ */
+inline const Mesh::List& Node::getMeshes() const {
+    return mMeshesList;
+}
+
+/**
+ * @brief   Add a Mesh to the current Node (the Mesh can be shared by many Nodes), before adding it to a Scene
  *
- * @param[in] aMeshPtr Draw call to add
+ * @param[in] aMeshPtr Mesh to add
  */
-inline void Node::addMesh(Mesh::Ptr& aMeshPtr) {
-    mMeshesList.push_back(std::move(aMeshPtr));
+inline void Node::addMesh(const Mesh::Ptr& aMeshPtr) {
+    mMeshesList.push_back(aMeshPtr);
 }
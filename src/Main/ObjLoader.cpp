@@ -0,0 +1,247 @@
+/**
+ * @file    ObjLoader.cpp
+ * @ingroup Main
+ * @brief   Loader of the OBJ (Wavefront) file format: vertices, normals and polygonal faces only
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/NativeLoader.h"
+#include "Utils/Exception.h"
+#include "Utils/Parse.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>      // std::make_pair
+#include <functional>   // std::bind
+#include <cstdint>      // uint64_t, uint32_t
+
+/**
+ * @brief Corner of a face: index of its position and of its normal, as read from a chunk
+ *
+ *  Relative (negative) indices refer to the vertices defined before the face, so they are stored relative
+ * to the start of the chunk, until the number of vertices of the previous chunks is known.
+ */
+struct ObjCorner {
+    int     mPosition;          ///< Index of the position (0 based)
+    int     mNormal;            ///< Index of the normal (0 based), if mbNormal
+    bool    mbNormal;           ///< The corner has a normal
+    bool    mbRelativePosition; ///< mPosition is relative to the first position of the chunk
+    bool    mbRelativeNormal;   ///< mNormal is relative to the first normal of the chunk
+};
+
+/**
+ * @brief Content of a chunk of an OBJ file
+ */
+struct ObjChunk {
+    std::vector<glm::vec3>  mPositions; ///< "v" lines of the chunk
+    std::vector<glm::vec3>  mNormals;   ///< "vn" lines of the chunk
+    std::vector<ObjCorner>  mCorners;   ///< Triangle list of corners of the "f" lines of the chunk
+};
+
+/// Maximum number of vertices of a polygon
+static const int _maxCorners = 64;
+
+/**
+ * @brief Parse a vector of 3 floats
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+static void parseVector(const char*& apCursor, const char* apEnd, glm::vec3& aVector) {
+    if (!Utils::parseFloat(apCursor, apEnd, aVector.x)
+        || !Utils::parseFloat(apCursor, apEnd, aVector.y)
+        || !Utils::parseFloat(apCursor, apEnd, aVector.z)) {
+        UTILS_THROW("ObjLoader: invalid vector");
+    }
+}
+
+/**
+ * @brief Convert an OBJ index (1 based, or negative to count backward) into a 0 based index
+ *
+ * @param[in]  aIndex       Index as read from the file
+ * @param[in]  aNbDefined   Number of positions (or normals) defined before in the chunk
+ * @param[out] aIndex0      0 based index (relative to the start of the chunk if aIndex is negative)
+ * @param[out] abRelative   The 0 based index is relative to the start of the chunk
+ */
+static void convertIndex(int aIndex, size_t aNbDefined, int& aIndex0, bool& abRelative) {
+    abRelative = (0 > aIndex);
+    aIndex0 = abRelative ? (static_cast<int>(aNbDefined) + aIndex) : (aIndex - 1);
+}
+
+/**
+ * @brief Parse a "f" line: corners "v", "v/vt", "v/vt/vn" or "v//vn", triangulated as a fan
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+static void parseFace(const char*& apCursor, const char* apEnd, ObjChunk& aChunk) {
+    ObjCorner corners[_maxCorners];
+    int nbCorners = 0;
+    int index;
+    while (Utils::parseInt(apCursor, apEnd, index)) {
+        if (_maxCorners <= nbCorners) {
+            UTILS_THROW("ObjLoader: face with more than " << _maxCorners << " vertices");
+        }
+        ObjCorner& corner = corners[nbCorners];
+        ++nbCorners;
+        convertIndex(index, aChunk.mPositions.size(), corner.mPosition, corner.mbRelativePosition);
+        corner.mbNormal = false;
+        corner.mNormal = 0;
+        corner.mbRelativeNormal = false;
+        if ((apCursor < apEnd) && ('/' == *apCursor)) {
+            ++apCursor;
+            // Texture coordinates are ignored
+            if ((apCursor < apEnd) && ('/' != *apCursor)) {
+                Utils::parseInt(apCursor, apEnd, index);
+            }
+            if ((apCursor < apEnd) && ('/' == *apCursor)) {
+                ++apCursor;
+                corner.mbNormal = Utils::parseInt(apCursor, apEnd, index);
+                if (corner.mbNormal) {
+                    convertIndex(index, aChunk.mNormals.size(), corner.mNormal, corner.mbRelativeNormal);
+                }
+            }
+        }
+    }
+    if (3 > nbCorners) {
+        UTILS_THROW("ObjLoader: face with less than 3 vertices");
+    }
+    for (int idxCorner = 2; idxCorner < nbCorners; ++idxCorner) {
+        aChunk.mCorners.push_back(corners[0]);
+        aChunk.mCorners.push_back(corners[idxCorner - 1]);
+        aChunk.mCorners.push_back(corners[idxCorner]);
+    }
+}
+
+/**
+ * @brief Parse the lines of a chunk of an OBJ file
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+static void parseChunk(const std::vector<const char*>& aBoundaries, size_t aIdxChunk, std::vector<ObjChunk>& aChunks) {
+    const char* pCursor = aBoundaries[aIdxChunk];
+    const char* pEnd    = aBoundaries[aIdxChunk + 1];
+    ObjChunk&   chunk   = aChunks[aIdxChunk];
+
+    // Rough estimation of the number of vertices ("v x y z" lines of about 30 characters)
+    chunk.mPositions.reserve((pEnd - pCursor) / 64);
+    while (pCursor < pEnd) {
+        Utils::skipSpaces(pCursor, pEnd);
+        if ((pCursor + 1 < pEnd) && ('v' == pCursor[0]) && ((' ' == pCursor[1]) || ('\t' == pCursor[1]))) {
+            pCursor += 2;
+            chunk.mPositions.push_back(glm::vec3());
+            parseVector(pCursor, pEnd, chunk.mPositions.back());
+        } else if ((pCursor + 2 < pEnd) && ('v' == pCursor[0]) && ('n' == pCursor[1])
+                   && ((' ' == pCursor[2]) || ('\t' == pCursor[2]))) {
+            pCursor += 3;
+            chunk.mNormals.push_back(glm::vec3());
+            parseVector(pCursor, pEnd, chunk.mNormals.back());
+        } else if ((pCursor + 1 < pEnd) && ('f' == pCursor[0]) && ((' ' == pCursor[1]) || ('\t' == pCursor[1]))) {
+            pCursor += 2;
+            parseFace(pCursor, pEnd, chunk);
+        }
+        // else "vt", "g", "o", "s", "usemtl", "mtllib", comments... are ignored
+        Utils::skipLine(pCursor, pEnd);
+    }
+}
+
+/**
+ * @brief Resolve an index of a corner, and check it
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+static unsigned int resolveIndex(int aIndex, bool abRelative, size_t aChunkBase, size_t aNbDefined) {
+    const long long index = abRelative ? (static_cast<long long>(aChunkBase) + aIndex) : aIndex;
+    if ((0 > index) || (static_cast<long long>(aNbDefined) <= index)) {
+        UTILS_THROW("ObjLoader: invalid index " << index + 1);
+    }
+    return static_cast<unsigned int>(index);
+}
+
+/**
+ * @brief Parse the content of an OBJ file
+ *
+ *  Chunks of lines are parsed in parallel, then concatenated in order. Relative (negative) indices are resolved
+ * with the number of vertices of the previous chunks.
+ *
+ *  Position/normal pairs are welded into single vertices. If any corner of a face has no normal,
+ * all normals of the file are dropped, to be generated smoothly (see VertexAttributes).
+ *
+ * @param[in]  apData   Content of the file (memory mapped)
+ * @param[in]  aSize    Size of the file, in bytes
+ * @param[out] aRawMesh Triangle mesh read from the file
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+void ObjLoader::load(const char* apData, size_t aSize, RawMesh& aRawMesh) {
+    std::vector<const char*> boundaries;
+    NativeLoader::splitLines(apData, aSize, boundaries);
+    const size_t nbChunks = boundaries.size() - 1;
+
+    std::vector<ObjChunk> chunks(nbChunks);
+    NativeLoader::runChunks(nbChunks, std::bind(parseChunk, std::cref(boundaries), std::placeholders::_1,
+                                                std::ref(chunks)));
+
+    // Concatenate the positions and normals of the chunks, remembering the number before each chunk
+    std::vector<glm::vec3>  normals;
+    std::vector<size_t>     positionBases(nbChunks);
+    std::vector<size_t>     normalBases(nbChunks);
+    size_t                  nbCorners = 0;
+    bool                    bNormals = true;
+    aRawMesh.mPositions.clear();
+    aRawMesh.mNormals.clear();
+    aRawMesh.mColors.clear();
+    aRawMesh.mIndices.clear();
+    for (size_t idxChunk = 0; idxChunk < nbChunks; ++idxChunk) {
+        const ObjChunk& chunk = chunks[idxChunk];
+        positionBases[idxChunk] = aRawMesh.mPositions.size();
+        normalBases[idxChunk] = normals.size();
+        aRawMesh.mPositions.insert(aRawMesh.mPositions.end(), chunk.mPositions.begin(), chunk.mPositions.end());
+        normals.insert(normals.end(), chunk.mNormals.begin(), chunk.mNormals.end());
+        nbCorners += chunk.mCorners.size();
+        for (size_t idxCorner = 0; bNormals && (idxCorner < chunk.mCorners.size()); ++idxCorner) {
+            bNormals = chunk.mCorners[idxCorner].mbNormal;
+        }
+    }
+
+    aRawMesh.mIndices.reserve(nbCorners);
+    if (false == bNormals) {
+        // Positions only: the indices of the file are used as is
+        for (size_t idxChunk = 0; idxChunk < nbChunks; ++idxChunk) {
+            const std::vector<ObjCorner>& corners = chunks[idxChunk].mCorners;
+            for (size_t idxCorner = 0; idxCorner < corners.size(); ++idxCorner) {
+                aRawMesh.mIndices.push_back(resolveIndex(corners[idxCorner].mPosition,
+                                                         corners[idxCorner].mbRelativePosition,
+                                                         positionBases[idxChunk], aRawMesh.mPositions.size()));
+            }
+        }
+    } else {
+        // Weld each distinct position/normal pair into a vertex
+        std::vector<glm::vec3>                      positions;
+        std::unordered_map<uint64_t, unsigned int>  vertices;
+        positions.reserve(aRawMesh.mPositions.size());
+        aRawMesh.mNormals.reserve(aRawMesh.mPositions.size());
+        for (size_t idxChunk = 0; idxChunk < nbChunks; ++idxChunk) {
+            const std::vector<ObjCorner>& corners = chunks[idxChunk].mCorners;
+            for (size_t idxCorner = 0; idxCorner < corners.size(); ++idxCorner) {
+                const ObjCorner& corner = corners[idxCorner];
+                const unsigned int idxPosition = resolveIndex(corner.mPosition, corner.mbRelativePosition,
+                                                              positionBases[idxChunk], aRawMesh.mPositions.size());
+                const unsigned int idxNormal = resolveIndex(corner.mNormal, corner.mbRelativeNormal,
+                                                            normalBases[idxChunk], normals.size());
+                const uint64_t key = (static_cast<uint64_t>(idxPosition) << 32) | idxNormal;
+                std::unordered_map<uint64_t, unsigned int>::const_iterator iVertex = vertices.find(key);
+                if (vertices.end() == iVertex) {
+                    iVertex = vertices.insert(std::make_pair(key, static_cast<unsigned int>(positions.size()))).first;
+                    positions.push_back(aRawMesh.mPositions[idxPosition]);
+                    aRawMesh.mNormals.push_back(normals[idxNormal]);
+                }
+                aRawMesh.mIndices.push_back(iVertex->second);
+            }
+        }
+        aRawMesh.mPositions.swap(positions);
+    }
+}
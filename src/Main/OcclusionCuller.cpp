@@ -0,0 +1,147 @@
+/**
+ * @file    OcclusionCuller.cpp
+ * @ingroup Main
+ * @brief   Hardware occlusion culling of the Nodes, by queries on their bounding boxes with temporal coherence
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/OcclusionCuller.h"
+
+#include <vector>   // std::vector
+
+
+/// Triangles of the unit cube, counter clockwise seen from outside (vertex i has the coordinates of the bits of i)
+static const GLshort _boxIndices[] = {
+    0, 4, 6,  0, 6, 2,  // -X
+    1, 3, 7,  1, 7, 5,  // +X
+    0, 1, 5,  0, 5, 4,  // -Y
+    2, 6, 7,  2, 7, 3,  // +Y
+    0, 2, 3,  0, 3, 1,  // -Z
+    4, 5, 7,  4, 7, 6   // +Z
+};
+
+
+/**
+ * @brief Constructor (disabled until setMinTriangles())
+ */
+OcclusionCuller::OcclusionCuller() :
+    mMinTriangles(0),
+    mFrame(0) {
+}
+
+/**
+ * @brief Destructor: delete the queries
+ */
+OcclusionCuller::~OcclusionCuller() {
+    for (size_t idxSlot = 0; idxSlot < mSlots.size(); ++idxSlot) {
+        if (0 != mSlots[idxSlot].mQuery) {
+            glDeleteQueries(1, &mSlots[idxSlot].mQuery);
+        }
+    }
+}
+
+/**
+ * @brief Read the results available at the start of a frame, never waiting for any
+ *
+ *  The queries have been issued at the end of a previous frame: their results are usually available
+ * one or two frames later, depending on the number of frames in flight.
+ */
+void OcclusionCuller::update() {
+    ++mFrame;
+    mRequests.clear();
+    for (size_t idxSlot = 0; idxSlot < mSlots.size(); ++idxSlot) {
+        Slot& slot = mSlots[idxSlot];
+        if (slot.mbPending) {
+            GLint bAvailable = GL_FALSE;
+            glGetQueryObjectiv(slot.mQuery, GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+            if (GL_FALSE != bAvailable) {
+                GLuint bAnySamplesPassed = GL_FALSE;
+                glGetQueryObjectuiv(slot.mQuery, GL_QUERY_RESULT, &bAnySamplesPassed);
+                slot.mbVisible = (GL_FALSE != bAnySamplesPassed);
+                slot.mbPending = false;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Decide the visibility of a candidate Node for the current frame, requesting a new query if needed
+ *
+ * @param[in] aNode             Index of the Node
+ * @param[in] aBoxToWorldMatrix "Box to World" matrix of the Node, placing the unit cube onto its bounding box
+ * @param[in] abCameraInside    Tell if a camera is inside the bounding box (or too near), which cannot be queried
+ *
+ * @return Visibility of the Node for both eyes
+ */
+OcclusionCuller::Visibility OcclusionCuller::test(size_t aNode, const glm::mat4& aBoxToWorldMatrix,
+                                                  bool abCameraInside) {
+    if (mSlots.size() <= aNode) {
+        const Slot slot = {0, false, true};
+        mSlots.resize(aNode + 1, slot);
+    }
+    Slot& slot = mSlots[aNode];
+
+    Visibility visibility;
+    if (abCameraInside) {
+        // The box would be clipped by the near plane: visible, and queried again once the camera is outside
+        slot.mbVisible = true;
+        visibility = eVisible;
+    } else if (slot.mbPending) {
+        // The new result is not yet available: let the GPU wait for it, instead of the CPU
+        visibility = slot.mbVisible ? eVisible : eConditional;
+    } else {
+        // Occluded Nodes are queried each frame, visible ones once every few frames
+        if ((false == slot.mbVisible) || (0 == (aNode + mFrame) % VISIBLE_INTERVAL)) {
+            const Request request = {aNode, aBoxToWorldMatrix};
+            mRequests.push_back(request);
+        }
+        visibility = slot.mbVisible ? eVisible : eOccluded;
+    }
+    return visibility;
+}
+
+/**
+ * @brief Start the query of a request, before drawing its bounding box in both eyes
+ *
+ * @param[in] aIdxRequest   Index of the request
+ */
+void OcclusionCuller::beginQuery(size_t aIdxRequest) {
+    Slot& slot = mSlots[mRequests[aIdxRequest].mNode];
+    if (0 == slot.mQuery) {
+        glGenQueries(1, &slot.mQuery);
+    }
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, slot.mQuery);
+}
+
+/**
+ * @brief Stop the query of a request, its result being read by a next frame
+ *
+ * @param[in] aIdxRequest   Index of the request
+ */
+void OcclusionCuller::endQuery(size_t aIdxRequest) {
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+    mSlots[mRequests[aIdxRequest].mNode].mbPending = true;
+}
+
+/**
+ * @brief Make the unit cube [-1,1] drawn for the queries, to be uploaded like any other Mesh
+ *
+ * @param[out] aMeshData    Vertex data (position, color, and normal) and indices of the cube
+ */
+void OcclusionCuller::makeBox(MeshData& aMeshData) {
+    aMeshData.mName = "occlusion box";
+    aMeshData.mVertexData.clear();
+    for (int idxVertex = 0; idxVertex < 8; ++idxVertex) {
+        const glm::vec3 position((idxVertex & 1) ? 1.0f : -1.0f, (idxVertex & 2) ? 1.0f : -1.0f,
+                                 (idxVertex & 4) ? 1.0f : -1.0f);
+        aMeshData.mVertexData.push_back(position);
+        aMeshData.mVertexData.push_back(glm::vec3(1.0f, 1.0f, 1.0f));
+        aMeshData.mVertexData.push_back(glm::normalize(position));
+    }
+    aMeshData.mIndexData.assign(_boxIndices, _boxIndices + sizeof(_boxIndices) / sizeof(_boxIndices[0]));
+    aMeshData.mLods.clear();
+}
@@ -0,0 +1,179 @@
+/**
+ * @file    OcclusionCuller.h
+ * @ingroup Main
+ * @brief   Hardware occlusion culling of the Nodes, by queries on their bounding boxes with temporal coherence
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Main/Mesh.h"
+#include "Main/ModelData.h"
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::mat4 (GLM_FORCE_RADIANS defined at the project level)
+
+#include <vector>           // std::vector
+#include <cstddef>          // size_t
+
+/**
+ * @brief   Hardware occlusion culling of the Nodes, by queries on their bounding boxes with temporal coherence
+ * @ingroup Main
+ *
+ *  The bounding box of each candidate Node (with enough triangles for a query to pay off) is drawn, without
+ * any color nor depth write, against the depth buffer of both eyes at the end of the frame, inside a single
+ * GL_ANY_SAMPLES_PASSED query: its visibility is thus decided once for both eyes.
+ *
+ *  Results are never waited for: they are read at the start of a next frame, when available (see update()),
+ * and the visibility of each Node is kept from frame to frame (temporal coherence):
+ * - a visible Node is drawn, and queried again only once every few frames (staggered between Nodes),
+ * - an occluded Node is culled before any draw call, and queried again each frame, as soon as its last result
+ *   has been read. While this new result is not available, its draws are emitted under a conditional render
+ *   waiting for it on the GPU side (see glBeginConditionalRender()), so that a Node becoming visible again
+ *   never misses a frame, without stalling the CPU. Draws under a conditional render cannot be instanced
+ *   together, which pays off only for Nodes with many triangles.
+ *
+ *  A Node whose bounding box contains a camera (or nearly so) is always visible, without any query, since
+ * its box would be clipped by the near plane.
+ */
+class OcclusionCuller {
+public:
+    /// Visibility of a Node for the current frame, for both eyes
+    enum Visibility {
+        eVisible = 0,   ///< Drawn (not a candidate, or visible at the last result)
+        eOccluded,      ///< Culled (occluded at the last result, read)
+        eConditional    ///< Drawn under a conditional render (occluded at the last result, a new one pending)
+    };
+
+public:
+    OcclusionCuller();
+    ~OcclusionCuller(); // not virtual because no virtual methods and class not derived
+
+    // Minimum number of triangles of a Node for its visibility to be queried (0 to disable occlusion culling)
+    inline void setMinTriangles(unsigned int aMinTriangles);
+    inline unsigned int getMinTriangles() const;
+    inline bool isEnabled() const;
+
+    // Read the results available at the start of a frame (never waiting for any)
+    void update();
+    // Decide the visibility of a candidate Node for the current frame, requesting a new query if needed
+    Visibility test(size_t aNode, const glm::mat4& aBoxToWorldMatrix, bool abCameraInside);
+    // Query of a Node, to be used by the conditional render of its draws
+    inline GLuint getQuery(size_t aNode) const;
+
+    // Queries requested for the current frame, with the "Box to World" matrix of their Node
+    inline size_t getNbRequests() const;
+    inline const glm::mat4& getRequestMatrix(size_t aIdxRequest) const;
+    // Query boundaries of a request, around the draws of its bounding box in both eyes
+    void beginQuery(size_t aIdxRequest);
+    void endQuery(size_t aIdxRequest);
+    // Forget the requests of the current frame (issued or not)
+    inline void clearRequests();
+
+    // Unit cube [-1,1] bounding box, scaled and placed by the "Box to World" matrix of each Node
+    static void makeBox(MeshData& aMeshData);
+    inline void setBox(const Mesh::Ptr& aBoxPtr);
+    inline const Mesh& getBox() const;
+
+private:
+    /// A visible Node is queried again once every VISIBLE_INTERVAL frames
+    static const unsigned int VISIBLE_INTERVAL = 4;
+
+    /**
+     * @brief Occlusion state of a Node
+     */
+    struct Slot {
+        GLuint  mQuery;     ///< Occlusion query of the Node (0 until first requested)
+        bool    mbPending;  ///< Tell if the result of the query is still to be read
+        bool    mbVisible;  ///< Visibility at the last result read (visible until queried)
+    };
+
+    /**
+     * @brief Query requested for the current frame
+     */
+    struct Request {
+        size_t      mNode;              ///< Index of the Node
+        glm::mat4   mBoxToWorldMatrix;  ///< "Box to World" matrix of the Node
+    };
+
+private:
+    std::vector<Slot>       mSlots;         ///< Occlusion state of each Node, by index
+    std::vector<Request>    mRequests;      ///< Queries requested for the current frame
+    unsigned int            mMinTriangles;  ///< Minimum number of triangles of a candidate Node (0 if disabled)
+    unsigned int            mFrame;         ///< Index of the current frame, to stagger the queries of visible Nodes
+    Mesh::Ptr               mBoxPtr;        ///< Unit cube [-1,1] drawn for the queries
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(OcclusionCuller);
+};
+
+
+/**
+ * @brief Set the minimum number of triangles of a Node for its visibility to be queried (0 to disable)
+ */
+inline void OcclusionCuller::setMinTriangles(unsigned int aMinTriangles) {
+    mMinTriangles = aMinTriangles;
+}
+
+/**
+ * @brief Get the minimum number of triangles of a Node for its visibility to be queried (0 if disabled)
+ */
+inline unsigned int OcclusionCuller::getMinTriangles() const {
+    return mMinTriangles;
+}
+
+/**
+ * @brief Tell if occlusion culling is enabled
+ */
+inline bool OcclusionCuller::isEnabled() const {
+    return (0 < mMinTriangles);
+}
+
+/**
+ * @brief Get the query of a Node, to be used by the conditional render of its draws (see eConditional)
+ */
+inline GLuint OcclusionCuller::getQuery(size_t aNode) const {
+    return mSlots[aNode].mQuery;
+}
+
+/**
+ * @brief Get the number of queries requested for the current frame
+ */
+inline size_t OcclusionCuller::getNbRequests() const {
+    return mRequests.size();
+}
+
+/**
+ * @brief Get the "Box to World" matrix of the Node of a query requested for the current frame
+ */
+inline const glm::mat4& OcclusionCuller::getRequestMatrix(size_t aIdxRequest) const {
+    return mRequests[aIdxRequest].mBoxToWorldMatrix;
+}
+
+/**
+ * @brief Forget the requests of the current frame: those not issued are requested again by a next frame
+ */
+inline void OcclusionCuller::clearRequests() {
+    mRequests.clear();
+}
+
+/**
+ * @brief Set the unit cube [-1,1] drawn for the queries (uploaded from makeBox())
+ */
+inline void OcclusionCuller::setBox(const Mesh::Ptr& aBoxPtr) {
+    mBoxPtr = aBoxPtr;
+}
+
+/**
+ * @brief Get the unit cube [-1,1] drawn for the queries
+ */
+inline const Mesh& OcclusionCuller::getBox() const {
+    return *mBoxPtr;
+}
@@ -14,11 +14,13 @@
 
 /**
  * @brief Constructor
+ *
+ * @param[in] abFakeInfo    Use a fake profile if no device is found (see OculusHMDImpl::fakeInfo())
  */
-OculusHMD::OculusHMD() {
+OculusHMD::OculusHMD(bool abFakeInfo /* = false */) {
     try {
         // Create a private implementation of the interface
-        mImplPtr.reset(new OculusHMDImpl());
+        mImplPtr.reset(new OculusHMDImpl(abFakeInfo));
     } catch (std::exception&) {
         // Error, no Oculus Rift found
     }
@@ -31,6 +33,22 @@ OculusHMD::~OculusHMD() {
     // mImplPtr is released
 }
 
+/**
+ * @brief Get the lens distortion of the left eye (the right eye being its mirror image)
+ *
+ * @param[out] aDistortion  Lens distortion, in the normalized device coordinates of the viewport of the eye
+ *
+ * @return true if the distortion is known (from the device, or from the fake profile)
+ */
+bool OculusHMD::getDistortion(Distortion& aDistortion) const {
+    bool bKnown = false;
+    if (mImplPtr) {
+        mImplPtr->getDistortion(aDistortion);
+        bKnown = true;
+    }
+    return bKnown;
+}
+
 /**
  * @brief Set prediction lookahead in milliseconds
  *
@@ -26,12 +26,32 @@ class OculusHMDImpl;
  * - Get device properties
  * - Get user configuration
  * - Access head orientation
+ *
+ *  Without any device, a fake profile (of the first development kit) can give the device properties,
+ * like the lens distortion, so that the rendering can be configured and tested; the orientation is then fixed.
 */
 class OculusHMD {
 public:
-    OculusHMD();
+    /**
+     * @brief Lens distortion of the left eye, in the normalized device coordinates of its viewport
+     *
+     *  The right eye is its mirror image. A point at the radius r from the lens center (y being divided by
+     * the aspect ratio) samples the rendered image at the radius r.(K0 + K1.r^2 + K2.r^4 + K3.r^6) / scale.
+     */
+    struct Distortion {
+        float   mK[4];          ///< Coefficients of the radial distortion polynomial
+        float   mCenterOffset;  ///< Horizontal offset of the lens center from the center of the viewport
+        float   mScale;         ///< Scale fitting the distorted image into the viewport
+        float   mAspect;        ///< Aspect ratio (width / height) of the viewport of an eye
+    };
+
+public:
+    explicit OculusHMD(bool abFakeInfo = false);
     ~OculusHMD();
 
+    // Get the lens distortion (false if no device, nor any fake profile)
+    bool getDistortion(Distortion& aDistortion) const;
+
     // Set prediction lookahead amount in ms
     void setPrediction(int aPredictionDeltaMs);
     void incrPrediction(int aOffset);
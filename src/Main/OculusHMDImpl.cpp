@@ -12,12 +12,15 @@
 #include "Main/OculusHMDImpl.h"
 #include "Utils/Exception.h"
 
-#include <cassert>
-
 /**
  * @brief Constructor - finds the Oculus Rift and its sensor, or throw en exception.
+ *
+ *  Without any device, the fake profile can be used instead: the device properties are then known,
+ * but there is no sensor (the orientation is fixed).
+ *
+ * @param[in] abFakeInfo    Use the fake profile if no device is found, instead of throwing an exception
  */
-OculusHMDImpl::OculusHMDImpl() :
+OculusHMDImpl::OculusHMDImpl(bool abFakeInfo) :
     mLog("OculusHMD"),
     mPredictionLookaheadMs(30) {
 
@@ -79,6 +82,11 @@ OculusHMDImpl::OculusHMDImpl() :
             throw Utils::Exception("error: No HMD info");
         }
         mHMDPtr.Clear();
+    } else if (abFakeInfo) {
+        fakeInfo();
+        mStereoConfig.SetHMDInfo(mHMDInfo);
+        mLog.notice() << "No HMD found, using a fake profile (" << mHMDInfo.HResolution << "x"
+                      << mHMDInfo.VResolution << ") without any sensor";
     } else {
         mLog.notice() << "No HMD found";
         throw Utils::Exception("note: No HMD found");
@@ -97,9 +105,9 @@ OculusHMDImpl::~OculusHMDImpl() {
 }
 
 /**
- * @brief Load default HMD information to fake its presence for development purpose
+ * @brief Load default HMD information (of the first development kit) to fake its presence for development purpose
  *
- * @note Not used any more
+ *  Used when no device is found with "--fake-hmd", to test the rendering configured by the lens distortion.
  */
 void OculusHMDImpl::fakeInfo() {
     mHMDInfo.HResolution = 1280;
@@ -123,17 +131,32 @@ void OculusHMDImpl::fakeInfo() {
 }
 
 /**
- * @brief Set prediction lookahead in miliseconds
+ * @brief Get the lens distortion of the left eye, as configured by the stereo view parameters
+ *
+ * @param[out] aDistortion  Lens distortion, in the normalized device coordinates of the viewport of the eye
+ */
+void OculusHMDImpl::getDistortion(OculusHMD::Distortion& aDistortion) {
+    const OVR::Util::Render::DistortionConfig& config = mStereoConfig.GetDistortionConfig();
+    for (int idxK = 0; idxK < 4; ++idxK) {
+        aDistortion.mK[idxK] = config.K[idxK];
+    }
+    aDistortion.mCenterOffset   = config.XCenterOffset;
+    aDistortion.mScale          = config.Scale;
+    aDistortion.mAspect         = mStereoConfig.GetAspect();
+}
+
+/**
+ * @brief Set prediction lookahead in miliseconds (no-op without any sensor)
  *
  * @param[in] aPredictionDeltaMs    prediction lookahead amount in miliseconds
  */
 void OculusHMDImpl::setPrediction(int aPredictionDeltaMs) {
-    assert(mSensorPtr && mSensorFusionPtr);
-
-    mPredictionLookaheadMs = aPredictionDeltaMs;
-    // Enable prediction with the provided delta (default is 30ms 0.03s)
-    mSensorFusionPtr->SetPrediction(0.001f * aPredictionDeltaMs);
-    mLog.info() << "SetPrediction(" << aPredictionDeltaMs << "ms) = " << (0.001f * aPredictionDeltaMs);
+    if (mSensorFusionPtr) {
+        mPredictionLookaheadMs = aPredictionDeltaMs;
+        // Enable prediction with the provided delta (default is 30ms 0.03s)
+        mSensorFusionPtr->SetPrediction(0.001f * aPredictionDeltaMs);
+        mLog.info() << "SetPrediction(" << aPredictionDeltaMs << "ms) = " << (0.001f * aPredictionDeltaMs);
+    }
 }
 
 /**
@@ -149,23 +172,25 @@ void OculusHMDImpl::incrPrediction(int aOffset) {
 }
 
 /**
- * @brief Reset orientation of the HMD
+ * @brief Reset orientation of the HMD (no-op without any sensor)
  */
 void OculusHMDImpl::resetOrientation() {
-    assert(mSensorFusionPtr);
-
-    mSensorFusionPtr->Reset();
+    if (mSensorFusionPtr) {
+        mSensorFusionPtr->Reset();
+    }
 }
 
 /**
  * @brief Get quaternion of orientation of the HMD
  *
- * @return A GLM quaternion of orientation
+ * @return A GLM quaternion of orientation (identity without any sensor)
  */
 glm::fquat OculusHMDImpl::getOrientation() const {
-    assert(mSensorFusionPtr);
-
-    OVR::Quatf hmdOrientation = mSensorFusionPtr->GetOrientation();
-    return glm::fquat(hmdOrientation.w, hmdOrientation.x, hmdOrientation.y, hmdOrientation.z);
+    glm::fquat orientation;
+    if (mSensorFusionPtr) {
+        OVR::Quatf hmdOrientation = mSensorFusionPtr->GetOrientation();
+        orientation = glm::fquat(hmdOrientation.w, hmdOrientation.x, hmdOrientation.y, hmdOrientation.z);
+    }
+    return orientation;
 }
 
@@ -12,6 +12,8 @@
 
 #include "LoggerCpp/Logger.h"
 
+#include "Main/OculusHMD.h"
+
 #include <memory>                   // std::unique_ptr
 
 #include "OVR.h" // NOLINT(build/include): OculusVR fault!
@@ -28,12 +30,15 @@
 */
 class OculusHMDImpl {
 public:
-    OculusHMDImpl();
+    explicit OculusHMDImpl(bool abFakeInfo);
     ~OculusHMDImpl();
 
     // Load default information if no real device found
     void fakeInfo();
 
+    // Get the lens distortion of the left eye
+    void getDistortion(OculusHMD::Distortion& aDistortion);
+
     // Set prediction lookahead amount in ms
     void setPrediction(int aPredictionDeltaMs);
     void incrPrediction(int aOffset);
@@ -0,0 +1,176 @@
+/**
+ * @file    Options.cpp
+ * @ingroup Main
+ * @brief   Command line options of the application
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/Options.h"
+
+#include <string>
+#include <sstream>
+#include <cstdlib>  // atoi, atof
+#include <cstring>  // strcmp
+
+/**
+ * @brief Default options
+ */
+Options::Options() :
+    mManifestFilename("data/scene.txt"),
+    mbGenerateScene(false),
+    mNbFramesInFlight(2),
+    mNbFrames(0),
+    mbHeadless(false),
+    mNbLoaderThreads(0),
+    mUploadBudgetKB(1024),
+    mUploadBudgetUs(2000),
+    mLodPixelError(1.0f),
+    mImpostorPixelSize(16.0f),
+    mbCompactVertices(false),
+    mStaticBatchVertices(4096),
+    mDepthMode(eDepthNone),
+    mbOverdraw(false),
+    mOcclusionTriangles(0),
+    mOcclusionCpuWidth(0),
+    mbCockpitMask(false),
+    mbHiddenArea(false),
+    mbFakeHmd(false) {
+}
+
+/**
+ * @brief Parse the command line arguments
+ *
+ * @param[in] argc   Number or argument given on the command line (starting with 1, the executable itself)
+ * @param[in] argv   Array of pointers of strings containing the arguments
+ *
+ * @return true if all arguments are valid
+ */
+bool Options::parse(int argc, char** argv) {
+    bool bValid = true;
+
+    for (int idxArg = 1; (idxArg < argc) && bValid; ++idxArg) {
+        const char* pArg    = argv[idxArg];
+        const char* pValue  = (idxArg + 1 < argc) ? argv[idxArg + 1] : nullptr;
+
+        if (0 == strcmp(pArg, "--headless")) {
+            mbHeadless = true;
+        } else if (0 == strcmp(pArg, "--compact-vertices")) {
+            mbCompactVertices = true;
+        } else if (0 == strcmp(pArg, "--overdraw")) {
+            mbOverdraw = true;
+        } else if (0 == strcmp(pArg, "--cockpit-mask")) {
+            mbCockpitMask = true;
+        } else if (0 == strcmp(pArg, "--hidden-area")) {
+            mbHiddenArea = true;
+        } else if (0 == strcmp(pArg, "--fake-hmd")) {
+            mbFakeHmd = true;
+        } else if (nullptr == pValue) {
+            // All other options require a value
+            bValid = false;
+        } else {
+            ++idxArg;
+            if (0 == strcmp(pArg, "--manifest")) {
+                mManifestFilename = pValue;
+            } else if (0 == strcmp(pArg, "--scene")) {
+                mbGenerateScene = true;
+                mSceneModel = (0 == strcmp(pValue, "none")) ? "" : pValue;
+            } else if (0 == strcmp(pArg, "--instances")) {
+                mSceneConfig.mNbInstances = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--depth")) {
+                mSceneConfig.mDepth = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--fanout")) {
+                mSceneConfig.mFanOut = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--moving")) {
+                mSceneConfig.mMovingRatio = static_cast<float>(atof(pValue));
+            } else if (0 == strcmp(pArg, "--spacing")) {
+                mSceneConfig.mSpacing = static_cast<float>(atof(pValue));
+            } else if (0 == strcmp(pArg, "--seed")) {
+                mSceneConfig.mSeed = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--frames-in-flight")) {
+                mNbFramesInFlight = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--frames")) {
+                mNbFrames = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--output")) {
+                mOutputFilename = pValue;
+            } else if (0 == strcmp(pArg, "--loader-threads")) {
+                mNbLoaderThreads = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--upload-kb")) {
+                mUploadBudgetKB = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--upload-us")) {
+                mUploadBudgetUs = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--lod-error")) {
+                mLodPixelError = static_cast<float>(atof(pValue));
+            } else if (0 == strcmp(pArg, "--impostor")) {
+                mImpostorPixelSize = static_cast<float>(atof(pValue));
+            } else if (0 == strcmp(pArg, "--static-batching")) {
+                mStaticBatchVertices = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--depth-mode")) {
+                if (0 == strcmp(pValue, "none")) {
+                    mDepthMode = eDepthNone;
+                } else if (0 == strcmp(pValue, "sort")) {
+                    mDepthMode = eDepthSort;
+                } else if (0 == strcmp(pValue, "prepass")) {
+                    mDepthMode = eDepthPrepass;
+                } else {
+                    bValid = false;
+                }
+            } else if (0 == strcmp(pArg, "--occlusion")) {
+                mOcclusionTriangles = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--occlusion-cpu")) {
+                mOcclusionCpuWidth = static_cast<unsigned int>(atoi(pValue));
+            } else if (0 == strcmp(pArg, "--shader-defines")) {
+                // Comma separated list of defines
+                mShaderDefines.clear();
+                std::istringstream defines(pValue);
+                std::string define;
+                while (std::getline(defines, define, ',')) {
+                    if (false == define.empty()) {
+                        mShaderDefines.push_back(define);
+                    }
+                }
+            } else {
+                bValid = false;
+            }
+        }
+    }
+
+    return bValid;
+}
+
+/**
+ * @brief Usage string describing the command line arguments
+ */
+const char* Options::getUsage() {
+    return "usage: glExperiments [options]\n"
+           "  --manifest <file>     scene manifest listing the models to load (default data/scene.txt)\n"
+           "  --scene <model|none>  generate a stress scene instantiating the given model (\"none\" for no mesh)\n"
+           "  --instances <N>       number of root instances of the generated scene (default 1)\n"
+           "  --depth <D>           depth of the hierarchy under each instance (default 0)\n"
+           "  --fanout <F>          number of children of each node of the hierarchy (default 0)\n"
+           "  --moving <R>          fraction of nodes in motion, between 0.0 and 1.0 (default 0.0)\n"
+           "  --spacing <S>         distance between instances in meters (default 5.0)\n"
+           "  --seed <X>            seed of the pseudo-random generator (default 42)\n"
+           "  --frames-in-flight <N> frames in flight between the CPU and the GPU, 1 to 3 (default 2)\n"
+           "  --frames <N>          exit after rendering N frames\n"
+           "  --output <file.csv>   write measurements at each FPS interval into a CSV file\n"
+           "  --headless            render into a hidden window instead of fullscreen\n"
+           "  --loader-threads <N>  worker threads importing models (default 0 for the number of hardware threads)\n"
+           "  --upload-kb <KB>      maximum size of the meshes uploaded to the GPU per frame (default 1024)\n"
+           "  --upload-us <us>      maximum time spent uploading meshes per frame (default 2000)\n"
+           "  --lod-error <pixels>  maximum projected error of the levels of detail (default 1.0, 0 for none)\n"
+           "  --impostor <pixels>   size under which meshes are drawn as impostors (default 16, 0 for none)\n"
+           "  --compact-vertices    upload meshes with 8 bits colors and 10 bits normals (20 instead of 36 bytes)\n"
+           "  --static-batching <V> bake static meshes up to V vertices into batches (default 4096, 0 for none)\n"
+           "  --shader-defines <A,B> defines of the permutation of the mesh shaders, compiled in the background\n"
+           "  --depth-mode <M>      none, sort (front-to-back), or prepass (sort and depth only pre-pass)\n"
+           "  --overdraw            visualize and measure the overdraw (samples shaded per pixel)\n"
+           "  --occlusion <T>       cull occluded nodes of at least T triangles by queries (default 0 for none)\n"
+           "  --occlusion-cpu <W>   cull nodes behind the occluders rasterized on the CPU W pixels wide (0 for none)\n"
+           "  --cockpit-mask        draw the models marked mask first into the stencil, rejecting the pixels behind\n"
+           "  --hidden-area         skip the pixels never seen through the lenses of the HMD (its hidden area mesh)\n"
+           "  --fake-hmd            use the profile of the first development kit when no HMD is found\n";
+}
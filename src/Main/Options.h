@@ -0,0 +1,66 @@
+/**
+ * @file    Options.h
+ * @ingroup Main
+ * @brief   Command line options of the application
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Main/SceneGenerator.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief   Command line options of the application
+ * @ingroup Main
+ *
+ *  Without any option, the application loads the default scene and renders fullscreen until Escape is pressed.
+ */
+struct Options {
+    /// Control of the overdraw of the Meshes (see Renderer::display())
+    enum DepthMode {
+        eDepthNone,     ///< Draw in the order of the Scene
+        eDepthSort,     ///< Sort the draws front-to-back by view depth
+        eDepthPrepass   ///< Sort, lay down the depth in a depth only pre-pass, then shade with GL_EQUAL depth test
+    };
+
+    std::string             mManifestFilename;  ///< Scene manifest listing the models to load (see SceneManifest)
+    bool                    mbGenerateScene;    ///< Generate a stress scene instead of loading the manifest
+    std::string             mSceneModel;        ///< Model instantiated in the generated scene (empty for no mesh)
+    SceneGenerator::Config  mSceneConfig;       ///< Configuration of the generated scene
+
+    unsigned int            mNbFramesInFlight;  ///< Number of frames in flight between the CPU and the GPU (1 to 3)
+    unsigned int            mNbFrames;          ///< Number of frames to render before exiting (0 for no limit)
+    std::string             mOutputFilename;    ///< CSV file where to write measurements at each FPS interval
+    bool                    mbHeadless;         ///< Render into a hidden window instead of fullscreen
+
+    unsigned int            mNbLoaderThreads;   ///< Number of worker threads importing models in the background
+    unsigned int            mUploadBudgetKB;    ///< Maximum size of the Meshes uploaded to the GPU per frame, in KB
+    unsigned int            mUploadBudgetUs;    ///< Maximum time spent uploading Meshes per frame, in microseconds
+
+    float                   mLodPixelError;     ///< Maximum projected error of the levels of detail, in pixels
+    float                   mImpostorPixelSize; ///< Projected size under which Meshes are drawn as impostors, in pixels
+    bool                    mbCompactVertices;  ///< Upload Meshes with 8 bits colors and 10 bits normals
+    unsigned int            mStaticBatchVertices;   ///< Vertices up to which a static Mesh is baked (0 for none)
+    DepthMode               mDepthMode;         ///< Control of the overdraw of the Meshes
+    bool                    mbOverdraw;         ///< Visualize and measure the overdraw (samples shaded per pixel)
+    unsigned int            mOcclusionTriangles;    ///< Triangles from which a Node is occlusion culled (0 for none)
+    unsigned int            mOcclusionCpuWidth;     ///< Width of the software occlusion depth buffers (0 for none)
+    bool                    mbCockpitMask;      ///< Reject the pixels covered by the cockpit mask by the stencil
+    bool                    mbHiddenArea;       ///< Skip the pixels never seen through the lenses of the HMD
+    bool                    mbFakeHmd;          ///< Use a fake HMD profile when no device is found
+    std::vector<std::string> mShaderDefines;    ///< Defines of the permutation of the program of the Meshes
+
+    Options();
+
+    // Parse the command line arguments
+    bool parse(int argc, char** argv);
+
+    // Usage string describing the command line arguments
+    static const char* getUsage();
+};
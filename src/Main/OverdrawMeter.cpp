@@ -0,0 +1,80 @@
+/**
+ * @file    OverdrawMeter.cpp
+ * @ingroup Main
+ * @brief   Non-blocking measurement of the overdraw with OpenGL occlusion queries
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/OverdrawMeter.h"
+
+/**
+ * @brief Constructor: generate the queries (requires a current OpenGL context)
+ */
+OverdrawMeter::OverdrawMeter() :
+    mIdxQuery(0),
+    mNbPixels(0),
+    mSumOverdraw(0.0),
+    mNbResults(0) {
+    glGenQueries(NB_QUERIES, mQueries);
+    for (int idxQuery = 0; idxQuery < NB_QUERIES; ++idxQuery) {
+        mbPending[idxQuery] = false;
+    }
+}
+
+/**
+ * @brief Destructor
+ */
+OverdrawMeter::~OverdrawMeter() {
+    glDeleteQueries(NB_QUERIES, mQueries);
+}
+
+/**
+ * @brief Start the occlusion query of the color pass of the current frame
+ */
+void OverdrawMeter::begin() {
+    // Read the result of the oldest query before reusing it (available since long, in practice)
+    collect(mIdxQuery, true);
+    glBeginQuery(GL_SAMPLES_PASSED, mQueries[mIdxQuery]);
+}
+
+/**
+ * @brief Stop the occlusion query of the color pass of the current frame
+ */
+void OverdrawMeter::end() {
+    glEndQuery(GL_SAMPLES_PASSED);
+    mbPending[mIdxQuery] = true;
+    mIdxQuery = (mIdxQuery + 1) % NB_QUERIES;
+
+    // Read already available results, to keep the average up to date
+    for (int idxQuery = 0; idxQuery < NB_QUERIES; ++idxQuery) {
+        collect(idxQuery, false);
+    }
+}
+
+/**
+ * @brief Read the result of a pending query
+ *
+ * @param[in] aIdxQuery Index of the query in the ring
+ * @param[in] abWait    Wait for the result if not yet available
+ */
+void OverdrawMeter::collect(int aIdxQuery, bool abWait) {
+    if (mbPending[aIdxQuery]) {
+        GLint bAvailable = GL_FALSE;
+        if (false == abWait) {
+            glGetQueryObjectiv(mQueries[aIdxQuery], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+        }
+        if (abWait || (GL_FALSE != bAvailable)) {
+            GLuint64 nbSamples = 0;
+            glGetQueryObjectui64v(mQueries[aIdxQuery], GL_QUERY_RESULT, &nbSamples);
+            if (0 < mNbPixels) {
+                mSumOverdraw += static_cast<double>(nbSamples) / mNbPixels;
+                ++mNbResults;
+            }
+            mbPending[aIdxQuery] = false;
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * @file    OverdrawMeter.h
+ * @ingroup Main
+ * @brief   Non-blocking measurement of the overdraw with OpenGL occlusion queries
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+
+/**
+ * @brief   Non-blocking measurement of the overdraw with OpenGL occlusion queries
+ * @ingroup Main
+ *
+ *  Counts the samples passing the depth test during the color pass of a frame with a GL_SAMPLES_PASSED query,
+ * that is the fragments shaded, and divides them by the number of pixels of the viewport: 1.0 means that
+ * each pixel is shaded once, as with a depth pre-pass (see Renderer), and anything above is overdraw.
+ *
+ *  Like the GpuTimer, uses a ring of queries, so that the result of a frame is only read a few frames later,
+ * when the GPU is done with it, without stalling the CPU.
+ *  Results are averaged until the next call to reset(), typically at the same interval as the FPS calculation.
+ */
+class OverdrawMeter {
+public:
+    OverdrawMeter();
+    ~OverdrawMeter(); // not virtual because no virtual methods and class not derived
+
+    // Set the number of pixels of the viewport (of both eyes)
+    inline void setNbPixels(unsigned int aNbPixels);
+
+    // Color pass boundaries: start and stop the occlusion query of the current frame
+    void begin();
+    void end();
+
+    // Average number of samples shaded per pixel in the frames measured since the last reset()
+    inline float getAverage() const;
+    inline void  reset();
+
+private:
+    // Read the result of a pending query
+    void collect(int aIdxQuery, bool abWait);
+
+private:
+    /// Number of queries in the ring, enough to never wait for a result
+    static const int NB_QUERIES = 4;
+
+    GLuint          mQueries[NB_QUERIES];   ///< Ring of occlusion queries
+    bool            mbPending[NB_QUERIES];  ///< Tell if the result of a query is still to be read
+    int             mIdxQuery;              ///< Index of the query of the current frame
+
+    unsigned int    mNbPixels;              ///< Number of pixels of the viewport
+    double          mSumOverdraw;           ///< Sum of the samples per pixel measured since reset()
+    unsigned int    mNbResults;             ///< Number of results measured since reset()
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(OverdrawMeter);
+};
+
+
+/**
+ * @brief Set the number of pixels of the viewport (of both eyes), on each reshape
+ *
+ *  With multisampling, each sample passing the depth test is counted: give the number of samples of the viewport.
+ */
+inline void OverdrawMeter::setNbPixels(unsigned int aNbPixels) {
+    mNbPixels = aNbPixels;
+}
+
+/**
+ * @brief Get the average number of samples shaded per pixel in the frames measured since the last reset()
+ */
+inline float OverdrawMeter::getAverage() const {
+    return (0 < mNbResults) ? static_cast<float>(mSumOverdraw / mNbResults) : 0.0f;
+}
+
+/**
+ * @brief Reset the average overdraw (start a new interval)
+ */
+inline void OverdrawMeter::reset() {
+    mSumOverdraw    = 0.0;
+    mNbResults      = 0;
+}
@@ -0,0 +1,522 @@
+/**
+ * @file    PlyLoader.cpp
+ * @ingroup Main
+ * @brief   Loader of the PLY ("Polygon File Format" or "Stanford Triangle Format") file format, ASCII or binary
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/NativeLoader.h"
+#include "Utils/Exception.h"
+#include "Utils/Parse.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>   // std::bind
+#include <cstring>      // memcpy, memchr
+#include <cstdint>      // int8_t, uint8_t...
+
+/**
+ * @brief Type of a scalar property of a PLY element
+ */
+enum PlyType {
+    eInt8 = 0,
+    eUInt8,
+    eInt16,
+    eUInt16,
+    eInt32,
+    eUInt32,
+    eFloat32,
+    eFloat64,
+    eNbTypes
+};
+
+/// Names of each PlyType (and their older alias)
+static const char* _typeNames[eNbTypes][2] = {
+    {"int8",    "char"},
+    {"uint8",   "uchar"},
+    {"int16",   "short"},
+    {"uint16",  "ushort"},
+    {"int32",   "int"},
+    {"uint32",  "uint"},
+    {"float32", "float"},
+    {"float64", "double"}
+};
+
+/// Size of each PlyType, in bytes
+static const size_t _typeSizes[eNbTypes] = {1, 1, 2, 2, 4, 4, 4, 8};
+
+/// Maximum number of vertices of a polygon, and of properties of an element
+static const int _maxValues = 64;
+
+/**
+ * @brief Property of a PLY element: a scalar, or a list of scalars preceded by their count
+ */
+struct PlyProperty {
+    std::string mName;          ///< Name of the property ("x", "nx", "red", "vertex_indices"...)
+    PlyType     mType;          ///< Type of the scalar, or of the items of the list
+    PlyType     mCountType;     ///< Type of the count of items of the list
+    bool        mbList;         ///< The property is a list
+};
+
+/**
+ * @brief Element of a PLY file ("vertex", "face"...): a number of records of the same properties
+ */
+struct PlyElement {
+    std::string                 mName;          ///< Name of the element
+    unsigned int                mCount;         ///< Number of records of the element
+    std::vector<PlyProperty>    mProperties;    ///< Properties of each record
+};
+
+/**
+ * @brief Header of a PLY file
+ */
+struct PlyHeader {
+    /// Format of the body of the file
+    enum Format {
+        eAscii,
+        eBinaryLittleEndian,
+        eBinaryBigEndian
+    };
+
+    Format                  mFormat;        ///< Format of the body of the file
+    std::vector<PlyElement> mElements;      ///< Elements, in the order of the body
+    size_t                  mBodyOffset;    ///< Offset of the body, after the "end_header" line
+};
+
+/**
+ * @brief Index of the vertex and face properties used by the loader (or -1 if missing)
+ */
+struct PlyLayout {
+    int mVertexElement;     ///< Index of the "vertex" element
+    int mFaceElement;       ///< Index of the "face" element
+    int mPosition[3];       ///< Index of the "x", "y" and "z" properties
+    int mNormal[3];         ///< Index of the "nx", "ny" and "nz" properties
+    int mColor[3];          ///< Index of the "red", "green" and "blue" properties
+    int mIndices;           ///< Index of the "vertex_indices" (or "vertex_index") property
+    float mColorScale;      ///< Scale of the color values (1/255 for integer colors)
+};
+
+/**
+ * @brief Get a PlyType from its name
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+static PlyType getType(const std::string& aName) {
+    for (int idxType = 0; idxType < eNbTypes; ++idxType) {
+        if ((aName == _typeNames[idxType][0]) || (aName == _typeNames[idxType][1])) {
+            return static_cast<PlyType>(idxType);
+        }
+    }
+    UTILS_THROW("PlyLoader: unknown type \"" << aName << "\"");
+}
+
+/**
+ * @brief Parse the header of a PLY file
+ *
+ * @param[in]  apData   Content of the file
+ * @param[in]  aSize    Size of the file, in bytes
+ * @param[out] aHeader  Header of the file
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+static void parseHeader(const char* apData, size_t aSize, PlyHeader& aHeader) {
+    const char* pCursor = apData;
+    const char* pEnd    = apData + aSize;
+    bool bEndHeader = false;
+    bool bFormat    = false;
+
+    if ((aSize < 4) || (0 != memcmp(apData, "ply", 3))) {
+        UTILS_THROW("PlyLoader: not a PLY file");
+    }
+    while ((pCursor < pEnd) && !bEndHeader) {
+        const char* pLine = pCursor;
+        Utils::skipLine(pCursor, pEnd);
+        std::istringstream line(std::string(pLine, pCursor));
+        std::string keyword;
+        line >> keyword;
+        if ("format" == keyword) {
+            std::string format;
+            line >> format;
+            bFormat = true;
+            if ("ascii" == format) {
+                aHeader.mFormat = PlyHeader::eAscii;
+            } else if ("binary_little_endian" == format) {
+                aHeader.mFormat = PlyHeader::eBinaryLittleEndian;
+            } else if ("binary_big_endian" == format) {
+                aHeader.mFormat = PlyHeader::eBinaryBigEndian;
+            } else {
+                UTILS_THROW("PlyLoader: unknown format \"" << format << "\"");
+            }
+        } else if ("element" == keyword) {
+            PlyElement element;
+            line >> element.mName >> element.mCount;
+            aHeader.mElements.push_back(element);
+        } else if ("property" == keyword) {
+            if (aHeader.mElements.empty()) {
+                UTILS_THROW("PlyLoader: property without element");
+            }
+            PlyProperty property;
+            std::string type;
+            line >> type;
+            property.mbList = ("list" == type);
+            if (property.mbList) {
+                std::string countType;
+                line >> countType >> type;
+                property.mCountType = getType(countType);
+            } else {
+                property.mCountType = eUInt8;
+            }
+            property.mType = getType(type);
+            line >> property.mName;
+            aHeader.mElements.back().mProperties.push_back(property);
+        } else if ("end_header" == keyword) {
+            bEndHeader = true;
+        }
+        // else "ply", "comment", "obj_info"... are ignored
+    }
+    if (!bEndHeader || !bFormat) {
+        UTILS_THROW("PlyLoader: invalid header");
+    }
+    // The values of the properties of a record are read into a fixed size array
+    for (size_t idxElement = 0; idxElement < aHeader.mElements.size(); ++idxElement) {
+        const PlyElement& element = aHeader.mElements[idxElement];
+        if (static_cast<size_t>(_maxValues) < element.mProperties.size()) {
+            UTILS_THROW("PlyLoader: too many properties of \"" << element.mName << "\" ("
+                        << element.mProperties.size() << ", at most " << _maxValues << ")");
+        }
+    }
+    aHeader.mBodyOffset = pCursor - apData;
+}
+
+/**
+ * @brief Find the properties used by the loader
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+static void getLayout(const PlyHeader& aHeader, PlyLayout& aLayout) {
+    static const char* _positionNames[3]  = {"x", "y", "z"};
+    static const char* _normalNames[3]    = {"nx", "ny", "nz"};
+    static const char* _colorNames[3]     = {"red", "green", "blue"};
+
+    aLayout.mVertexElement  = -1;
+    aLayout.mFaceElement    = -1;
+    aLayout.mIndices        = -1;
+    aLayout.mColorScale     = 1.0f;
+    for (int idxAxis = 0; idxAxis < 3; ++idxAxis) {
+        aLayout.mPosition[idxAxis]  = -1;
+        aLayout.mNormal[idxAxis]    = -1;
+        aLayout.mColor[idxAxis]     = -1;
+    }
+
+    for (size_t idxElement = 0; idxElement < aHeader.mElements.size(); ++idxElement) {
+        const PlyElement& element = aHeader.mElements[idxElement];
+        for (size_t idxProperty = 0; idxProperty < element.mProperties.size(); ++idxProperty) {
+            const PlyProperty& property = element.mProperties[idxProperty];
+            if ("vertex" == element.mName) {
+                aLayout.mVertexElement = static_cast<int>(idxElement);
+                for (int idxAxis = 0; idxAxis < 3; ++idxAxis) {
+                    if (property.mName == _positionNames[idxAxis]) {
+                        aLayout.mPosition[idxAxis] = static_cast<int>(idxProperty);
+                    } else if (property.mName == _normalNames[idxAxis]) {
+                        aLayout.mNormal[idxAxis] = static_cast<int>(idxProperty);
+                    } else if (property.mName == _colorNames[idxAxis]) {
+                        aLayout.mColor[idxAxis] = static_cast<int>(idxProperty);
+                        aLayout.mColorScale = (eFloat32 <= property.mType) ? 1.0f : (1.0f / 255.0f);
+                    }
+                }
+            } else if (("face" == element.mName) && property.mbList
+                       && (("vertex_indices" == property.mName) || ("vertex_index" == property.mName))) {
+                aLayout.mFaceElement = static_cast<int>(idxElement);
+                aLayout.mIndices = static_cast<int>(idxProperty);
+            }
+        }
+    }
+    if ((0 > aLayout.mPosition[0]) || (0 > aLayout.mPosition[1]) || (0 > aLayout.mPosition[2])
+        || (0 > aLayout.mIndices)) {
+        UTILS_THROW("PlyLoader: missing vertex positions or face indices");
+    }
+}
+
+/**
+ * @brief Add a polygon as a fan of triangles to a list of indices, checking the indices
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+static void addPolygon(const int* apIndices, int aNbIndices, size_t aNbVertices, std::vector<unsigned int>& aIndices) {
+    for (int idxIndex = 0; idxIndex < aNbIndices; ++idxIndex) {
+        if ((0 > apIndices[idxIndex]) || (aNbVertices <= static_cast<size_t>(apIndices[idxIndex]))) {
+            UTILS_THROW("PlyLoader: invalid vertex index " << apIndices[idxIndex]);
+        }
+    }
+    for (int idxIndex = 2; idxIndex < aNbIndices; ++idxIndex) {
+        aIndices.push_back(apIndices[0]);
+        aIndices.push_back(apIndices[idxIndex - 1]);
+        aIndices.push_back(apIndices[idxIndex]);
+    }
+}
+
+/**
+ * @brief Set a vertex attribute from the values of the properties of a vertex record
+ */
+static void setAttribute(const float* apValues, const int* apProperties, float aScale, glm::vec3& aAttribute) {
+    aAttribute = aScale * glm::vec3(apValues[apProperties[0]], apValues[apProperties[1]], apValues[apProperties[2]]);
+}
+
+/**
+ * @brief Tell if the line at the cursor is empty or made only of spaces (not a record)
+ */
+static bool isBlankLine(const char* apCursor, const char* apEnd) {
+    Utils::skipSpaces(apCursor, apEnd);
+    return (apCursor >= apEnd) || ('\n' == *apCursor) || ('\r' == *apCursor);
+}
+
+/**
+ * @brief Count the lines of a chunk of the ASCII body, but the blank ones
+ */
+static void countLines(const std::vector<const char*>& aChunks, size_t aIdxChunk, std::vector<size_t>& aNbLines) {
+    size_t nbLines = 0;
+    const char* pEnd = aChunks[aIdxChunk + 1];
+    for (const char* pCursor = aChunks[aIdxChunk]; pCursor < pEnd; Utils::skipLine(pCursor, pEnd)) {
+        if (false == isBlankLine(pCursor, pEnd)) {
+            ++nbLines;
+        }
+    }
+    aNbLines[aIdxChunk] = nbLines;
+}
+
+/**
+ * @brief Parse the lines of a chunk of the ASCII body: one record of an element per line, skipping blank lines
+ *
+ * @param[in]     aHeader       Header of the file
+ * @param[in]     aLayout       Properties used by the loader
+ * @param[in]     aChunks       Boundaries of the chunks
+ * @param[in]     aIdxChunk     Index of the chunk to parse
+ * @param[in]     aFirstLines   Index of the first line (record) of each chunk
+ * @param[in,out] aRawMesh      Raw mesh, with vertex attributes already sized, written at the index of each record
+ * @param[out]    aChunkIndices Triangle list of the faces of each chunk
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+static void parseAsciiChunk(const PlyHeader& aHeader, const PlyLayout& aLayout,
+                            const std::vector<const char*>& aChunks, size_t aIdxChunk,
+                            const std::vector<size_t>& aFirstLines, RawMesh& aRawMesh,
+                            std::vector<std::vector<unsigned int> >& aChunkIndices) {
+    const char* pCursor = aChunks[aIdxChunk];
+    const char* pEnd    = aChunks[aIdxChunk + 1];
+    size_t      idxLine = aFirstLines[aIdxChunk];
+
+    size_t idxElement   = 0;
+    size_t firstLine    = 0;
+    float  values[_maxValues];
+    int    indices[_maxValues];
+    std::vector<unsigned int>& chunkIndices = aChunkIndices[aIdxChunk];
+    for (; pCursor < pEnd; Utils::skipLine(pCursor, pEnd)) {
+        if (isBlankLine(pCursor, pEnd)) {
+            continue;
+        }
+        // Find the element of the line (skipping elements without any record)
+        while ((idxElement < aHeader.mElements.size())
+               && (idxLine >= firstLine + aHeader.mElements[idxElement].mCount)) {
+            firstLine += aHeader.mElements[idxElement].mCount;
+            ++idxElement;
+        }
+        if (idxElement >= aHeader.mElements.size()) {
+            break;
+        }
+        const PlyElement& element = aHeader.mElements[idxElement];
+        if (static_cast<int>(idxElement) == aLayout.mVertexElement) {
+            // Vertex record: all properties are read as floats (integers included)
+            for (size_t idxProperty = 0; idxProperty < element.mProperties.size(); ++idxProperty) {
+                if (!Utils::parseFloat(pCursor, pEnd, values[idxProperty])) {
+                    UTILS_THROW("PlyLoader: invalid vertex at line " << idxLine);
+                }
+            }
+            const size_t idxVertex = idxLine - firstLine;
+            setAttribute(values, aLayout.mPosition, 1.0f, aRawMesh.mPositions[idxVertex]);
+            if (false == aRawMesh.mNormals.empty()) {
+                setAttribute(values, aLayout.mNormal, 1.0f, aRawMesh.mNormals[idxVertex]);
+            }
+            if (false == aRawMesh.mColors.empty()) {
+                setAttribute(values, aLayout.mColor, aLayout.mColorScale, aRawMesh.mColors[idxVertex]);
+            }
+        } else if (static_cast<int>(idxElement) == aLayout.mFaceElement) {
+            // Face record: skip the properties before the list of indices
+            for (int idxProperty = 0; idxProperty < aLayout.mIndices; ++idxProperty) {
+                Utils::parseFloat(pCursor, pEnd, values[0]);
+            }
+            int nbIndices = 0;
+            if (!Utils::parseInt(pCursor, pEnd, nbIndices) || (3 > nbIndices) || (_maxValues < nbIndices)) {
+                UTILS_THROW("PlyLoader: invalid face at line " << idxLine);
+            }
+            for (int idxIndex = 0; idxIndex < nbIndices; ++idxIndex) {
+                if (!Utils::parseInt(pCursor, pEnd, indices[idxIndex])) {
+                    UTILS_THROW("PlyLoader: invalid face at line " << idxLine);
+                }
+            }
+            addPolygon(indices, nbIndices, aRawMesh.mPositions.size(), chunkIndices);
+        }
+        // else record of an element not used by the loader
+        ++idxLine;
+    }
+}
+
+/**
+ * @brief Parse the ASCII body of a PLY file by chunks of lines in parallel
+ *
+ *  A first parallel pass counts the lines of each chunk (but the blank ones), to know the index of the first record
+ * of each chunk, and a second parallel pass parses the records: vertices are written directly at their index,
+ * while faces are gathered by chunk, and concatenated in order at the end.
+ */
+static void parseAscii(const char* apData, size_t aSize, const PlyHeader& aHeader, const PlyLayout& aLayout,
+                       RawMesh& aRawMesh) {
+    std::vector<const char*> chunks;
+    NativeLoader::splitLines(apData + aHeader.mBodyOffset, aSize - aHeader.mBodyOffset, chunks);
+    const size_t nbChunks = chunks.size() - 1;
+
+    std::vector<size_t> nbLines(nbChunks);
+    NativeLoader::runChunks(nbChunks, std::bind(countLines, std::cref(chunks), std::placeholders::_1,
+                                                std::ref(nbLines)));
+    std::vector<size_t> firstLines(nbChunks, 0);
+    for (size_t idxChunk = 1; idxChunk < nbChunks; ++idxChunk) {
+        firstLines[idxChunk] = firstLines[idxChunk - 1] + nbLines[idxChunk - 1];
+    }
+
+    std::vector<std::vector<unsigned int> > chunkIndices(nbChunks);
+    NativeLoader::runChunks(nbChunks, std::bind(parseAsciiChunk, std::cref(aHeader), std::cref(aLayout),
+                                                std::cref(chunks), std::placeholders::_1, std::cref(firstLines),
+                                                std::ref(aRawMesh), std::ref(chunkIndices)));
+
+    size_t nbIndices = 0;
+    for (size_t idxChunk = 0; idxChunk < nbChunks; ++idxChunk) {
+        nbIndices += chunkIndices[idxChunk].size();
+    }
+    aRawMesh.mIndices.reserve(nbIndices);
+    for (size_t idxChunk = 0; idxChunk < nbChunks; ++idxChunk) {
+        aRawMesh.mIndices.insert(aRawMesh.mIndices.end(), chunkIndices[idxChunk].begin(), chunkIndices[idxChunk].end());
+    }
+}
+
+/**
+ * @brief Read a binary scalar, swapping its bytes if its endianness differs from the one of the CPU
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+static double readBinary(const char*& apCursor, const char* apEnd, PlyType aType, bool abSwap) {
+    const size_t size = _typeSizes[aType];
+    if (apCursor + size > apEnd) {
+        UTILS_THROW("PlyLoader: unexpected end of file");
+    }
+    char bytes[8];
+    for (size_t idxByte = 0; idxByte < size; ++idxByte) {
+        bytes[idxByte] = abSwap ? apCursor[size - 1 - idxByte] : apCursor[idxByte];
+    }
+    apCursor += size;
+
+    double value = 0.0;
+    switch (aType) {
+    case eInt8:     { int8_t   scalar; memcpy(&scalar, bytes, size); value = scalar; break; }
+    case eUInt8:    { uint8_t  scalar; memcpy(&scalar, bytes, size); value = scalar; break; }
+    case eInt16:    { int16_t  scalar; memcpy(&scalar, bytes, size); value = scalar; break; }
+    case eUInt16:   { uint16_t scalar; memcpy(&scalar, bytes, size); value = scalar; break; }
+    case eInt32:    { int32_t  scalar; memcpy(&scalar, bytes, size); value = scalar; break; }
+    case eUInt32:   { uint32_t scalar; memcpy(&scalar, bytes, size); value = scalar; break; }
+    case eFloat32:  { float    scalar; memcpy(&scalar, bytes, size); value = scalar; break; }
+    case eFloat64:  { double   scalar; memcpy(&scalar, bytes, size); value = scalar; break; }
+    default: break;
+    }
+    return value;
+}
+
+/**
+ * @brief Parse the binary body of a PLY file (sequentially: binary records need no text parsing)
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+static void parseBinary(const char* apData, size_t aSize, const PlyHeader& aHeader, const PlyLayout& aLayout,
+                        RawMesh& aRawMesh) {
+    const uint16_t  one = 1;
+    const bool      bLittleEndianCpu = (1 == *reinterpret_cast<const uint8_t*>(&one));
+    const bool      bSwap = (bLittleEndianCpu != (PlyHeader::eBinaryLittleEndian == aHeader.mFormat));
+    const char*     pCursor = apData + aHeader.mBodyOffset;
+    const char*     pEnd    = apData + aSize;
+
+    float values[_maxValues];
+    int   indices[_maxValues];
+    for (size_t idxElement = 0; idxElement < aHeader.mElements.size(); ++idxElement) {
+        const PlyElement& element = aHeader.mElements[idxElement];
+        for (unsigned int idxRecord = 0; idxRecord < element.mCount; ++idxRecord) {
+            for (size_t idxProperty = 0; idxProperty < element.mProperties.size(); ++idxProperty) {
+                const PlyProperty& property = element.mProperties[idxProperty];
+                if (property.mbList) {
+                    const int nbItems = static_cast<int>(readBinary(pCursor, pEnd, property.mCountType, bSwap));
+                    const bool bIndices = (static_cast<int>(idxElement) == aLayout.mFaceElement)
+                                       && (static_cast<int>(idxProperty) == aLayout.mIndices);
+                    if (bIndices && ((3 > nbItems) || (_maxValues < nbItems))) {
+                        UTILS_THROW("PlyLoader: invalid face " << idxRecord);
+                    }
+                    for (int idxItem = 0; idxItem < nbItems; ++idxItem) {
+                        const double item = readBinary(pCursor, pEnd, property.mType, bSwap);
+                        if (bIndices) {
+                            indices[idxItem] = static_cast<int>(item);
+                        }
+                    }
+                    if (bIndices) {
+                        addPolygon(indices, nbItems, aRawMesh.mPositions.size(), aRawMesh.mIndices);
+                    }
+                } else {
+                    values[idxProperty] = static_cast<float>(readBinary(pCursor, pEnd, property.mType, bSwap));
+                }
+            }
+            if (static_cast<int>(idxElement) == aLayout.mVertexElement) {
+                setAttribute(values, aLayout.mPosition, 1.0f, aRawMesh.mPositions[idxRecord]);
+                if (false == aRawMesh.mNormals.empty()) {
+                    setAttribute(values, aLayout.mNormal, 1.0f, aRawMesh.mNormals[idxRecord]);
+                }
+                if (false == aRawMesh.mColors.empty()) {
+                    setAttribute(values, aLayout.mColor, aLayout.mColorScale, aRawMesh.mColors[idxRecord]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Parse the content of a PLY file
+ *
+ *  Supports ASCII and binary (little and big endian) bodies, with vertex positions, optional normals and colors,
+ * and polygonal faces (triangulated as fans). Other elements and properties are ignored.
+ *
+ * @param[in]  apData   Content of the file (memory mapped)
+ * @param[in]  aSize    Size of the file, in bytes
+ * @param[out] aRawMesh Triangle mesh read from the file
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+void PlyLoader::load(const char* apData, size_t aSize, RawMesh& aRawMesh) {
+    PlyHeader header;
+    PlyLayout layout;
+    parseHeader(apData, aSize, header);
+    getLayout(header, layout);
+
+    // Size the vertex attributes, so that vertex records can be written in parallel at their index
+    const size_t nbVertices = header.mElements[layout.mVertexElement].mCount;
+    aRawMesh.mPositions.resize(nbVertices);
+    if ((0 <= layout.mNormal[0]) && (0 <= layout.mNormal[1]) && (0 <= layout.mNormal[2])) {
+        aRawMesh.mNormals.resize(nbVertices);
+    }
+    if ((0 <= layout.mColor[0]) && (0 <= layout.mColor[1]) && (0 <= layout.mColor[2])) {
+        aRawMesh.mColors.resize(nbVertices);
+    }
+    aRawMesh.mIndices.clear();
+
+    if (PlyHeader::eAscii == header.mFormat) {
+        parseAscii(apData, aSize, header, layout, aRawMesh);
+    } else {
+        parseBinary(apData, aSize, header, layout, aRawMesh);
+    }
+}
@@ -0,0 +1,243 @@
+/**
+ * @file    ProgramCache.cpp
+ * @ingroup Main
+ * @brief   Disk cache of linked program binaries, to skip compiling shaders at startup
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/ProgramCache.h"
+
+#include <GLFW/glfw3.h>     // glfwGetProcAddress
+
+#ifdef _WIN32
+#include <direct.h>         // _mkdir
+#else
+#include <sys/stat.h>       // mkdir
+#endif
+
+#include <fstream>          // NOLINT(readability/streams) for the cache files
+#include <sstream>
+#include <iomanip>          // std::setw, std::setfill
+#include <vector>
+#include <string>
+#include <cstring>          // strcmp, memcmp
+
+// ARB_get_program_binary (core since OpenGL 4.1) is not part of the OpenGL 3.3 API
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT  0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH            0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS       0x87FE
+#endif
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+/// Prototype of the glGetProgramBinary() function of ARB_get_program_binary
+typedef void (APIENTRY* GetProgramBinaryProc)(GLuint aProgram, GLsizei aBufSize, GLsizei* apLength,
+                                              GLenum* apBinaryFormat, void* apBinary);
+/// Prototype of the glProgramBinary() function of ARB_get_program_binary
+typedef void (APIENTRY* ProgramBinaryProc)(GLuint aProgram, GLenum aBinaryFormat, const void* apBinary,
+                                           GLsizei aLength);
+/// Prototype of the glProgramParameteri() function of ARB_get_program_binary
+typedef void (APIENTRY* ProgramParameteriProc)(GLuint aProgram, GLenum aName, GLint aValue);
+
+/// Pointers to the ARB_get_program_binary functions, loaded at runtime (nullptr if not supported)
+static GetProgramBinaryProc     _glGetProgramBinary     = nullptr;
+static ProgramBinaryProc        _glProgramBinary        = nullptr;
+static ProgramParameteriProc    _glProgramParameteri    = nullptr;
+/// Tell if the support of ARB_get_program_binary has already been checked
+static bool                     _bProgramBinaryChecked  = false;
+
+/// Directory of the cache files, relative to the working directory (the root directory, as for "data/")
+static const char* _cacheDirectory = "cache";
+
+/// Magic number at the start of each cache file ("GLPB", program binary)
+static const char _magic[4] = {'G', 'L', 'P', 'B'};
+
+/**
+ * @brief Header of a cache file, followed by the binary of the program
+ */
+struct CacheHeader {
+    char    mMagic[4];      ///< Magic number ("GLPB")
+    GLenum  mFormat;        ///< Format of the binary, given by the driver
+    GLsizei mLength;        ///< Length of the binary in bytes
+};
+
+/**
+ * @brief 64 bits FNV-1a hash of a string, continuing a previous hash (stable from one run to the next)
+ */
+static unsigned long long hashString(const std::string& aString, unsigned long long aHash) {
+    for (size_t idxChar = 0; idxChar < aString.size(); ++idxChar) {
+        aHash ^= static_cast<unsigned char>(aString[idxChar]);
+        aHash *= 0x100000001B3ULL;
+    }
+    return aHash;
+}
+
+/**
+ * @brief Tell if ARB_get_program_binary is supported with at least one binary format, and load its functions
+ */
+static bool loadProgramBinary() {
+    if (false == _bProgramBinaryChecked) {
+        _bProgramBinaryChecked = true;
+        GLint nbExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &nbExtensions);
+        for (GLint idxExtension = 0; idxExtension < nbExtensions; ++idxExtension) {
+            const char* pExtension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, idxExtension));
+            if ((nullptr != pExtension) && (0 == strcmp(pExtension, "GL_ARB_get_program_binary"))) {
+                GLint nbFormats = 0;
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nbFormats);
+                if (0 < nbFormats) {
+                    _glGetProgramBinary = reinterpret_cast<GetProgramBinaryProc>(
+                        glfwGetProcAddress("glGetProgramBinary"));
+                    _glProgramParameteri = reinterpret_cast<ProgramParameteriProc>(
+                        glfwGetProcAddress("glProgramParameteri"));
+                    _glProgramBinary = reinterpret_cast<ProgramBinaryProc>(glfwGetProcAddress("glProgramBinary"));
+                }
+                break;
+            }
+        }
+    }
+    return (nullptr != _glProgramBinary) && (nullptr != _glGetProgramBinary) && (nullptr != _glProgramParameteri);
+}
+
+
+/**
+ * @brief Constructor (requires the OpenGL context to be current)
+ */
+ProgramCache::ProgramCache() :
+    mLog("ProgramCache") {
+    const GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (size_t idxName = 0; idxName < sizeof(names)/sizeof(names[0]); ++idxName) {
+        const char* pString = reinterpret_cast<const char*>(glGetString(names[idxName]));
+        if (nullptr != pString) {
+            mDriver += pString;
+        }
+        mDriver += '\n';
+    }
+}
+
+/**
+ * @brief Destructor
+ */
+ProgramCache::~ProgramCache() {
+}
+
+/**
+ * @brief Key of a program: hash of the sources of its shaders, of their defines, and of the driver
+ *
+ * @param[in] aSources  Source code of each shader of the program
+ * @param[in] aDefines  Preprocessor defines injected into the sources (empty if none)
+ *
+ * @return Hexadecimal string of the hash
+ */
+std::string ProgramCache::getKey(const std::vector<std::string>& aSources, const std::string& aDefines) const {
+    unsigned long long hash = 0xCBF29CE484222325ULL; // FNV offset basis
+    for (size_t idxSource = 0; idxSource < aSources.size(); ++idxSource) {
+        hash = hashString(aSources[idxSource], hash);
+        hash = hashString(std::string(1, '\0'), hash); // separator, so that moving code between shaders matters
+    }
+    hash = hashString(aDefines, hash);
+    hash = hashString(mDriver, hash);
+
+    std::ostringstream key;
+    key << std::hex << std::setfill('0') << std::setw(16) << hash;
+    return key.str();
+}
+
+/**
+ * @brief Create a program from its cached binary
+ *
+ * @param[in] aKey  Key of the program (see getKey())
+ *
+ * @return Id of the created program object, or 0 if not in the cache, or rejected by the driver
+ */
+GLuint ProgramCache::load(const std::string& aKey) const {
+    GLuint program = 0;
+    if (isSupported()) {
+        std::ifstream file(getFilename(aKey).c_str(), std::ios::binary);
+        CacheHeader header;
+        if (file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            && (0 == memcmp(header.mMagic, _magic, sizeof(_magic))) && (0 < header.mLength)) {
+            std::vector<char> binary(header.mLength);
+            if (file.read(&binary[0], header.mLength)) {
+                program = glCreateProgram();
+                _glProgramBinary(program, header.mFormat, &binary[0], header.mLength);
+                // The binary is rejected (without any error) if the driver or the GPU have changed
+                GLint status = GL_FALSE;
+                glGetProgramiv(program, GL_LINK_STATUS, &status);
+                if (GL_FALSE == status) {
+                    mLog.notice() << "load(" << aKey << "): binary rejected by the driver";
+                    glDeleteProgram(program);
+                    program = 0;
+                }
+            }
+        }
+    }
+    return program;
+}
+
+/**
+ * @brief Store the binary of a linked program into the cache (errors are only logged)
+ *
+ * @param[in] aKey      Key of the program (see getKey())
+ * @param[in] aProgram  Program object linked with setRetrievableHint()
+ */
+void ProgramCache::store(const std::string& aKey, GLuint aProgram) const {
+    if (isSupported()) {
+        GLint length = 0;
+        glGetProgramiv(aProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (0 < length) {
+            CacheHeader header;
+            memcpy(header.mMagic, _magic, sizeof(_magic));
+            std::vector<char> binary(length);
+            _glGetProgramBinary(aProgram, length, &header.mLength, &header.mFormat, &binary[0]);
+
+#ifdef _WIN32
+            _mkdir(_cacheDirectory);
+#else
+            mkdir(_cacheDirectory, 0755);
+#endif
+            std::ofstream file(getFilename(aKey).c_str(), std::ios::binary | std::ios::trunc);
+            if (file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+                && file.write(&binary[0], header.mLength)) {
+                mLog.debug() << "store(" << aKey << "): " << header.mLength << " bytes";
+            } else {
+                mLog.warning() << "store(" << aKey << "): cannot write \"" << getFilename(aKey) << "\"";
+            }
+        }
+    }
+}
+
+/**
+ * @brief Tell if program binaries are supported by the driver (ARB_get_program_binary with at least one format)
+ */
+bool ProgramCache::isSupported() {
+    return loadProgramBinary();
+}
+
+/**
+ * @brief Ask the driver to keep the binary of a program retrievable, to be called before linking it
+ *
+ * @param[in] aProgram  Program object not yet linked
+ */
+void ProgramCache::setRetrievableHint(GLuint aProgram) {
+    if (isSupported()) {
+        _glProgramParameteri(aProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+/**
+ * @brief Name of the cache file of a program
+ */
+std::string ProgramCache::getFilename(const std::string& aKey) {
+    return std::string(_cacheDirectory) + "/" + aKey + ".bin";
+}
@@ -0,0 +1,66 @@
+/**
+ * @file    ProgramCache.h
+ * @ingroup Main
+ * @brief   Disk cache of linked program binaries, to skip compiling shaders at startup
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "LoggerCpp/LoggerCpp.h"
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+
+#include <vector>
+#include <string>
+
+/**
+ * @brief   Disk cache of linked program binaries, to skip compiling shaders at startup
+ * @ingroup Main
+ *
+ *  Uses ARB_get_program_binary (core since OpenGL 4.1, loaded at runtime): after a program is linked,
+ * its binary is retrieved with glGetProgramBinary() and written into the "cache/" directory,
+ * and on next runs it is given back to glProgramBinary() instead of compiling and linking the sources.
+ *
+ *  A binary is only valid for a given driver and GPU, so the key of a program is a hash of the sources
+ * of its shaders, of their preprocessor defines, and of the vendor, renderer and version strings of OpenGL.
+ * The driver can still reject a binary (after an update keeping the same version string): the program
+ * is then compiled again and its cache entry replaced.
+ */
+class ProgramCache {
+public:
+    ProgramCache();
+    ~ProgramCache(); // not virtual because no virtual methods and class not derived
+
+    // Key of a program: hash of the sources of its shaders, of their defines, and of the driver
+    std::string getKey(const std::vector<std::string>& aSources, const std::string& aDefines) const;
+
+    // Create a program from its cached binary (0 if not in the cache, or rejected by the driver)
+    GLuint load(const std::string& aKey) const;
+    // Store the binary of a linked program into the cache
+    void store(const std::string& aKey, GLuint aProgram) const;
+
+    // Tell if program binaries are supported by the driver
+    static bool isSupported();
+    // Ask the driver to keep the binary of a program retrievable (before linking it)
+    static void setRetrievableHint(GLuint aProgram);
+
+private:
+    // Name of the cache file of a program
+    static std::string getFilename(const std::string& aKey);
+
+private:
+    Log::Logger mLog;       ///< Logger object to output runtime information
+
+    std::string mDriver;    ///< Vendor, renderer and version strings of OpenGL, identifying the binary formats
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(ProgramCache);
+};
@@ -0,0 +1,366 @@
+/**
+ * @file    ProgramInterface.cpp
+ * @ingroup Main
+ * @brief   Active attributes, uniforms and uniform blocks of a linked program, and their slots
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/ProgramInterface.h"
+
+#include "Utils/Exception.h"
+
+#include <glm/gtc/type_ptr.hpp> // glm::value_ptr
+
+#include <vector>
+#include <string>
+#include <cstring>              // strcmp, memcmp, memcpy
+
+/**
+ * @brief Size in bytes of the value of a uniform type (the largest one, a mat4, for unknown types)
+ */
+static size_t getTypeSize(GLenum aType) {
+    size_t size;
+    switch (aType) {
+    case GL_FLOAT:      size = sizeof(GLfloat);     break;
+    case GL_FLOAT_VEC2: size = 2 * sizeof(GLfloat); break;
+    case GL_FLOAT_VEC3: size = 3 * sizeof(GLfloat); break;
+    case GL_FLOAT_VEC4: size = 4 * sizeof(GLfloat); break;
+    case GL_FLOAT_MAT3: size = 9 * sizeof(GLfloat); break;
+    default:            size = sizeof(glm::mat4);   break;
+    }
+    return size;
+}
+
+/**
+ * @brief Tell if a uniform type is a sampler (set by an integer texture unit)
+ */
+static bool isSampler(GLenum aType) {
+    return (GL_SAMPLER_1D == aType) || (GL_SAMPLER_2D == aType) || (GL_SAMPLER_3D == aType)
+        || (GL_SAMPLER_CUBE == aType) || (GL_SAMPLER_2D_SHADOW == aType) || (GL_SAMPLER_2D_ARRAY == aType)
+        || (GL_SAMPLER_BUFFER == aType) || (GL_SAMPLER_2D_MULTISAMPLE == aType);
+}
+
+
+/**
+ * @brief Constructor
+ */
+ProgramInterface::ProgramInterface() :
+    mLog("ProgramInterface"),
+    mProgram(0) {
+}
+
+/**
+ * @brief Destructor (the program is not deleted)
+ */
+ProgramInterface::~ProgramInterface() {
+}
+
+/**
+ * @brief Introspect the active variables of a linked program, forgetting any previous program and slots
+ *
+ * @param[in] aProgram  Program successfully linked
+ */
+void ProgramInterface::reflect(GLuint aProgram) {
+    mProgram = aProgram;
+    mVariables.clear();
+    mUniformSlots.clear();
+    mAttribSlots.clear();
+    mValues.clear();
+
+    GLint nbAttribs = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(aProgram, GL_ACTIVE_ATTRIBUTES, &nbAttribs);
+    glGetProgramiv(aProgram, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> name(maxLength + 1, '\0');
+    for (GLint idxAttrib = 0; idxAttrib < nbAttribs; ++idxAttrib) {
+        GLint   size = 0;
+        GLenum  type = 0;
+        glGetActiveAttrib(aProgram, idxAttrib, static_cast<GLsizei>(name.size()), NULL, &size, &type, &name[0]);
+        // Built-in inputs (like "gl_VertexID") have no location
+        const GLint location = glGetAttribLocation(aProgram, &name[0]);
+        if (-1 != location) {
+            add(eAttrib, &name[0], type, size, location);
+        }
+    }
+
+    GLint nbUniforms = 0;
+    glGetProgramiv(aProgram, GL_ACTIVE_UNIFORMS, &nbUniforms);
+    glGetProgramiv(aProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    name.assign(maxLength + 1, '\0');
+    for (GLint idxUniform = 0; idxUniform < nbUniforms; ++idxUniform) {
+        const GLuint index = idxUniform;
+        GLint blockIndex = -1;
+        glGetActiveUniformsiv(aProgram, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+        // Uniforms of a block are set through their buffer, not by setUniform()
+        if (-1 == blockIndex) {
+            GLint   size = 0;
+            GLenum  type = 0;
+            glGetActiveUniform(aProgram, index, static_cast<GLsizei>(name.size()), NULL, &size, &type, &name[0]);
+            const GLint location = glGetUniformLocation(aProgram, &name[0]);
+            // Arrays are named after their first element ("lights[0]")
+            std::string uniformName(&name[0]);
+            const size_t bracket = uniformName.find('[');
+            if (std::string::npos != bracket) {
+                uniformName.resize(bracket);
+            }
+            add(eUniform, uniformName, type, size, location);
+        }
+    }
+
+    GLint nbBlocks = 0;
+    glGetProgramiv(aProgram, GL_ACTIVE_UNIFORM_BLOCKS, &nbBlocks);
+    glGetProgramiv(aProgram, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+    name.assign(maxLength + 1, '\0');
+    for (GLint idxBlock = 0; idxBlock < nbBlocks; ++idxBlock) {
+        GLint dataSize = 0;
+        glGetActiveUniformBlockName(aProgram, idxBlock, static_cast<GLsizei>(name.size()), NULL, &name[0]);
+        glGetActiveUniformBlockiv(aProgram, idxBlock, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+        add(eUniformBlock, &name[0], 0, dataSize, idxBlock);
+    }
+
+    // Build the hash table, at most half full so that probing sequences stay short
+    size_t capacity = 8;
+    while (capacity < 2 * mVariables.size()) {
+        capacity *= 2;
+    }
+    mTable.assign(capacity, -1);
+    for (size_t idxVariable = 0; idxVariable < mVariables.size(); ++idxVariable) {
+        size_t idxEntry = mVariables[idxVariable].mHash & (capacity - 1);
+        while (-1 != mTable[idxEntry]) {
+            idxEntry = (idxEntry + 1) & (capacity - 1);
+        }
+        mTable[idxEntry] = static_cast<int>(idxVariable);
+    }
+
+    mLog.debug() << "reflect(" << aProgram << "): " << nbAttribs << " attributes, " << nbUniforms << " uniforms, "
+                 << nbBlocks << " uniform blocks";
+}
+
+/**
+ * @brief Validate the uniforms expected by the C++ code, and resolve them into slots
+ *
+ *  The slot of each uniform is the index of its Descriptor, and its value is reset (uploaded on next set).
+ *
+ * @param[in] apDescriptors     Array of the uniforms expected, indexed by the slots of the caller
+ * @param[in] aNbDescriptors    Number of elements of the array
+ *
+ * @throw a std::exception if a uniform has a different type, or is required but not active (std::runtime_error)
+ */
+void ProgramInterface::bindUniforms(const Descriptor* apDescriptors, size_t aNbDescriptors) {
+    mUniformSlots.resize(aNbDescriptors);
+    size_t offset = 0;
+    for (size_t idxSlot = 0; idxSlot < aNbDescriptors; ++idxSlot) {
+        UniformSlot& slot = mUniformSlots[idxSlot];
+        slot.mLocation  = validate(eUniform, apDescriptors[idxSlot]);
+        slot.mType      = apDescriptors[idxSlot].mType;
+        slot.mOffset    = offset;
+        slot.mbUploaded = false;
+        offset += getTypeSize(slot.mType);
+    }
+    mValues.assign(offset, 0);
+}
+
+/**
+ * @brief Validate the attributes expected by the C++ code, and resolve them into slots
+ *
+ * @param[in] apDescriptors     Array of the attributes expected, indexed by the slots of the caller
+ * @param[in] aNbDescriptors    Number of elements of the array
+ *
+ * @throw a std::exception if an attribute has a different type or location, or is required but not active
+ */
+void ProgramInterface::bindAttribs(const Descriptor* apDescriptors, size_t aNbDescriptors) {
+    mAttribSlots.resize(aNbDescriptors);
+    for (size_t idxSlot = 0; idxSlot < aNbDescriptors; ++idxSlot) {
+        mAttribSlots[idxSlot] = validate(eAttrib, apDescriptors[idxSlot]);
+    }
+}
+
+/**
+ * @brief Set the value of an integer or sampler uniform of the program in use, unless unchanged
+ *
+ * @param[in] aSlot     Slot of the uniform (index of its Descriptor)
+ * @param[in] aValue    Value of the uniform (texture unit for samplers)
+ *
+ * @return true if the value was uploaded, false if unchanged (or the uniform is not active)
+ */
+bool ProgramInterface::setUniform(Slot aSlot, GLint aValue) {
+    const bool bChanged = isChanged(aSlot, GL_INT, &aValue, sizeof(aValue));
+    if (bChanged) {
+        glUniform1i(mUniformSlots[aSlot].mLocation, aValue);
+    }
+    return bChanged;
+}
+
+/**
+ * @brief Set the value of a vec3 uniform of the program in use, unless unchanged
+ *
+ * @param[in] aSlot     Slot of the uniform (index of its Descriptor)
+ * @param[in] aValue    Value of the uniform
+ *
+ * @return true if the value was uploaded, false if unchanged (or the uniform is not active)
+ */
+bool ProgramInterface::setUniform(Slot aSlot, const glm::vec3& aValue) {
+    const bool bChanged = isChanged(aSlot, GL_FLOAT_VEC3, glm::value_ptr(aValue), sizeof(aValue));
+    if (bChanged) {
+        glUniform3fv(mUniformSlots[aSlot].mLocation, 1, glm::value_ptr(aValue));
+    }
+    return bChanged;
+}
+
+/**
+ * @brief Set the value of a vec4 uniform of the program in use, unless unchanged
+ *
+ * @param[in] aSlot     Slot of the uniform (index of its Descriptor)
+ * @param[in] aValue    Value of the uniform
+ *
+ * @return true if the value was uploaded, false if unchanged (or the uniform is not active)
+ */
+bool ProgramInterface::setUniform(Slot aSlot, const glm::vec4& aValue) {
+    const bool bChanged = isChanged(aSlot, GL_FLOAT_VEC4, glm::value_ptr(aValue), sizeof(aValue));
+    if (bChanged) {
+        glUniform4fv(mUniformSlots[aSlot].mLocation, 1, glm::value_ptr(aValue));
+    }
+    return bChanged;
+}
+
+/**
+ * @brief Set the value of a mat4 uniform of the program in use, unless unchanged
+ *
+ * @param[in] aSlot     Slot of the uniform (index of its Descriptor)
+ * @param[in] aValue    Value of the uniform
+ *
+ * @return true if the value was uploaded, false if unchanged (or the uniform is not active)
+ */
+bool ProgramInterface::setUniform(Slot aSlot, const glm::mat4& aValue) {
+    const bool bChanged = isChanged(aSlot, GL_FLOAT_MAT4, glm::value_ptr(aValue), sizeof(aValue));
+    if (bChanged) {
+        glUniformMatrix4fv(mUniformSlots[aSlot].mLocation, 1, GL_FALSE, glm::value_ptr(aValue));
+    }
+    return bChanged;
+}
+
+/**
+ * @brief Index of an active uniform block, to be bound with glUniformBlockBinding()
+ *
+ * @param[in] apName    Name of the uniform block
+ *
+ * @return Index of the block, or GL_INVALID_INDEX if not active
+ */
+GLuint ProgramInterface::getUniformBlockIndex(const char* apName) const {
+    const Variable* pBlock = find(eUniformBlock, apName);
+    return (nullptr != pBlock) ? static_cast<GLuint>(pBlock->mLocation) : GL_INVALID_INDEX;
+}
+
+/**
+ * @brief Add a variable to the table (built at the end of reflect())
+ */
+void ProgramInterface::add(Kind aKind, const std::string& aName, GLenum aType, GLint aSize, GLint aLocation) {
+    Variable variable = {aName, hash(aName.c_str()), aKind, aType, aSize, aLocation};
+    mVariables.push_back(variable);
+}
+
+/**
+ * @brief Find an active variable by name
+ *
+ * @param[in] aKind     Kind of variable
+ * @param[in] apName    Name of the variable
+ *
+ * @return Pointer to the variable, or nullptr if not active
+ */
+const ProgramInterface::Variable* ProgramInterface::find(Kind aKind, const char* apName) const {
+    const Variable* pVariable = nullptr;
+    if (false == mTable.empty()) {
+        const unsigned int nameHash = hash(apName);
+        for (size_t idxEntry = nameHash & (mTable.size() - 1);
+             (nullptr == pVariable) && (-1 != mTable[idxEntry]);
+             idxEntry = (idxEntry + 1) & (mTable.size() - 1)) {
+            const Variable& variable = mVariables[mTable[idxEntry]];
+            if ((nameHash == variable.mHash) && (aKind == variable.mKind) && (variable.mName == apName)) {
+                pVariable = &variable;
+            }
+        }
+    }
+    return pVariable;
+}
+
+/**
+ * @brief Validate a Descriptor against the active variables of the program
+ *
+ * @param[in] aKind         Kind of variable
+ * @param[in] aDescriptor   Variable expected by the C++ code
+ *
+ * @return Location of the variable, or -1 if not active
+ *
+ * @throw a std::exception if the variable has a different type or location, or is required but not active
+ */
+GLint ProgramInterface::validate(Kind aKind, const Descriptor& aDescriptor) const {
+    GLint location = -1;
+    const Variable* pVariable = find(aKind, aDescriptor.mpName);
+    if (nullptr != pVariable) {
+        if (aDescriptor.mType != pVariable->mType) {
+            mLog.critic() << "validate(" << mProgram << "): \"" << aDescriptor.mpName << "\" of type "
+                          << pVariable->mType << " instead of " << aDescriptor.mType;
+            UTILS_THROW("validate: \"" << aDescriptor.mpName << "\" of type " << pVariable->mType << " instead of "
+                        << aDescriptor.mType);
+        }
+        if ((-1 != aDescriptor.mLocation) && (aDescriptor.mLocation != pVariable->mLocation)) {
+            mLog.critic() << "validate(" << mProgram << "): \"" << aDescriptor.mpName << "\" at location "
+                          << pVariable->mLocation << " instead of " << aDescriptor.mLocation;
+            UTILS_THROW("validate: \"" << aDescriptor.mpName << "\" at location " << pVariable->mLocation
+                        << " instead of " << aDescriptor.mLocation);
+        }
+        location = pVariable->mLocation;
+    } else if (aDescriptor.mbRequired) {
+        mLog.critic() << "validate(" << mProgram << "): \"" << aDescriptor.mpName << "\" not active";
+        UTILS_THROW("validate: \"" << aDescriptor.mpName << "\" not active");
+    } else {
+        mLog.debug() << "validate(" << mProgram << "): \"" << aDescriptor.mpName << "\" not active (optimized out)";
+    }
+    return location;
+}
+
+/**
+ * @brief Compare a value to the last one uploaded into a slot, and keep it if different
+ *
+ * @param[in] aSlot     Slot of the uniform (index of its Descriptor)
+ * @param[in] aType     Type of the value (GL_INT is also accepted by samplers)
+ * @param[in] apValue   Pointer to the value
+ * @param[in] aSize     Size of the value in bytes
+ *
+ * @return true if the value has to be uploaded
+ *
+ * @throw a std::exception if the type of the value is not the one of the Descriptor (std::runtime_error)
+ */
+bool ProgramInterface::isChanged(Slot aSlot, GLenum aType, const void* apValue, size_t aSize) {
+    UniformSlot& slot = mUniformSlots[aSlot];
+    if ((aType != slot.mType) && ((GL_INT != aType) || (false == isSampler(slot.mType)))) {
+        UTILS_THROW("setUniform: slot " << aSlot << " of type " << slot.mType << " set with a value of type "
+                    << aType);
+    }
+    bool bChanged = false;
+    if (-1 != slot.mLocation) {
+        unsigned char* pLastValue = &mValues[slot.mOffset];
+        if ((false == slot.mbUploaded) || (0 != memcmp(pLastValue, apValue, aSize))) {
+            memcpy(pLastValue, apValue, aSize);
+            slot.mbUploaded = true;
+            bChanged = true;
+        }
+    }
+    return bChanged;
+}
+
+/**
+ * @brief 32 bits FNV-1a hash of a name
+ */
+unsigned int ProgramInterface::hash(const char* apName) {
+    unsigned int nameHash = 2166136261U;
+    for (const char* pChar = apName; '\0' != *pChar; ++pChar) {
+        nameHash ^= static_cast<unsigned char>(*pChar);
+        nameHash *= 16777619U;
+    }
+    return nameHash;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file    ProgramInterface.h
+ * @ingroup Main
+ * @brief   Active attributes, uniforms and uniform blocks of a linked program, and their slots
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "LoggerCpp/LoggerCpp.h"
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::mat4, glm::vec3... (GLM_FORCE_RADIANS defined at the project level)
+
+#include <vector>
+#include <string>
+
+/**
+ * @brief   Active attributes, uniforms and uniform blocks of a linked program, and their slots
+ * @ingroup Main
+ *
+ *  reflect() introspects a linked program (glGetActiveAttrib(), glGetActiveUniform() and
+ * glGetActiveUniformBlockName()) into a compact open addressing hash table of its names,
+ * so that no string is ever given to OpenGL afterward.
+ *
+ *  The code using the program describes the variables it expects by an array of Descriptor, indexed
+ * by its own enum: bindUniforms() and bindAttribs() validate them against the program (type, and location
+ * for attributes with an explicit layout) and resolve them into slots, the index of each Descriptor.
+ * Values are then pushed through these slots by setUniform(), which keeps a copy of the last value uploaded
+ * to skip redundant glUniform*() calls. Variables optimized out by the compiler (like the lighting in
+ * a "DEPTH_ONLY" permutation) get a location of -1 and are silently ignored, unless required.
+ */
+class ProgramInterface {
+public:
+    /**
+     * @brief Variable expected by the C++ code
+     */
+    struct Descriptor {
+        const char* mpName;     ///< Name of the variable in the shaders
+        GLenum      mType;      ///< Type of the variable (GL_FLOAT_VEC3, GL_FLOAT_MAT4, GL_SAMPLER_2D...)
+        GLint       mLocation;  ///< Explicit location of an attribute (-1 for any location, and for uniforms)
+        bool        mbRequired; ///< Tell if the variable has to be active in the program
+    };
+
+    /// Index of a Descriptor in the array given to bindUniforms() or bindAttribs()
+    typedef size_t Slot;
+
+public:
+    ProgramInterface();
+    ~ProgramInterface(); // not virtual because no virtual methods and class not derived
+
+    // Introspect the active variables of a linked program, forgetting any previous one
+    void reflect(GLuint aProgram);
+
+    // Validate the uniforms expected by the C++ code, and resolve them into slots
+    void bindUniforms(const Descriptor* apDescriptors, size_t aNbDescriptors);
+    // Validate the attributes expected by the C++ code, and resolve them into slots
+    void bindAttribs(const Descriptor* apDescriptors, size_t aNbDescriptors);
+
+    // Set the value of a uniform of the program in use, unless unchanged (return true if uploaded)
+    bool setUniform(Slot aSlot, GLint aValue);
+    bool setUniform(Slot aSlot, const glm::vec3& aValue);
+    bool setUniform(Slot aSlot, const glm::vec4& aValue);
+    bool setUniform(Slot aSlot, const glm::mat4& aValue);
+
+    // Index of an active uniform block (GL_INVALID_INDEX if not active)
+    GLuint getUniformBlockIndex(const char* apName) const;
+
+    // Getters
+    inline GLuint getProgram() const;
+    inline GLint  getUniformLocation(Slot aSlot) const;
+    inline GLint  getAttribLocation(Slot aSlot) const;
+
+private:
+    /**
+     * @brief Kind of active variable
+     */
+    enum Kind {
+        eAttrib,        ///< Vertex attribute (input stream)
+        eUniform,       ///< Uniform of the default block
+        eUniformBlock   ///< Uniform block (or a uniform of a block, not settable by setUniform())
+    };
+
+    /**
+     * @brief Active variable of the program
+     */
+    struct Variable {
+        std::string mName;      ///< Name of the variable (without any "[0]" suffix for arrays)
+        unsigned int mHash;     ///< Hash of the name
+        Kind        mKind;      ///< Kind of variable
+        GLenum      mType;      ///< Type of the variable (0 for uniform blocks)
+        GLint       mSize;      ///< Number of elements of an array (1 if not an array), or data size of a block
+        GLint       mLocation;  ///< Location of the variable, or index of the uniform block
+    };
+
+    /**
+     * @brief Uniform resolved from a Descriptor
+     */
+    struct UniformSlot {
+        GLint   mLocation;  ///< Location of the uniform (-1 if not active)
+        GLenum  mType;      ///< Type of the Descriptor
+        size_t  mOffset;    ///< Offset of the last value uploaded in mValues
+        bool    mbUploaded; ///< Tell if a value has been uploaded since reflect()
+    };
+
+private:
+    // Add a variable to the table
+    void add(Kind aKind, const std::string& aName, GLenum aType, GLint aSize, GLint aLocation);
+    // Find an active variable by name (nullptr if not active)
+    const Variable* find(Kind aKind, const char* apName) const;
+    // Validate a Descriptor, returning the location of its variable (-1 if not active)
+    GLint validate(Kind aKind, const Descriptor& aDescriptor) const;
+    // Compare a value to the last one uploaded into a slot, and keep it if different
+    bool isChanged(Slot aSlot, GLenum aType, const void* apValue, size_t aSize);
+
+    // Hash of a name
+    static unsigned int hash(const char* apName);
+
+private:
+    Log::Logger mLog;                           ///< Logger object to output runtime information
+
+    GLuint                      mProgram;       ///< Program introspected
+    std::vector<Variable>       mVariables;     ///< Active variables of the program
+    std::vector<int>            mTable;         ///< Open addressing hash table of indexes in mVariables (-1 if empty)
+    std::vector<UniformSlot>    mUniformSlots;  ///< Uniforms resolved by bindUniforms()
+    std::vector<GLint>          mAttribSlots;   ///< Locations of the attributes resolved by bindAttribs()
+    std::vector<unsigned char>  mValues;        ///< Last value uploaded into each uniform slot
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(ProgramInterface);
+};
+
+
+/**
+ * @brief Get the program introspected (0 if none)
+ */
+inline GLuint ProgramInterface::getProgram() const {
+    return mProgram;
+}
+
+/**
+ * @brief Get the location of a uniform resolved by bindUniforms() (-1 if not active)
+ */
+inline GLint ProgramInterface::getUniformLocation(Slot aSlot) const {
+    return mUniformSlots[aSlot].mLocation;
+}
+
+/**
+ * @brief Get the location of an attribute resolved by bindAttribs() (-1 if not active)
+ */
+inline GLint ProgramInterface::getAttribLocation(Slot aSlot) const {
+    return mAttribSlots[aSlot];
+}
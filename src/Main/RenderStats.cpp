@@ -0,0 +1,131 @@
+/**
+ * @file    RenderStats.cpp
+ * @ingroup Main
+ * @brief   Per-frame rendering statistics counters (draw calls, triangles, binds...)
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/RenderStats.h"
+
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <cstring>  // memset
+
+/**
+ * @brief Constructor
+ */
+RenderStats::RenderStats() :
+    mIdxCurrent(IDX_FRAME) {
+    memset(mCurrent, 0, sizeof(mCurrent));
+    memset(mLast, 0, sizeof(mLast));
+    reset();
+}
+
+/**
+ * @brief Destructor
+ */
+RenderStats::~RenderStats() {
+}
+
+/**
+ * @brief Start counting a new frame
+ */
+void RenderStats::beginFrame() {
+    memset(mCurrent, 0, sizeof(mCurrent));
+    mIdxCurrent = IDX_FRAME;
+}
+
+/**
+ * @brief End of the current frame: aggregate its totals
+ */
+void RenderStats::endFrame() {
+    for (int idxCounter = 0; idxCounter < eNbCounters; ++idxCounter) {
+        unsigned int total = 0;
+        for (int idxEye = 0; idxEye <= IDX_FRAME; ++idxEye) {
+            total += mCurrent[idxEye][idxCounter];
+        }
+        for (int idxEye = 0; idxEye < NB_EYES; ++idxEye) {
+            mEyeSum[idxEye][idxCounter] += mCurrent[idxEye][idxCounter];
+        }
+
+        mLast[idxCounter] = total;
+        mSum[idxCounter] += total;
+        if ((0 == mNbFrames) || (total < mMin[idxCounter])) {
+            mMin[idxCounter] = total;
+        }
+        if (total > mMax[idxCounter]) {
+            mMax[idxCounter] = total;
+        }
+    }
+    ++mNbFrames;
+    mIdxCurrent = IDX_FRAME;
+}
+
+/**
+ * @brief Reset the aggregated values (start a new interval)
+ */
+void RenderStats::reset() {
+    mNbFrames = 0;
+    memset(mMin, 0, sizeof(mMin));
+    memset(mMax, 0, sizeof(mMax));
+    memset(mSum, 0, sizeof(mSum));
+    memset(mEyeSum, 0, sizeof(mEyeSum));
+}
+
+/**
+ * @brief Human readable summary of the aggregated values
+ *
+ *  For each counter: "name avg (min-max) [left/right]"
+ *
+ * @return String summarizing the aggregated values since the last reset()
+ */
+std::string RenderStats::toString() const {
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(1);
+    for (int idxCounter = 0; idxCounter < eNbCounters; ++idxCounter) {
+        const Counter counter = static_cast<Counter>(idxCounter);
+        if (0 != idxCounter) {
+            stream << ", ";
+        }
+        stream << getName(counter) << " " << getAverage(counter)
+               << " (" << getMin(counter) << "-" << getMax(counter) << ")"
+               << " [" << getEyeAverage(0, counter) << "/" << getEyeAverage(1, counter) << "]";
+    }
+    return stream.str();
+}
+
+/**
+ * @brief Short name of a counter
+ *
+ * @param[in] aCounter  Counter to name
+ *
+ * @return Static string with the name of the counter
+ */
+const char* RenderStats::getName(Counter aCounter) {
+    static const char* _names[eNbCounters] = {
+        "draws",
+        "triangles",
+        "vaoBinds",
+        "programBinds",
+        "uniforms",
+        "nodes",
+        "meshes",
+        "instances",
+        "lodSaved",
+        "impostors",
+        "stateCalls",
+        "stateElided",
+        "static",
+        "occluded",
+        "occludedSaved",
+        "queries",
+        "softTested",
+        "softOccluded"
+    };
+    return _names[aCounter];
+}
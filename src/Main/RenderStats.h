@@ -0,0 +1,168 @@
+/**
+ * @file    RenderStats.h
+ * @ingroup Main
+ * @brief   Per-frame rendering statistics counters (draw calls, triangles, binds...)
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Utils/Utils.h"
+
+#include <string>
+#include <cstdint>         // uint64_t
+
+/**
+ * @brief   Per-frame rendering statistics counters (draw calls, triangles, binds...)
+ * @ingroup Main
+ *
+ *  Counters are incremented by the drawing code during a frame, separately for each eye,
+ * and everything issued outside of an eye (like clearing or binding the program) is attributed to the frame itself.
+ *  At the end of each frame, the totals are aggregated (min/average/max) until the next call to reset(),
+ * typically at the same interval as the FPS calculation.
+ */
+class RenderStats {
+public:
+    /// Enumeration of the counters available
+    enum Counter {
+        eDrawCalls = 0,     ///< Number of glDraw*() calls issued
+        eTriangles,         ///< Number of triangles submitted to the GPU
+        eVaoBinds,          ///< Number of Vertex Array Object bound
+        eProgramBinds,      ///< Number of shader Program bound
+        eUniformUploads,    ///< Number of glUniform*() calls issued
+        eNodes,             ///< Number of Nodes visited by the draw traversal
+        eMeshes,            ///< Number of Meshes visited by the draw traversal
+        eInstances,         ///< Number of Mesh instances drawn (by instanced draw calls)
+        eLodSavedTriangles, ///< Number of triangles not drawn thanks to the levels of detail (and impostors)
+        eImpostors,         ///< Number of Mesh instances drawn as impostors
+        eStateCalls,        ///< Number of binding and state changing OpenGL calls issued (see StateCache)
+        eStateElided,       ///< Number of binding and state changing OpenGL calls elided as redundant
+        eStaticMeshes,      ///< Number of Meshes baked into static batches (see RetainedDrawList)
+        eOccludedNodes,     ///< Number of Nodes culled by occlusion queries (see OcclusionCuller)
+        eOccludedTriangles, ///< Number of triangles not drawn thanks to occlusion culling
+        eOcclusionQueries,  ///< Number of occlusion queries issued
+        eSoftTestedNodes,   ///< Number of Nodes tested by the software occlusion culling (see SoftwareOcclusion)
+        eSoftOccludedNodes, ///< Number of Nodes culled by the software occlusion culling
+        eNbCounters         ///< Number of counters (not a counter by itself)
+    };
+
+    /// Number of eyes for stereo rendering, the frame itself uses the following index
+    static const int NB_EYES = 2;
+
+public:
+    RenderStats();
+    ~RenderStats(); // not virtual because no virtual methods and class not derived
+
+    // Frame boundaries: counters are accumulated between a begin/end pair
+    void beginFrame();
+    void endFrame();
+
+    // Attribute the following counters to the given eye (0: left, 1: right), or to the frame (-1)
+    inline void setEye(int aIdxEye);
+
+    // Increment a counter of the current frame and current eye
+    inline void incr(Counter aCounter, unsigned int aValue = 1);
+
+    // Reset the aggregated values (start a new interval)
+    void reset();
+
+    // Getters of the aggregated values
+    inline unsigned int getNbFrames() const;
+    inline unsigned int getMin(Counter aCounter) const;
+    inline unsigned int getMax(Counter aCounter) const;
+    inline float        getAverage(Counter aCounter) const;
+    inline float        getEyeAverage(int aIdxEye, Counter aCounter) const;
+    inline unsigned int getLast(Counter aCounter) const;
+
+    // Human readable summary of the aggregated values
+    std::string toString() const;
+
+    // Short name of a counter
+    static const char* getName(Counter aCounter);
+
+private:
+    /// Index of the frame (not an eye) in the per-frame arrays
+    static const int IDX_FRAME = NB_EYES;
+
+    int                 mIdxCurrent;                                ///< Index of the eye (or frame) being counted
+    unsigned int        mCurrent[NB_EYES + 1][eNbCounters];         ///< Counters of the current frame, per eye
+    unsigned int        mLast[eNbCounters];                         ///< Totals of the last complete frame
+
+    unsigned int        mNbFrames;                                  ///< Number of frames aggregated since reset()
+    unsigned int        mMin[eNbCounters];                          ///< Minimum per frame total since reset()
+    unsigned int        mMax[eNbCounters];                          ///< Maximum per frame total since reset()
+    uint64_t            mSum[eNbCounters];                          ///< Sum of per frame totals since reset()
+    uint64_t            mEyeSum[NB_EYES][eNbCounters];              ///< Sum of per eye values since reset()
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(RenderStats);
+};
+
+
+/**
+ * @brief Attribute the following counters to the given eye, or to the frame
+ *
+ * @param[in] aIdxEye   Index of the eye (0: left, 1: right), or -1 for anything outside of an eye
+ */
+inline void RenderStats::setEye(int aIdxEye) {
+    mIdxCurrent = ((0 <= aIdxEye) && (NB_EYES > aIdxEye)) ? aIdxEye : IDX_FRAME;
+}
+
+/**
+ * @brief Increment a counter of the current frame and current eye
+ *
+ * @param[in] aCounter  Counter to increment
+ * @param[in] aValue    Value to add to the counter
+ */
+inline void RenderStats::incr(Counter aCounter, unsigned int aValue /* = 1 */) {
+    mCurrent[mIdxCurrent][aCounter] += aValue;
+}
+
+/**
+ * @brief Get the number of frames aggregated since the last reset()
+ */
+inline unsigned int RenderStats::getNbFrames() const {
+    return mNbFrames;
+}
+
+/**
+ * @brief Get the minimum per frame value of a counter since the last reset()
+ */
+inline unsigned int RenderStats::getMin(Counter aCounter) const {
+    return (0 < mNbFrames) ? mMin[aCounter] : 0;
+}
+
+/**
+ * @brief Get the maximum per frame value of a counter since the last reset()
+ */
+inline unsigned int RenderStats::getMax(Counter aCounter) const {
+    return mMax[aCounter];
+}
+
+/**
+ * @brief Get the average per frame value of a counter since the last reset()
+ */
+inline float RenderStats::getAverage(Counter aCounter) const {
+    return (0 < mNbFrames) ? (static_cast<float>(mSum[aCounter]) / mNbFrames) : 0.0f;
+}
+
+/**
+ * @brief Get the average per eye value of a counter since the last reset()
+ *
+ * @param[in] aIdxEye   Index of the eye (0: left, 1: right)
+ * @param[in] aCounter  Counter to get
+ */
+inline float RenderStats::getEyeAverage(int aIdxEye, Counter aCounter) const {
+    return (0 < mNbFrames) ? (static_cast<float>(mEyeSum[aIdxEye][aCounter]) / mNbFrames) : 0.0f;
+}
+
+/**
+ * @brief Get the value of a counter for the last complete frame
+ */
+inline unsigned int RenderStats::getLast(Counter aCounter) const {
+    return mLast[aCounter];
+}
@@ -10,25 +10,26 @@
  */
 
 #include "Main/Renderer.h"
-#include "Main/MatrixStack.h"
-#include "Main/ShaderProgram.h"
+#include "Main/SceneGenerator.h"
+#include "Main/SceneManifest.h"
+#include "Main/StateCache.h"
 #include "Utils/Exception.h"
 #include "Utils/Measure.h"
-#include "Utils/String.h"
 
 #include <glm/gtc/type_ptr.hpp>         // glm::value_ptr
 #include <glm/gtc/matrix_transform.hpp> // glm::perspective, glm::rotate, glm::translate
 
 #include <assimp/cimport.h>     // Log Stream
-#include <assimp/Importer.hpp>  // Open Asset Importer
-#include <assimp/postprocess.h> // Post processing flags
 
-#include <fstream>      // NOLINT(readability/streams) for shader files
 #include <sstream>
 #include <string>
 #include <vector>
 #include <ctime>
 #include <cassert>
+#include <cstring>      // memcpy
+#include <functional>   // std::bind, std::placeholders
+#include <algorithm>    // std::sort, std::max
+#include <utility>      // std::pair, std::make_pair
 
 #include <cmath>    // cos, sin, tan
 
@@ -43,60 +44,126 @@ static const float Z_BACK   = -1.0f;    ///< Back coordinate
 
 static const float _zNear           = 0.1f;     ///< Z coordinate or the near/front frustum plane from which to render
 static const float _zFar            = 10000.0f; ///< Z coordinate or the far/back frustum plane to which to render
+static const float _lodHysteresis   = 0.25f;    ///< Relative margin around the maximum LOD error before switching
+
+/// Uniforms of the program of the Meshes, in the order of Renderer::MeshUniform (the lighting is optional)
+static const ProgramInterface::Descriptor _meshUniforms[] = {
+    {"cameraToClipMatrix",  GL_FLOAT_MAT4, -1, true},
+    {"dirToLight",          GL_FLOAT_VEC3, -1, false},
+    {"lightIntensity",      GL_FLOAT_VEC4, -1, false},
+    {"ambientIntensity",    GL_FLOAT_VEC4, -1, false}
+};
+/// Attributes of the program of the Meshes, in the order of Renderer::MeshAttrib, at their explicit layout locations
+static const ProgramInterface::Descriptor _meshAttribs[] = {
+    {"position",            GL_FLOAT_VEC4, 0, true},
+    {"diffuseColor",        GL_FLOAT_VEC4, 1, false},
+    {"normal",              GL_FLOAT_VEC3, 2, false},
+    {"modelToCameraMatrix", GL_FLOAT_MAT4, 3, true}
+};
 
 
 /**
  * @brief Constructor
+ *
+ * @param[in] aOptions  Command line options (scene to load or to generate)
  */
-Renderer::Renderer() :
+Renderer::Renderer(const Options& aOptions) :
     mLog("Renderer"),
+    mMeshPrograms("data/ModelWorldCameraClip.vert", "data/PassthroughColor.frag"),
+    mShaderDefines(aOptions.mShaderDefines),
     mProgram(0),
-    mPositionAttrib(-1),
-    mColorAttrib(-1),
-    mNormalAttrib(-1),
-    mModelToCameraMatrixUnif(-1),
-    mCameraToClipMatrixUnif(-1),
+    mDepthMode(aOptions.mDepthMode),
+    mDepthProgram(0),
+    mbOverdraw(aOptions.mbOverdraw),
+    mCameraToClipMatrix(1.0f),
     mCameraOrientation(),
     mCameraTranslation(0.0f, 0.0f, 30.0f),
     mDirToLight(0.866f, -0.5f, 0.0f, 0.0f), // Normalized vector!
     mLightIntensity(0.8f, 0.8f, 0.8f, 1.0f),
     mAmbientIntensity(0.2f, 0.2f, 0.2f, 1.0f),
+    mAssetStreamer(mResourceManager, aOptions.mNbLoaderThreads),
+    mUploadBudgetBytes(aOptions.mUploadBudgetKB * 1024),
+    mUploadBudgetUs(aOptions.mUploadBudgetUs),
     mScreenWidth(0),
     mScreenHeight(0),
-    mScreenCenterOffset(2.0f) {
-    init();
+    mScreenCenterOffset(2.0f),
+    mLodSelector(aOptions.mLodPixelError, aOptions.mImpostorPixelSize, _lodHysteresis),
+    mOcclusionCpuWidth(aOptions.mOcclusionCpuWidth),
+    mFramePacer(aOptions.mNbFramesInFlight),
+    mMatrixRing(GL_ARRAY_BUFFER, mFramePacer.getNbFramesInFlight(), 64 * 1024, sizeof(glm::mat4)) {
+    init(aOptions);
 }
 
 /**
  * @brief Destructor
  */
 Renderer::~Renderer() {
-    glDeleteProgram(mProgram);
+    // The programs are deleted by mMeshPrograms
 }
 
 /**
  * @brief Initialization
+ *
+ * @param[in] aOptions  Command line options (scene to load or to generate)
  */
-void Renderer::init() {
+void Renderer::init(const Options& aOptions) {
     // 1) compile shaders and link them in a program
+    if (mbOverdraw) {
+        // Visualize the overdraw by accumulating a constant color for each fragment shaded
+        mShaderDefines.push_back("OVERDRAW");
+    }
     initProgram();
+    mResourceManager.setCompactVertices(aOptions.mbCompactVertices);
+    // The depth pre-pass reads the positions only, and uses the cheapest permutation of the program
+    mResourceManager.setDepthOnlyStream(Options::eDepthPrepass == mDepthMode);
+    mOcclusionCuller.setMinTriangles(aOptions.mOcclusionTriangles);
+    if ((Options::eDepthPrepass == mDepthMode) || mOcclusionCuller.isEnabled() || aOptions.mbCockpitMask) {
+        initDepthProgram();
+    }
+    if (mOcclusionCuller.isEnabled() || aOptions.mbCockpitMask) {
+        // The bounding boxes of the occlusion queries, and the cockpit mask with the quad testing its coverage,
+        // are drawn by the program of the depth pre-pass
+        MeshData boxData;
+        OcclusionCuller::makeBox(boxData);
+        const Mesh::Ptr boxPtr = mResourceManager.uploadMesh(boxData, false);
+        mOcclusionCuller.setBox(boxPtr);
+        if (aOptions.mbCockpitMask) {
+            mCockpitMask.init(boxPtr);
+        }
+    }
+    mResourceManager.setStaticBatching(aOptions.mStaticBatchVertices);
+    if (0 < aOptions.mStaticBatchVertices) {
+        // Static batches are uploaded like the other Meshes, but are not baked again themselves
+        mBakeUploader = std::bind(&ResourceManager::uploadMesh, &mResourceManager, std::placeholders::_1, false,
+                                  false);
+    }
+
+    // 2) Initialize the scene hierarchy, default or procedurally generated
+    if (aOptions.mbGenerateScene) {
+        initGeneratedScene(aOptions);
+    } else {
+        initScene(aOptions.mManifestFilename);
+    }
 
-    // 2) Initialize the scene hierarchy
-    initScene();
+    // 3) Size the matrix ring for the Scene: one matrix per Node and per eye
+    const unsigned int nbNodes = mSceneHierarchy.getNbNodes();
+    mMatrixRing.reserve(2 * nbNodes * sizeof(glm::mat4));
+    mLog.notice() << nbNodes << " Nodes";
 
     // 2) Initialize more OpenGL option
     // Face Culling : We use the OpenGL default Counter Clockwise Winding order (GL_CCW)
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    StateCache::enable(GL_CULL_FACE, true);
+    StateCache::cullFace(GL_BACK);
     glFrontFace(GL_CCW);
     // Depth Test
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask(GL_TRUE);
-    glDepthFunc(GL_LEQUAL);
+    StateCache::enable(GL_DEPTH_TEST, true);
+    StateCache::depthMask(true);
+    StateCache::depthFunc(GL_LEQUAL);
     glDepthRange(0.0f, 1.0f);
-    // Enable blending transparency (and also the unused following OpenGL "SMOOTH" anti-aliasing)
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // No blending: all Meshes are opaque (and the impostors are alpha tested), except to visualize the overdraw,
+    // where each fragment shaded adds its constant color
+    StateCache::enable(GL_BLEND, mbOverdraw);
+    StateCache::blendFunc(GL_ONE, GL_ONE);
 
     // NOTE OpenGL "SMOOTH" polygon anti-aliasing, does NOT work nicely; it requires to do depth sorted rendering
     //   => prefer following modern multisampling MSAA or FSAA
@@ -107,54 +174,117 @@ void Renderer::init() {
     if (0 != multiSampling) {
         glGetIntegerv(GL_SAMPLES, &numSamples);
         // Enable multisampling : MSAA/FSAA needs to be defined in NVIDIA/AMD/Intel driver panel
-        glEnable(GL_MULTISAMPLE);
+        StateCache::enable(GL_MULTISAMPLE, true);
         glHint(GL_MULTISAMPLE_FILTER_HINT_NV, GL_NICEST); // or GL_FASTEST
         mLog.notice() << "MultiSampling " << numSamples << "x";
     } else {
         mLog.warning() << "MultiSampling not working";
-        glDisable(GL_MULTISAMPLE);
+        StateCache::enable(GL_MULTISAMPLE, false);
     }
 
     // Gamma correction to produce image in the sRGB colorspace
-    glEnable(GL_FRAMEBUFFER_SRGB);
+    StateCache::enable(GL_FRAMEBUFFER_SRGB, true);
 }
 
 /**
- * @brief compile shaders and link them in a program
+ * @brief Use the base program of the Meshes (compiled at construction), and request the required permutation
  */
 void Renderer::initProgram() {
-    ShaderProgram   shaderProgram;
-
-    // Compile the shader files (into intermediate compiled object)
-    // and Link them in a program (into the final executable to send to the GPU)
-    mLog.debug() << "initProgram: compiling shaders and linking program...";
-    mProgram = shaderProgram.makeProgram("data/ModelWorldCameraClip.vert", "data/PassthroughColor.frag");
-
-    // Get location of (vertex) attributes (input streams of (vertex) shader
-    /// @todo test (THROW) attribute and uniform != -1
-    mPositionAttrib = glGetAttribLocation(mProgram, "position");        // layout(location = 0) in vec4 position;
-    mColorAttrib    = glGetAttribLocation(mProgram, "diffuseColor");    // layout(location = 1) in vec4 diffuseColor;
-    mNormalAttrib   = glGetAttribLocation(mProgram, "normal");          // layout(location = 2) in vec4 normal;
-    // Get location of uniforms - input variables of (vertex) shader
-    // "Model to Camera" matrix, positioning the model into camera space
-    // "Camera to Clip" matrix,  defining the perspective transformation
-    mModelToCameraMatrixUnif    = glGetUniformLocation(mProgram, "modelToCameraMatrix");
-    mCameraToClipMatrixUnif     = glGetUniformLocation(mProgram, "cameraToClipMatrix");
-    mDirToLightUnif             = glGetUniformLocation(mProgram, "dirToLight");
-    mLightIntensityUnif         = glGetUniformLocation(mProgram, "lightIntensity");
-    mAmbientIntensityUnif       = glGetUniformLocation(mProgram, "ambientIntensity");
+    // The base program, without any define, is used until the required permutation is compiled in the background
+    setProgram(mMeshPrograms.getBase());
+    mMeshPrograms.get(mShaderDefines);
+
+    // Locations of (vertex) attributes (input streams of (vertex) shader)
+    // (the same for all permutations, given by explicit layout locations validated by setProgram())
+    mResourceManager.setAttribLocations(mMeshInterface.getAttribLocation(ePositionAttrib),
+                                        mMeshInterface.getAttribLocation(eColorAttrib),
+                                        mMeshInterface.getAttribLocation(eNormalAttrib),
+                                        mMeshInterface.getAttribLocation(eMatrixAttrib));
+    mImpostorAtlas.setLighting(mLightIntensity, mAmbientIntensity);
+}
+
+/**
+ * @brief Use a permutation of the program of the Meshes, introspecting its variables and setting their values
+ *
+ *  The lighting is optimized out of some permutations (like "DEPTH_ONLY"), so only the matrices are required.
+ *
+ * @param[in] aProgram  Program of a permutation (see ShaderPermutations)
+ *
+ * @throw a std::exception if the variables of the program are not the ones expected (std::runtime_error)
+ */
+void Renderer::setProgram(GLuint aProgram) {
+    static_assert(sizeof(_meshUniforms) / sizeof(_meshUniforms[0]) == eNbMeshUniforms, "one Descriptor per slot");
+    static_assert(sizeof(_meshAttribs) / sizeof(_meshAttribs[0]) == eNbMeshAttribs, "one Descriptor per slot");
+
+    mProgram = aProgram;
+    mMeshInterface.reflect(mProgram);
+    mMeshInterface.bindUniforms(_meshUniforms, eNbMeshUniforms);
+    mMeshInterface.bindAttribs(_meshAttribs, eNbMeshAttribs);
 
     // Set uniform values with our constants
-    glUseProgram(mProgram);
-    glUniform4fv(mLightIntensityUnif, 1, glm::value_ptr(mLightIntensity));
-    glUniform4fv(mAmbientIntensityUnif, 1, glm::value_ptr(mAmbientIntensity));
-    glUseProgram(0);
+    StateCache::useProgram(mProgram);
+    mMeshInterface.setUniform(eLightIntensityUnif, mLightIntensity);
+    mMeshInterface.setUniform(eAmbientIntensityUnif, mAmbientIntensity);
+    mMeshInterface.setUniform(eCameraToClipMatrixUnif, mCameraToClipMatrix);
 }
 
 /**
- * @brief  Initialize the scene hierarchy
+ * @brief Use the base program for the depth only passes, and request its "DEPTH_ONLY" permutation (once)
  */
-void Renderer::initScene() {
+void Renderer::initDepthProgram() {
+    if (0 == mDepthProgram) {
+        mDepthDefines.push_back("DEPTH_ONLY");
+        setDepthProgram(mMeshPrograms.getBase());
+        mMeshPrograms.get(mDepthDefines);
+    }
+}
+
+/**
+ * @brief Use a permutation of the program of the depth pre-pass, introspecting its variables and setting their values
+ *
+ *  The depth pre-pass only needs the matrices: the lighting of the base program is ignored (the color mask is off)
+ * until its "DEPTH_ONLY" permutation is compiled.
+ *
+ * @param[in] aProgram  Program of a permutation (see ShaderPermutations)
+ *
+ * @throw a std::exception if the variables of the program are not the ones expected (std::runtime_error)
+ */
+void Renderer::setDepthProgram(GLuint aProgram) {
+    mDepthProgram = aProgram;
+    mDepthInterface.reflect(mDepthProgram);
+    mDepthInterface.bindUniforms(_meshUniforms, eNbMeshUniforms);
+    mDepthInterface.bindAttribs(_meshAttribs, eNbMeshAttribs);
+
+    StateCache::useProgram(mDepthProgram);
+    mDepthInterface.setUniform(eCameraToClipMatrixUnif, mCameraToClipMatrix);
+}
+
+/**
+ * @brief Skip the pixels never seen through the lenses of the HMD, by drawing their hidden area first into each eye
+ *
+ *  Called once the HMD is known (after the construction), before the first reshape().
+ *
+ * @param[in] aDistortion   Lens distortion of the HMD (see OculusHMD::getDistortion())
+ */
+void Renderer::setHiddenArea(const OculusHMD::Distortion& aDistortion) {
+    // The hidden area is drawn by the program of the depth pre-pass
+    initDepthProgram();
+    float fractions[2];
+    for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+        MeshData meshData;
+        fractions[idxEye] = HiddenArea::make(aDistortion, idxEye, meshData);
+        mHiddenArea.setMesh(idxEye, mResourceManager.uploadMesh(meshData, false));
+    }
+    mLog.notice() << "setHiddenArea: " << fractions[0] * 100.0f << "% of the left eye and "
+                  << fractions[1] * 100.0f << "% of the right eye never seen through the lenses";
+}
+
+/**
+ * @brief  Initialize the scene hierarchy from a scene manifest
+ *
+ * @param[in] aManifestFilename Name of the scene manifest file (see SceneManifest)
+ */
+void Renderer::initScene(const std::string& aManifestFilename) {
     // get a handle to the predefined STDOUT log stream and attach
     // it to the logging system. It remains active for all further
     // calls to aiImportFile(Ex) and aiApplyPostProcessing.
@@ -166,199 +296,115 @@ void Renderer::initScene() {
     // stream = aiGetPredefinedLogStream(aiDefaultLogStream_FILE, "assimp_log.txt");
     // aiAttachLogStream(&stream);
 
-    // We use a text file to tell which test mesh to load
-    std::string importFilename = "data/import.txt";
-    mLog.debug() << "initScene(" << importFilename << ")...";
-    std::ifstream importFile(importFilename.c_str());
-    if (false == importFile.is_open()) {
-        mLog.critic() << "initScene: unavailable file \"" << importFilename << "\"";
-        UTILS_THROW("compileShader: unavailable file \"" << importFilename << "\"");
-    }
-
-    /// @todo multi-line multi-mesh loading
-    std::string modelFile;
-    if (std::getline(importFile, modelFile)) {
-        Utils::trim(modelFile);
-
-        mLog.notice() << "initScene(\"" << importFilename << "\") modelFile=\"" << modelFile << "\"";
-
-        // Load the mesh of our main movable model (a colored cube by default), and add it to the Scene hierarchy
-        Node::Ptr HierarchyPtr = loadFile(modelFile.c_str());
-        mSceneHierarchy.addRootNode(HierarchyPtr);
-        /// @todo here we get to the Cuboid & Cube models => use a dictionary (map) to get models by names
-        mModelPtr  = HierarchyPtr;
-        mModelPtr->move(glm::vec3(-3.0f, -1.0f, -4.0f));
-        mModelPtr->yaw(1.57f); // 90° horizontally arround y (to face right)
-        mModelPtr->roll(0.2f); // arround z
-        mModelPtr->setRotationalSpeed(glm::vec3(-0.05f, -0.3f, 0.0f)); // pitch, yaw, roll
-        mModelPtr->setLinearSpeed(glm::vec3(0.0f, 0.0f, 3.0f));
-        mTurretPtr = HierarchyPtr->getChildren().front();
-        mTurretPtr->setRotationalSpeed(glm::vec3(0.0f, 0.8f, 0.0f));
-    } else  {
-        mLog.critic() << "initScene: no model file in \"" << importFilename << "\"";
-        UTILS_THROW("compileShader: no model file in \"" << importFilename << "\"");
-    }
-
-    // Load an experimental cockpit => toward a camera view in world
-    Node::Ptr CockpitPtr = loadFile("data/cockpit.dae");
-    CockpitPtr->move(glm::vec3(0.0f, 0.0f, 0.0f));
-//  CockpitPtr->yaw(3.14f); // 180° horizontally arround y (to face back)
-    mSceneHierarchy.addRootNode(CockpitPtr);
-
-    // Load a ground/plane for some kind of fixe reference
-    Node::Ptr PlanePtr = loadFile("data/plane.dae");
-    mSceneHierarchy.addRootNode(PlanePtr);
+    // We use a manifest file to tell which models to load, with their placement and motion
+    Utils::Measure measure;
+    SceneManifest manifest(aManifestFilename);
+    const SceneManifest::EntryList& entries = manifest.getEntries();
+    // The Meshes of the occluders are kept in CPU memory, to be rasterized by the software occlusion culling
+    const bool bOcclusionCpu = (0 < mOcclusionCpuWidth);
+
+    // Import concurrently all the models, and wait for them, so that startup is bounded by the slowest one
+    for (SceneManifest::EntryList::const_iterator iEntry = entries.begin(); iEntry != entries.end(); ++iEntry) {
+        if (false == iEntry->mbBackground) {
+            mAssetStreamer.request(iEntry->mFilename,
+                                   std::bind(&Renderer::addEntry, this, *iEntry, std::placeholders::_1),
+                                   ResourceManager::DEFAULT_IMPORT_FLAGS, iEntry->mbOccluder && bOcclusionCpu);
+        }
+    }
+    mAssetStreamer.finish();
+
+    // Then request the models to be streamed in the background, added to the Scene when ready
+    for (SceneManifest::EntryList::const_iterator iEntry = entries.begin(); iEntry != entries.end(); ++iEntry) {
+        if (iEntry->mbBackground) {
+            mAssetStreamer.request(iEntry->mFilename,
+                                   std::bind(&Renderer::addEntry, this, *iEntry, std::placeholders::_1),
+                                   ResourceManager::DEFAULT_IMPORT_FLAGS, iEntry->mbOccluder && bOcclusionCpu);
+        }
+    }
+
+    time_t diffUs = measure.diff();
+    mLog.notice() << "initScene(\"" << aManifestFilename << "\") " << entries.size() << " models, "
+                  << mAssetStreamer.getNbPending() << " in the background, loaded in " << diffUs/1000 << "ms";
 }
 
 /**
- * @brief Load of Mesh file and put it on a new Node
+ * @brief Add a new instance of a model of the scene manifest to the Scene hierarchy
  *
- * @param[in] apFilename    Name of the mesh file to load (must be supported by assimp)
- *
- * @return A pointer to the new Node, or throw a std::exception if none loaded
+ * @param[in] aEntry    Description of the model in the scene manifest (placement and motion)
+ * @param[in] aNodePtr  New instance of the model
  */
-Node::Ptr Renderer::loadFile(const char* apFilename) {
-    Node::Ptr           NodePtr;
-    Utils::Measure      measure;
-    Assimp::Importer    importer;
-    mLog.notice() << "loadFile(" << apFilename << ")...";
-
-    // Read the mesh file
-    const aiScene* pScene = importer.ReadFile(apFilename, aiProcessPreset_TargetRealtime_Fast);
-    if ( (nullptr != pScene) && (0 == (pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE)) ) {
-        mLog.info() << "Meshes: " << pScene->mNumMeshes;
-
-        aiNode* pNode = pScene->mRootNode;
-        // Load recursively all the nodes
-        NodePtr = loadNode(pScene, pNode);
-    }  else {
-        mLog.critic() << "loadFile(" << apFilename << ") failed '" << importer.GetErrorString() << "'";
-        UTILS_THROW("loadFile(" << apFilename << ") failed '" << importer.GetErrorString() << "'");
+void Renderer::addEntry(const SceneManifest::Entry& aEntry, const Node::Ptr& aNodePtr) {
+    if (aEntry.mbMaskOnly && (false == mCockpitMask.isEnabled())) {
+        // An authored mask Mesh is never shaded
+        mLog.info() << "addEntry: '" << aEntry.mName << "' is only a cockpit mask, not added without --cockpit-mask";
+        return;
     }
-    time_t diffUs = measure.diff();
-    mLog.notice() << "loadFile(" << apFilename << ") done in " << diffUs/1000000 << "." << diffUs/1000 << "s";
+    aEntry.mPlacement.apply(*aNodePtr);
+    const Node::List& children = aNodePtr->getChildren();
+    for (size_t idxChild = 0; idxChild < aEntry.mChildPlacements.size(); ++idxChild) {
+        const SceneManifest::ChildPlacement& childPlacement = aEntry.mChildPlacements[idxChild];
+        if (childPlacement.mIndex < children.size()) {
+            childPlacement.mPlacement.apply(*children[childPlacement.mIndex]);
+        } else {
+            mLog.warning() << "addEntry: '" << aEntry.mName << "' has no child " << childPlacement.mIndex;
+        }
+    }
+    // (an occluder is only rasterized if its data has been retained, see initScene())
+    unsigned int flags = 0;
+    if (aEntry.mbOccluder && (0 < mOcclusionCpuWidth)) {
+        flags |= RetainedDrawList::eOccluder;
+    }
+    if (mCockpitMask.isEnabled()) {
+        flags |= (aEntry.mbMask ? RetainedDrawList::eMask : 0) | (aEntry.mbMaskOnly ? RetainedDrawList::eMaskOnly : 0);
+    }
+    mSceneHierarchy.addRootNode(aNodePtr, flags);
 
-    return NodePtr;
+    if (aEntry.mbControlled) {
+        // The model (and its first child, if any) can be moved with the keyboard
+        mModelPtr  = aNodePtr;
+        mTurretPtr = children.empty() ? aNodePtr : children.front();
+    }
+    mLog.info() << "addEntry: '" << aEntry.mName << "' added to the scene";
 }
 
 /**
- * @brief Load recursively a node and its Meshes and put it on a new Node
+ * @brief  Initialize a procedurally generated stress scene
  *
- * @param[in] apScene   Pointer to the Assimp Scene
- * @param[in] apNode    Pointer to the Assimp Node
+ *  The model file is imported and converted only once, and each instance is a clone sharing the same Meshes.
  *
- * @return A pointer to the new Node, or throw a std::exception if none loaded
+ * @param[in] aOptions  Command line options (model to instantiate and configuration of the generated scene)
  */
-Node::Ptr Renderer::loadNode(const aiScene* apScene, const aiNode* apNode) {
-    Node::Ptr NodePtr;
-    assert(nullptr != apNode);
-
-    // If the Node has at least one Mesh or more than one Child
-    /// @todo Loading Cameras and Lights
-    if ( (1 <= apNode->mNumMeshes) || (2 < apNode->mNumChildren) ) {
-        NodePtr.reset(new Node(apNode->mName.C_Str()));
-        mLog.info() << "Node '" << apNode->mName.C_Str() << "'";
-
-        // Decompose the Node traformation matrix with no scaling into its original components
-        aiQuaternion rotation;
-        aiVector3D position;
-        apNode->mTransformation.DecomposeNoScaling(rotation, position);
-        NodePtr->setOrientationQuaternion(rotation.w, rotation.x, rotation.y, rotation.z);
-        NodePtr->setTranslationVector(position.x, position.y, position.z);
-
-        // Load all meshes of the current Node
-        for (unsigned int iMesh = 0; iMesh < apNode->mNumMeshes; ++iMesh) {
-            unsigned int idxMesh = apNode->mMeshes[iMesh];
-            aiMesh* pMesh = apScene->mMeshes[idxMesh];
-            assert(nullptr != pMesh);
-            const size_t nbSet = 1 + (pMesh->HasNormals()?1:0) + (pMesh->HasVertexColors(0)?1:0);
-            const size_t nbOfData = pMesh->mNumVertices * nbSet;
-            std::vector<glm::vec3> vertexData;
-            vertexData.reserve(nbOfData);
-
-            mLog.info() << " Mesh '" << pMesh->mName.C_Str() << "'";
-            mLog.info() << "  Vertices: " << pMesh->mNumVertices;
-            mLog.info() << "  Colors: "   << (pMesh->HasVertexColors(0)?"true":"false");
-            mLog.info() << "  Normals: "  << (pMesh->HasNormals()?"true":"false");
-            for (unsigned int iVertex = 0; iVertex < pMesh->mNumVertices; ++iVertex) {
-                // mLog.info() << "   Vertex: " << pMesh->mVertices[iVertex].x
-                //             << ", " << pMesh->mVertices[iVertex].y << ", " << pMesh->mVertices[iVertex].z;
-                vertexData.push_back(glm::vec3(pMesh->mVertices[iVertex].x,
-                                                pMesh->mVertices[iVertex].y,
-                                                pMesh->mVertices[iVertex].z));
-                if (pMesh->HasVertexColors(0)) {
-                    // mLog.info() << "   Colors: " << pMesh->mColors[0][iVertex].r
-                    //             << ", " << pMesh->mColors[0][iVertex].g << ", " << pMesh->mColors[0][iVertex].b;
-                    vertexData.push_back(glm::vec3(pMesh->mColors[0][iVertex].r,
-                                                    pMesh->mColors[0][iVertex].g,
-                                                    pMesh->mColors[0][iVertex].b));
-                } else {
-                    // NOTE if no colors, use pure white
-                    vertexData.push_back(glm::vec3(1.0f, 1.0f, 1.0f));
-                }
-                if (pMesh->HasNormals()) {
-                    // mLog.info() << "   Normal: " << pMesh->mNormals[iVertex].x
-                    //             << ", " << pMesh->mNormals[iVertex].y << ", " << pMesh->mNormals[iVertex].z;
-                    vertexData.push_back(glm::vec3(pMesh->mNormals[iVertex].x,
-                                                    pMesh->mNormals[iVertex].y,
-                                                    pMesh->mNormals[iVertex].z));
-                } else {
-                    // NOTE if no normals, we cannot render properly, but we can still see something
-                    vertexData.push_back(glm::vec3(1.0f, 0.0f, 0.0f));
-                }
-            }
+void Renderer::initGeneratedScene(const Options& aOptions) {
+    Utils::Measure          measure;
+    SceneGenerator::Factory factory;
+    Node::Ptr               TemplatePtr;
+
+    mLog.notice() << "initGeneratedScene(\"" << aOptions.mSceneModel << "\") instances="
+                  << aOptions.mSceneConfig.mNbInstances << " depth=" << aOptions.mSceneConfig.mDepth
+                  << " fanout=" << aOptions.mSceneConfig.mFanOut << " moving=" << aOptions.mSceneConfig.mMovingRatio;
+
+    if (false == aOptions.mSceneModel.empty()) {
+        // Load the model once, then clone it for each instance (without looking up the resource each time)
+        TemplatePtr = mResourceManager.instantiate(aOptions.mSceneModel);
+        factory = std::bind(&Node::clone, TemplatePtr.get());
+    }
 
-            // If only triangles :
-            const size_t nbOfIndex = pMesh->mNumFaces * 3;
-            if (65536 < nbOfIndex) {
-                /// @todo if there is more than 64k indices, switch to GL_UNSIGNED_INT !
-                mLog.critic() << "loadNode: too many indices for SHORT (" << nbOfIndex << " > " << 65536 << ")";
-                UTILS_THROW("loadNode: too many indices for SHORT (" << nbOfIndex << " > " << 65536 << ")");
-            }
-            std::vector<GLshort> vertexIndex;
-            vertexIndex.reserve(nbOfIndex);
-
-            mLog.info() << " Faces: " << pMesh->mNumFaces;
-            for (unsigned int iFace = 0; iFace < pMesh->mNumFaces; ++iFace) {
-                aiFace& face = pMesh->mFaces[iFace];
-                // mLog.info() << "  Indices: " << face.mNumIndices;
-                assert(3 == face.mNumIndices);
-                for (unsigned int iIndice = 0; iIndice < face.mNumIndices; ++iIndice) {
-                    // mLog.info() << "   - " << face.mIndices[iIndice];
-                    vertexIndex.push_back(static_cast<GLshort>(face.mIndices[iIndice]));
-                }
-            }
+    SceneGenerator generator(aOptions.mSceneConfig);
+    const unsigned int nbNodes = generator.generate(mSceneHierarchy, factory);
 
-            /// @todo The following API is not good => short<->int
-            // Generate a Mesh objet to draw the imported model
-            Mesh::Ptr MeshPtr(new Mesh(pMesh->mName.C_Str(), GL_TRIANGLES, vertexIndex.size(), GL_UNSIGNED_SHORT, 0));
-            // Generate a VBO/VBI & VAO in GPU memory with those data
-            MeshPtr->genOpenGlObjects(vertexData, vertexIndex, mPositionAttrib, mColorAttrib, mNormalAttrib);
-            // here vertexData and vertexIndex are of no more use, std::vector memory will be deallocated
-            // here pScene is of no more use, Assimp::Importer will release it
+    // The first instance (and its first child, if any) can be moved with the keyboard
+    if (false == mSceneHierarchy.getRootNodes().empty()) {
+        mModelPtr = mSceneHierarchy.getRootNodes().front();
+        mTurretPtr = mModelPtr->getChildren().empty() ? mModelPtr : mModelPtr->getChildren().front();
+    }
 
-            NodePtr->addMesh(std::move(MeshPtr));
-        }
+    // Load a ground/plane for some kind of fixe reference (in the background, added to the Scene when ready)
+    const AssetStreamer::Callback addToScene = std::bind(&Scene::addRootNode, &mSceneHierarchy, std::placeholders::_1,
+                                                         0U);
+    mAssetStreamer.request("data/plane.dae", addToScene);
 
-        // Load all children of the current Node recursively
-        mLog.info() << " Children: " << apNode->mNumChildren;
-        for (unsigned int iChild = 0; iChild < apNode->mNumChildren; ++iChild) {
-            const aiNode* pChildNode = apNode->mChildren[iChild];
-            // Load a child Node...
-            Node::Ptr ChildNodePtr = loadNode(apScene, pChildNode);
-            if (ChildNodePtr) {
-                // and add it to the current Node (if not empty)
-                NodePtr->addChildNode(ChildNodePtr);
-            }
-        }
-    } else if (1 == apNode->mNumChildren) {
-        // No Mesh and only one child: skip this Node of the hierarchy! (ex. Root Scene Node)
-        /// @todo Accumulate matrix transformation not to loose relative positionning if any
-        mLog.debug() << "Skipped Node '" << apNode->mName.C_Str() << "'";
-        const aiNode* pChildNode = apNode->mChildren[0];
-        NodePtr = loadNode(apScene, pChildNode);
-    }
-    return NodePtr;
+    time_t diffUs = measure.diff();
+    mLog.notice() << "initGeneratedScene: " << nbNodes << " Nodes generated in " << diffUs/1000 << "ms";
 }
 
 /**
@@ -420,28 +466,244 @@ glm::mat4 Renderer::getWorldToCameraMatrix(int aIdxEye) {
  * @param[in] aTranslation  3D Translation vector to add to the given camera position
  */
 void Renderer::modelMove(const glm::vec3& aTranslation) {
-    mModelPtr->move(aTranslation);
+    if (mModelPtr) {
+        mModelPtr->move(aTranslation);
+    }
 }
 
 /**
  * @brief Pitch, rotate the model vertically around its current relative horizontal X axis
  */
 void Renderer::modelPitch(float aAngle) {
-    mTurretPtr->pitch(aAngle);
+    if (mTurretPtr) {
+        mTurretPtr->pitch(aAngle);
+    }
 }
 
 /**
  * @brief Yaw, rotate the model horizontally around its current relative vertical Y axis
  */
 void Renderer::modelYaw(float aAngle) {
-    mTurretPtr->yaw(aAngle);
+    if (mTurretPtr) {
+        mTurretPtr->yaw(aAngle);
+    }
 }
 
 /**
  * @brief Roll, rotate the model around its current relative viewing Z axis
  */
 void Renderer::modelRoll(float aAngle) {
-    mTurretPtr->roll(aAngle);
+    if (mTurretPtr) {
+        mTurretPtr->roll(aAngle);
+    }
+}
+
+/**
+ * @brief Sort the draw calls front-to-back, by the view depth of the center of their bounding sphere
+ *
+ *  Nearer surfaces drawn first hide the farther ones, whose fragments are then rejected by the early depth test
+ * instead of being shaded. Since the draws of a same Mesh are then grouped into one instanced draw call
+ * (see batch()), the batches are ordered by their nearest instance, and their instances front-to-back.
+ *
+ * @param[in,out] aDrawList Draw calls collected from the Scene hierarchy, sorted front-to-back on return
+ */
+void Renderer::sortFrontToBack(DrawList& aDrawList) {
+    // Sort the keys (view depth and index) instead of the draw calls themselves, then gather them
+    mSortKeys.resize(aDrawList.size());
+    for (size_t idxItem = 0; idxItem < aDrawList.size(); ++idxItem) {
+        const DrawItem& item = aDrawList[idxItem];
+        const glm::vec4 center = item.mModelToCameraMatrix * glm::vec4(item.mpMesh->getBoundingCenter(), 1.0f);
+        // The camera looks toward -Z: the view depth is the opposite of the Z coordinate
+        mSortKeys[idxItem] = std::make_pair(-center.z, idxItem);
+    }
+    std::sort(mSortKeys.begin(), mSortKeys.end());
+
+    mSortedDrawList.resize(aDrawList.size());
+    for (size_t idxItem = 0; idxItem < aDrawList.size(); ++idxItem) {
+        mSortedDrawList[idxItem] = aDrawList[mSortKeys[idxItem].second];
+    }
+    aDrawList.swap(mSortedDrawList);
+}
+
+/**
+ * @brief Group the draw calls of a same Mesh, writing their matrices contiguously into the matrix ring
+ *
+ *  Instances of a same Mesh drawn at different levels of detail go into different batches.
+ * Impostors of all Meshes go into a single batch, or while their views are not yet rendered,
+ * are drawn at the coarsest level of detail of their Mesh.
+ *
+ *  Linear in the number of draw calls: a first pass counts the instances of each Mesh,
+ * then one allocation is made per batch, and a second pass scatters the matrices into the batches.
+ *
+ * @param[in]  aDrawList        Draw calls collected from the Scene hierarchy
+ * @param[out] aDrawBatches     Instanced draw calls, in the order of the first occurrence of each Mesh
+ * @param[out] apImpostorBatch  Instanced draw call of the impostors, or nullptr to draw every Mesh at the level
+ *                              of detail of its draw call, without any impostor (like the cockpit mask)
+ */
+void Renderer::batch(const DrawList& aDrawList, DrawBatchList& aDrawBatches,
+                     ImpostorBatch* apImpostorBatch /* = nullptr */) {
+    ImpostorBatch noImpostorBatch;
+    ImpostorBatch& impostorBatch = (nullptr != apImpostorBatch) ? *apImpostorBatch : noImpostorBatch;
+    aDrawBatches.clear();
+    impostorBatch.mInstanceOffset = 0;
+    impostorBatch.mNbInstances = 0;
+    mBatchIndexes.clear();
+    mItemBatches.resize(aDrawList.size());
+    mItemSlots.resize(aDrawList.size());
+
+    // Count the instances of each Mesh level of detail, and the impostors
+    for (size_t idxItem = 0; idxItem < aDrawList.size(); ++idxItem) {
+        const Mesh* pMesh = aDrawList[idxItem].mpMesh;
+        unsigned int lod = aDrawList[idxItem].mLod;
+        mItemSlots[idxItem] = -1;
+        if ((nullptr != apImpostorBatch) && (LodSelector::IMPOSTOR == lod)) {
+            mItemSlots[idxItem] = mImpostorAtlas.request(*pMesh);
+            if (-1 != mItemSlots[idxItem]) {
+                ++impostorBatch.mNbInstances;
+                mRenderStats.incr(RenderStats::eLodSavedTriangles, pMesh->getNbTriangles(0) - 2);
+                continue;
+            }
+            // Views not yet rendered: draw the coarsest level of detail meanwhile
+            lod = pMesh->getNbLods() - 1;
+            mRenderStats.incr(RenderStats::eLodSavedTriangles, pMesh->getNbTriangles(0) - pMesh->getNbTriangles(lod));
+        }
+        const DrawBatchKey key(pMesh, lod);
+        size_t idxBatch;
+        if (0 != aDrawList[idxItem].mQuery) {
+            // A draw under a conditional render cannot be grouped with the other instances of its Mesh
+            idxBatch = aDrawBatches.size();
+            const DrawBatch newBatch = {key.first, key.second, 0, 0, aDrawList[idxItem].mQuery};
+            aDrawBatches.push_back(newBatch);
+        } else {
+            BatchIndexMap::const_iterator iBatchIndex = mBatchIndexes.find(key);
+            if (mBatchIndexes.end() != iBatchIndex) {
+                idxBatch = iBatchIndex->second;
+            } else {
+                idxBatch = aDrawBatches.size();
+                mBatchIndexes[key] = idxBatch;
+                const DrawBatch newBatch = {key.first, key.second, 0, 0, 0};
+                aDrawBatches.push_back(newBatch);
+            }
+        }
+        ++aDrawBatches[idxBatch].mNbInstances;
+        mItemBatches[idxItem] = idxBatch;
+    }
+
+    // Allocate the contiguous matrices of each batch
+    mBatchWrites.resize(aDrawBatches.size());
+    for (size_t idxBatch = 0; idxBatch < aDrawBatches.size(); ++idxBatch) {
+        DrawBatch& drawBatch = aDrawBatches[idxBatch];
+        mBatchWrites[idxBatch] = static_cast<char*>(mMatrixRing.allocate(drawBatch.mNbInstances * sizeof(glm::mat4),
+                                                                         drawBatch.mMatrixOffset));
+        if (nullptr == mBatchWrites[idxBatch]) {
+            // The ring is full: skip this batch for this frame only, the ring will grow for the next one
+            drawBatch.mNbInstances = 0;
+        }
+    }
+    char* pImpostorWrite = nullptr;
+    if (0 < impostorBatch.mNbInstances) {
+        pImpostorWrite = static_cast<char*>(mMatrixRing.allocate(impostorBatch.mNbInstances * sizeof(glm::mat4),
+                                                                 impostorBatch.mInstanceOffset));
+        if (nullptr == pImpostorWrite) {
+            impostorBatch.mNbInstances = 0;
+        }
+    }
+
+    // Scatter the matrices into their batch, and the data of the impostors
+    for (size_t idxItem = 0; idxItem < aDrawList.size(); ++idxItem) {
+        const DrawItem& item = aDrawList[idxItem];
+        if (-1 != mItemSlots[idxItem]) {
+            if (nullptr != pImpostorWrite) {
+                glm::mat4 instance;
+                mImpostorAtlas.getInstance(*item.mpMesh, mItemSlots[idxItem], item.mModelToCameraMatrix, instance);
+                memcpy(pImpostorWrite, glm::value_ptr(instance), sizeof(glm::mat4));
+                pImpostorWrite += sizeof(glm::mat4);
+            }
+        } else {
+            char*& pWrite = mBatchWrites[mItemBatches[idxItem]];
+            if (nullptr != pWrite) {
+                memcpy(pWrite, glm::value_ptr(item.mModelToCameraMatrix), sizeof(glm::mat4));
+                pWrite += sizeof(glm::mat4);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Emit the instanced draw calls of an eye, with the program in use
+ *
+ * @param[in] aDrawBatches  Instanced draw calls of the eye
+ * @param[in] aMatrixAttrib Location of the "modelToCameraMatrix" per-instance vertex shader attribute
+ * @param[in] abDepthOnly   Read only the positions of the Meshes (depth pre-pass)
+ */
+void Renderer::draw(const DrawBatchList& aDrawBatches, GLuint aMatrixAttrib, bool abDepthOnly) {
+    for (DrawBatchList::const_iterator iBatch = aDrawBatches.begin(); iBatch != aDrawBatches.end(); ++iBatch) {
+        if (0 < iBatch->mNbInstances) {
+            // The GPU skips the draw call if the bounding box of the Node was occluded (see OcclusionCuller),
+            // unless already under the conditional render of the cockpit mask (which cannot be nested)
+            const bool bConditional = (0 != iBatch->mQuery) && (false == mCockpitMask.isConditional());
+            if (bConditional) {
+                glBeginConditionalRender(iBatch->mQuery, GL_QUERY_WAIT);
+            }
+            iBatch->mpMesh->draw(aMatrixAttrib, mMatrixRing.getBuffer(), iBatch->mMatrixOffset,
+                                 iBatch->mNbInstances, iBatch->mLod, mRenderStats, abDepthOnly);
+            if (bConditional) {
+                glEndConditionalRender();
+            }
+        }
+    }
+}
+
+/**
+ * @brief Set the viewport of an eye: the left or right half of the window
+ *
+ * @param[in] aIdxEye   Index of the eye (0 for left, 1 for right)
+ */
+void Renderer::setEyeViewport(int aIdxEye) {
+    /// @todo Use a config class for each eye
+    if (0 == aIdxEye) {
+        // Left eye rendering :
+        StateCache::viewport(0, 0, (GLsizei)(mScreenWidth/2), (GLsizei)mScreenHeight);
+    } else {
+        // Right eye rendering :
+        StateCache::viewport((GLsizei)(mScreenWidth/2), 0, (GLsizei)(mScreenWidth/2), (GLsizei)mScreenHeight);
+    }
+}
+
+/**
+ * @brief Issue the occlusion queries requested for the frame, drawing bounding boxes against the depth buffer
+ *
+ *  Each query spans the bounding box of its Node drawn into both eyes, so that the visibility is decided
+ * once for both. The boxes are drawn by the depth only program, without any color nor depth write.
+ *
+ * @param[in] aBoxOffset    Offset in bytes of the "Box to Camera" matrices of the queries in the matrix ring
+ * @param[in] aMatrixAttrib Location of the "modelToCameraMatrix" per-instance vertex shader attribute
+ */
+void Renderer::queryOcclusion(size_t aBoxOffset, GLuint aMatrixAttrib) {
+    const size_t nbQueries = mOcclusionCuller.getNbRequests();
+    if (0 < nbQueries) {
+        if (StateCache::useProgram(mDepthProgram)) {
+            mRenderStats.incr(RenderStats::eProgramBinds);
+        }
+        StateCache::colorMask(false);
+        StateCache::depthMask(false);
+
+        const Mesh& box = mOcclusionCuller.getBox();
+        for (size_t idxQuery = 0; idxQuery < nbQueries; ++idxQuery) {
+            mOcclusionCuller.beginQuery(idxQuery);
+            for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+                const size_t matrixOffset = aBoxOffset + (2 * idxQuery + idxEye) * sizeof(glm::mat4);
+                setEyeViewport(idxEye);
+                box.draw(aMatrixAttrib, mMatrixRing.getBuffer(), matrixOffset, 1, 0, mRenderStats, true);
+            }
+            mOcclusionCuller.endQuery(idxQuery);
+        }
+        mRenderStats.incr(RenderStats::eOcclusionQueries, static_cast<unsigned int>(nbQueries));
+        mOcclusionCuller.clearRequests();
+
+        StateCache::colorMask(true);
+        StateCache::depthMask(true);
+    }
 }
 
 /**
@@ -458,12 +720,30 @@ void Renderer::reshape(int aW, int aH) {
     mScreenHeight = aH;
 
     // Define the "Camera to Clip" matrix for the perspective transformation
-    glm::mat4 cameraToClipMatrix = glm::perspective<float>(45.0f, ((aW/2) / static_cast<float>(aH)), _zNear, _zFar);
+    mCameraToClipMatrix = glm::perspective<float>(45.0f, ((aW/2) / static_cast<float>(aH)), _zNear, _zFar);
+    // The vertical scale of the projection is 1/tan(fovy/2): it maps one unit at a distance of one unit to NDC
+    mLodSelector.setPixelsPerUnit(mCameraToClipMatrix[1][1] * aH / 2.0f);
+    mImpostorAtlas.setCameraToClipMatrix(mCameraToClipMatrix);
+    // The depth buffers of the software occlusion have the aspect ratio of the viewport of an eye
+    if (0 < mOcclusionCpuWidth) {
+        mSoftwareOcclusion.setResolution(mOcclusionCpuWidth, mOcclusionCpuWidth * aH / std::max(aW / 2, 1));
+        mLog.info() << "reshape: software occlusion " << mSoftwareOcclusion.getWidth() << "x"
+                    << mSoftwareOcclusion.getHeight() << " per eye";
+    }
 
     // Set uniform values with the new "Camera to Clip" matrix
-    glUseProgram(mProgram);
-    glUniformMatrix4fv(mCameraToClipMatrixUnif, 1, GL_FALSE, glm::value_ptr(cameraToClipMatrix));
-    glUseProgram(0);
+    StateCache::useProgram(mProgram);
+    mMeshInterface.setUniform(eCameraToClipMatrixUnif, mCameraToClipMatrix);
+    if (0 != mDepthProgram) {
+        StateCache::useProgram(mDepthProgram);
+        mDepthInterface.setUniform(eCameraToClipMatrixUnif, mCameraToClipMatrix);
+    }
+
+    // The overdraw is the number of samples shaded divided by the number of samples of the window
+    GLint nbSamples = 0;
+    glGetIntegerv(GL_SAMPLES, &nbSamples);
+    mOverdrawMeter.setNbPixels(static_cast<unsigned int>(aW * aH * std::max(nbSamples, 1)));
+    mCockpitMask.setNbSamples(static_cast<unsigned int>((aW / 2) * aH * std::max(nbSamples, 1)));
 }
 
 /**
@@ -471,44 +751,266 @@ void Renderer::reshape(int aW, int aH) {
  */
 void Renderer::display() {
     // mLog.debug() << "displayCallback()";
+    // Wait for the GPU to release the resources of the frame previously rendered in the same slot
+    mFramePacer.beginFrame();
+    mRenderStats.beginFrame();
+    mGpuTimer.begin();
+
+    // 0) Upload the Meshes of the models loaded in the background, under a per-frame budget
+    mAssetStreamer.update(mUploadBudgetBytes, mUploadBudgetUs);
+    // and switch to the required permutation of the program of the Meshes once compiled in the background
+    mMeshPrograms.update();
+    if ((false == mShaderDefines.empty()) && (mMeshPrograms.getBase() == mProgram)) {
+        const GLuint program = mMeshPrograms.get(mShaderDefines);
+        if (program != mProgram) {
+            mLog.notice() << "display: switching to the required permutation of the program";
+            setProgram(program);
+        }
+    }
+    if ((0 != mDepthProgram) && (mMeshPrograms.getBase() == mDepthProgram)) {
+        const GLuint program = mMeshPrograms.get(mDepthDefines);
+        if (program != mDepthProgram) {
+            mLog.notice() << "display: switching to the depth only permutation of the program";
+            setDepthProgram(program);
+        }
+    }
+
+    // 1) Upload phase: collect the draw calls of each eye, and write their matrices into the ring grouped by Mesh
+    mSceneHierarchy.update();
+    // and bake the Meshes of the Nodes which never move, when new ones have been added (or some moved)
+    const size_t nbBaked = mSceneHierarchy.bake(mBakeUploader);
+    if (0 < nbBaked) {
+        mLog.info() << "display: " << nbBaked << " static Meshes baked";
+    }
+    ////////////////////////////////////////////////////////////////////////////////////////
+    /// @todo This camera related calculation need to go into a Camera class into the Scene
+    // re-calculate the "World to Camera" matrix of each eye
+    glm::mat4 worldToCameraMatrices[2];
+    worldToCameraMatrices[0] = getWorldToCameraMatrix(0);
+    worldToCameraMatrices[1] = getWorldToCameraMatrix(1);
+    ////////////////////////////////////////////////////////////////////////////////////////
+    // and decide the visibility of the Nodes once for both eyes, behind the occluders rasterized on the CPU,
+    // and from the results of the previous occlusion queries
+    mRenderStats.setEye(-1);
+    if (mSoftwareOcclusion.isEnabled()) {
+        const glm::mat4 worldToClipMatrices[2] = {
+            mCameraToClipMatrix * worldToCameraMatrices[0],
+            mCameraToClipMatrix * worldToCameraMatrices[1]
+        };
+        mSoftwareOcclusion.begin(worldToClipMatrices);
+    }
+    if (mOcclusionCuller.isEnabled()) {
+        mOcclusionCuller.update();
+    }
+    if (mSoftwareOcclusion.isEnabled() || mOcclusionCuller.isEnabled()) {
+        mSceneHierarchy.cull(worldToCameraMatrices, _zNear, mOcclusionCuller, mSoftwareOcclusion, mRenderStats);
+    }
+    if (mSoftwareOcclusion.isEnabled()) {
+        mSoftwareOcclusion.end();
+    }
+    mMatrixRing.beginFrame(mFramePacer.getFrameSlot());
+    for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+        mRenderStats.setEye(idxEye);
+        mLodSelector.setEye(idxEye);
+
+        // One linear loop over the draws retained by the scene, multiplying their world matrices
+        mDrawLists[idxEye].clear();
+        mSceneHierarchy.collect(worldToCameraMatrices[idxEye], mLodSelector, mDrawLists[idxEye], mRenderStats);
+        if (Options::eDepthNone != mDepthMode) {
+            sortFrontToBack(mDrawLists[idxEye]);
+        }
+        batch(mDrawLists[idxEye], mDrawBatches[idxEye], &mImpostorBatches[idxEye]);
+
+        // and the draw calls of the cockpit mask apart, at full resolution
+        if (mCockpitMask.isEnabled()) {
+            mMaskDrawLists[idxEye].clear();
+            mMaskOnlyDrawLists[idxEye].clear();
+            mSceneHierarchy.collectMask(worldToCameraMatrices[idxEye], mMaskDrawLists[idxEye],
+                                        mMaskOnlyDrawLists[idxEye]);
+            batch(mMaskDrawLists[idxEye], mMaskBatches[idxEye]);
+            batch(mMaskOnlyDrawLists[idxEye], mMaskOnlyBatches[idxEye]);
+        }
+    }
+    // and the "Box to Camera" matrices of the bounding boxes of the occlusion queries requested, for each eye
+    size_t boxOffset = 0;
+    const size_t nbQueries = mOcclusionCuller.getNbRequests();
+    if (0 < nbQueries) {
+        char* pWrite = static_cast<char*>(mMatrixRing.allocate(2 * nbQueries * sizeof(glm::mat4), boxOffset));
+        if (nullptr != pWrite) {
+            for (size_t idxQuery = 0; idxQuery < nbQueries; ++idxQuery) {
+                for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+                    const glm::mat4 boxToCamera = worldToCameraMatrices[idxEye]
+                                                * mOcclusionCuller.getRequestMatrix(idxQuery);
+                    memcpy(pWrite, glm::value_ptr(boxToCamera), sizeof(glm::mat4));
+                    pWrite += sizeof(glm::mat4);
+                }
+            }
+        } else {
+            // The ring is full: the queries are requested again by the next frame
+            mOcclusionCuller.clearRequests();
+        }
+    }
+    // and the "Hidden Area to Camera" matrix of the hidden area of the lenses (the same for both eyes)
+    size_t hiddenOffset = 0;
+    bool bHidden = false;
+    if (mHiddenArea.isEnabled()) {
+        void* pWrite = mMatrixRing.allocate(sizeof(glm::mat4), hiddenOffset);
+        if (nullptr != pWrite) {
+            const glm::mat4 hiddenToCamera = HiddenArea::getMatrix(mCameraToClipMatrix, _zNear);
+            memcpy(pWrite, glm::value_ptr(hiddenToCamera), sizeof(glm::mat4));
+            bHidden = true;
+        }
+    }
+    // and the "Quad to Camera" matrix of the quad testing the coverage of the cockpit mask (the same for both eyes)
+    size_t quadOffset = 0;
+    bool bMask = false;
+    if (mCockpitMask.isEnabled()) {
+        void* pWrite = mMatrixRing.allocate(sizeof(glm::mat4), quadOffset);
+        if (nullptr != pWrite) {
+            const glm::mat4 quadToCamera = CockpitMask::getQuadMatrix(mCameraToClipMatrix);
+            memcpy(pWrite, glm::value_ptr(quadToCamera), sizeof(glm::mat4));
+            bMask = true;
+        }
+        // (else the ring is full: the world is drawn without the mask for this frame only)
+    }
+    mMatrixRing.endFrame();
+
+    // 2) Render the views of the impostors requested by the batching, under a per-frame budget
+    mRenderStats.setEye(-1);
+    const GLuint matrixAttrib = mMeshInterface.getAttribLocation(eMatrixAttrib);
+    mImpostorAtlas.update(matrixAttrib, mRenderStats);
 
+    // 3) Draw phase
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
     glClearDepth(1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClearStencil(0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | (bMask ? GL_STENCIL_BUFFER_BIT : 0));
+
+    // Opaque Meshes, unless visualizing the overdraw (the atlas of impostors disables the blending)
+    StateCache::enable(GL_BLEND, mbOverdraw);
+
+    // Hidden area of the lenses and cockpit mask: lay down their depth (and 1 into the stencil for the mask)
+    // at the start of each eye, without any color
+    if (bHidden || bMask) {
+        if (StateCache::useProgram(mDepthProgram)) {
+            mRenderStats.incr(RenderStats::eProgramBinds);
+        }
+        for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+            mRenderStats.setEye(idxEye);
+            setEyeViewport(idxEye);
+            if (bMask) {
+                mCockpitMask.beginMask();
+            } else {
+                StateCache::colorMask(false);
+            }
+            if (bHidden) {
+                // the hidden area is the nearest: nothing behind it passes the early depth test
+                mHiddenArea.getMesh(idxEye).draw(matrixAttrib, mMatrixRing.getBuffer(), hiddenOffset, 1, 0,
+                                                 mRenderStats, true);
+            }
+            if (bMask) {
+                draw(mMaskBatches[idxEye], matrixAttrib, true);
+                // (an authored mask only Mesh does not hide the cockpit shaded behind it)
+                StateCache::depthMask(false);
+                draw(mMaskOnlyBatches[idxEye], matrixAttrib, true);
+                StateCache::depthMask(true);
+                // then count the samples left uncovered, to skip the world draws of an eye fully masked
+                mCockpitMask.endMask(idxEye, matrixAttrib, mMatrixRing.getBuffer(), quadOffset, mRenderStats);
+            } else {
+                StateCache::colorMask(true);
+            }
+        }
+    }
+
+    // Depth pre-pass: lay down the depth of the Meshes of both eyes, without any color nor lighting
+    if (Options::eDepthPrepass == mDepthMode) {
+        if (StateCache::useProgram(mDepthProgram)) {
+            mRenderStats.incr(RenderStats::eProgramBinds);
+        }
+        StateCache::colorMask(false);
+        for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+            mRenderStats.setEye(idxEye);
+            setEyeViewport(idxEye);
+            if (bMask) {
+                mCockpitMask.beginWorld(idxEye);
+            }
+            draw(mDrawBatches[idxEye], matrixAttrib, true);
+            if (bMask) {
+                mCockpitMask.endWorld();
+            }
+        }
+        StateCache::colorMask(true);
+    }
 
     // Use the linked program of compiled shaders
-    glUseProgram(mProgram);
+    if (StateCache::useProgram(mProgram)) {
+        mRenderStats.incr(RenderStats::eProgramBinds);
+    }
 
+    // Color pass: the samples shaded (passing the depth test) are counted to measure the overdraw
+    if (mbOverdraw) {
+        mOverdrawMeter.begin();
+    }
     // Stereo rendering
     for (int idxEye = 0; idxEye <= 1; ++idxEye) {
-        /// @todo Use a config class for each eye
-        if (0 == idxEye) {
-            // Left eye rendering :
-            glViewport(0, 0, (GLsizei)(mScreenWidth/2), (GLsizei)mScreenHeight);
-        } else {
-            // Right eye rendering :
-            glViewport((GLsizei)(mScreenWidth/2), 0, (GLsizei)(mScreenWidth/2), (GLsizei)mScreenHeight);
-        }
-
-        ////////////////////////////////////////////////////////////////////////////////////////
-        /// @todo This camera related calculation need to go into a Camera class into the Scene
-        // re-calculate the "World to Camera" matrix,
-        glm::mat4 worldToCamerMatrix = getWorldToCameraMatrix(idxEye);
+        mRenderStats.setEye(idxEye);
+        setEyeViewport(idxEye);
 
         // mDirToLight have to be recalculated with each camera orientation change
-        glm::vec4 lightDirCameraSpace = worldToCamerMatrix * mDirToLight;
-        glUniform3fv(mDirToLightUnif, 1, glm::value_ptr(lightDirCameraSpace));
+        glm::vec4 lightDirCameraSpace = worldToCameraMatrices[idxEye] * mDirToLight;
+        if (mMeshInterface.setUniform(eDirToLightUnif, glm::vec3(lightDirCameraSpace))) {
+            mRenderStats.incr(RenderStats::eUniformUploads);
+        }
 
-        // and initialize the "Model to Camera" matrix stack with it
-        MatrixStack modelToCameraMatrixStack(worldToCamerMatrix);
-        ////////////////////////////////////////////////////////////////////////////////////////
+        // Emit one instanced draw call per Mesh
+        if (Options::eDepthPrepass == mDepthMode) {
+            // after the pre-pass, shade only the nearest fragment of each sample, whose depth is already written
+            StateCache::depthMask(false);
+            StateCache::depthFunc(GL_EQUAL);
+        }
+        if (bMask) {
+            // The cockpit first, then the world outside of it
+            draw(mMaskBatches[idxEye], matrixAttrib, false);
+            mCockpitMask.beginWorld(idxEye);
+        }
+        draw(mDrawBatches[idxEye], matrixAttrib, false);
+        if (Options::eDepthPrepass == mDepthMode) {
+            // the impostors are not in the depth pre-pass
+            StateCache::depthMask(true);
+            StateCache::depthFunc(GL_LEQUAL);
+        }
 
-        // Use the matrix stack to manage the hierarchy of the scene
-        mSceneHierarchy.draw(modelToCameraMatrixStack, mModelToCameraMatrixUnif);
+        // Then all the impostors in one instanced draw call
+        const ImpostorBatch& impostorBatch = mImpostorBatches[idxEye];
+        if (0 < impostorBatch.mNbInstances) {
+            mImpostorAtlas.draw(glm::vec3(lightDirCameraSpace), mMatrixRing.getBuffer(), impostorBatch.mInstanceOffset,
+                                impostorBatch.mNbInstances, mRenderStats);
+            if (StateCache::useProgram(mProgram)) {
+                mRenderStats.incr(RenderStats::eProgramBinds);
+            }
+        }
+        if (bMask) {
+            mCockpitMask.endWorld();
+        }
+    }
+    if (mbOverdraw) {
+        mOverdrawMeter.end();
     }
+    if (bMask) {
+        mCockpitMask.endFrame();
+    }
+    mRenderStats.setEye(-1);
+
+    // Test the bounding boxes of the Nodes against the depth buffer of the frame, for the next frames
+    queryOcclusion(boxOffset, matrixAttrib);
 
-    // Unbind the Vertex Program
-    glUseProgram(0);
+    // The program and the Vertex Array Object are left bound, to be elided by the next frame
+    mRenderStats.incr(RenderStats::eStateCalls, StateCache::getNbIssued());
+    mRenderStats.incr(RenderStats::eStateElided, StateCache::getNbElided());
+    StateCache::resetCounters();
 
-    glFlush();
+    mGpuTimer.end();
+    // Insert the fence of the frame (instead of a glFlush(), the command stream is flushed by the next wait)
+    mFramePacer.endFrame();
+    mRenderStats.endFrame();
 }
@@ -14,15 +14,35 @@
 
 #include "Main/Scene.h"
 #include "Main/Node.h"
+#include "Main/Options.h"
+#include "Main/RenderStats.h"
+#include "Main/GpuTimer.h"
+#include "Main/OverdrawMeter.h"
+#include "Main/FramePacer.h"
+#include "Main/UploadRing.h"
+#include "Main/DrawList.h"
+#include "Main/LodSelector.h"
+#include "Main/ImpostorAtlas.h"
+#include "Main/OcclusionCuller.h"
+#include "Main/SoftwareOcclusion.h"
+#include "Main/CockpitMask.h"
+#include "Main/HiddenArea.h"
+#include "Main/OculusHMD.h"
+#include "Main/ResourceManager.h"
+#include "Main/ShaderPermutations.h"
+#include "Main/ProgramInterface.h"
+#include "Main/AssetStreamer.h"
+#include "Main/SceneManifest.h"
 #include "Utils/Utils.h"
 
 // NOTE: Needs to be included before any other gl/glfw/freeglut header
 #include <glload/gl_3_3.h>      // GLuint, GLenum, and OpenGL 3.3 core function APIs
 #include <glm/glm.hpp>          // glm::mat4, glm::vec3... (GLM_FORCE_RADIANS defined at the project level)
 
-#include <assimp/scene.h>       // Assimp output data structure
-
 #include <vector>
+#include <string>
+#include <utility>
+#include <unordered_map>
 
 namespace Utils {
     class FPS;
@@ -32,8 +52,28 @@ namespace Utils {
  * @brief Management of OpenGL drawing/rendering
  */
 class Renderer {
+    /// Index of the batch of each Mesh level of detail
+    typedef std::unordered_map<DrawBatchKey, size_t, DrawBatchKeyHash> BatchIndexMap;
+
+    /// Slots of the uniforms of the program of the Meshes (see ProgramInterface)
+    enum MeshUniform {
+        eCameraToClipMatrixUnif,    ///< "Camera to Clip" matrix, defining the perspective projection
+        eDirToLightUnif,            ///< Vector of directional light orientation, in camera space
+        eLightIntensityUnif,        ///< Directional light intensity and color
+        eAmbientIntensityUnif,      ///< Ambiant light intensity and color
+        eNbMeshUniforms
+    };
+    /// Slots of the vertex attributes (input streams) of the program of the Meshes (see ProgramInterface)
+    enum MeshAttrib {
+        ePositionAttrib,            ///< Vertex position
+        eColorAttrib,               ///< Vertex diffuse color
+        eNormalAttrib,              ///< Vertex normal
+        eMatrixAttrib,              ///< "Model to Camera" matrix of the instance
+        eNbMeshAttribs
+    };
+
 public:
-    Renderer();
+    explicit Renderer(const Options& aOptions);
     ~Renderer();
 
     // called by gflw through Input
@@ -43,9 +83,27 @@ public:
     // Calculate new position and orientation given current Node movements
     inline void move(float aDeltaTime);
 
+    // Skip the pixels never seen through the lenses of the HMD
+    void setHiddenArea(const OculusHMD::Distortion& aDistortion);
+
     // Increment/decrement the screen center offset
     inline void incrScreenCenterOffset(float aOffset);
 
+    // Statistics counters of the rendering
+    inline RenderStats& getRenderStats();
+    // GPU time of the rendering
+    inline GpuTimer& getGpuTimer();
+    // Pacing of the frames in flight
+    inline FramePacer& getFramePacer();
+    // Overdraw of the color pass
+    inline OverdrawMeter& getOverdrawMeter();
+    // Software occlusion culling (time spent per frame)
+    inline SoftwareOcclusion& getSoftwareOcclusion();
+    // Stencil mask of the cockpit (coverage)
+    inline CockpitMask& getCockpitMask();
+    // Models loaded once, shared by all their instances (purge)
+    inline ResourceManager& getResourceManager();
+
     // called by Input::checkKeys()
     // camera:
     void move(const glm::vec3& aTranslation);
@@ -58,12 +116,29 @@ public:
 
 private:
     // Initialization
-    void init();
+    void init(const Options& aOptions);
     void initProgram();
-    void initScene();
+    // Use a permutation of the program of the Meshes, introspecting its variables and setting their values
+    void setProgram(GLuint aProgram);
+    // Use the base program for the depth only passes, and request its depth only permutation
+    void initDepthProgram();
+    // Use a permutation of the program of the depth pre-pass, introspecting its variables and setting their values
+    void setDepthProgram(GLuint aProgram);
+    void initScene(const std::string& aManifestFilename);
+    void initGeneratedScene(const Options& aOptions);
+    // Add a new instance of a model of the scene manifest to the Scene hierarchy
+    void addEntry(const SceneManifest::Entry& aEntry, const Node::Ptr& aNodePtr);
 
-    Node::Ptr loadFile(const char* apFilename);
-    Node::Ptr loadNode(const aiScene* apScene, const aiNode* apNode);
+    // Sort the draw calls front-to-back, by the view depth of the center of their bounding sphere
+    void sortFrontToBack(DrawList& aDrawList);
+    // Group the draw calls of a same Mesh, writing their matrices contiguously into the matrix ring
+    void batch(const DrawList& aDrawList, DrawBatchList& aDrawBatches, ImpostorBatch* apImpostorBatch = nullptr);
+    // Set the viewport of an eye
+    void setEyeViewport(int aIdxEye);
+    // Emit the instanced draw calls of an eye
+    void draw(const DrawBatchList& aDrawBatches, GLuint aMatrixAttrib, bool abDepthOnly);
+    // Issue the occlusion queries requested for the frame, drawing bounding boxes against the depth buffer
+    void queryOcclusion(size_t aBoxOffset, GLuint aMatrixAttrib);
 
     /// @todo Generalize like the Node class (but Camera is the inverse of Model)
     glm::mat4 getWorldToCameraMatrix(int aIdxEye);
@@ -71,15 +146,16 @@ private:
 private:
     Log::Logger mLog;                   ///< Logger object to output runtime information
 
-    GLuint mProgram;                    ///< OpenGL program containing compiled and linked shaders
-    GLuint mPositionAttrib;             ///< Location of the "position" vertex shader attribute (input stream)
-    GLuint mColorAttrib;                ///< Location of the "diffuseColor" vertex shader attribute (input stream)
-    GLuint mNormalAttrib;               ///< Location of the "normal" vertex shader attribute (input stream)
-    GLuint mModelToCameraMatrixUnif;    ///< Location of the "modelToCameraMatrix" vertex shader uniform input variable
-    GLuint mCameraToClipMatrixUnif;     ///< Location of the "cameraToClipMatrix" vertex shader uniform input variable
-    GLuint mDirToLightUnif;             ///< Location of the "dirToLight" vertex shader uniform input variable
-    GLuint mLightIntensityUnif;         ///< Location of the "lightIntensity" vertex shader uniform input variable
-    GLuint mAmbientIntensityUnif;       ///< Location of the "ambientIntensity" vertex shader uniform input variable
+    ShaderPermutations  mMeshPrograms;  ///< Permutations of the program of the Meshes, compiled in the background
+    ShaderPermutations::Defines mShaderDefines; ///< Defines of the permutation of the program to use
+    GLuint mProgram;                    ///< OpenGL program in use (base permutation until the required one is ready)
+    ProgramInterface mMeshInterface;    ///< Slots of the uniforms and attributes of mProgram
+    Options::DepthMode mDepthMode;      ///< Control of the overdraw of the Meshes (sort, depth pre-pass)
+    ShaderPermutations::Defines mDepthDefines;  ///< Defines of the permutation of the program of the depth pre-pass
+    GLuint mDepthProgram;               ///< Program of the depth pre-pass (base permutation until the required one)
+    ProgramInterface mDepthInterface;   ///< Slots of the uniforms and attributes of mDepthProgram
+    bool mbOverdraw;                    ///< Visualize and measure the overdraw of the color pass
+    glm::mat4 mCameraToClipMatrix;      ///< "Camera to Clip" matrix, defining the perspective projection
 
     glm::fquat  mCameraOrientation;     ///< Quaternion of camera orientation
     glm::vec3   mCameraTranslation;     ///< Vector of translation of the camera
@@ -88,7 +164,12 @@ private:
     glm::vec4   mLightIntensity;        ///< Directional light intensity and color
     glm::vec4   mAmbientIntensity;      ///< Ambiant light intensity and color
 
+    ResourceManager mResourceManager;   ///< Models loaded once, shared by all their instances
+    AssetStreamer   mAssetStreamer;     ///< Background loading of models, delivered into the Scene when ready
+    size_t          mUploadBudgetBytes; ///< Maximum size of the Meshes uploaded to the GPU per frame, in bytes
+    time_t          mUploadBudgetUs;    ///< Maximum time spent uploading Meshes per frame, in microseconds
     Scene       mSceneHierarchy;        ///< Scene node hierarchy
+    RetainedDrawList::Uploader mBakeUploader;   ///< Upload of the static batches of the Scene (empty if disabled)
     Node::Ptr   mModelPtr;              ///< The loadble/movable model
     Node::Ptr   mTurretPtr;             ///< The turret sub-model
 
@@ -96,6 +177,33 @@ private:
     int         mScreenHeight;          ///< Screen height
     float       mScreenCenterOffset;    ///< Screen center offset for each eye, in meters
 
+    LodSelector mLodSelector;           ///< Selection of the level of detail of each Mesh instance, for each eye
+    ImpostorAtlas mImpostorAtlas;       ///< Views of the Meshes drawn as impostors
+    OcclusionCuller mOcclusionCuller;   ///< Visibility of the Nodes, decided by occlusion queries
+    SoftwareOcclusion mSoftwareOcclusion;   ///< Visibility of the Nodes behind the occluders, decided on the CPU
+    unsigned int mOcclusionCpuWidth;    ///< Width of the depth buffers of the software occlusion (0 if disabled)
+    CockpitMask mCockpitMask;           ///< Stencil mask of the cockpit, rejecting the pixels of the world it covers
+    HiddenArea  mHiddenArea;            ///< Pixels of each eye never seen through the lenses of the HMD
+    RenderStats mRenderStats;           ///< Per-frame statistics counters (draw calls, triangles, binds...)
+    GpuTimer    mGpuTimer;              ///< GPU time of the rendering, measured by timer queries
+    FramePacer  mFramePacer;            ///< Bound the number of frames in flight between the CPU and the GPU
+    OverdrawMeter mOverdrawMeter;       ///< Overdraw of the color pass, measured by occlusion queries
+    UploadRing  mMatrixRing;            ///< Ring buffer streaming the "Model to Camera" matrices of each frame
+    DrawList    mDrawLists[2];          ///< Draw calls collected for each eye
+    DrawBatchList mDrawBatches[2];      ///< Instanced draw calls of each eye, grouping the draws of a same Mesh
+    ImpostorBatch mImpostorBatches[2];  ///< Instanced draw call of the impostors of each eye
+    DrawList    mMaskDrawLists[2];      ///< Draw calls of the cockpit mask shaded, for each eye
+    DrawBatchList mMaskBatches[2];      ///< Instanced draw calls of the cockpit mask shaded, for each eye
+    DrawList    mMaskOnlyDrawLists[2];  ///< Draw calls only drawn into the cockpit mask, for each eye
+    DrawBatchList mMaskOnlyBatches[2];  ///< Instanced draw calls only drawn into the cockpit mask, for each eye
+
+    BatchIndexMap           mBatchIndexes;  ///< Index of the batch of each Mesh level of detail (while batching)
+    std::vector<size_t>     mItemBatches;   ///< Index of the batch of each item (while batching)
+    std::vector<int>        mItemSlots;     ///< Impostor slot of each item, -1 if not an impostor (while batching)
+    std::vector<char*>      mBatchWrites;   ///< Where to write the next matrix of each batch
+    std::vector<std::pair<float, size_t> > mSortKeys;   ///< View depth and index of each item (while sorting)
+    DrawList                mSortedDrawList;    ///< Draw calls sorted front-to-back (while sorting)
+
 private:
     /// disallow copy constructor and assignment operator
     DISALLOW_COPY_AND_ASSIGN(Renderer);
@@ -120,3 +228,52 @@ inline void Renderer::incrScreenCenterOffset(float aOffset) {
     mScreenCenterOffset += aOffset;
     mLog.info() << "SetScreenCenterOffset(" << mScreenCenterOffset << "m)";
 }
+
+/**
+ * @brief Get the statistics counters of the rendering (aggregated over frames until reset)
+ */
+inline RenderStats& Renderer::getRenderStats() {
+    return mRenderStats;
+}
+
+/**
+ * @brief Get the GPU time of the rendering (averaged over frames until reset)
+ */
+inline GpuTimer& Renderer::getGpuTimer() {
+    return mGpuTimer;
+}
+
+/**
+ * @brief Get the pacing of the frames in flight (frame index and slot for per-frame buffer rings)
+ */
+inline FramePacer& Renderer::getFramePacer() {
+    return mFramePacer;
+}
+
+/**
+ * @brief Get the overdraw of the color pass (averaged over frames until reset, only measured with "--overdraw")
+ */
+inline OverdrawMeter& Renderer::getOverdrawMeter() {
+    return mOverdrawMeter;
+}
+
+/**
+ * @brief Get the software occlusion culling (time averaged over frames until reset, only with "--occlusion-cpu")
+ */
+inline SoftwareOcclusion& Renderer::getSoftwareOcclusion() {
+    return mSoftwareOcclusion;
+}
+
+/**
+ * @brief Get the stencil mask of the cockpit (coverage averaged over frames until reset, only with "--cockpit-mask")
+ */
+inline CockpitMask& Renderer::getCockpitMask() {
+    return mCockpitMask;
+}
+
+/**
+ * @brief Get the models loaded once and shared by all their instances (to release the ones no more used)
+ */
+inline ResourceManager& Renderer::getResourceManager() {
+    return mResourceManager;
+}
@@ -0,0 +1,575 @@
+/**
+ * @file    ResourceManager.cpp
+ * @ingroup Main
+ * @brief   Loading and sharing of models: each file is imported and uploaded to the GPU only once
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/ResourceManager.h"
+#include "Main/NativeLoader.h"
+#include "Main/MeshSimplifier.h"
+#include "Main/VertexAttributes.h"
+#include "Main/VertexFormat.h"
+#include "Utils/Exception.h"
+#include "Utils/Measure.h"
+
+#include <assimp/Importer.hpp>  // Open Asset Importer
+
+#include <map>
+#include <vector>
+#include <string>
+#include <utility>              // std::pair
+#include <cassert>
+#include <cstdlib>              // realpath, _fullpath
+#include <climits>              // PATH_MAX
+#include <algorithm>            // std::max
+
+/**
+ * @brief Constructor
+ */
+ResourceManager::ResourceManager() :
+    mLog("ResourceManager"),
+    mPositionAttrib(0),
+    mColorAttrib(1),
+    mNormalAttrib(2),
+    mMatrixAttrib(3),
+    mbCompactVertices(false),
+    mMaxBakedVertices(0),
+    mbDepthOnlyStream(false) {
+}
+
+/**
+ * @brief Destructor: release all the templates (Meshes still used by instances remain alive)
+ */
+ResourceManager::~ResourceManager() {
+}
+
+/**
+ * @brief Set the location of the vertex shader attributes used by all Meshes
+ *
+ * @param[in] aPositionAttrib   Location of the "position" vertex shader attribute (input stream)
+ * @param[in] aColorAttrib      Location of the "diffuseColor" vertex shader attribute (input stream)
+ * @param[in] aNormalAttrib     Location of the "normal" vertex shader attribute (input stream)
+ * @param[in] aMatrixAttrib     Location of the "modelToCameraMatrix" per-instance vertex shader attribute
+ */
+void ResourceManager::setAttribLocations(GLuint aPositionAttrib, GLuint aColorAttrib, GLuint aNormalAttrib,
+                                         GLuint aMatrixAttrib) {
+    mPositionAttrib = aPositionAttrib;
+    mColorAttrib    = aColorAttrib;
+    mNormalAttrib   = aNormalAttrib;
+    mMatrixAttrib   = aMatrixAttrib;
+}
+
+/**
+ * @brief Upload the Meshes with the compact vertex format, quantizing their colors and normals
+ *
+ * @param[in] abCompactVertices true for VertexFormat::PositionColorNormalPacked (20 bytes per vertex),
+ *                              false for VertexFormat::PositionColorNormal (36 bytes per vertex)
+ */
+void ResourceManager::setCompactVertices(bool abCompactVertices) {
+    mbCompactVertices = abCompactVertices;
+}
+
+/**
+ * @brief Retain in CPU memory the data of the small Meshes, to be baked into static batches (see RetainedDrawList)
+ *
+ *  Only the Meshes with a single level of detail are retained: their instances which never move are then
+ * pre-transformed into world space and merged, each static batch being drawn in one call.
+ *
+ * @param[in] aMaxVertices  Number of vertices up to which a Mesh is retained (0 for no static batching)
+ */
+void ResourceManager::setStaticBatching(unsigned int aMaxVertices) {
+    mMaxBakedVertices = aMaxVertices;
+}
+
+/**
+ * @brief Upload along with each Mesh a stream of its positions only, read by the depth pre-pass (see Renderer)
+ *
+ * @param[in] abDepthOnlyStream true to upload a VertexFormat::Position stream (12 more bytes per vertex)
+ */
+void ResourceManager::setDepthOnlyStream(bool abDepthOnlyStream) {
+    mbDepthOnlyStream = abDepthOnlyStream;
+}
+
+/**
+ * @brief Get a new instance of a model: a clone of its template hierarchy, loading it at first request only
+ *
+ * @param[in] aFilename     Name of the model file to load (must be supported by assimp)
+ * @param[in] aImportFlags  Assimp post-processing flags (part of the identity of the resource)
+ *
+ * @return A pointer to the new Node, or throw a std::exception if none loaded
+ */
+Node::Ptr ResourceManager::instantiate(const std::string& aFilename, unsigned int aImportFlags /* = DEFAULT */) {
+    const Key key(getCanonicalPath(aFilename), aImportFlags);
+    ModelMap::const_iterator iModel = mModels.find(key);
+    if (mModels.end() == iModel) {
+        iModel = mModels.insert(std::make_pair(key, loadFile(aFilename, aImportFlags))).first;
+    } else {
+        mLog.debug() << "instantiate(" << aFilename << ") reusing \"" << key.first << "\"";
+    }
+    return iModel->second->clone();
+}
+
+/// Number of references to a Mesh made by a template hierarchy, and its total use count
+typedef std::map<const Mesh*, std::pair<long, long> > ReferenceMap;
+
+/**
+ * @brief Count the references to each Mesh made by a hierarchy of Nodes
+ *
+ * @param[in]     aNode         Root of the hierarchy
+ * @param[in,out] aReferences   Number of references to each Mesh made by the hierarchy, and its total use count
+ */
+static void countReferences(const Node& aNode, ReferenceMap& aReferences) {
+    const Mesh::List& meshes = aNode.getMeshes();
+    for (Mesh::List::const_iterator iMesh = meshes.begin(); iMesh != meshes.end(); ++iMesh) {
+        std::pair<long, long>& references = aReferences[iMesh->get()];
+        ++references.first;
+        references.second = iMesh->use_count();
+    }
+    const Node::List& children = aNode.getChildren();
+    for (Node::List::const_iterator iChild = children.begin(); iChild != children.end(); ++iChild) {
+        countReferences(**iChild, aReferences);
+    }
+}
+
+/**
+ * @brief Tell if any Mesh of a template hierarchy is referenced outside of the template (by an instance)
+ *
+ * @param[in] aTemplate Root of the template hierarchy
+ */
+static bool isInstantiated(const Node& aTemplate) {
+    bool            bInstantiated = false;
+    ReferenceMap    references;
+    countReferences(aTemplate, references);
+    for (ReferenceMap::const_iterator iRef = references.begin(); (iRef != references.end()) && !bInstantiated; ++iRef) {
+        bInstantiated = (iRef->second.second > iRef->second.first);
+    }
+    return bInstantiated;
+}
+
+/**
+ * @brief Release the templates of the models no more used by any instance, freeing their GPU memory
+ *
+ * @return Number of models released
+ */
+unsigned int ResourceManager::purge() {
+    unsigned int nbReleased = 0;
+    for (ModelMap::iterator iModel = mModels.begin(); iModel != mModels.end(); ) {
+        if (isInstantiated(*iModel->second)) {
+            ++iModel;
+        } else {
+            mLog.info() << "purge: releasing \"" << iModel->first.first << "\"";
+            iModel = mModels.erase(iModel);
+            ++nbReleased;
+        }
+    }
+    return nbReleased;
+}
+
+/**
+ * @brief Canonical absolute path of a file, used to identify a resource
+ *
+ * @param[in] aFilename Relative or absolute name of a file
+ *
+ * @return Canonical absolute path (or the given name if the file does not exist)
+ */
+std::string ResourceManager::getCanonicalPath(const std::string& aFilename) {
+    std::string canonicalPath = aFilename;
+#ifdef WIN32
+    char path[_MAX_PATH];
+    if (nullptr != _fullpath(path, aFilename.c_str(), _MAX_PATH)) {
+        canonicalPath = path;
+    }
+#else
+    char path[PATH_MAX];
+    if (nullptr != realpath(aFilename.c_str(), path)) {
+        canonicalPath = path;
+    }
+#endif
+    return canonicalPath;
+}
+
+/**
+ * @brief Load a model file into a template hierarchy of Nodes
+ *
+ * @param[in] aFilename     Name of the model file to load (must be supported by assimp)
+ * @param[in] aImportFlags  Assimp post-processing flags
+ *
+ * @return A pointer to the new Node, or throw a std::exception if none loaded
+ */
+Node::Ptr ResourceManager::loadFile(const std::string& aFilename, unsigned int aImportFlags) {
+    Utils::Measure  measure;
+    ModelData       modelData;
+    mLog.notice() << "loadFile(" << aFilename << ")...";
+
+    // Read the mesh file and convert it (throw in case of error)
+    importFile(aFilename, aImportFlags, modelData);
+    mLog.info() << "Meshes: " << modelData.mMeshes.size();
+
+    // Upload each Mesh used by a Node to the GPU
+    Mesh::List meshes(modelData.mMeshes.size());
+    for (size_t idxMesh = 0; idxMesh < modelData.mMeshes.size(); ++idxMesh) {
+        meshes[idxMesh] = uploadMesh(modelData.mMeshes[idxMesh]);
+    }
+    Node::Ptr NodePtr = createNode(modelData.mRoot, meshes);
+
+    time_t diffUs = measure.diff();
+    mLog.notice() << "loadFile(" << aFilename << ") done in " << diffUs/1000 << "ms";
+
+    return NodePtr;
+}
+
+/**
+ * @brief Get a new instance of a model imported and uploaded by stages, registering its template if needed
+ *
+ *  If the same model has been loaded in the meantime, its template is reused (and the given Meshes are dropped).
+ *
+ * @param[in] aModelData    CPU side data of the model, imported by importFile()
+ * @param[in] aMeshes       Meshes uploaded by uploadMesh(), by index in aModelData.mMeshes
+ *
+ * @return A pointer to the new Node
+ */
+Node::Ptr ResourceManager::instantiate(const ModelData& aModelData, const Mesh::List& aMeshes) {
+    const Key key(getCanonicalPath(aModelData.mFilename), aModelData.mImportFlags);
+    ModelMap::const_iterator iModel = mModels.find(key);
+    if (mModels.end() == iModel) {
+        iModel = mModels.insert(std::make_pair(key, createNode(aModelData.mRoot, aMeshes))).first;
+        mLog.notice() << "instantiate(" << aModelData.mFilename << ") streamed";
+    } else {
+        mLog.debug() << "instantiate(" << aModelData.mFilename << ") reusing \"" << key.first << "\"";
+    }
+    return iModel->second->clone();
+}
+
+/**
+ * @brief Tell if a model is already loaded
+ *
+ * @param[in] aFilename     Name of the model file
+ * @param[in] aImportFlags  Assimp post-processing flags (part of the identity of the resource)
+ */
+bool ResourceManager::isLoaded(const std::string& aFilename, unsigned int aImportFlags /* = DEFAULT */) const {
+    const Key key(getCanonicalPath(aFilename), aImportFlags);
+    return (mModels.end() != mModels.find(key));
+}
+
+/**
+ * @brief Upload a converted Mesh to the GPU (to be called by the render thread, owning the OpenGL context)
+ *
+ * @param[in] aMeshData     CPU side data of the Mesh
+ * @param[in] abBakeable    Tell if the Mesh can be baked into static batches (false for the batches themselves)
+ * @param[in] abRetainData  Keep the data in CPU memory whatever its size (for the occluders, see SoftwareOcclusion)
+ *
+ * @return A pointer to the new Mesh, or an empty pointer if the Mesh was not converted (not used by any Node)
+ */
+Mesh::Ptr ResourceManager::uploadMesh(const MeshData& aMeshData, bool abBakeable /* = true */,
+                                      bool abRetainData /* = false */) {
+    Mesh::Ptr MeshPtr;
+    if (aMeshData.isConverted()) {
+        mLog.info() << " Mesh '" << aMeshData.mName << "'";
+        mLog.info() << "  Vertices: " << aMeshData.mVertexData.size() / 3;
+        // The index data contains the full resolution followed by the other levels of detail (if any)
+        const size_t nbIndices = aMeshData.mLods.empty() ? aMeshData.mIndexData.size() : aMeshData.mLods[0].mNbIndices;
+        mLog.info() << " Faces: " << nbIndices / 3;
+        mLog.info() << " LODs: " << std::max<size_t>(aMeshData.mLods.size(), 1);
+
+        /// @todo The following API is not good => short<->int
+        // Generate a Mesh objet to draw the imported model
+        MeshPtr.reset(new Mesh(aMeshData.mName.c_str(), GL_TRIANGLES, nbIndices, GL_UNSIGNED_SHORT, 0));
+        // Generate a VBO/VBI & VAO in GPU memory with those data
+        if (mbCompactVertices) {
+            std::vector<VertexFormat::PositionColorNormalPacked> vertices;
+            VertexFormat::convert(aMeshData.mVertexData, vertices);
+            MeshPtr->genOpenGlObjects(vertices.data(), vertices.size(), aMeshData.mIndexData, mPositionAttrib,
+                                      mColorAttrib, mNormalAttrib, mMatrixAttrib);
+        } else {
+            MeshPtr->genOpenGlObjects(aMeshData.mVertexData, aMeshData.mIndexData, mPositionAttrib, mColorAttrib,
+                                      mNormalAttrib, mMatrixAttrib);
+        }
+        // The depth pre-pass reads only the positions, from a tightly packed stream sharing the index buffer
+        if (mbDepthOnlyStream) {
+            std::vector<VertexFormat::Position> positions;
+            VertexFormat::convert(aMeshData.mVertexData, positions);
+            MeshPtr->genDepthOpenGlObjects(positions, mPositionAttrib, mMatrixAttrib);
+        }
+        // All levels of detail share the same buffers, each one being a range of the index buffer
+        for (size_t idxLod = 1; idxLod < aMeshData.mLods.size(); ++idxLod) {
+            const Mesh::Lod& lod = aMeshData.mLods[idxLod];
+            MeshPtr->addLod(lod.mNbIndices, lod.mFirstIndex * sizeof(GLshort), lod.mError);
+        }
+        // Small Meshes without levels of detail are kept in CPU memory, to be baked where they never move
+        const size_t nbVertices = aMeshData.mVertexData.size() / 3;
+        if (abBakeable && (aMeshData.mLods.size() <= 1) && (0 < nbVertices) && (nbVertices <= mMaxBakedVertices)) {
+            MeshPtr->retainData(aMeshData.mVertexData, aMeshData.mIndexData);
+        } else if (abRetainData && (0 < nbVertices)) {
+            // (only the full resolution, the first range of the index data)
+            const Mesh::IndexData indices(aMeshData.mIndexData.begin(), aMeshData.mIndexData.begin() + nbIndices);
+            MeshPtr->retainData(aMeshData.mVertexData, indices);
+        }
+    }
+    return MeshPtr;
+}
+
+/**
+ * @brief Create recursively a hierarchy of Nodes sharing the uploaded Meshes
+ *
+ * @param[in] aNodeData CPU side data of the Node
+ * @param[in] aMeshes   Meshes of the model, by index (shared between Nodes)
+ *
+ * @return A pointer to the new Node
+ */
+Node::Ptr ResourceManager::createNode(const NodeData& aNodeData, const Mesh::List& aMeshes) const {
+    Node::Ptr NodePtr(new Node(aNodeData.mName.c_str()));
+    NodePtr->setOrientationQuaternion(aNodeData.mOrientation.w, aNodeData.mOrientation.x,
+                                      aNodeData.mOrientation.y, aNodeData.mOrientation.z);
+    NodePtr->setTranslationVector(aNodeData.mTranslation.x, aNodeData.mTranslation.y, aNodeData.mTranslation.z);
+    for (size_t iMesh = 0; iMesh < aNodeData.mMeshes.size(); ++iMesh) {
+        // Share the Mesh with any other Node referencing it
+        NodePtr->addMesh(aMeshes[aNodeData.mMeshes[iMesh]]);
+    }
+    for (size_t iChild = 0; iChild < aNodeData.mChildren.size(); ++iChild) {
+        NodePtr->addChildNode(createNode(aNodeData.mChildren[iChild], aMeshes));
+    }
+    return NodePtr;
+}
+
+/**
+ * @brief Import a model file and convert its Meshes, without any OpenGL call
+ *
+ *  PLY and OBJ files are read by the dedicated NativeLoader (memory mapped and parsed in parallel,
+ * ignoring the Assimp flags), and any other format by Assimp (see importAssimpFile()).
+ * Then the levels of detail of each Mesh are generated (see MeshSimplifier). The chunks parsed in parallel
+ * share the hardware threads with the other imports running concurrently (see NativeLoader::Import).
+ *
+ * @param[in]  aFilename    Name of the model file to load (must be supported by assimp)
+ * @param[in]  aImportFlags Assimp post-processing flags
+ * @param[out] aModelData   CPU side data of the model
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+void ResourceManager::importFile(const std::string& aFilename, unsigned int aImportFlags, ModelData& aModelData) {
+    NativeLoader::Import import;
+    if (NativeLoader::isSupported(aFilename)) {
+        NativeLoader::importFile(aFilename, aModelData);
+    } else {
+        importAssimpFile(aFilename, aImportFlags, aModelData);
+    }
+    for (size_t idxMesh = 0; idxMesh < aModelData.mMeshes.size(); ++idxMesh) {
+        MeshData& meshData = aModelData.mMeshes[idxMesh];
+        if (meshData.isConverted()) {
+            MeshSimplifier::generateLods(meshData.mVertexData, meshData.mIndexData, meshData.mLods);
+        }
+    }
+    aModelData.mFilename    = aFilename;
+    aModelData.mImportFlags = aImportFlags;
+}
+
+/**
+ * @brief Import a model file with Assimp and convert its Meshes, without any OpenGL call
+ *
+ *  Each call uses its own Assimp::Importer, and Assimp post-processing (triangulation, joining identical
+ * vertices, cache locality optimization...) is done here, so that it can run concurrently on worker threads.
+ *
+ * @param[in]  aFilename    Name of the model file to load (must be supported by assimp)
+ * @param[in]  aImportFlags Assimp post-processing flags
+ * @param[out] aModelData   CPU side data of the model
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+void ResourceManager::importAssimpFile(const std::string& aFilename, unsigned int aImportFlags,
+                                       ModelData& aModelData) {
+    Assimp::Importer importer;
+    bool bConverted = false;
+
+    aModelData.mFilename    = aFilename;
+    aModelData.mImportFlags = aImportFlags;
+
+    // Read the mesh file
+    const aiScene* pScene = importer.ReadFile(aFilename.c_str(), aImportFlags);
+    if ( (nullptr != pScene) && (0 == (pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE)) ) {
+        // Meshes of the file, converted at their first use by a Node
+        aModelData.mMeshes.clear();
+        aModelData.mMeshes.resize(pScene->mNumMeshes);
+        // Convert recursively all the nodes
+        bConverted = convertNode(pScene, pScene->mRootNode, aModelData, aModelData.mRoot);
+    }
+    if (false == bConverted) {
+        UTILS_THROW("importFile(" << aFilename << ") failed '" << importer.GetErrorString() << "'");
+    }
+    // here pScene is of no more use, Assimp::Importer will release it
+}
+
+/**
+ * @brief Convert recursively an Assimp node and its Meshes
+ *
+ * @param[in]     apScene       Pointer to the Assimp Scene
+ * @param[in]     apNode        Pointer to the Assimp Node
+ * @param[in,out] aModelData    Model data, with the Meshes already converted (shared between Nodes)
+ * @param[out]    aNodeData     Node data to fill
+ *
+ * @return true if the Node is kept, false if it is empty
+ */
+bool ResourceManager::convertNode(const aiScene* apScene, const aiNode* apNode, ModelData& aModelData,
+                                  NodeData& aNodeData) {
+    bool bKept = false;
+    assert(nullptr != apNode);
+
+    // If the Node has at least one Mesh or more than one Child
+    /// @todo Loading Cameras and Lights
+    if ( (1 <= apNode->mNumMeshes) || (2 < apNode->mNumChildren) ) {
+        bKept = true;
+        aNodeData.mName = apNode->mName.C_Str();
+
+        // Decompose the Node traformation matrix with no scaling into its original components
+        aiQuaternion rotation;
+        aiVector3D position;
+        apNode->mTransformation.DecomposeNoScaling(rotation, position);
+        aNodeData.mOrientation = glm::fquat(rotation.w, rotation.x, rotation.y, rotation.z);
+        aNodeData.mTranslation = glm::vec3(position.x, position.y, position.z);
+
+        // Convert all meshes of the current Node
+        for (unsigned int iMesh = 0; iMesh < apNode->mNumMeshes; ++iMesh) {
+            unsigned int idxMesh = apNode->mMeshes[iMesh];
+            MeshData& meshData = aModelData.mMeshes[idxMesh];
+            if (false == meshData.isConverted()) {
+                // First use of this Mesh in the file: convert it
+                aiMesh* pMesh = apScene->mMeshes[idxMesh];
+                assert(nullptr != pMesh);
+                meshData.mName = pMesh->mName.C_Str();
+                convertMesh(pMesh, meshData.mVertexData, meshData.mIndexData);
+            }
+            aNodeData.mMeshes.push_back(idxMesh);
+        }
+
+        // Convert all children of the current Node recursively
+        for (unsigned int iChild = 0; iChild < apNode->mNumChildren; ++iChild) {
+            aNodeData.mChildren.push_back(NodeData());
+            if (false == convertNode(apScene, apNode->mChildren[iChild], aModelData, aNodeData.mChildren.back())) {
+                // and keep it only if not empty
+                aNodeData.mChildren.pop_back();
+            }
+        }
+    } else if (1 == apNode->mNumChildren) {
+        // No Mesh and only one child: skip this Node of the hierarchy! (ex. Root Scene Node)
+        /// @todo Accumulate matrix transformation not to loose relative positionning if any
+        bKept = convertNode(apScene, apNode->mChildren[0], aModelData, aNodeData);
+    }
+    return bKept;
+}
+
+/**
+ * @brief Convert an Assimp mesh without normals, welding its vertices and generating smooth normals in parallel
+ *
+ * @param[in]  apMesh       Pointer to the Assimp Mesh (triangulated, without normals)
+ * @param[out] aVertexData  Vertex data (vertex positions, colors, and normals)
+ * @param[out] aIndexData   Index data (triangle list)
+ */
+static void convertMeshWithoutNormals(const aiMesh* apMesh, Mesh::VertexData& aVertexData,
+                                      Mesh::IndexData& aIndexData) {
+    RawMesh rawMesh;
+    rawMesh.mPositions.reserve(apMesh->mNumVertices);
+    for (unsigned int iVertex = 0; iVertex < apMesh->mNumVertices; ++iVertex) {
+        rawMesh.mPositions.push_back(glm::vec3(apMesh->mVertices[iVertex].x,
+                                               apMesh->mVertices[iVertex].y,
+                                               apMesh->mVertices[iVertex].z));
+    }
+    if (apMesh->HasVertexColors(0)) {
+        rawMesh.mColors.reserve(apMesh->mNumVertices);
+        for (unsigned int iVertex = 0; iVertex < apMesh->mNumVertices; ++iVertex) {
+            rawMesh.mColors.push_back(glm::vec3(apMesh->mColors[0][iVertex].r,
+                                                apMesh->mColors[0][iVertex].g,
+                                                apMesh->mColors[0][iVertex].b));
+        }
+    }
+    rawMesh.mIndices.reserve(apMesh->mNumFaces * 3);
+    for (unsigned int iFace = 0; iFace < apMesh->mNumFaces; ++iFace) {
+        const aiFace& face = apMesh->mFaces[iFace];
+        assert(3 == face.mNumIndices);
+        rawMesh.mIndices.insert(rawMesh.mIndices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+    }
+
+    VertexAttributes vertexAttributes;
+    vertexAttributes.generateNormals(rawMesh);
+
+    aVertexData.clear();
+    aVertexData.reserve(rawMesh.mPositions.size() * 3);
+    for (size_t iVertex = 0; iVertex < rawMesh.mPositions.size(); ++iVertex) {
+        aVertexData.push_back(rawMesh.mPositions[iVertex]);
+        // NOTE if no colors, use pure white
+        aVertexData.push_back(rawMesh.mColors.empty() ? glm::vec3(1.0f, 1.0f, 1.0f) : rawMesh.mColors[iVertex]);
+        aVertexData.push_back(rawMesh.mNormals[iVertex]);
+    }
+    aIndexData.assign(rawMesh.mIndices.begin(), rawMesh.mIndices.end());
+}
+
+/**
+ * @brief Convert an Assimp mesh into interleaved vertex data and a triangle list of indices
+ *
+ *  Vertex data are interleaved position, color and normal (pure white color if missing).
+ * If normals are missing, vertices are welded and smooth normals generated (see VertexAttributes).
+ *  This does not need any OpenGL context, so that it can be used (and benchmarked) independently.
+ *
+ * @param[in]  apMesh       Pointer to the Assimp Mesh (triangulated)
+ * @param[out] aVertexData  Vertex data (vertex positions, colors, and normals)
+ * @param[out] aIndexData   Index data (triangle list)
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+void ResourceManager::convertMesh(const aiMesh* apMesh, Mesh::VertexData& aVertexData, Mesh::IndexData& aIndexData) {
+    assert(nullptr != apMesh);
+
+    // If only triangles :
+    const size_t nbOfIndex = apMesh->mNumFaces * 3;
+    if (65536 < nbOfIndex) {
+        /// @todo if there is more than 64k indices, switch to GL_UNSIGNED_INT !
+        UTILS_THROW("convertMesh: too many indices for SHORT (" << nbOfIndex << " > " << 65536 << ")");
+    }
+    if (false == apMesh->HasNormals()) {
+        convertMeshWithoutNormals(apMesh, aVertexData, aIndexData);
+        return;
+    }
+
+    // Always 3 sets of data per vertex (position, color and normal), even when colors are missing
+    const size_t nbOfData = apMesh->mNumVertices * 3;
+    aVertexData.clear();
+    aVertexData.reserve(nbOfData);
+
+    for (unsigned int iVertex = 0; iVertex < apMesh->mNumVertices; ++iVertex) {
+        // mLog.info() << "   Vertex: " << apMesh->mVertices[iVertex].x
+        //             << ", " << apMesh->mVertices[iVertex].y << ", " << apMesh->mVertices[iVertex].z;
+        aVertexData.push_back(glm::vec3(apMesh->mVertices[iVertex].x,
+                                        apMesh->mVertices[iVertex].y,
+                                        apMesh->mVertices[iVertex].z));
+        if (apMesh->HasVertexColors(0)) {
+            // mLog.info() << "   Colors: " << apMesh->mColors[0][iVertex].r
+            //             << ", " << apMesh->mColors[0][iVertex].g << ", " << apMesh->mColors[0][iVertex].b;
+            aVertexData.push_back(glm::vec3(apMesh->mColors[0][iVertex].r,
+                                            apMesh->mColors[0][iVertex].g,
+                                            apMesh->mColors[0][iVertex].b));
+        } else {
+            // NOTE if no colors, use pure white
+            aVertexData.push_back(glm::vec3(1.0f, 1.0f, 1.0f));
+        }
+        // mLog.info() << "   Normal: " << apMesh->mNormals[iVertex].x
+        //             << ", " << apMesh->mNormals[iVertex].y << ", " << apMesh->mNormals[iVertex].z;
+        aVertexData.push_back(glm::vec3(apMesh->mNormals[iVertex].x,
+                                        apMesh->mNormals[iVertex].y,
+                                        apMesh->mNormals[iVertex].z));
+    }
+
+    aIndexData.clear();
+    aIndexData.reserve(nbOfIndex);
+
+    for (unsigned int iFace = 0; iFace < apMesh->mNumFaces; ++iFace) {
+        aiFace& face = apMesh->mFaces[iFace];
+        // mLog.info() << "  Indices: " << face.mNumIndices;
+        assert(3 == face.mNumIndices);
+        for (unsigned int iIndice = 0; iIndice < face.mNumIndices; ++iIndice) {
+            // mLog.info() << "   - " << face.mIndices[iIndice];
+            aIndexData.push_back(static_cast<GLshort>(face.mIndices[iIndice]));
+        }
+    }
+}
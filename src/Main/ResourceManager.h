@@ -0,0 +1,131 @@
+/**
+ * @file    ResourceManager.h
+ * @ingroup Main
+ * @brief   Loading and sharing of models: each file is imported and uploaded to the GPU only once
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "LoggerCpp/LoggerCpp.h"
+
+#include "Main/Node.h"
+#include "Main/Mesh.h"
+#include "Main/ModelData.h"
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>      // GLuint, GLenum, and OpenGL 3.3 core function APIs
+
+#include <assimp/scene.h>       // Assimp output data structure
+#include <assimp/postprocess.h> // Post processing flags
+
+#include <map>
+#include <string>
+#include <utility>              // std::pair
+
+/**
+ * @brief   Loading and sharing of models: each file is imported and uploaded to the GPU only once
+ * @ingroup Main
+ *
+ *  Models are keyed by canonical path and Assimp import flags, so that "data/cube.dae" and "./data/cube.dae"
+ * are the same resource. The first request of a model loads a template hierarchy of Nodes (with each Mesh
+ * of the file converted and uploaded once), and every request returns a new lightweight clone of this template,
+ * sharing its Meshes (reference-counted).
+ *
+ *  The GPU memory of a Mesh is freed when its last user goes away: purge(), called by the render thread once
+ * per FPS interval (see App::loop()), releases the templates of models no more used by any instance.
+ *
+ *  Loading is split in two stages, so that the first one can be done on a worker thread (see AssetStreamer):
+ * importFile() reads and converts a file into ModelData without any OpenGL call, then uploadMesh() and
+ * instantiate(ModelData) create the OpenGL objects and the template on the render thread.
+ */
+class ResourceManager {
+public:
+    /// Default Assimp import flags: missing normals are generated by VertexAttributes, and tangents are not used
+    static const unsigned int DEFAULT_IMPORT_FLAGS = aiProcessPreset_TargetRealtime_Fast
+                                                   & ~(aiProcess_GenNormals | aiProcess_CalcTangentSpace);
+
+public:
+    ResourceManager();
+    ~ResourceManager(); // not virtual because no virtual methods and class not derived
+
+    // Set the location of the vertex shader attributes used by all Meshes
+    void setAttribLocations(GLuint aPositionAttrib, GLuint aColorAttrib, GLuint aNormalAttrib, GLuint aMatrixAttrib);
+    // Upload the Meshes with the compact vertex format (see VertexFormat::PositionColorNormalPacked)
+    void setCompactVertices(bool abCompactVertices);
+    // Retain in CPU memory the data of the small Meshes, to be baked into static batches (see RetainedDrawList)
+    void setStaticBatching(unsigned int aMaxVertices);
+    // Upload along with each Mesh a stream of its positions only, for the depth pre-pass
+    void setDepthOnlyStream(bool abDepthOnlyStream);
+
+    // Get a new instance of a model (loading it only once)
+    Node::Ptr instantiate(const std::string& aFilename, unsigned int aImportFlags = DEFAULT_IMPORT_FLAGS);
+    // Get a new instance of a model imported and uploaded by stages (registering it if not already loaded)
+    Node::Ptr instantiate(const ModelData& aModelData, const Mesh::List& aMeshes);
+
+    // Tell if a model is already loaded
+    bool isLoaded(const std::string& aFilename, unsigned int aImportFlags = DEFAULT_IMPORT_FLAGS) const;
+
+    // Upload a converted Mesh to the GPU (render thread)
+    Mesh::Ptr uploadMesh(const MeshData& aMeshData, bool abBakeable = true, bool abRetainData = false);
+
+    // Release the models no more used by any instance
+    unsigned int purge();
+
+    // Number of models loaded
+    inline size_t getNbModels() const;
+
+    // Import a model file and convert its Meshes (no OpenGL call, thread-safe)
+    static void importFile(const std::string& aFilename, unsigned int aImportFlags, ModelData& aModelData);
+    // Import a model file with Assimp, even if supported by the NativeLoader (no OpenGL call, thread-safe)
+    static void importAssimpFile(const std::string& aFilename, unsigned int aImportFlags, ModelData& aModelData);
+
+    // Convert an Assimp mesh into interleaved vertex data and indices (no OpenGL call)
+    static void convertMesh(const aiMesh* apMesh, Mesh::VertexData& aVertexData, Mesh::IndexData& aIndexData);
+
+    // Canonical absolute path of a file, used to identify a resource
+    static std::string getCanonicalPath(const std::string& aFilename);
+
+private:
+    // Load a model file into a template hierarchy of Nodes
+    Node::Ptr loadFile(const std::string& aFilename, unsigned int aImportFlags);
+    // Create recursively a hierarchy of Nodes sharing the uploaded Meshes
+    Node::Ptr createNode(const NodeData& aNodeData, const Mesh::List& aMeshes) const;
+
+    // Convert recursively an Assimp Node and its Meshes (no OpenGL call)
+    static bool convertNode(const aiScene* apScene, const aiNode* apNode, ModelData& aModelData, NodeData& aNodeData);
+
+private:
+    /// Key of a model: canonical path and Assimp import flags
+    typedef std::pair<std::string, unsigned int>    Key;
+    /// Template hierarchy of each model loaded
+    typedef std::map<Key, Node::Ptr>                ModelMap;
+
+    Log::Logger mLog;               ///< Logger object to output runtime information
+
+    ModelMap    mModels;            ///< Template hierarchy of each model loaded
+
+    GLuint      mPositionAttrib;    ///< Location of the "position" vertex shader attribute (input stream)
+    GLuint      mColorAttrib;       ///< Location of the "diffuseColor" vertex shader attribute (input stream)
+    GLuint      mNormalAttrib;      ///< Location of the "normal" vertex shader attribute (input stream)
+    GLuint      mMatrixAttrib;      ///< Location of the "modelToCameraMatrix" per-instance vertex shader attribute
+    bool        mbCompactVertices;  ///< Upload the Meshes with the compact vertex format (20 instead of 36 bytes)
+    unsigned int mMaxBakedVertices; ///< Number of vertices up to which a Mesh can be baked (0 for no static batching)
+    bool        mbDepthOnlyStream;  ///< Upload along with each Mesh a stream of its positions only (depth pre-pass)
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(ResourceManager);
+};
+
+
+/**
+ * @brief Get the number of models loaded
+ */
+inline size_t ResourceManager::getNbModels() const {
+    return mModels.size();
+}
@@ -0,0 +1,429 @@
+/**
+ * @file    RetainedDrawList.cpp
+ * @ingroup Main
+ * @brief   Flat draw list compiled from the Scene hierarchy, retained until the structure of the Scene changes
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/RetainedDrawList.h"
+#include "Main/LodSelector.h"
+#include "Main/RenderStats.h"
+
+#include "Utils/Exception.h"
+
+#include <vector>   // std::vector
+#include <algorithm>
+
+
+/**
+ * @brief Constructor
+ */
+RetainedDrawList::RetainedDrawList() :
+    mNbBaked(0),
+    mbBakeDirty(false) {
+}
+
+/**
+ * @brief Destructor
+ */
+RetainedDrawList::~RetainedDrawList() {
+}
+
+/**
+ * @brief Compile a new root Node and its hierarchy, appended to the arrays
+ *
+ * @param[in] aRootNode     Root Node added to the Scene
+ * @param[in] aFlags        Role of the hierarchy in the Scene (see Flags: occluder, cockpit mask)
+ */
+void RetainedDrawList::addRoot(const Node& aRootNode, unsigned int aFlags /* = 0 */) {
+    append(aRootNode, NONE, aFlags);
+}
+
+/**
+ * @brief Compile a new child (and its hierarchy) of a Node already compiled, appended to the arrays
+ *
+ *  Structural edits are rare: the parent is searched linearly. The child inherits the role of its parent.
+ *
+ * @param[in] aParentNode   Node of the Scene the child has been added to
+ * @param[in] aChildNode    Child Node added
+ */
+void RetainedDrawList::addChild(const Node& aParentNode, const Node& aChildNode) {
+    size_t idxParent = 0;
+    while ((idxParent < mEntries.size()) && (mEntries[idxParent].mpNode != &aParentNode)) {
+        ++idxParent;
+    }
+    if (idxParent == mEntries.size()) {
+        UTILS_THROW("addChild: parent Node '" << aParentNode.getName() << "' is not part of the Scene");
+    }
+    append(aChildNode, idxParent, mEntries[idxParent].mFlags);
+}
+
+/**
+ * @brief Append a Node and its hierarchy to the arrays, with its up-to-date world matrix
+ *
+ *  The world matrix of the parent may be one update late: it is then marked as moved at the next update,
+ * which also recalculates the matrix of the new Node.
+ *
+ * @param[in] aNode         Node to append
+ * @param[in] aParent       Index of its parent (NONE for a root Node)
+ * @param[in] aFlags        Role of the hierarchy in the Scene (see Flags)
+ */
+void RetainedDrawList::append(const Node& aNode, size_t aParent, unsigned int aFlags) {
+    const size_t idxEntry = mEntries.size();
+    const glm::mat4& matrix = aNode.getMatrix();
+    const Mesh::List& meshes = aNode.getMeshes();
+    // Bounding box of the bounding spheres of the Meshes, for the occlusion queries
+    unsigned int nbTriangles = 0;
+    glm::vec3 boxMin(0.0f, 0.0f, 0.0f);
+    glm::vec3 boxMax(0.0f, 0.0f, 0.0f);
+    for (size_t idxMesh = 0; idxMesh < meshes.size(); ++idxMesh) {
+        const Mesh& mesh = *meshes[idxMesh];
+        const glm::vec3 meshMin = mesh.getBoundingCenter() - glm::vec3(mesh.getBoundingRadius());
+        const glm::vec3 meshMax = mesh.getBoundingCenter() + glm::vec3(mesh.getBoundingRadius());
+        boxMin = (0 == idxMesh) ? meshMin : glm::min(boxMin, meshMin);
+        boxMax = (0 == idxMesh) ? meshMax : glm::max(boxMax, meshMax);
+        nbTriangles += mesh.getNbTriangles(0);
+    }
+    // (static or not is decided by the next update)
+    const Entry entry = {&aNode, aParent, aNode.getMatrixVersion(), mDraws.size(), meshes.size(), false, false, false,
+                         aFlags, nbTriangles, (boxMin + boxMax) * 0.5f, (boxMax - boxMin) * 0.5f,
+                         OcclusionCuller::eVisible, 0};
+    mEntries.push_back(entry);
+    if (NONE == aParent) {
+        mWorldMatrices.push_back(matrix);
+    } else {
+        mWorldMatrices.push_back(mWorldMatrices[aParent] * matrix);
+    }
+
+    for (size_t idxMesh = 0; idxMesh < meshes.size(); ++idxMesh) {
+        const Draw draw = {meshes[idxMesh].get(), idxEntry, NONE, {0, 0}};
+        mDraws.push_back(draw);
+    }
+    mbBakeDirty = true;
+
+    const Node::List& children = aNode.getChildren();
+    for (Node::List::const_iterator iChild = children.begin(); iChild != children.end(); ++iChild) {
+        append(**iChild, idxEntry, aFlags);
+    }
+}
+
+/**
+ * @brief Recalculate the "Model to World" matrices of the Nodes which moved since the last update
+ *
+ *  One linear pass in the order of compilation: parents are always updated before their children,
+ * and only the Nodes whose own matrix changed (see Node::getMatrixVersion()), or whose parent moved,
+ * are multiplied again.
+ *
+ *  A Node which moves becomes dynamic for good, releasing the static batches its Meshes were baked into.
+ */
+void RetainedDrawList::update() {
+    for (size_t idxEntry = 0; idxEntry < mEntries.size(); ++idxEntry) {
+        Entry& entry = mEntries[idxEntry];
+        // (recalculate the relative matrix first, if dirty, which changes its version)
+        const glm::mat4& matrix = entry.mpNode->getMatrix();
+        const bool bParentMoved = (NONE != entry.mParent) && mEntries[entry.mParent].mbMoved;
+        entry.mbMoved = bParentMoved || (entry.mMatrixVersion != entry.mpNode->getMatrixVersion());
+        if (entry.mbMoved) {
+            entry.mMatrixVersion = entry.mpNode->getMatrixVersion();
+            if (NONE == entry.mParent) {
+                mWorldMatrices[idxEntry] = matrix;
+            } else {
+                mWorldMatrices[idxEntry] = mWorldMatrices[entry.mParent] * matrix;
+            }
+            if (false == entry.mbDynamic) {
+                entry.mbDynamic = true;
+                for (size_t idxDraw = entry.mFirstDraw; idxDraw < entry.mFirstDraw + entry.mNbDraws; ++idxDraw) {
+                    if (NONE != mDraws[idxDraw].mBatch) {
+                        release(mDraws[idxDraw].mBatch);
+                    }
+                }
+            }
+        }
+        entry.mbStatic = (false == entry.mbDynamic) && (false == entry.mpNode->isInMotion())
+                      && ((NONE == entry.mParent) || mEntries[entry.mParent].mbStatic);
+    }
+}
+
+/**
+ * @brief Merge the Meshes of the static Nodes not yet baked into static batches (when some may be baked)
+ *
+ *  The vertices of each Mesh are transformed into world space (positions by the "Model to World" matrix,
+ * and normals by its rotation, Nodes having no scaling), and appended to the current batch, its indices being
+ * offset by the number of vertices before it; a batch is uploaded when it has no room left for the next Mesh.
+ * A batch of a single Mesh would save nothing: it is not uploaded, the Mesh being drawn as before.
+ *
+ * @param[in] aUploader Upload of the data of a static batch (to be called by the render thread)
+ *
+ * @return Number of Meshes baked by this call
+ */
+size_t RetainedDrawList::bake(const Uploader& aUploader) {
+    size_t nbBaked = 0;
+    if (mbBakeDirty && aUploader) {
+        mbBakeDirty = false;
+
+        MeshData            meshData;
+        std::vector<size_t> draws;
+        for (size_t idxDraw = 0; idxDraw < mDraws.size(); ++idxDraw) {
+            const Draw& draw = mDraws[idxDraw];
+            const Mesh& mesh = *draw.mpMesh;
+            const size_t nbVertices = mesh.getVertexData().size() / 3;
+            // (the data of an occluder is retained even with levels of detail, which a batch would lose,
+            // and the cockpit mask is drawn apart)
+            const Entry& entry = mEntries[draw.mMatrixSlot];
+            if ((NONE == draw.mBatch) && entry.mbStatic && (0 == (entry.mFlags & (eMask | eMaskOnly)))
+                && mesh.hasData() && (1 == mesh.getNbLods()) && (nbVertices <= MAX_BATCH_VERTICES)) {
+                if (MAX_BATCH_VERTICES < (meshData.mVertexData.size() / 3) + nbVertices) {
+                    nbBaked += flush(aUploader, meshData, draws);
+                }
+                const size_t firstVertex = meshData.mVertexData.size() / 3;
+                const glm::mat4& matrix = mWorldMatrices[draw.mMatrixSlot];
+                const glm::mat3 rotation(matrix);
+                const Mesh::VertexData& vertices = mesh.getVertexData();
+                for (size_t idxVertex = 0; idxVertex < nbVertices; ++idxVertex) {
+                    meshData.mVertexData.push_back(glm::vec3(matrix * glm::vec4(vertices[idxVertex * 3], 1.0f)));
+                    meshData.mVertexData.push_back(vertices[idxVertex * 3 + 1]);
+                    meshData.mVertexData.push_back(rotation * vertices[idxVertex * 3 + 2]);
+                }
+                const Mesh::IndexData& indices = mesh.getIndexData();
+                for (size_t idxIndex = 0; idxIndex < indices.size(); ++idxIndex) {
+                    // (unsigned 16 bits indices, stored as GLshort)
+                    const size_t index = firstVertex + static_cast<unsigned short>(indices[idxIndex]);
+                    meshData.mIndexData.push_back(static_cast<GLshort>(static_cast<unsigned short>(index)));
+                }
+                draws.push_back(idxDraw);
+            }
+        }
+        nbBaked += flush(aUploader, meshData, draws);
+    }
+    return nbBaked;
+}
+
+/**
+ * @brief Upload the Meshes merged into a static batch (if more than one), and start a new one
+ *
+ * @param[in] aUploader     Upload of the data of a static batch
+ * @param[in,out] aMeshData Vertices and indices of the batch, in world space, cleared afterward
+ * @param[in,out] aDraws    Index of the draws merged into the batch, cleared afterward
+ *
+ * @return Number of Meshes baked
+ */
+size_t RetainedDrawList::flush(const Uploader& aUploader, MeshData& aMeshData, std::vector<size_t>& aDraws) {
+    size_t nbBaked = 0;
+    if (1 < aDraws.size()) {
+        // Reuse the slot of a released batch, if any
+        size_t idxBatch = 0;
+        while ((idxBatch < mBatches.size()) && mBatches[idxBatch].mMeshPtr) {
+            ++idxBatch;
+        }
+        if (idxBatch == mBatches.size()) {
+            mBatches.push_back(Batch());
+        }
+        aMeshData.mName = "static batch";
+        Batch& batch = mBatches[idxBatch];
+        batch.mMeshPtr = aUploader(aMeshData);
+        batch.mDraws = aDraws;
+        for (size_t idxDraw = 0; idxDraw < aDraws.size(); ++idxDraw) {
+            mDraws[aDraws[idxDraw]].mBatch = idxBatch;
+        }
+        nbBaked = aDraws.size();
+        mNbBaked += nbBaked;
+    }
+    aMeshData.mVertexData.clear();
+    aMeshData.mIndexData.clear();
+    aDraws.clear();
+    return nbBaked;
+}
+
+/**
+ * @brief Release a static batch, when one of its Nodes moved: its Meshes are drawn one by one again
+ *
+ *  The other Meshes of the batch are still static: they are baked again by the next call to bake().
+ *
+ * @param[in] aBatch    Index of the batch to release
+ */
+void RetainedDrawList::release(size_t aBatch) {
+    Batch& batch = mBatches[aBatch];
+    for (size_t idxDraw = 0; idxDraw < batch.mDraws.size(); ++idxDraw) {
+        mDraws[batch.mDraws[idxDraw]].mBatch = NONE;
+    }
+    mNbBaked -= batch.mDraws.size();
+    batch.mDraws.clear();
+    batch.mMeshPtr.reset();
+    mbBakeDirty = true;
+}
+
+/**
+ * @brief Decide the visibility of the Nodes for both eyes, by software occlusion and by occlusion queries
+ *
+ *  Only the Nodes with some Meshes not baked are candidates, the other ones being visible, like the cockpit mask.
+ * The unit cube is placed onto the bounding box of each candidate by its "Box to World" matrix.
+ *
+ *  If enabled, the Meshes of the occluder Nodes are first rasterized on the CPU, and the box of every other
+ * candidate is tested against them (see SoftwareOcclusion): a Node hidden in both eyes is occluded at once
+ * for the current frame, without any query.
+ *
+ *  If enabled, the visibility of the remaining candidates with enough triangles (see OcclusionCuller::getMinTriangles())
+ * is then decided by the results of their previous occlusion queries; a camera is considered inside the box when
+ * nearer to its center than its half diagonal (plus the distance of the near plane), since the box would then
+ * be clipped.
+ *
+ * @param[in] aWorldToCameraMatrices    "World to Camera" matrix of each eye
+ * @param[in] aNearDistance             Distance of the near plane of the frustum
+ * @param[in,out] aCuller               Occlusion state of the Nodes, and queries requested for the frame
+ * @param[in,out] aSoftwareOcclusion    Depth buffers of the occluders, started for the frame (see begin())
+ * @param[in,out] aRenderStats          Statistics counters of the current frame
+ */
+void RetainedDrawList::cull(const glm::mat4 aWorldToCameraMatrices[2], float aNearDistance,
+                            OcclusionCuller& aCuller, SoftwareOcclusion& aSoftwareOcclusion,
+                            RenderStats& aRenderStats) {
+    if (aSoftwareOcclusion.isEnabled()) {
+        for (size_t idxDraw = 0; idxDraw < mDraws.size(); ++idxDraw) {
+            const Draw& draw = mDraws[idxDraw];
+            if ((0 != (mEntries[draw.mMatrixSlot].mFlags & eOccluder)) && draw.mpMesh->hasData()) {
+                aSoftwareOcclusion.addOccluder(*draw.mpMesh, mWorldMatrices[draw.mMatrixSlot]);
+            }
+        }
+        aSoftwareOcclusion.rasterize();
+    }
+
+    const glm::vec3 cameraPositions[2] = {
+        glm::vec3(glm::inverse(aWorldToCameraMatrices[0])[3]),
+        glm::vec3(glm::inverse(aWorldToCameraMatrices[1])[3])
+    };
+    for (size_t idxEntry = 0; idxEntry < mEntries.size(); ++idxEntry) {
+        Entry& entry = mEntries[idxEntry];
+        entry.mVisibility = OcclusionCuller::eVisible;
+        entry.mQuery = 0;
+        if ((0 == entry.mNbTriangles) || (0 != (entry.mFlags & (eMask | eMaskOnly)))) {
+            continue;
+        }
+        bool bBaked = true;
+        for (size_t idxDraw = entry.mFirstDraw; idxDraw < entry.mFirstDraw + entry.mNbDraws; ++idxDraw) {
+            bBaked = bBaked && (NONE != mDraws[idxDraw].mBatch);
+        }
+        if (bBaked) {
+            continue;
+        }
+
+        const glm::mat4& worldMatrix = mWorldMatrices[idxEntry];
+        glm::mat4 boxToWorldMatrix = worldMatrix;
+        boxToWorldMatrix[0] *= entry.mBoxExtent.x;
+        boxToWorldMatrix[1] *= entry.mBoxExtent.y;
+        boxToWorldMatrix[2] *= entry.mBoxExtent.z;
+        boxToWorldMatrix[3] = worldMatrix * glm::vec4(entry.mBoxCenter, 1.0f);
+
+        if (aSoftwareOcclusion.isEnabled() && (0 == (entry.mFlags & eOccluder))) {
+            aRenderStats.incr(RenderStats::eSoftTestedNodes);
+            if (aSoftwareOcclusion.isOccluded(boxToWorldMatrix)) {
+                aRenderStats.incr(RenderStats::eSoftOccludedNodes);
+                entry.mVisibility = OcclusionCuller::eOccluded;
+                continue;
+            }
+        }
+
+        if ((false == aCuller.isEnabled()) || (entry.mNbTriangles < aCuller.getMinTriangles())) {
+            continue;
+        }
+        const float halfDiagonal = glm::length(glm::vec3(boxToWorldMatrix[0]) + glm::vec3(boxToWorldMatrix[1])
+                                               + glm::vec3(boxToWorldMatrix[2]));
+        const glm::vec3 boxCenter(boxToWorldMatrix[3]);
+        const bool bCameraInside = (glm::distance(cameraPositions[0], boxCenter) < halfDiagonal + aNearDistance)
+                                || (glm::distance(cameraPositions[1], boxCenter) < halfDiagonal + aNearDistance);
+
+        entry.mVisibility = aCuller.test(idxEntry, boxToWorldMatrix, bCameraInside);
+        if (OcclusionCuller::eConditional == entry.mVisibility) {
+            entry.mQuery = aCuller.getQuery(idxEntry);
+        }
+    }
+}
+
+/**
+ * @brief Collect the draw calls of an eye, in one linear loop over the draws compiled
+ *
+ *  Each Mesh not baked is recorded into the draw list along with its "Model to Camera" matrix, to be drawn later,
+ * and each static batch with the "World to Camera" matrix, at full resolution.
+ *
+ *  The level of detail of each Mesh is selected from the one of the last frame for the same eye (see LodSelector).
+ * The draws of the Nodes occluded (see cull()) are skipped, keeping their level of detail of the last frame,
+ * and so are the ones of the cockpit mask (see collectMask()).
+ *
+ * @param[in] aWorldToCameraMatrix      "World to Camera" matrix of the eye
+ * @param[in] aLodSelector              Selection of the level of detail of the Meshes, for the current eye
+ * @param[in,out] aDrawList             Draw list of the frame
+ * @param[in,out] aRenderStats          Statistics counters of the current frame
+ */
+void RetainedDrawList::collect(const glm::mat4& aWorldToCameraMatrix, const LodSelector& aLodSelector,
+                               DrawList& aDrawList, RenderStats& aRenderStats) {
+    aRenderStats.incr(RenderStats::eNodes, static_cast<unsigned int>(mEntries.size()));
+    aRenderStats.incr(RenderStats::eMeshes, static_cast<unsigned int>(mDraws.size()));
+    aRenderStats.incr(RenderStats::eStaticMeshes, static_cast<unsigned int>(mNbBaked));
+    aDrawList.reserve(aDrawList.size() + mDraws.size() - mNbBaked + mBatches.size());
+
+    for (size_t idxBatch = 0; idxBatch < mBatches.size(); ++idxBatch) {
+        if (mBatches[idxBatch].mMeshPtr) {
+            const DrawItem item = {mBatches[idxBatch].mMeshPtr.get(), 0, aWorldToCameraMatrix, 0};
+            aDrawList.push_back(item);
+        }
+    }
+
+    const int idxEye = aLodSelector.getEye();
+    size_t lastOccluded = NONE;
+    for (size_t idxDraw = 0; idxDraw < mDraws.size(); ++idxDraw) {
+        Draw& draw = mDraws[idxDraw];
+        const Entry& entry = mEntries[draw.mMatrixSlot];
+        if ((NONE != draw.mBatch) || (0 != (entry.mFlags & (eMask | eMaskOnly)))) {
+            continue;
+        }
+        const Mesh& mesh = *draw.mpMesh;
+        if (OcclusionCuller::eOccluded == entry.mVisibility) {
+            // (the draws of a Node are contiguous)
+            if (lastOccluded != draw.mMatrixSlot) {
+                lastOccluded = draw.mMatrixSlot;
+                aRenderStats.incr(RenderStats::eOccludedNodes);
+            }
+            const unsigned int lod = draw.mLods[idxEye];
+            aRenderStats.incr(RenderStats::eOccludedTriangles,
+                              (LodSelector::IMPOSTOR == lod) ? 2 : mesh.getNbTriangles(lod));
+            continue;
+        }
+        const glm::mat4 modelToCameraMatrix = aWorldToCameraMatrix * mWorldMatrices[draw.mMatrixSlot];
+        unsigned char& lod = draw.mLods[idxEye];
+        lod = static_cast<unsigned char>(aLodSelector.select(mesh, modelToCameraMatrix, lod));
+        if (LodSelector::IMPOSTOR != lod) {
+            // (the triangles saved by an impostor are counted when drawing it, see ImpostorAtlas)
+            aRenderStats.incr(RenderStats::eLodSavedTriangles, mesh.getNbTriangles(0) - mesh.getNbTriangles(lod));
+        }
+        const DrawItem item = {&mesh, lod, modelToCameraMatrix, entry.mQuery};
+        aDrawList.push_back(item);
+    }
+}
+
+/**
+ * @brief Collect the draw calls of the cockpit mask of an eye, at full resolution (see CockpitMask)
+ *
+ *  The mask is near the eye, where a coarser level of detail would open gaps in it: its draws are never simplified,
+ * nor baked, nor culled.
+ *
+ * @param[in] aWorldToCameraMatrix      "World to Camera" matrix of the eye
+ * @param[in,out] aShadedDrawList       Draw list of the Meshes drawn into the mask, and then shaded
+ * @param[in,out] aMaskOnlyDrawList     Draw list of the Meshes only drawn into the mask
+ */
+void RetainedDrawList::collectMask(const glm::mat4& aWorldToCameraMatrix, DrawList& aShadedDrawList,
+                                   DrawList& aMaskOnlyDrawList) {
+    for (size_t idxDraw = 0; idxDraw < mDraws.size(); ++idxDraw) {
+        const Draw& draw = mDraws[idxDraw];
+        const unsigned int flags = mEntries[draw.mMatrixSlot].mFlags;
+        if (0 != (flags & (eMask | eMaskOnly))) {
+            const DrawItem item = {draw.mpMesh, 0, aWorldToCameraMatrix * mWorldMatrices[draw.mMatrixSlot], 0};
+            if (0 != (flags & eMaskOnly)) {
+                aMaskOnlyDrawList.push_back(item);
+            } else {
+                aShadedDrawList.push_back(item);
+            }
+        }
+    }
+}
@@ -0,0 +1,189 @@
+/**
+ * @file    RetainedDrawList.h
+ * @ingroup Main
+ * @brief   Flat draw list compiled from the Scene hierarchy, retained until the structure of the Scene changes
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Main/Node.h"
+#include "Main/DrawList.h"
+#include "Main/ModelData.h"
+#include "Main/OcclusionCuller.h"
+#include "Main/SoftwareOcclusion.h"
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::mat4 (GLM_FORCE_RADIANS defined at the project level)
+
+#include <vector>           // std::vector
+#include <functional>       // std::function
+#include <cstddef>          // size_t
+
+class LodSelector;
+class RenderStats;
+
+/**
+ * @brief   Flat draw list compiled from the Scene hierarchy, retained until the structure of the Scene changes
+ * @ingroup Main
+ *
+ *  The Nodes of the hierarchy are compiled once into a flat array, each parent before its children,
+ * with a "Model to World" matrix slot for each of them, and each Mesh into a draw referencing the slot
+ * of its Node. Instead of walking the whole tree with a matrix stack each frame and for each eye:
+ * - update() recalculates only the world matrices of the Nodes which moved (or whose parent moved),
+ *   in one linear pass, detected by the version of the matrix of each Node,
+ * - collect() fills the draw list of an eye in one linear loop over the draws.
+ *
+ *  Structural edits are incremental: a new subtree (root Node, or child of a Node already compiled)
+ * is appended at the end of the arrays, which keeps each parent before its children.
+ *  Nodes are referenced by raw pointers: they are owned by the Scene, and never removed from it.
+ *
+ *  Static batching: bake() pre-transforms into world space the Meshes of the static Nodes (without any motion,
+ * nor any move since compiled, nor any moving ancestor), whose data is retained in CPU memory (see
+ * Mesh::retainData()), and merges them into batches of at most 65536 vertices (16 bits indices), each drawn
+ * by one call with the "World to Camera" matrix. All Meshes share the same program and vertex format, so a batch
+ * only depends on the order of compilation. If a baked Node moves, it becomes dynamic for good, and its batches
+ * are released: their other Meshes are drawn one by one again, until baked again by the next call.
+ *
+ *  Occlusion culling: cull() decides once per frame the visibility of the Nodes with enough triangles,
+ * by the bounding box of their Meshes (see OcclusionCuller): collect() skips the draws of the occluded ones.
+ * Before that, the Meshes of the occluder Nodes (see addRoot()) can be rasterized on the CPU, to test the bounding
+ * box of all the other Nodes against them for the current frame (see SoftwareOcclusion).
+ *
+ *  Cockpit mask: the draws of the mask Nodes (see addRoot()) are never culled, baked nor simplified: collectMask()
+ * gathers them apart, to be drawn into the stencil before the rest of the Scene (see CockpitMask), and collect()
+ * skips them.
+ */
+class RetainedDrawList {
+public:
+    /// Upload of the data of a static batch (see ResourceManager::uploadMesh())
+    typedef std::function<Mesh::Ptr (const MeshData& aMeshData)> Uploader;
+
+    /// Role of a root Node and its hierarchy in the Scene (bit flags, see addRoot())
+    enum Flags {
+        eOccluder   = 1,    ///< Rasterized by the software occlusion culling (see SoftwareOcclusion)
+        eMask       = 2,    ///< Drawn into the cockpit mask, then shaded before the rest of the Scene (see CockpitMask)
+        eMaskOnly   = 4     ///< Only drawn into the cockpit mask, never shaded (authored mask Mesh)
+    };
+
+public:
+    RetainedDrawList();
+    ~RetainedDrawList(); // not virtual because no virtual methods and class not derived
+
+    // Compile a new root Node and its hierarchy
+    void addRoot(const Node& aRootNode, unsigned int aFlags = 0);
+    // Compile a new child (and its hierarchy) of a Node already compiled
+    void addChild(const Node& aParentNode, const Node& aChildNode);
+
+    // Recalculate the "Model to World" matrices of the Nodes which moved since the last update
+    void update();
+    // Merge the Meshes of the static Nodes not yet baked into static batches, returning the number baked
+    size_t bake(const Uploader& aUploader);
+
+    // Decide the visibility of the Nodes for both eyes, by software occlusion and by occlusion queries
+    void cull(const glm::mat4 aWorldToCameraMatrices[2], float aNearDistance, OcclusionCuller& aCuller,
+              SoftwareOcclusion& aSoftwareOcclusion, RenderStats& aRenderStats);
+
+    // Collect the draw calls of an eye, with their "Model to Camera" matrices and level of detail
+    void collect(const glm::mat4& aWorldToCameraMatrix, const LodSelector& aLodSelector, DrawList& aDrawList,
+                 RenderStats& aRenderStats);
+    // Collect the draw calls of the cockpit mask of an eye, at full resolution
+    void collectMask(const glm::mat4& aWorldToCameraMatrix, DrawList& aShadedDrawList, DrawList& aMaskOnlyDrawList);
+
+    // Getters
+    inline size_t getNbNodes() const;
+    inline size_t getNbDraws() const;
+    inline size_t getNbBaked() const;
+
+private:
+    /// Index of the parent of a root Node, and of the batch of a Mesh not baked
+    static const size_t NONE = static_cast<size_t>(-1);
+    /// Maximum number of vertices of a static batch (indexed by 16 bits)
+    static const size_t MAX_BATCH_VERTICES = 65536;
+
+    /**
+     * @brief Node compiled, with the slot of its "Model to World" matrix (its own index)
+     */
+    struct Entry {
+        const Node*     mpNode;         ///< Node of the Scene
+        size_t          mParent;        ///< Index of the parent of the Node (NONE for a root Node)
+        unsigned int    mMatrixVersion; ///< Version of the matrix of the Node used by the last update
+        size_t          mFirstDraw;     ///< Index of the draw of the first Mesh of the Node
+        size_t          mNbDraws;       ///< Number of Meshes of the Node
+        bool            mbMoved;        ///< Tell if the world matrix changed during the last update
+        bool            mbDynamic;      ///< Tell if the Node (or an ancestor) moved since compiled
+        bool            mbStatic;       ///< Tell if the Node can be baked (no motion, never moved)
+        unsigned int    mFlags;         ///< Role of the Node in the Scene (see Flags, inherited from its root)
+        unsigned int    mNbTriangles;   ///< Number of triangles of the Meshes of the Node (at full resolution)
+        glm::vec3       mBoxCenter;     ///< Center of the bounding box of the Meshes of the Node, in model space
+        glm::vec3       mBoxExtent;     ///< Half size of the bounding box of the Meshes of the Node
+        OcclusionCuller::Visibility mVisibility;    ///< Visibility of the Node for the current frame
+        GLuint          mQuery;         ///< Occlusion query of the conditional render of the Node (or 0)
+    };
+
+    /**
+     * @brief Mesh of a Node compiled, with the level of detail it was drawn with for each eye
+     */
+    struct Draw {
+        const Mesh*     mpMesh;         ///< Mesh to draw
+        size_t          mMatrixSlot;    ///< Index of the "Model to World" matrix of its Node
+        size_t          mBatch;         ///< Index of the static batch the Mesh is baked into (NONE if not baked)
+        unsigned char   mLods[2];       ///< Level of detail of the Mesh at the last frame, for each eye
+    };
+
+    /**
+     * @brief Meshes of static Nodes pre-transformed into world space, and merged into one Mesh
+     */
+    struct Batch {
+        Mesh::Ptr           mMeshPtr;   ///< Merged Mesh, drawn at full resolution (empty if released)
+        std::vector<size_t> mDraws;     ///< Index of the draws baked into the batch
+    };
+
+private:
+    // Append a Node and its hierarchy to the arrays
+    void append(const Node& aNode, size_t aParent, unsigned int aFlags);
+    // Release a static batch: its Meshes are drawn one by one again
+    void release(size_t aBatch);
+    // Upload the Meshes merged into a static batch (returning the number of Meshes baked)
+    size_t flush(const Uploader& aUploader, MeshData& aMeshData, std::vector<size_t>& aDraws);
+
+private:
+    std::vector<Entry>      mEntries;           ///< Nodes of the Scene, each parent before its children
+    std::vector<glm::mat4>  mWorldMatrices;     ///< "Model to World" matrix of each Node
+    std::vector<Draw>       mDraws;             ///< Meshes of the Nodes, in the order of their compilation
+    std::vector<Batch>      mBatches;           ///< Static batches (released ones being reused)
+    size_t                  mNbBaked;           ///< Number of Meshes baked into static batches
+    bool                    mbBakeDirty;        ///< Tell if some Meshes may be baked (new Nodes, batch released)
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(RetainedDrawList);
+};
+
+
+/**
+ * @brief Get the number of Nodes compiled
+ */
+inline size_t RetainedDrawList::getNbNodes() const {
+    return mEntries.size();
+}
+
+/**
+ * @brief Get the number of draws compiled (Meshes of the Nodes)
+ */
+inline size_t RetainedDrawList::getNbDraws() const {
+    return mDraws.size();
+}
+
+/**
+ * @brief Get the number of draws baked into static batches
+ */
+inline size_t RetainedDrawList::getNbBaked() const {
+    return mNbBaked;
+}
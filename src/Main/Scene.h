@@ -11,7 +11,7 @@
 #pragma once
 
 #include "Main/Node.h"
-#include "Main/MatrixStack.h"
+#include "Main/RetainedDrawList.h"
 
 // NOTE: Needs to be included before any other gl/glfw/freeglut header
 #include <glload/gl_3_3.h>          // GLuint, GLenum, and OpenGL 3.3 core function APIs
@@ -27,6 +27,9 @@
  *
  *  This base level of a scene graph does not have a matrix of transformation of its own.
  * It does not contain any mesh objects, and thus do no drawing at all.
+ *
+ *  The hierarchy is compiled into a RetainedDrawList as Nodes are added: structural edits of Nodes
+ * already in the Scene have to go through addChildNode() to keep it up to date.
  */
 class Scene {
 public:
@@ -36,15 +39,34 @@ public:
     // Calculate new position and orientation given current Node movements
     inline void move(float aDeltaTime);
 
-    // Draw
-    inline void draw(MatrixStack& aModelToCameraMatrixStack, GLuint aModelToWorldMatrixUnif) const;
+    // Recalculate the "Model to World" matrices of the Nodes which moved, once per frame before collecting
+    inline void update();
+
+    // Merge the Meshes of the static Nodes into static batches (returning the number of Meshes baked)
+    inline size_t bake(const RetainedDrawList::Uploader& aUploader);
+
+    // Decide the visibility of the Nodes for both eyes by occlusion culling, once per frame before collecting
+    inline void cull(const glm::mat4 aWorldToCameraMatrices[2], float aNearDistance, OcclusionCuller& aCuller,
+                     SoftwareOcclusion& aSoftwareOcclusion, RenderStats& aRenderStats);
+
+    // Collect draw calls, with their "Model to Camera" matrices and level of detail
+    inline void collect(const glm::mat4& aWorldToCameraMatrix, const LodSelector& aLodSelector, DrawList& aDrawList,
+                        RenderStats& aRenderStats);
+    // Collect the draw calls of the cockpit mask, at full resolution
+    inline void collectMask(const glm::mat4& aWorldToCameraMatrix, DrawList& aShadedDrawList,
+                            DrawList& aMaskOnlyDrawList);
+
+    // Number of Nodes of the scene
+    inline unsigned int getNbNodes() const;
 
     // Getters/Setters
     inline const Node::List&    getRootNodes() const;
-    inline       void           addRootNode(const Node::Ptr& aRootNodePtr);
+    inline       void           addRootNode(const Node::Ptr& aRootNodePtr, unsigned int aFlags = 0);
+    inline       void           addChildNode(const Node::Ptr& aParentNodePtr, const Node::Ptr& aChildNodePtr);
 
 private:
-    Node::List  mRootNodes; ///< Root Nodes of the current Scene
+    Node::List          mRootNodes;     ///< Root Nodes of the current Scene
+    RetainedDrawList    mDrawList;      ///< Draws of the Nodes of the Scene, compiled as they are added
 
     /// @todo Add Camera (or stereoscopic camera) object
     /// @todo Add Lights objects
@@ -64,18 +86,71 @@ inline void Scene::move(float aDeltaTime) {
 }
 
 /**
- * @brief Draw the root nodes of the scene, and their children
+ * @brief Recalculate the "Model to World" matrices of the Nodes which moved (after move(), before collect())
+ */
+inline void Scene::update() {
+    mDrawList.update();
+}
+
+/**
+ * @brief Merge the Meshes of the static Nodes into static batches, after update() (see RetainedDrawList::bake())
  *
- * @param[in] aModelToCameraMatrixStack "Model to Camera" matrix stack
- * @param[in] aModelToCameraMatrixUnif  Location of the "modelToCameraMatrix" vertex shader uniform input variable
+ * @param[in] aUploader Upload of the data of a static batch (to be called by the render thread)
+ *
+ * @return Number of Meshes baked by this call
+ */
+inline size_t Scene::bake(const RetainedDrawList::Uploader& aUploader) {
+    return mDrawList.bake(aUploader);
+}
+
+/**
+ * @brief Decide the visibility of the Nodes for both eyes, after update() (see RetainedDrawList::cull())
+ *
+ * @param[in] aWorldToCameraMatrices    "World to Camera" matrix of each eye
+ * @param[in] aNearDistance             Distance of the near plane of the frustum
+ * @param[in,out] aCuller               Occlusion state of the Nodes, and queries requested for the frame
+ * @param[in,out] aSoftwareOcclusion    Depth buffers of the occluders, started for the frame
+ * @param[in,out] aRenderStats          Statistics counters of the current frame
  */
-inline void Scene::draw(MatrixStack& aModelToCameraMatrixStack, GLuint aModelToCameraMatrixUnif) const {
-    // Root of the stack : no transformation, no need to push the stack
+inline void Scene::cull(const glm::mat4 aWorldToCameraMatrices[2], float aNearDistance, OcclusionCuller& aCuller,
+                        SoftwareOcclusion& aSoftwareOcclusion, RenderStats& aRenderStats) {
+    mDrawList.cull(aWorldToCameraMatrices, aNearDistance, aCuller, aSoftwareOcclusion, aRenderStats);
+}
 
-    // Ask root Nodes to draw themselves
+/**
+ * @brief Collect the draw calls of the Nodes of the scene, from the retained draw list
+ *
+ * @param[in] aWorldToCameraMatrix      "World to Camera" matrix of the eye
+ * @param[in] aLodSelector              Selection of the level of detail of the Meshes, for the current eye
+ * @param[in,out] aDrawList             Draw list of the frame
+ * @param[in,out] aRenderStats          Statistics counters of the current frame
+ */
+inline void Scene::collect(const glm::mat4& aWorldToCameraMatrix, const LodSelector& aLodSelector,
+                           DrawList& aDrawList, RenderStats& aRenderStats) {
+    mDrawList.collect(aWorldToCameraMatrix, aLodSelector, aDrawList, aRenderStats);
+}
+
+/**
+ * @brief Collect the draw calls of the cockpit mask, from the retained draw list (see RetainedDrawList::collectMask())
+ *
+ * @param[in] aWorldToCameraMatrix      "World to Camera" matrix of the eye
+ * @param[in,out] aShadedDrawList       Draw list of the Meshes drawn into the mask, and then shaded
+ * @param[in,out] aMaskOnlyDrawList     Draw list of the Meshes only drawn into the mask
+ */
+inline void Scene::collectMask(const glm::mat4& aWorldToCameraMatrix, DrawList& aShadedDrawList,
+                               DrawList& aMaskOnlyDrawList) {
+    mDrawList.collectMask(aWorldToCameraMatrix, aShadedDrawList, aMaskOnlyDrawList);
+}
+
+/**
+ * @brief Count the Nodes of the scene
+ */
+inline unsigned int Scene::getNbNodes() const {
+    unsigned int nbNodes = 0;
     for (Node::List::const_iterator iChild = mRootNodes.begin(); iChild != mRootNodes.end(); ++iChild) {
-        (*iChild)->draw(aModelToCameraMatrixStack, aModelToCameraMatrixUnif);
+        nbNodes += (*iChild)->getNbNodes();
     }
+    return nbNodes;
 }
 
 /**
@@ -91,7 +166,20 @@ inline const Node::List& Scene::getRootNodes() const {
  * @brief   Add a child Scene to the current Scene
  *
  * @param[in] aChildScenePtr Child Scene to add
+ * @param[in] aFlags        Role of its hierarchy in the Scene (see RetainedDrawList::Flags: occluder, cockpit mask)
  */
-inline void Scene::addRootNode(const Node::Ptr& aChildScenePtr) {
+inline void Scene::addRootNode(const Node::Ptr& aChildScenePtr, unsigned int aFlags /* = 0 */) {
     mRootNodes.push_back(aChildScenePtr);
+    mDrawList.addRoot(*aChildScenePtr, aFlags);
+}
+
+/**
+ * @brief   Add a child Node to a Node already part of the Scene
+ *
+ * @param[in] aParentNodePtr    Node of the Scene
+ * @param[in] aChildNodePtr     Child Node to add
+ */
+inline void Scene::addChildNode(const Node::Ptr& aParentNodePtr, const Node::Ptr& aChildNodePtr) {
+    aParentNodePtr->addChildNode(aChildNodePtr);
+    mDrawList.addChild(*aParentNodePtr, *aChildNodePtr);
 }
@@ -0,0 +1,147 @@
+/**
+ * @file    SceneGenerator.cpp
+ * @ingroup Main
+ * @brief   Procedural generation of stress scenes for scaling tests
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/SceneGenerator.h"
+
+#include <cmath>    // sqrt, ceil, cos, sin
+
+/**
+ * @brief Default configuration: a single static instance
+ */
+SceneGenerator::Config::Config() :
+    mNbInstances(1),
+    mDepth(0),
+    mFanOut(0),
+    mMovingRatio(0.0f),
+    mSpacing(5.0f),
+    mSeed(42) {
+}
+
+/**
+ * @brief Constructor
+ *
+ * @param[in] aConfig   Configuration of the world to generate
+ */
+SceneGenerator::SceneGenerator(const Config& aConfig) :
+    mConfig(aConfig),
+    mRandom(aConfig.mSeed),
+    mUniform(0.0f, 1.0f) {
+}
+
+/**
+ * @brief Destructor
+ */
+SceneGenerator::~SceneGenerator() {
+}
+
+/**
+ * @brief Generate the configured world into the given Scene
+ *
+ *  Root instances are laid out on a square grid on the horizontal plane, in front of the default camera,
+ * and children are laid out on circles around their parent, each level being smaller than the previous one.
+ *
+ * @param[in,out] aScene    Scene to populate with new root Nodes
+ * @param[in]     aFactory  Factory creating the content of each Node (or empty for Nodes without any Mesh)
+ *
+ * @return Number of Nodes generated
+ */
+unsigned int SceneGenerator::generate(Scene& aScene, const Factory& aFactory /* = Factory() */) {
+    unsigned int nbNodes = 0;
+    const unsigned int side = static_cast<unsigned int>(ceil(sqrt(static_cast<float>(mConfig.mNbInstances))));
+
+    for (unsigned int idxInstance = 0; idxInstance < mConfig.mNbInstances; ++idxInstance) {
+        Node::Ptr InstancePtr = createNode(aFactory);
+        const float x = (static_cast<float>(idxInstance % side) - (side / 2.0f)) * mConfig.mSpacing;
+        const float z = -static_cast<float>(1 + (idxInstance / side)) * mConfig.mSpacing;
+        InstancePtr->setTranslationVector(x, 0.0f, z);
+        setRandomMotion(*InstancePtr);
+        nbNodes += 1 + generateChildren(InstancePtr, mConfig.mDepth, aFactory);
+        aScene.addRootNode(InstancePtr);
+    }
+
+    return nbNodes;
+}
+
+/**
+ * @brief Calculate the number of Nodes that a configuration generates
+ *
+ * @param[in] aConfig   Configuration of a world to generate
+ *
+ * @return Number of Nodes
+ */
+unsigned int SceneGenerator::getNbNodes(const Config& aConfig) {
+    unsigned int nbNodesPerInstance = 1;
+    unsigned int nbNodesPerLevel    = 1;
+    for (unsigned int level = 0; level < aConfig.mDepth; ++level) {
+        nbNodesPerLevel     *= aConfig.mFanOut;
+        nbNodesPerInstance  += nbNodesPerLevel;
+    }
+    return aConfig.mNbInstances * nbNodesPerInstance;
+}
+
+/**
+ * @brief Create a Node, with the content given by the factory
+ *
+ * @param[in] aFactory  Factory creating the content of the Node (or empty for a Node without any Mesh)
+ *
+ * @return A pointer to the new Node
+ */
+Node::Ptr SceneGenerator::createNode(const Factory& aFactory) {
+    Node::Ptr NodePtr;
+    if (aFactory) {
+        NodePtr = aFactory();
+    }
+    if (!NodePtr) {
+        NodePtr.reset(new Node("generated"));
+    }
+    return NodePtr;
+}
+
+/**
+ * @brief Generate recursively the hierarchy under a Node
+ *
+ * @param[in] aParentPtr    Node to populate with children
+ * @param[in] aDepth        Remaining depth of the hierarchy under the parent
+ * @param[in] aFactory      Factory creating the content of each Node
+ *
+ * @return Number of Nodes generated under the parent
+ */
+unsigned int SceneGenerator::generateChildren(const Node::Ptr& aParentPtr, unsigned int aDepth,
+                                              const Factory& aFactory) {
+    unsigned int nbNodes = 0;
+    if ((0 < aDepth) && (0 < mConfig.mFanOut)) {
+        // Children are on a circle, smaller and smaller when going down the hierarchy
+        const float radius = mConfig.mSpacing * 0.4f * aDepth / (mConfig.mDepth + 1);
+        for (unsigned int idxChild = 0; idxChild < mConfig.mFanOut; ++idxChild) {
+            const float angle = (6.2831853f * idxChild) / mConfig.mFanOut;
+            Node::Ptr ChildPtr = createNode(aFactory);
+            ChildPtr->setTranslationVector(radius * cos(angle), 0.0f, radius * sin(angle));
+            setRandomMotion(*ChildPtr);
+            nbNodes += 1 + generateChildren(ChildPtr, aDepth - 1, aFactory);
+            aParentPtr->addChildNode(ChildPtr);
+        }
+    }
+    return nbNodes;
+}
+
+/**
+ * @brief Set a random rotational speed to the configured fraction of Nodes
+ *
+ * @param[in,out] aNode Node to put in motion
+ */
+void SceneGenerator::setRandomMotion(Node& aNode) {
+    if (mUniform(mRandom) < mConfig.mMovingRatio) {
+        // Random yaw speed between -1 and 1 rad/s, and a slower random pitch
+        const float yawSpeed    = 2.0f * mUniform(mRandom) - 1.0f;
+        const float pitchSpeed  = 0.2f * mUniform(mRandom) - 0.1f;
+        aNode.setRotationalSpeed(glm::vec3(pitchSpeed, yawSpeed, 0.0f));
+    }
+}
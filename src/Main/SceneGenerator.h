@@ -0,0 +1,76 @@
+/**
+ * @file    SceneGenerator.h
+ * @ingroup Main
+ * @brief   Procedural generation of stress scenes for scaling tests
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Main/Scene.h"
+#include "Main/Node.h"
+#include "Utils/Utils.h"
+
+#include <functional>   // std::function
+#include <random>       // std::mt19937
+
+/**
+ * @brief   Procedural generation of stress scenes for scaling tests
+ * @ingroup Main
+ *
+ *  Generates a configurable world: a grid of instances, each being the root of a hierarchy
+ * of configurable depth and fan-out, with a configurable fraction of Nodes in motion (random rotational speeds).
+ *  The content of each Node is created by an optional factory (typically loading a model from "data/"),
+ * so that the generator itself does not need any OpenGL context (to be used by micro-benchmarks).
+ *
+ *  The total number of Nodes is: instances * (1 + fanOut + fanOut^2 + ... + fanOut^depth)
+ */
+class SceneGenerator {
+public:
+    /// Factory creating the content of a new Node (a new instance of a model)
+    typedef std::function<Node::Ptr ()> Factory;
+
+    /**
+     * @brief Configuration of a generated scene
+     */
+    struct Config {
+        unsigned int    mNbInstances;   ///< Number of root instances, laid out on a square grid
+        unsigned int    mDepth;         ///< Depth of the hierarchy under each root instance (0 for none)
+        unsigned int    mFanOut;        ///< Number of children of each Node of the hierarchy
+        float           mMovingRatio;   ///< Fraction of Nodes in motion, between 0.0 and 1.0
+        float           mSpacing;       ///< Distance between two root instances, in meters
+        unsigned int    mSeed;          ///< Seed of the pseudo-random generator, for reproducible scenes
+
+        Config();
+    };
+
+public:
+    explicit SceneGenerator(const Config& aConfig);
+    ~SceneGenerator(); // not virtual because no virtual methods and class not derived
+
+    // Generate the configured world into the given Scene
+    unsigned int generate(Scene& aScene, const Factory& aFactory = Factory());
+
+    // Calculate the number of Nodes that a configuration generates
+    static unsigned int getNbNodes(const Config& aConfig);
+
+private:
+    // Create a Node, with the content given by the factory
+    Node::Ptr createNode(const Factory& aFactory);
+    // Generate recursively the hierarchy under a Node
+    unsigned int generateChildren(const Node::Ptr& aParentPtr, unsigned int aDepth, const Factory& aFactory);
+    // Set a random rotational speed to a fraction of Nodes
+    void setRandomMotion(Node& aNode);
+
+private:
+    const Config                            mConfig;    ///< Configuration of the generated world
+    std::mt19937                            mRandom;    ///< Pseudo-random number generator
+    std::uniform_real_distribution<float>   mUniform;   ///< Uniform distribution between 0.0 and 1.0
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(SceneGenerator);
+};
@@ -0,0 +1,195 @@
+/**
+ * @file    SceneManifest.cpp
+ * @ingroup Main
+ * @brief   Text description of the models of a Scene, with their placement and motion
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/SceneManifest.h"
+#include "Main/Node.h"
+#include "Utils/Exception.h"
+#include "Utils/String.h"
+
+#include <fstream>      // NOLINT(readability/streams) for the manifest file
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>       // sscanf
+#include <cstdlib>      // atoi
+
+/**
+ * @brief Parse a vector of three comma separated floats "x,y,z"
+ *
+ * @param[in]  aValue   String to parse
+ * @param[out] aVector  Resulting vector
+ *
+ * @return true if the string is valid
+ */
+static bool parseVector(const std::string& aValue, glm::vec3& aVector) {
+    return (3 == sscanf(aValue.c_str(), "%f,%f,%f", &aVector.x, &aVector.y, &aVector.z));
+}
+
+/**
+ * @brief Default placement: at the origin of the parent, with no rotation and no motion
+ */
+SceneManifest::Placement::Placement() :
+    mPosition(0.0f, 0.0f, 0.0f),
+    mOrientation(0.0f, 0.0f, 0.0f),
+    mLinearSpeed(0.0f, 0.0f, 0.0f),
+    mRotationalSpeed(0.0f, 0.0f, 0.0f) {
+}
+
+/**
+ * @brief Apply the placement and the motion to a Node
+ *
+ * @param[in,out] aNode Node to place
+ */
+void SceneManifest::Placement::apply(Node& aNode) const {
+    aNode.move(mPosition);
+    aNode.pitch(mOrientation.x);
+    aNode.yaw(mOrientation.y);
+    aNode.roll(mOrientation.z);
+    // Only set non-null speeds, so that one does not cancel the motion set by the other
+    if (glm::vec3(0.0f) != mRotationalSpeed) {
+        aNode.setRotationalSpeed(mRotationalSpeed);
+    }
+    if (glm::vec3(0.0f) != mLinearSpeed) {
+        aNode.setLinearSpeed(mLinearSpeed);
+    }
+}
+
+/**
+ * @brief Default entry: not controlled, waited for at startup, not an occluder, not part of the cockpit mask
+ */
+SceneManifest::Entry::Entry() :
+    mbControlled(false),
+    mbBackground(false),
+    mbOccluder(false),
+    mbMask(false),
+    mbMaskOnly(false) {
+}
+
+/**
+ * @brief Constructor: read and parse the manifest file
+ *
+ * @param[in] aFilename Name of the manifest file
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+SceneManifest::SceneManifest(const std::string& aFilename) :
+    mLog("SceneManifest"),
+    mFilename(aFilename) {
+    std::ifstream manifestFile(aFilename.c_str());
+    if (false == manifestFile.is_open()) {
+        mLog.critic() << "SceneManifest: unavailable file \"" << aFilename << "\"";
+        UTILS_THROW("SceneManifest: unavailable file \"" << aFilename << "\"");
+    }
+
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(manifestFile, line)) {
+        ++lineNumber;
+        parseLine(line, lineNumber);
+    }
+    mLog.notice() << "\"" << aFilename << "\": " << mEntries.size() << " models";
+}
+
+/**
+ * @brief Destructor
+ */
+SceneManifest::~SceneManifest() {
+}
+
+/**
+ * @brief Parse a line of the manifest: "name file [keyword|key=value]..."
+ *
+ * @param[in] aLine         Line of the manifest
+ * @param[in] aLineNumber   Number of the line (for error messages)
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+void SceneManifest::parseLine(const std::string& aLine, unsigned int aLineNumber) {
+    // Strip comments
+    std::string line = aLine.substr(0, aLine.find('#'));
+    Utils::trim(line);
+    if (line.empty()) {
+        return;
+    }
+
+    std::istringstream tokens(line);
+    Entry entry;
+    if (!(tokens >> entry.mName >> entry.mFilename)) {
+        UTILS_THROW("SceneManifest: missing model file at " << mFilename << ":" << aLineNumber);
+    }
+
+    std::string token;
+    while (tokens >> token) {
+        bool bValid = true;
+        const size_t equal = token.find('=');
+        if (0 == token.compare("control")) {
+            entry.mbControlled = true;
+        } else if (0 == token.compare("background")) {
+            entry.mbBackground = true;
+        } else if (0 == token.compare("occluder")) {
+            entry.mbOccluder = true;
+        } else if (0 == token.compare("mask")) {
+            entry.mbMask = true;
+        } else if (0 == token.compare("mask-only")) {
+            entry.mbMaskOnly = true;
+        } else if (std::string::npos == equal) {
+            bValid = false;
+        } else if (0 == token.compare(0, 5, "child")) {
+            // "childN.key=value" setting of the N-th child
+            const size_t dot = token.find('.');
+            bValid = (dot < equal) && (5 < dot);
+            if (bValid) {
+                ChildPlacement child;
+                child.mIndex = static_cast<unsigned int>(atoi(token.substr(5, dot - 5).c_str()));
+                std::vector<ChildPlacement>::iterator iChild = entry.mChildPlacements.begin();
+                while ((iChild != entry.mChildPlacements.end()) && (iChild->mIndex != child.mIndex)) {
+                    ++iChild;
+                }
+                if (iChild == entry.mChildPlacements.end()) {
+                    iChild = entry.mChildPlacements.insert(iChild, child);
+                }
+                bValid = parseSetting(token.substr(dot + 1, equal - dot - 1), token.substr(equal + 1),
+                                      iChild->mPlacement);
+            }
+        } else {
+            bValid = parseSetting(token.substr(0, equal), token.substr(equal + 1), entry.mPlacement);
+        }
+        if (false == bValid) {
+            UTILS_THROW("SceneManifest: invalid setting \"" << token << "\" at " << mFilename << ":" << aLineNumber);
+        }
+    }
+
+    mLog.debug() << "'" << entry.mName << "' \"" << entry.mFilename << "\"";
+    mEntries.push_back(entry);
+}
+
+/**
+ * @brief Parse a "key=value" setting of a Placement
+ *
+ * @param[in]     aKey          Name of the setting (position, orientation, speed or spin)
+ * @param[in]     aValue        Value of the setting (vector of three comma separated floats)
+ * @param[in,out] aPlacement    Placement to update
+ *
+ * @return true if the setting is valid
+ */
+bool SceneManifest::parseSetting(const std::string& aKey, const std::string& aValue, Placement& aPlacement) {
+    bool bValid = false;
+    if (0 == aKey.compare("position")) {
+        bValid = parseVector(aValue, aPlacement.mPosition);
+    } else if (0 == aKey.compare("orientation")) {
+        bValid = parseVector(aValue, aPlacement.mOrientation);
+    } else if (0 == aKey.compare("speed")) {
+        bValid = parseVector(aValue, aPlacement.mLinearSpeed);
+    } else if (0 == aKey.compare("spin")) {
+        bValid = parseVector(aValue, aPlacement.mRotationalSpeed);
+    }
+    return bValid;
+}
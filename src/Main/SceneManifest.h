@@ -0,0 +1,126 @@
+/**
+ * @file    SceneManifest.h
+ * @ingroup Main
+ * @brief   Text description of the models of a Scene, with their placement and motion
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "LoggerCpp/LoggerCpp.h"
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::vec3 (GLM_FORCE_RADIANS defined at the project level)
+
+#include <vector>           // std::vector
+#include <string>           // std::string
+
+class Node;
+
+/**
+ * @brief   Text description of the models of a Scene, with their placement and motion
+ * @ingroup Main
+ *
+ *  One model per line: a name, a model file, then optional keywords and "key=value" settings,
+ * where vectors are three comma separated floats, and angles are in radians. Empty lines and '#' comments
+ * are ignored.
+ *
+ *   position=x,y,z     initial translation
+ *   orientation=p,y,r  initial pitch, yaw and roll
+ *   speed=x,y,z        linear speed, in meters per second
+ *   spin=p,y,r         rotational speed, in radians per second
+ *   childN.<setting>   any of the above, applied to the N-th child of the model
+ *   control            the model (and its first child) is moved with the keyboard
+ *   background         the model is streamed while rendering instead of being waited for at startup
+ *   occluder           the model hides what is behind it from the software occlusion culling (see SoftwareOcclusion)
+ *   mask               the model is drawn first into the cockpit mask, rejecting the pixels it covers (see CockpitMask)
+ *   mask-only          the model is only drawn into the cockpit mask, never shaded (authored mask mesh)
+ *
+ * @code
+ * # name   file                settings
+ * model    data/hierarchy.dae  position=-3,-1,-4 orientation=0,1.57,0.2 speed=0,0,3 child0.spin=0,0.8,0 control
+ * plane    data/plane.dae
+ * @endcode
+ */
+class SceneManifest {
+public:
+    /**
+     * @brief Placement and motion of a Node
+     */
+    struct Placement {
+        glm::vec3   mPosition;          ///< Initial translation
+        glm::vec3   mOrientation;       ///< Initial pitch, yaw and roll, in radians
+        glm::vec3   mLinearSpeed;       ///< Linear speed, in meters per second
+        glm::vec3   mRotationalSpeed;   ///< Rotational speed (pitch, yaw, roll), in radians per second
+
+        Placement();
+
+        // Apply the placement and the motion to a Node
+        void apply(Node& aNode) const;
+    };
+
+    /**
+     * @brief Placement of the N-th child of a model
+     */
+    struct ChildPlacement {
+        unsigned int    mIndex;         ///< Index of the child
+        Placement       mPlacement;     ///< Placement and motion of the child
+    };
+
+    /**
+     * @brief Model of the Scene
+     */
+    struct Entry {
+        std::string                 mName;              ///< Name of the model in the Scene
+        std::string                 mFilename;          ///< Model file to load (must be supported by assimp)
+        Placement                   mPlacement;         ///< Placement and motion of the model
+        std::vector<ChildPlacement> mChildPlacements;   ///< Placement and motion of some of its children
+        bool                        mbControlled;       ///< The model is moved with the keyboard
+        bool                        mbBackground;       ///< The model is streamed instead of waited for
+        bool                        mbOccluder;         ///< The model is rasterized by the software occlusion
+        bool                        mbMask;             ///< The model is drawn into the cockpit mask, then shaded
+        bool                        mbMaskOnly;         ///< The model is only drawn into the cockpit mask
+
+        Entry();
+    };
+
+    /// List of models of the Scene, in the order of the manifest
+    typedef std::vector<Entry> EntryList;
+
+public:
+    explicit SceneManifest(const std::string& aFilename);
+    ~SceneManifest(); // not virtual because no virtual methods and class not derived
+
+    // Getter
+    inline const EntryList& getEntries() const;
+
+private:
+    // Parse a line of the manifest
+    void parseLine(const std::string& aLine, unsigned int aLineNumber);
+    // Parse a "key=value" setting of a Placement
+    static bool parseSetting(const std::string& aKey, const std::string& aValue, Placement& aPlacement);
+
+private:
+    Log::Logger mLog;       ///< Logger object to output runtime information
+
+    std::string mFilename;  ///< Name of the manifest file
+    EntryList   mEntries;   ///< List of models of the Scene
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(SceneManifest);
+};
+
+
+/**
+ * @brief Get the list of models of the Scene, in the order of the manifest
+ */
+inline const SceneManifest::EntryList& SceneManifest::getEntries() const {
+    return mEntries;
+}
@@ -0,0 +1,278 @@
+/**
+ * @file    ShaderPermutations.cpp
+ * @ingroup Main
+ * @brief   Variants of a program, specialized by preprocessor defines, compiled in the background
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/ShaderPermutations.h"
+#include "Main/ShaderProgram.h"
+#include "Utils/Time.h"
+
+#include <GLFW/glfw3.h>     // glfwGetProcAddress
+
+#include <vector>
+#include <string>
+#include <algorithm>        // std::sort, std::unique
+#include <cstring>          // strcmp
+
+// KHR_parallel_shader_compile (core since OpenGL 4.6) is not part of the OpenGL 3.3 API
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR    0x91B1
+#endif
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+/// Prototype of the glMaxShaderCompilerThreadsKHR() function of KHR_parallel_shader_compile
+typedef void (APIENTRY* MaxShaderCompilerThreadsProc)(GLuint aCount);
+
+/**
+ * @brief Tell if KHR_parallel_shader_compile (or ARB_parallel_shader_compile) is supported, and enable it
+ */
+static bool enableParallelCompile() {
+    const char* pFunction = nullptr;
+    GLint nbExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &nbExtensions);
+    for (GLint idxExtension = 0; (idxExtension < nbExtensions) && (nullptr == pFunction); ++idxExtension) {
+        const char* pExtension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, idxExtension));
+        if (nullptr != pExtension) {
+            if (0 == strcmp(pExtension, "GL_KHR_parallel_shader_compile")) {
+                pFunction = "glMaxShaderCompilerThreadsKHR";
+            } else if (0 == strcmp(pExtension, "GL_ARB_parallel_shader_compile")) {
+                pFunction = "glMaxShaderCompilerThreadsARB";
+            }
+        }
+    }
+    MaxShaderCompilerThreadsProc maxShaderCompilerThreads = nullptr;
+    if (nullptr != pFunction) {
+        maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(glfwGetProcAddress(pFunction));
+    }
+    if (nullptr != maxShaderCompilerThreads) {
+        // Let the driver choose its number of compiler threads
+        maxShaderCompilerThreads(0xFFFFFFFF);
+    }
+    return (nullptr != maxShaderCompilerThreads);
+}
+
+/**
+ * @brief Get the error message of a shader which failed to compile (empty if compiled successfully)
+ */
+static std::string getShaderError(GLuint aShader) {
+    std::string errorMsg;
+    GLint status = GL_FALSE;
+    glGetShaderiv(aShader, GL_COMPILE_STATUS, &status);
+    if (GL_FALSE == status) {
+        GLint infoLogLength = 0;
+        glGetShaderiv(aShader, GL_INFO_LOG_LENGTH, &infoLogLength);
+        std::vector<GLchar> infoLog(infoLogLength + 1, '\0');
+        glGetShaderInfoLog(aShader, infoLogLength, NULL, &infoLog[0]);
+        errorMsg = &infoLog[0];
+    }
+    return errorMsg;
+}
+
+
+/**
+ * @brief Constructor: compile (or load from the cache) the base program, without any define
+ *
+ * @param[in] apVertexShaderFilename    Name of the vertex shader file
+ * @param[in] apFragmentShaderFilename  Name of the fragment shader file
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+ShaderPermutations::ShaderPermutations(const char* apVertexShaderFilename, const char* apFragmentShaderFilename) :
+    mLog("ShaderPermutations"),
+    mBaseProgram(0),
+    mbParallel(enableParallelCompile()) {
+    ShaderProgram shaderProgram;
+    mVertexSource   = shaderProgram.readShader(apVertexShaderFilename);
+    mFragmentSource = shaderProgram.readShader(apFragmentShaderFilename);
+    mBaseProgram    = shaderProgram.makeProgram(apVertexShaderFilename, apFragmentShaderFilename);
+    mLog.notice() << apVertexShaderFilename << ", " << apFragmentShaderFilename << ": permutations compiled "
+                  << (mbParallel ? "in parallel by the driver" : "one per frame");
+}
+
+/**
+ * @brief Destructor: delete all the programs
+ */
+ShaderPermutations::~ShaderPermutations() {
+    for (size_t idxPermutation = 0; idxPermutation < mPermutations.size(); ++idxPermutation) {
+        const Permutation& permutation = mPermutations[idxPermutation];
+        glDeleteShader(permutation.mVertexShader);
+        glDeleteShader(permutation.mFragmentShader);
+        glDeleteProgram(permutation.mProgram);
+    }
+    glDeleteProgram(mBaseProgram);
+}
+
+/**
+ * @brief Get the program of a permutation, requesting it if needed: the base program until it is ready
+ *
+ * @param[in] aDefines  Preprocessor defines of the permutation, in any order (empty for the base program)
+ *
+ * @return Program of the permutation if ready, or the base program
+ */
+GLuint ShaderPermutations::get(const Defines& aDefines) {
+    GLuint program = mBaseProgram;
+    if (false == aDefines.empty()) {
+        // Sort and deduplicate the defines, so that a same set always gives the same permutation
+        Defines defines(aDefines);
+        std::sort(defines.begin(), defines.end());
+        defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+        std::string defineLines;
+        for (size_t idxDefine = 0; idxDefine < defines.size(); ++idxDefine) {
+            defineLines += "#define " + defines[idxDefine] + "\n";
+        }
+
+        PermutationIndexMap::const_iterator iIndex = mIndexes.find(defineLines);
+        if (mIndexes.end() == iIndex) {
+            Permutation permutation = {defineLines, "", ePending, 0, 0, 0, Utils::Time::getTickUs()};
+            std::vector<std::string> sources;
+            sources.push_back(mVertexSource);
+            sources.push_back(mFragmentSource);
+            permutation.mKey = mProgramCache.getKey(sources, defineLines);
+            permutation.mProgram = mProgramCache.load(permutation.mKey);
+            if (0 != permutation.mProgram) {
+                permutation.mState = eReady;
+                mLog.info() << "get(" << permutation.mKey << "): loaded from cache in "
+                            << Utils::Time::diff(permutation.mStartUs, Utils::Time::getTickUs()) << "us";
+            } else if (mbParallel) {
+                compile(permutation);
+            }
+            iIndex = mIndexes.insert(std::make_pair(defineLines, mPermutations.size())).first;
+            mPermutations.push_back(permutation);
+        }
+
+        const Permutation& permutation = mPermutations[iIndex->second];
+        if (eReady == permutation.mState) {
+            program = permutation.mProgram;
+        }
+    }
+    return program;
+}
+
+/**
+ * @brief Finish the permutations compiled in the background, or compile a pending one, without waiting
+ *
+ *  To be called once per frame.
+ */
+void ShaderPermutations::update() {
+    bool bCompiled = false; // Without parallel compilation, only one permutation is compiled per frame
+    for (size_t idxPermutation = 0; idxPermutation < mPermutations.size(); ++idxPermutation) {
+        Permutation& permutation = mPermutations[idxPermutation];
+        if ((ePending == permutation.mState) && (false == bCompiled)) {
+            compile(permutation);
+            bCompiled = true;
+        }
+        if (eCompiling == permutation.mState) {
+            GLint bCompleted = GL_TRUE;
+            if (mbParallel) {
+                glGetProgramiv(permutation.mProgram, GL_COMPLETION_STATUS_KHR, &bCompleted);
+            }
+            if (GL_FALSE != bCompleted) {
+                finish(permutation);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Issue the compilation and the link of a permutation
+ *
+ *  With parallel compilation, these calls return at once, the driver compiling and linking in the background.
+ *
+ * @param[in,out] aPermutation  Permutation to compile
+ */
+void ShaderPermutations::compile(Permutation& aPermutation) {
+    aPermutation.mStartUs = Utils::Time::getTickUs();
+
+    const std::string   vertexSource    = inject(mVertexSource, aPermutation.mDefines);
+    const std::string   fragmentSource  = inject(mFragmentSource, aPermutation.mDefines);
+    const char*         pVertexSource   = vertexSource.c_str();
+    const char*         pFragmentSource = fragmentSource.c_str();
+    aPermutation.mVertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(aPermutation.mVertexShader, 1, &pVertexSource, NULL);
+    glCompileShader(aPermutation.mVertexShader);
+    aPermutation.mFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(aPermutation.mFragmentShader, 1, &pFragmentSource, NULL);
+    glCompileShader(aPermutation.mFragmentShader);
+
+    // Link without checking the compilation status, which would wait for the compiler
+    aPermutation.mProgram = glCreateProgram();
+    ProgramCache::setRetrievableHint(aPermutation.mProgram);
+    glAttachShader(aPermutation.mProgram, aPermutation.mVertexShader);
+    glAttachShader(aPermutation.mProgram, aPermutation.mFragmentShader);
+    glLinkProgram(aPermutation.mProgram);
+    aPermutation.mState = eCompiling;
+}
+
+/**
+ * @brief Check the result of the compilation and the link of a permutation, and store it into the cache
+ *
+ * @param[in,out] aPermutation  Permutation compiled and linked
+ */
+void ShaderPermutations::finish(Permutation& aPermutation) {
+    GLint status = GL_FALSE;
+    glGetProgramiv(aPermutation.mProgram, GL_LINK_STATUS, &status);
+    if (GL_FALSE != status) {
+        aPermutation.mState = eReady;
+        mLog.info() << "update(" << aPermutation.mKey << "): compiled and linked in "
+                    << Utils::Time::diff(aPermutation.mStartUs, Utils::Time::getTickUs()) << "us";
+        mProgramCache.store(aPermutation.mKey, aPermutation.mProgram);
+    } else {
+        // The base program is used instead, as if this permutation was not yet ready
+        aPermutation.mState = eFailed;
+        std::string errorMsg = getShaderError(aPermutation.mVertexShader)
+                             + getShaderError(aPermutation.mFragmentShader);
+        if (errorMsg.empty()) {
+            GLint infoLogLength = 0;
+            glGetProgramiv(aPermutation.mProgram, GL_INFO_LOG_LENGTH, &infoLogLength);
+            std::vector<GLchar> infoLog(infoLogLength + 1, '\0');
+            glGetProgramInfoLog(aPermutation.mProgram, infoLogLength, NULL, &infoLog[0]);
+            errorMsg = &infoLog[0];
+        }
+        mLog.error() << "update(" << aPermutation.mKey << "): permutation failed:\n" << aPermutation.mDefines
+                     << errorMsg;
+        glDeleteProgram(aPermutation.mProgram);
+        aPermutation.mProgram = 0;
+    }
+
+    // The intermediate compiled shaders can be detached and deleted (the program contain them)
+    if (0 != aPermutation.mProgram) {
+        glDetachShader(aPermutation.mProgram, aPermutation.mVertexShader);
+        glDetachShader(aPermutation.mProgram, aPermutation.mFragmentShader);
+    }
+    glDeleteShader(aPermutation.mVertexShader);
+    glDeleteShader(aPermutation.mFragmentShader);
+    aPermutation.mVertexShader   = 0;
+    aPermutation.mFragmentShader = 0;
+}
+
+/**
+ * @brief Inject "#define" lines into the source code of a shader, after its "#version" line
+ *
+ * @param[in] aSource   Source code of the shader
+ * @param[in] aDefines  "#define" lines to inject
+ *
+ * @return Source code of the permutation
+ */
+std::string ShaderPermutations::inject(const std::string& aSource, const std::string& aDefines) {
+    std::string source;
+    if (0 == aSource.compare(0, 8, "#version")) {
+        // The "#version" directive must come first: insert after it, and restore the numbering of the next lines
+        const size_t endOfVersion = aSource.find('\n');
+        if (std::string::npos == endOfVersion) {
+            source = aSource + "\n" + aDefines;
+        } else {
+            source = aSource.substr(0, endOfVersion + 1) + aDefines + "#line 2\n" + aSource.substr(endOfVersion + 1);
+        }
+    } else {
+        source = aDefines + "#line 1\n" + aSource;
+    }
+    return source;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file    ShaderPermutations.h
+ * @ingroup Main
+ * @brief   Variants of a program, specialized by preprocessor defines, compiled in the background
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "LoggerCpp/LoggerCpp.h"
+
+#include "Main/ProgramCache.h"
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+
+#include <vector>
+#include <string>
+#include <map>
+#include <ctime>            // time_t
+
+/**
+ * @brief   Variants of a program, specialized by preprocessor defines, compiled in the background
+ * @ingroup Main
+ *
+ *  A permutation is the program of a vertex and a fragment shader with a set of "#define" injected
+ * right after their "#version" line (followed by a "#line" directive so that error messages keep the line
+ * numbers of the files). Sets of defines are sorted and deduplicated, so that requesting the same defines
+ * in a different order gives the same program.
+ *
+ *  The base program (without any define) is compiled synchronously at construction (or loaded from
+ * the ProgramCache), and is served as a fallback while a permutation is not ready, so that requesting
+ * a new variant never stalls a frame:
+ *  - with KHR_parallel_shader_compile (or its ARB equivalent), the driver compiles and links on its own threads,
+ *    and update() only polls their GL_COMPLETION_STATUS,
+ *  - without it, update() compiles and links one pending permutation per frame.
+ * Permutations found in the ProgramCache are ready at once.
+ */
+class ShaderPermutations {
+public:
+    /// Set of preprocessor defines of a permutation ("NAME" or "NAME VALUE")
+    typedef std::vector<std::string> Defines;
+
+public:
+    ShaderPermutations(const char* apVertexShaderFilename, const char* apFragmentShaderFilename);
+    ~ShaderPermutations(); // not virtual because no virtual methods and class not derived
+
+    // Get the program of a permutation, requesting it if needed: the base program until it is ready
+    GLuint get(const Defines& aDefines);
+
+    // Finish the permutations compiled in the background, or compile a pending one, without waiting
+    void update();
+
+    // Getters
+    inline GLuint getBase() const;
+    inline size_t getNbPermutations() const;
+
+private:
+    /**
+     * @brief State of the compilation of a permutation
+     */
+    enum State {
+        ePending,   ///< Waiting to be compiled (without parallel compilation)
+        eCompiling, ///< Compiled and linked by the driver
+        eReady,     ///< Linked successfully
+        eFailed     ///< Failed to compile or link (the base program is used instead)
+    };
+
+    /**
+     * @brief Permutation of the program
+     */
+    struct Permutation {
+        std::string mDefines;           ///< "#define" lines of the permutation
+        std::string mKey;               ///< Key of the permutation in the ProgramCache
+        State       mState;             ///< State of the compilation
+        GLuint      mProgram;           ///< Program object (0 if not created)
+        GLuint      mVertexShader;      ///< Vertex shader object (0 once linked)
+        GLuint      mFragmentShader;    ///< Fragment shader object (0 once linked)
+        time_t      mStartUs;           ///< Time the compilation started, in microseconds
+    };
+
+    /// Index of each permutation in mPermutations, by "#define" lines
+    typedef std::map<std::string, size_t> PermutationIndexMap;
+
+private:
+    // Issue the compilation and the link of a permutation
+    void compile(Permutation& aPermutation);
+    // Check the result of the compilation and the link of a permutation
+    void finish(Permutation& aPermutation);
+
+    // Inject "#define" lines into the source code of a shader, after its "#version" line
+    static std::string inject(const std::string& aSource, const std::string& aDefines);
+
+private:
+    Log::Logger         mLog;               ///< Logger object to output runtime information
+
+    std::string         mVertexSource;      ///< Source code of the vertex shader
+    std::string         mFragmentSource;    ///< Source code of the fragment shader
+    ProgramCache        mProgramCache;      ///< Disk cache of linked program binaries
+
+    GLuint              mBaseProgram;       ///< Program without any define, used as a fallback
+    std::vector<Permutation> mPermutations; ///< Permutations requested
+    PermutationIndexMap mIndexes;           ///< Index of each permutation in mPermutations, by "#define" lines
+    bool                mbParallel;         ///< Tell if the driver compiles in parallel (KHR_parallel_shader_compile)
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(ShaderPermutations);
+};
+
+
+/**
+ * @brief Get the base program, without any define
+ */
+inline GLuint ShaderPermutations::getBase() const {
+    return mBaseProgram;
+}
+
+/**
+ * @brief Get the number of permutations requested (not counting the base program)
+ */
+inline size_t ShaderPermutations::getNbPermutations() const {
+    return mPermutations.size();
+}
@@ -12,11 +12,13 @@
 #include "Main/ShaderProgram.h"
 
 #include "Utils/Exception.h"
+#include "Utils/Measure.h"
 
 #include <fstream>      // NOLINT(readability/streams) for shader files
 #include <sstream>
 
 #include <string>
+#include <vector>
 
 /**
  * @brief Constructor
@@ -31,7 +33,7 @@ ShaderProgram::~ShaderProgram() {
 }
 
 /**
- * @brief Compile and link a typical program composed of a vertex and a fragment shader.
+ * @brief Load from the cache, or compile and link, a typical program composed of a vertex and a fragment shader.
  *
  * @param[in] apVertexShaderFilename    Name of the vertex shader file to compile.
  * @param[in] apFragmentShaderFilename  Name of the fragment shader file to compile.
@@ -41,17 +43,60 @@ ShaderProgram::~ShaderProgram() {
  * @throw a std::exception in case of error (std::runtime_error).
  */
 GLuint ShaderProgram::makeProgram(const char* apVertexShaderFilename, const char* apFragmentShaderFilename) {
-    // Compile the shader files (into intermediate compiled object)
-    mLog.debug() << "makeProgram: compiling shaders...";
-    compileShader(GL_VERTEX_SHADER, apVertexShaderFilename);
-    compileShader(GL_FRAGMENT_SHADER, apFragmentShaderFilename);
-
-    // Link them in a program (into the final executable to send to the GPU)
-    mLog.debug() << "makeProgram: linking program...";
-    GLuint program = linkProgram();
+    Utils::Measure measure;
+    std::vector<std::string> sources;
+    sources.push_back(readShader(apVertexShaderFilename));
+    sources.push_back(readShader(apFragmentShaderFilename));
+
+    // Look first for the binary of the program in the cache
+    const std::string key = mProgramCache.getKey(sources, "");
+    GLuint program = mProgramCache.load(key);
+    if (0 != program) {
+        mLog.info() << "makeProgram(" << apVertexShaderFilename << ", " << apFragmentShaderFilename
+                    << "): loaded from cache in " << measure.diff() << "us";
+    } else {
+        // Compile the shader sources (into intermediate compiled object)
+        mLog.debug() << "makeProgram: compiling shaders...";
+        try {
+            mShaderList.push_back(compileShader(GL_VERTEX_SHADER, sources[0]));
+            mShaderList.push_back(compileShader(GL_FRAGMENT_SHADER, sources[1]));
+        }
+        catch(std::exception& e) {
+            mLog.info() << "makeProgram: \"" << apVertexShaderFilename << "\", \"" << apFragmentShaderFilename
+                        << "\":\n" << e.what();
+            throw;  // rethrow to abort program
+        }
+
+        // Link them in a program (into the final executable to send to the GPU)
+        mLog.debug() << "makeProgram: linking program...";
+        program = linkProgram();
+        mLog.info() << "makeProgram(" << apVertexShaderFilename << ", " << apFragmentShaderFilename
+                    << "): compiled and linked in " << measure.diff() << "us";
+        mProgramCache.store(key, program);
+    }
     return program;
 }
 
+/**
+ * @brief Read the source code of a shader file.
+ *
+ * @param[in] apShaderFilename  Name of the shader file to read.
+ *
+ * @return Source code of the shader.
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+std::string ShaderProgram::readShader(const char* apShaderFilename) const {
+    std::ifstream ifShader(apShaderFilename);
+    if (false == ifShader.is_open()) {
+        mLog.critic() << "readShader: unavailable file \"" << apShaderFilename << "\"";
+        UTILS_THROW("readShader: unavailable file " << apShaderFilename);
+    }
+    std::ostringstream isShader;
+    isShader << ifShader.rdbuf();
+    return isShader.str();
+}
+
 /**
  * @brief Compile a shader of the given type from the content of a file, and add it to the list.
  *
@@ -126,8 +171,9 @@ GLuint ShaderProgram::compileShader(GLenum              aShaderType,
  * @throw a std::exception in case of error (std::runtime_error).
  */
 GLuint ShaderProgram::linkProgram() const {
-    // Create a program, attach shaders to it, and link the program
+    // Create a program, attach shaders to it, and link the program (keeping its binary for the ProgramCache)
     GLuint program = glCreateProgram();
+    ProgramCache::setRetrievableHint(program);
     for (size_t idxShader = 0; idxShader < mShaderList.size(); ++idxShader) {
         glAttachShader(program, mShaderList[idxShader]);
     }
@@ -12,6 +12,7 @@
 
 #include "LoggerCpp/LoggerCpp.h"
 
+#include "Main/ProgramCache.h"
 #include "Utils/Utils.h"
 
 // NOTE: Needs to be included before any other gl/glfw/freeglut header
@@ -24,19 +25,26 @@
 /**
  * @brief   Compile and link shaders into a program object
  * @ingroup Main
+ *
+ *  makeProgram() first looks for the binary of the program in the ProgramCache, and only compiles
+ * and links the shaders if it is not there (storing the new binary), logging the time it took.
+ * The active variables of the program are then introspected by a ProgramInterface.
  */
 class ShaderProgram {
 public:
     ShaderProgram();
     ~ShaderProgram();
 
-    // Compile and link a typical program composed of a vertex and a fragment shader
+    // Load from the cache, or compile and link, a typical program composed of a vertex and a fragment shader
     GLuint  makeProgram(const char* apVertexShaderFilename, const char* apFragmentShaderFilename);
 
     // Compile and link a program with arbitrary shader types
     void    compileShader(const GLenum aShaderType, const char* apShaderFilename);
     GLuint  linkProgram() const;
 
+    // Read the source code of a shader file
+    std::string readShader(const char* apShaderFilename) const;
+
 private:
     GLuint  compileShader(const GLenum aShaderType, const std::string& aShaderSource) const;
 
@@ -44,9 +52,10 @@ private:
     typedef std::vector<GLuint> ShaderList; ///< List of OpenGL compiled shaders
 
 private:
-    Log::Logger mLog;           ///< Logger object to output runtime information
+    Log::Logger     mLog;           ///< Logger object to output runtime information
 
-    ShaderList  mShaderList;    ///< List of OpenGL compiled shaders
+    ShaderList      mShaderList;    ///< List of OpenGL compiled shaders
+    ProgramCache    mProgramCache;  ///< Disk cache of linked program binaries
 
 private:
     /// disallow copy constructor and assignment operator
@@ -0,0 +1,463 @@
+/**
+ * @file    SoftwareOcclusion.cpp
+ * @ingroup Main
+ * @brief   Software occlusion culling: occluders rasterized on the CPU into a small hierarchical depth buffer
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/SoftwareOcclusion.h"
+
+#include <vector>       // std::vector
+#include <algorithm>    // std::min, std::max, std::fill
+#include <functional>   // std::bind
+#include <utility>      // std::swap
+#include <cmath>        // floor, std::abs
+
+// SSE is part of any x86-64 target, and optional on 32 bits x86
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+#define SOFTWARE_OCCLUSION_SSE
+#include <xmmintrin.h>  // SSE intrinsics
+#endif
+
+
+/**
+ * @brief Rasterize a triangle into some rows of a depth buffer, keeping the nearest depth of each pixel covered
+ *
+ *  A pixel is covered when its center is inside the three edges. Columns are processed four at a time,
+ * from a multiple of four: the width of the buffer, a multiple of the tile size, is never overrun.
+ *
+ * @param[in] aEdgeA, aEdgeB, aEdgeC      Coefficients of the edge function opposite to each vertex
+ * @param[in] aDepthA, aDepthB, aDepthC     Coefficients of the depth plane
+ * @param[in] aMinX, aMaxX  First and last columns of the bounding rectangle of the triangle
+ * @param[in,out] apDepths  Depth buffer
+ * @param[in] aWidth        Width of the buffer (a multiple of four)
+ * @param[in] aMinY, aMaxY  First and last rows to rasterize (inside the bounding rectangle of the triangle)
+ */
+static void rasterizeTriangle(const float aEdgeA[3], const float aEdgeB[3], const float aEdgeC[3],
+                              float aDepthA, float aDepthB, float aDepthC, int aMinX, int aMaxX,
+                              float* apDepths, int aWidth, int aMinY, int aMaxY) {
+    const int minX = aMinX & ~3;
+    for (int y = aMinY; y <= aMaxY; ++y) {
+        const float py = static_cast<float>(y) + 0.5f;
+        const float px = static_cast<float>(minX) + 0.5f;
+        float* pRow = apDepths + y * aWidth;
+#ifdef SOFTWARE_OCCLUSION_SSE
+        const __m128 offsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        const __m128 zero = _mm_setzero_ps();
+        __m128 edges[3];
+        __m128 steps[3];
+        for (int idxEdge = 0; idxEdge < 3; ++idxEdge) {
+            const __m128 a = _mm_set1_ps(aEdgeA[idxEdge]);
+            edges[idxEdge] = _mm_add_ps(_mm_mul_ps(a, offsets),
+                                        _mm_set1_ps(aEdgeA[idxEdge] * px + aEdgeB[idxEdge] * py + aEdgeC[idxEdge]));
+            steps[idxEdge] = _mm_set1_ps(aEdgeA[idxEdge] * 4.0f);
+        }
+        __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(aDepthA), offsets),
+                                  _mm_set1_ps(aDepthA * px + aDepthB * py + aDepthC));
+        const __m128 depthStep = _mm_set1_ps(aDepthA * 4.0f);
+        for (int x = minX; x <= aMaxX; x += 4) {
+            const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edges[0], zero), _mm_cmpge_ps(edges[1], zero)),
+                                             _mm_cmpge_ps(edges[2], zero));
+            if (0 != _mm_movemask_ps(inside)) {
+                const __m128 previous = _mm_loadu_ps(pRow + x);
+                const __m128 nearest = _mm_min_ps(previous, depth);
+                _mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+            }
+            edges[0] = _mm_add_ps(edges[0], steps[0]);
+            edges[1] = _mm_add_ps(edges[1], steps[1]);
+            edges[2] = _mm_add_ps(edges[2], steps[2]);
+            depth = _mm_add_ps(depth, depthStep);
+        }
+#else
+        float edges[3];
+        for (int idxEdge = 0; idxEdge < 3; ++idxEdge) {
+            edges[idxEdge] = aEdgeA[idxEdge] * px + aEdgeB[idxEdge] * py + aEdgeC[idxEdge];
+        }
+        float depth = aDepthA * px + aDepthB * py + aDepthC;
+        for (int x = minX; x <= aMaxX; ++x) {
+            if ((0.0f <= edges[0]) && (0.0f <= edges[1]) && (0.0f <= edges[2]) && (depth < pRow[x])) {
+                pRow[x] = depth;
+            }
+            edges[0] += aEdgeA[0];
+            edges[1] += aEdgeA[1];
+            edges[2] += aEdgeA[2];
+            depth += aDepthA;
+        }
+#endif
+    }
+}
+
+
+/**
+ * @brief Constructor (disabled until setResolution())
+ */
+SoftwareOcclusion::SoftwareOcclusion() :
+    mWidth(0),
+    mHeight(0),
+    mBandsPerEye(0),
+    mFrame(0),
+    mNextBand(0),
+    mNbBandsDone(0),
+    mbStopping(false),
+    mSumMs(0.0),
+    mNbFrames(0) {
+}
+
+/**
+ * @brief Destructor: stop the helper threads
+ */
+SoftwareOcclusion::~SoftwareOcclusion() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mbStopping = true;
+    }
+    mCondition.notify_all();
+    for (std::vector<std::thread>::iterator iThread = mThreads.begin(); iThread != mThreads.end(); ++iThread) {
+        iThread->join();
+    }
+}
+
+/**
+ * @brief Set the resolution of the depth buffer of each eye, rounded up to whole tiles (on each reshape)
+ *
+ *  The helper threads are started the first time the software occlusion is enabled.
+ *
+ * @param[in] aWidth    Width in pixels of the buffer of each eye (0 to disable)
+ * @param[in] aHeight   Height in pixels of the buffer of each eye
+ */
+void SoftwareOcclusion::setResolution(unsigned int aWidth, unsigned int aHeight) {
+    const int tileSize = TILE_SIZE;
+    mWidth  = (0 < aWidth) ? ((static_cast<int>(aWidth) + tileSize - 1) / tileSize) * tileSize : 0;
+    mHeight = (0 < aWidth) ? std::max(1, (static_cast<int>(aHeight) + tileSize - 1) / tileSize) * tileSize : 0;
+    const int bandSize = BAND_TILES * TILE_SIZE;
+    mBandsPerEye = static_cast<size_t>((mHeight + bandSize - 1) / bandSize);
+    for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+        mDepths[idxEye].assign(static_cast<size_t>(mWidth * mHeight), 1.0f);
+        mTileDepths[idxEye].assign(static_cast<size_t>((mWidth / tileSize) * (mHeight / tileSize)), 1.0f);
+    }
+
+    if ((0 < mWidth) && mThreads.empty()) {
+        const unsigned int nbThreads = std::min(MAX_THREADS, std::max(1U, std::thread::hardware_concurrency()));
+        for (unsigned int idxThread = 1; idxThread < nbThreads; ++idxThread) {
+            mThreads.push_back(std::thread(std::bind(&SoftwareOcclusion::work, this)));
+        }
+    }
+}
+
+/**
+ * @brief Start a frame, forgetting the occluders of the previous one
+ *
+ * @param[in] aWorldToClipMatrices  "World to Clip" matrix of each eye
+ */
+void SoftwareOcclusion::begin(const glm::mat4 aWorldToClipMatrices[2]) {
+    mMeasure.restart();
+    for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+        mWorldToClipMatrices[idxEye] = aWorldToClipMatrices[idxEye];
+        mTriangles[idxEye].clear();
+    }
+}
+
+/**
+ * @brief Add the triangles of an occluder Mesh, transformed and clipped for each eye
+ *
+ *  Only the full resolution retained in CPU memory is rasterized (see Mesh::retainData()): a Mesh without data
+ * is ignored. Both faces of the triangles are rasterized, occluders being seen from inside as well.
+ *
+ * @param[in] aMesh                 Mesh of an occluder
+ * @param[in] aModelToWorldMatrix   "Model to World" matrix of its Node
+ */
+void SoftwareOcclusion::addOccluder(const Mesh& aMesh, const glm::mat4& aModelToWorldMatrix) {
+    const Mesh::VertexData& vertices = aMesh.getVertexData();
+    const Mesh::IndexData& indices = aMesh.getIndexData();
+    for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+        const glm::mat4 modelToClipMatrix = mWorldToClipMatrices[idxEye] * aModelToWorldMatrix;
+        for (size_t idxIndex = 0; idxIndex + 2 < indices.size(); idxIndex += 3) {
+            glm::vec4 clipVertices[3];
+            for (size_t idxVertex = 0; idxVertex < 3; ++idxVertex) {
+                // (unsigned 16 bits indices, stored as GLshort; positions are the first of the 3 attributes)
+                const size_t index = static_cast<unsigned short>(indices[idxIndex + idxVertex]);
+                clipVertices[idxVertex] = modelToClipMatrix * glm::vec4(vertices[index * 3], 1.0f);
+            }
+            clip(idxEye, clipVertices);
+        }
+    }
+}
+
+/**
+ * @brief Clip a triangle by the near plane (z >= -w), and set up the resulting triangle(s) for an eye
+ *
+ *  Triangles entirely out of a side of the frustum are rejected; the other sides are handled by the clamping
+ * of the bounding rectangle.
+ *
+ * @param[in] aIdxEye       Index of the eye
+ * @param[in] aVertices     Clip coordinates of the vertices of the triangle
+ */
+void SoftwareOcclusion::clip(int aIdxEye, const glm::vec4 aVertices[3]) {
+    for (int axis = 0; axis < 2; ++axis) {
+        if (((aVertices[0][axis] > aVertices[0].w) && (aVertices[1][axis] > aVertices[1].w)
+                                                   && (aVertices[2][axis] > aVertices[2].w))
+         || ((aVertices[0][axis] < -aVertices[0].w) && (aVertices[1][axis] < -aVertices[1].w)
+                                                    && (aVertices[2][axis] < -aVertices[2].w))) {
+            return;
+        }
+    }
+
+    // Sutherland-Hodgman clipping of the triangle by the near plane, giving a polygon of up to 4 vertices
+    glm::vec4 polygon[4];
+    int nbVertices = 0;
+    for (int idxVertex = 0; idxVertex < 3; ++idxVertex) {
+        const glm::vec4& current = aVertices[idxVertex];
+        const glm::vec4& next = aVertices[(idxVertex + 1) % 3];
+        const float currentDistance = current.z + current.w;
+        const float nextDistance = next.z + next.w;
+        if (0.0f <= currentDistance) {
+            polygon[nbVertices] = current;
+            ++nbVertices;
+        }
+        if ((0.0f <= currentDistance) != (0.0f <= nextDistance)) {
+            const float t = currentDistance / (currentDistance - nextDistance);
+            polygon[nbVertices] = current + (next - current) * t;
+            ++nbVertices;
+        }
+    }
+    for (int idxVertex = 2; idxVertex < nbVertices; ++idxVertex) {
+        setup(aIdxEye, polygon[0], polygon[idxVertex - 1], polygon[idxVertex]);
+    }
+}
+
+/**
+ * @brief Set up a triangle for an eye: edge functions and depth plane in the pixel coordinates of its buffer
+ *
+ * @param[in] aIdxEye       Index of the eye
+ * @param[in] aV0, aV1, aV2 Clip coordinates of the vertices, in front of the near plane
+ */
+void SoftwareOcclusion::setup(int aIdxEye, const glm::vec4& aV0, const glm::vec4& aV1, const glm::vec4& aV2) {
+    const glm::vec4* pVertices[3] = {&aV0, &aV1, &aV2};
+    float x[3];
+    float y[3];
+    float z[3];
+    for (int idxVertex = 0; idxVertex < 3; ++idxVertex) {
+        const glm::vec4& vertex = *pVertices[idxVertex];
+        const float invW = 1.0f / std::max(vertex.w, 1e-6f);
+        x[idxVertex] = (vertex.x * invW * 0.5f + 0.5f) * mWidth;
+        y[idxVertex] = (vertex.y * invW * 0.5f + 0.5f) * mHeight;
+        z[idxVertex] = vertex.z * invW * 0.5f + 0.5f;
+    }
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (std::abs(area) < 1e-6f) {
+        return;
+    }
+    if (area < 0.0f) {
+        // Clockwise: swap two vertices, both faces being rasterized
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(z[1], z[2]);
+        area = -area;
+    }
+
+    Triangle triangle;
+    triangle.mMinX = std::max(0, static_cast<int>(floor(std::min(x[0], std::min(x[1], x[2])))));
+    triangle.mMaxX = std::min(mWidth - 1, static_cast<int>(floor(std::max(x[0], std::max(x[1], x[2])))));
+    triangle.mMinY = std::max(0, static_cast<int>(floor(std::min(y[0], std::min(y[1], y[2])))));
+    triangle.mMaxY = std::min(mHeight - 1, static_cast<int>(floor(std::max(y[0], std::max(y[1], y[2])))));
+    if ((triangle.mMinX > triangle.mMaxX) || (triangle.mMinY > triangle.mMaxY)) {
+        return;
+    }
+    // Edge function opposite to vertex i, from vertex a to vertex b: (xb - xa) * (y - ya) - (yb - ya) * (x - xa)
+    const float invArea = 1.0f / area;
+    triangle.mDepthA = 0.0f;
+    triangle.mDepthB = 0.0f;
+    triangle.mDepthC = 0.0f;
+    for (int idxEdge = 0; idxEdge < 3; ++idxEdge) {
+        const int a = (idxEdge + 1) % 3;
+        const int b = (idxEdge + 2) % 3;
+        triangle.mEdgeA[idxEdge] = y[a] - y[b];
+        triangle.mEdgeB[idxEdge] = x[b] - x[a];
+        triangle.mEdgeC[idxEdge] = x[a] * y[b] - x[b] * y[a];
+        // The depth is interpolated by the barycentric coordinates, the edge functions divided by the area
+        triangle.mDepthA += z[idxEdge] * triangle.mEdgeA[idxEdge] * invArea;
+        triangle.mDepthB += z[idxEdge] * triangle.mEdgeB[idxEdge] * invArea;
+        triangle.mDepthC += z[idxEdge] * triangle.mEdgeC[idxEdge] * invArea;
+    }
+    mTriangles[aIdxEye].push_back(triangle);
+}
+
+/**
+ * @brief Rasterize the occluders into the depth buffer of both eyes, and build their hierarchical Z
+ *
+ *  The bands of both eyes are shared between the helper threads and the render thread, which returns
+ * when all of them are done.
+ */
+void SoftwareOcclusion::rasterize() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    ++mFrame;
+    mNextBand = 0;
+    mNbBandsDone = 0;
+    mCondition.notify_all();
+    rasterizeBands(lock);
+    while (mNbBandsDone < 2 * mBandsPerEye) {
+        mDoneCondition.wait(lock);
+    }
+}
+
+/**
+ * @brief Loop of a helper thread: rasterize the bands of each new frame
+ */
+void SoftwareOcclusion::work() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    unsigned int frame = mFrame;
+    while (false == mbStopping) {
+        if (frame == mFrame) {
+            mCondition.wait(lock);
+        } else {
+            frame = mFrame;
+            rasterizeBands(lock);
+        }
+    }
+}
+
+/**
+ * @brief Rasterize the remaining bands of the current frame, one at a time, without holding the lock
+ *
+ * @param[in,out] aLock Lock of mMutex, held when called and when returning
+ */
+void SoftwareOcclusion::rasterizeBands(std::unique_lock<std::mutex>& aLock) {
+    while (mNextBand < 2 * mBandsPerEye) {
+        const size_t band = mNextBand;
+        ++mNextBand;
+        aLock.unlock();
+        rasterizeBand(band);
+        aLock.lock();
+        if (++mNbBandsDone == 2 * mBandsPerEye) {
+            mDoneCondition.notify_one();
+        }
+    }
+}
+
+/**
+ * @brief Clear and rasterize a band of rows of an eye, then build the hierarchical Z of its tiles
+ *
+ * @param[in] aBand Index of the band (bands of the left eye, followed by those of the right eye)
+ */
+void SoftwareOcclusion::rasterizeBand(size_t aBand) {
+    const int idxEye = static_cast<int>(aBand / mBandsPerEye);
+    const int minY = static_cast<int>(aBand % mBandsPerEye) * BAND_TILES * TILE_SIZE;
+    const int maxY = std::min(mHeight, minY + BAND_TILES * TILE_SIZE) - 1;
+    float* pDepths = mDepths[idxEye].data();
+    std::fill(pDepths + minY * mWidth, pDepths + (maxY + 1) * mWidth, 1.0f);
+
+    const std::vector<Triangle>& triangles = mTriangles[idxEye];
+    for (size_t idxTriangle = 0; idxTriangle < triangles.size(); ++idxTriangle) {
+        const Triangle& triangle = triangles[idxTriangle];
+        if ((triangle.mMinY <= maxY) && (triangle.mMaxY >= minY)) {
+            rasterizeTriangle(triangle.mEdgeA, triangle.mEdgeB, triangle.mEdgeC,
+                              triangle.mDepthA, triangle.mDepthB, triangle.mDepthC, triangle.mMinX, triangle.mMaxX,
+                              pDepths, mWidth, std::max(minY, triangle.mMinY), std::min(maxY, triangle.mMaxY));
+        }
+    }
+
+    // Farthest depth of each tile of the band
+    const int nbTilesX = mWidth / TILE_SIZE;
+    for (int tileY = minY / TILE_SIZE; tileY <= maxY / TILE_SIZE; ++tileY) {
+        for (int tileX = 0; tileX < nbTilesX; ++tileX) {
+            float farthest = 0.0f;
+            for (int y = tileY * TILE_SIZE; y < (tileY + 1) * TILE_SIZE; ++y) {
+                const float* pRow = pDepths + y * mWidth + tileX * TILE_SIZE;
+                for (int x = 0; x < TILE_SIZE; ++x) {
+                    farthest = std::max(farthest, pRow[x]);
+                }
+            }
+            mTileDepths[idxEye][tileY * nbTilesX + tileX] = farthest;
+        }
+    }
+}
+
+/**
+ * @brief Test a bounding box against the depth buffer of both eyes
+ *
+ * @param[in] aBoxToWorldMatrix "Box to World" matrix placing the unit cube [-1,1] onto the bounding box
+ *
+ * @return true if the box is hidden in both eyes (behind the occluders, or out of the view)
+ */
+bool SoftwareOcclusion::isOccluded(const glm::mat4& aBoxToWorldMatrix) const {
+    for (int idxEye = 0; idxEye <= 1; ++idxEye) {
+        const glm::mat4 boxToClipMatrix = mWorldToClipMatrices[idxEye] * aBoxToWorldMatrix;
+        float minX = 0.0f;
+        float maxX = 0.0f;
+        float minY = 0.0f;
+        float maxY = 0.0f;
+        float minZ = 0.0f;
+        for (int idxCorner = 0; idxCorner < 8; ++idxCorner) {
+            const glm::vec4 corner = boxToClipMatrix * glm::vec4((idxCorner & 1) ? 1.0f : -1.0f,
+                                                                 (idxCorner & 2) ? 1.0f : -1.0f,
+                                                                 (idxCorner & 4) ? 1.0f : -1.0f, 1.0f);
+            if (corner.z < -corner.w) {
+                // The box crosses the near plane
+                return false;
+            }
+            const float x = (corner.x / corner.w * 0.5f + 0.5f) * mWidth;
+            const float y = (corner.y / corner.w * 0.5f + 0.5f) * mHeight;
+            const float z = corner.z / corner.w * 0.5f + 0.5f;
+            minX = (0 == idxCorner) ? x : std::min(minX, x);
+            maxX = (0 == idxCorner) ? x : std::max(maxX, x);
+            minY = (0 == idxCorner) ? y : std::min(minY, y);
+            maxY = (0 == idxCorner) ? y : std::max(maxY, y);
+            minZ = (0 == idxCorner) ? z : std::min(minZ, z);
+        }
+        const int rectMinX = std::max(0, static_cast<int>(floor(minX)));
+        const int rectMaxX = std::min(mWidth - 1, static_cast<int>(floor(maxX)));
+        const int rectMinY = std::max(0, static_cast<int>(floor(minY)));
+        const int rectMaxY = std::min(mHeight - 1, static_cast<int>(floor(maxY)));
+        // (out of the view of the eye if the rectangle is empty)
+        if ((rectMinX <= rectMaxX) && (rectMinY <= rectMaxY)
+            && (false == isRectOccluded(idxEye, rectMinX, rectMaxX, rectMinY, rectMaxY, minZ))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Tell if all the pixels of a rectangle of an eye are nearer than a depth, tile by tile
+ *
+ * @param[in] aIdxEye       Index of the eye
+ * @param[in] aMinX, aMaxX  First and last columns of the rectangle
+ * @param[in] aMinY, aMaxY  First and last rows of the rectangle
+ * @param[in] aDepth        Nearest depth of the bounding box
+ */
+bool SoftwareOcclusion::isRectOccluded(int aIdxEye, int aMinX, int aMaxX, int aMinY, int aMaxY,
+                                       float aDepth) const {
+    const int nbTilesX = mWidth / TILE_SIZE;
+    const float* pDepths = mDepths[aIdxEye].data();
+    for (int tileY = aMinY / TILE_SIZE; tileY <= aMaxY / TILE_SIZE; ++tileY) {
+        for (int tileX = aMinX / TILE_SIZE; tileX <= aMaxX / TILE_SIZE; ++tileX) {
+            if (mTileDepths[aIdxEye][tileY * nbTilesX + tileX] >= aDepth) {
+                // Some pixels of the tile are not nearer than the box: test those of the rectangle one by one
+                const int minX = std::max(aMinX, tileX * TILE_SIZE);
+                const int maxX = std::min(aMaxX, (tileX + 1) * TILE_SIZE - 1);
+                const int minY = std::max(aMinY, tileY * TILE_SIZE);
+                const int maxY = std::min(aMaxY, (tileY + 1) * TILE_SIZE - 1);
+                for (int y = minY; y <= maxY; ++y) {
+                    for (int x = minX; x <= maxX; ++x) {
+                        if (pDepths[y * mWidth + x] >= aDepth) {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Stop the frame, accumulating its time (rasterization and tests) into the average
+ */
+void SoftwareOcclusion::end() {
+    mSumMs += static_cast<double>(mMeasure.diff()) / 1000.0;
+    ++mNbFrames;
+}
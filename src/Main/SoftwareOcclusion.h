@@ -0,0 +1,186 @@
+/**
+ * @file    SoftwareOcclusion.h
+ * @ingroup Main
+ * @brief   Software occlusion culling: occluders rasterized on the CPU into a small hierarchical depth buffer
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Main/Mesh.h"
+
+#include "Utils/Utils.h"
+#include "Utils/Measure.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>      // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>          // glm::mat4 (GLM_FORCE_RADIANS defined at the project level)
+
+#include <vector>               // std::vector
+#include <thread>               // std::thread
+#include <mutex>                // std::mutex
+#include <condition_variable>   // std::condition_variable
+#include <cstddef>              // size_t
+
+/**
+ * @brief   Software occlusion culling: occluders rasterized on the CPU into a small hierarchical depth buffer
+ * @ingroup Main
+ *
+ *  Unlike the occlusion queries (see OcclusionCuller), the visibility is decided on the CPU for the current frame,
+ * before any draw call, without any latency nor any GPU work: the triangles of a few designated occluders
+ * (like the hull of a cockpit, see SceneManifest) are rasterized each frame into a low resolution depth buffer
+ * of each eye, and the bounding box of each Node is then tested against it.
+ *
+ *  Rasterization: the triangles are transformed and clipped by the near plane once, and the depth buffers of both
+ * eyes are split into bands of rows, rasterized in parallel by a few helper threads along with the render thread.
+ * Each band evaluates the edge functions and the depth plane of the triangles overlapping it, four pixels at
+ * a time with SSE where available (with a scalar fallback), keeping the nearest depth of each pixel.
+ *
+ *  Hierarchical Z: each band then keeps the farthest depth of each of its 8x8 tiles. A bounding box is occluded
+ * in an eye if the nearest depth of its corners is behind the farthest depth of all the tiles its screen rectangle
+ * overlaps, the pixels being tested one by one only in the tiles which do not decide at once.
+ * A box crossing the near plane is always visible, and a box out of the view of both eyes is hidden too.
+ *
+ *  The time spent each frame (rasterization and tests) is averaged until the next call to reset().
+ */
+class SoftwareOcclusion {
+public:
+    SoftwareOcclusion();
+    ~SoftwareOcclusion(); // not virtual because no virtual methods and class not derived
+
+    // Resolution of the depth buffer of each eye (0 width to disable), rounded up to whole tiles
+    void setResolution(unsigned int aWidth, unsigned int aHeight);
+    inline unsigned int getWidth() const;
+    inline unsigned int getHeight() const;
+    inline bool isEnabled() const;
+
+    // Start a frame, with the "World to Clip" matrix of each eye
+    void begin(const glm::mat4 aWorldToClipMatrices[2]);
+    // Add the triangles of an occluder Mesh (retained in CPU memory), placed by its "Model to World" matrix
+    void addOccluder(const Mesh& aMesh, const glm::mat4& aModelToWorldMatrix);
+    // Rasterize the occluders into the depth buffer of both eyes in parallel, and build their hierarchical Z
+    void rasterize();
+    // Test a bounding box (unit cube [-1,1] placed by its "Box to World" matrix) against both eyes
+    bool isOccluded(const glm::mat4& aBoxToWorldMatrix) const;
+    // Stop the frame, measuring its time
+    void end();
+
+    // Average time spent per frame since the last reset(), and triangles rasterized in the last frame
+    inline float  getAverageMs() const;
+    inline size_t getNbTriangles() const;
+    inline void   reset();
+
+private:
+    /// Size in pixels of the square tiles of the hierarchical Z (and alignment of the resolution)
+    static const int TILE_SIZE = 8;
+    /// Number of rows of tiles of a band, the unit of work of the threads
+    static const int BAND_TILES = 2;
+    /// Maximum number of threads rasterizing a frame (including the render thread): the buffers are small
+    static const unsigned int MAX_THREADS = 4;
+
+    /**
+     * @brief Triangle set up for the rasterization, in the pixel coordinates of the buffer of an eye
+     *
+     *  Each edge function (positive inside) and the depth are planes: value = A * x + B * y + C.
+     */
+    struct Triangle {
+        float   mEdgeA[3];  ///< Coefficient A of the edge function opposite to each vertex
+        float   mEdgeB[3];  ///< Coefficient B of the edge function opposite to each vertex
+        float   mEdgeC[3];  ///< Coefficient C of the edge function opposite to each vertex
+        float   mDepthA;    ///< Coefficient A of the depth plane (depth between 0 and 1)
+        float   mDepthB;    ///< Coefficient B of the depth plane
+        float   mDepthC;    ///< Coefficient C of the depth plane
+        int     mMinX;      ///< First column of the bounding rectangle (clamped to the buffer)
+        int     mMaxX;      ///< Last column of the bounding rectangle
+        int     mMinY;      ///< First row of the bounding rectangle
+        int     mMaxY;      ///< Last row of the bounding rectangle
+    };
+
+private:
+    // Clip a triangle by the near plane, and set up the resulting triangle(s) for an eye
+    void clip(int aIdxEye, const glm::vec4 aVertices[3]);
+    // Set up a triangle for an eye, from its clip coordinates in front of the near plane
+    void setup(int aIdxEye, const glm::vec4& aV0, const glm::vec4& aV1, const glm::vec4& aV2);
+    // Clear and rasterize a band of rows, then build the hierarchical Z of its tiles
+    void rasterizeBand(size_t aBand);
+    // Tell if all the pixels of a rectangle of an eye are nearer than a depth
+    bool isRectOccluded(int aIdxEye, int aMinX, int aMaxX, int aMinY, int aMaxY, float aDepth) const;
+
+    // Loop of a helper thread: rasterize the bands of each frame
+    void work();
+    // Rasterize the remaining bands of the current frame (called with the lock held)
+    void rasterizeBands(std::unique_lock<std::mutex>& aLock);
+
+private:
+    int                     mWidth;         ///< Width in pixels of the buffer of each eye (0 if disabled)
+    int                     mHeight;        ///< Height in pixels of the buffer of each eye
+    size_t                  mBandsPerEye;   ///< Number of bands of the buffer of each eye
+    glm::mat4               mWorldToClipMatrices[2];    ///< "World to Clip" matrix of each eye
+    std::vector<Triangle>   mTriangles[2];  ///< Triangles of the occluders of the frame, set up for each eye
+    std::vector<float>      mDepths[2];     ///< Nearest depth of each pixel of each eye (1.0 for the far plane)
+    std::vector<float>      mTileDepths[2]; ///< Farthest depth of each tile of each eye (hierarchical Z)
+
+    std::vector<std::thread>    mThreads;       ///< Helper threads rasterizing the bands
+    std::mutex                  mMutex;         ///< Protect the following work counters, and the stop flag
+    std::condition_variable     mCondition;     ///< Signal a new frame to rasterize, or the stop of the helpers
+    std::condition_variable     mDoneCondition; ///< Signal the last band of a frame rasterized
+    unsigned int                mFrame;         ///< Index of the frame to rasterize (protected by mMutex)
+    size_t                      mNextBand;      ///< Next band to rasterize (protected by mMutex)
+    size_t                      mNbBandsDone;   ///< Number of bands rasterized (protected by mMutex)
+    bool                        mbStopping;     ///< Tell the helpers to exit (protected by mMutex)
+
+    Utils::Measure          mMeasure;       ///< Time of the current frame, since begin()
+    double                  mSumMs;         ///< Sum of the time of the frames since reset(), in milliseconds
+    unsigned int            mNbFrames;      ///< Number of frames measured since reset()
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(SoftwareOcclusion);
+};
+
+
+/**
+ * @brief Get the width in pixels of the depth buffer of each eye (0 if disabled)
+ */
+inline unsigned int SoftwareOcclusion::getWidth() const {
+    return static_cast<unsigned int>(mWidth);
+}
+
+/**
+ * @brief Get the height in pixels of the depth buffer of each eye
+ */
+inline unsigned int SoftwareOcclusion::getHeight() const {
+    return static_cast<unsigned int>(mHeight);
+}
+
+/**
+ * @brief Tell if software occlusion culling is enabled
+ */
+inline bool SoftwareOcclusion::isEnabled() const {
+    return (0 < mWidth);
+}
+
+/**
+ * @brief Get the average time spent per frame (rasterization and tests) since the last reset(), in milliseconds
+ */
+inline float SoftwareOcclusion::getAverageMs() const {
+    return (0 < mNbFrames) ? static_cast<float>(mSumMs / mNbFrames) : 0.0f;
+}
+
+/**
+ * @brief Get the number of occluder triangles rasterized in the last frame (for both eyes, after clipping)
+ */
+inline size_t SoftwareOcclusion::getNbTriangles() const {
+    return mTriangles[0].size() + mTriangles[1].size();
+}
+
+/**
+ * @brief Reset the average time (start a new interval)
+ */
+inline void SoftwareOcclusion::reset() {
+    mSumMs      = 0.0;
+    mNbFrames   = 0;
+}
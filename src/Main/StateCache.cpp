@@ -0,0 +1,386 @@
+/**
+ * @file    StateCache.cpp
+ * @ingroup Main
+ * @brief   Shadow copy of the OpenGL bindings and fixed function states, skipping redundant calls
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/StateCache.h"
+
+#include <cstddef>  // size_t
+
+/// Value of a name or an enum not known (forcing the next call), never given by OpenGL
+static const GLuint _unknown = 0xFFFFFFFF;
+
+/// Buffer binding targets cached (GL_ELEMENT_ARRAY_BUFFER is part of the Vertex Array Object)
+static const GLenum _bufferTargets[] = {
+    GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+    GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_TEXTURE_BUFFER
+};
+static const size_t _nbBufferTargets = sizeof(_bufferTargets) / sizeof(_bufferTargets[0]);
+
+/// Capabilities cached by enable()
+static const GLenum _capabilities[] = {
+    GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_MULTISAMPLE, GL_FRAMEBUFFER_SRGB
+};
+static const size_t _nbCapabilities = sizeof(_capabilities) / sizeof(_capabilities[0]);
+
+/**
+ * @brief Shadow copy of the OpenGL state (_unknown, or -1 for booleans, when not known)
+ */
+struct State {
+    GLuint  mProgram;                           ///< Program in use
+    GLuint  mVertexArray;                       ///< Vertex Array Object bound
+    GLuint  mBuffers[_nbBufferTargets];         ///< Buffer bound to each target of _bufferTargets
+    GLint   mViewport[4];                       ///< Viewport (x, y, width, height), width of -1 if not known
+    int     mCapabilities[_nbCapabilities];     ///< Each capability of _capabilities enabled (1) or disabled (0)
+    GLenum  mBlendFactors[2];                   ///< Source and destination blending factors
+    GLenum  mDepthFunc;                         ///< Depth comparison function
+    int     mDepthMask;                         ///< Depth writes enabled (1) or disabled (0)
+    GLenum  mStencilFunc;                       ///< Stencil comparison function
+    GLint   mStencilRef;                        ///< Stencil reference value
+    GLuint  mStencilMask;                       ///< Stencil mask of the comparison
+    GLenum  mStencilOps[3];                     ///< Stencil actions on stencil fail, depth fail and depth pass
+    int     mColorMask;                         ///< Color writes enabled (1) or disabled (0), for all components
+    GLenum  mCullFace;                          ///< Faces culled
+};
+
+/// Shadow copy of the OpenGL state, all unknown at start
+static State _state = {
+    _unknown, _unknown, {_unknown, _unknown, _unknown, _unknown, _unknown, _unknown, _unknown},
+    {0, 0, -1, 0}, {-1, -1, -1, -1, -1, -1, -1}, {_unknown, _unknown}, _unknown, -1,
+    _unknown, 0, 0, {_unknown, _unknown, _unknown}, -1, _unknown
+};
+/// Number of OpenGL calls issued since the last reset
+static unsigned int _nbIssued = 0;
+/// Number of OpenGL calls elided since the last reset
+static unsigned int _nbElided = 0;
+
+/**
+ * @brief Update a cached value, and count the call as issued or elided
+ *
+ * @return true if the value changed (the OpenGL call has to be issued)
+ */
+template<typename T>
+static bool update(T& aCached, const T aValue) {
+    const bool bChanged = (aCached != aValue);
+    if (bChanged) {
+        aCached = aValue;
+        ++_nbIssued;
+    } else {
+        ++_nbElided;
+    }
+    return bChanged;
+}
+
+/**
+ * @brief Index of a buffer target in _bufferTargets (_nbBufferTargets if not cached)
+ */
+static size_t getBufferIndex(GLenum aTarget) {
+    size_t idxTarget = 0;
+    while ((idxTarget < _nbBufferTargets) && (_bufferTargets[idxTarget] != aTarget)) {
+        ++idxTarget;
+    }
+    return idxTarget;
+}
+
+/**
+ * @brief Index of a capability in _capabilities (_nbCapabilities if not cached)
+ */
+static size_t getCapabilityIndex(GLenum aCapability) {
+    size_t idxCapability = 0;
+    while ((idxCapability < _nbCapabilities) && (_capabilities[idxCapability] != aCapability)) {
+        ++idxCapability;
+    }
+    return idxCapability;
+}
+
+
+/**
+ * @brief Use a program, unless already in use
+ *
+ * @param[in] aProgram  Program to use (0 for none)
+ *
+ * @return true if glUseProgram() was called
+ */
+bool StateCache::useProgram(GLuint aProgram) {
+    const bool bIssued = update(_state.mProgram, aProgram);
+    if (bIssued) {
+        glUseProgram(aProgram);
+    }
+    return bIssued;
+}
+
+/**
+ * @brief Bind a Vertex Array Object, unless already bound
+ *
+ * @param[in] aVertexArray  Vertex Array Object to bind (0 for none)
+ *
+ * @return true if glBindVertexArray() was called
+ */
+bool StateCache::bindVertexArray(GLuint aVertexArray) {
+    const bool bIssued = update(_state.mVertexArray, aVertexArray);
+    if (bIssued) {
+        glBindVertexArray(aVertexArray);
+    }
+    return bIssued;
+}
+
+/**
+ * @brief Bind a buffer to a target, unless already bound (always bound for targets not cached)
+ *
+ * @param[in] aTarget   Binding target (GL_ARRAY_BUFFER...)
+ * @param[in] aBuffer   Buffer to bind (0 for none)
+ *
+ * @return true if glBindBuffer() was called
+ */
+bool StateCache::bindBuffer(GLenum aTarget, GLuint aBuffer) {
+    const size_t idxTarget = getBufferIndex(aTarget);
+    bool bIssued = true;
+    if (idxTarget < _nbBufferTargets) {
+        bIssued = update(_state.mBuffers[idxTarget], aBuffer);
+    } else {
+        ++_nbIssued;
+    }
+    if (bIssued) {
+        glBindBuffer(aTarget, aBuffer);
+    }
+    return bIssued;
+}
+
+/**
+ * @brief Set the viewport, unless unchanged
+ *
+ * @return true if glViewport() was called
+ */
+bool StateCache::viewport(GLint aX, GLint aY, GLsizei aWidth, GLsizei aHeight) {
+    const bool bChanged = (_state.mViewport[0] != aX) || (_state.mViewport[1] != aY)
+                       || (_state.mViewport[2] != aWidth) || (_state.mViewport[3] != aHeight);
+    if (bChanged) {
+        _state.mViewport[0] = aX;
+        _state.mViewport[1] = aY;
+        _state.mViewport[2] = aWidth;
+        _state.mViewport[3] = aHeight;
+        glViewport(aX, aY, aWidth, aHeight);
+        ++_nbIssued;
+    } else {
+        ++_nbElided;
+    }
+    return bChanged;
+}
+
+/**
+ * @brief Enable or disable a capability, unless unchanged (always called for capabilities not cached)
+ *
+ * @param[in] aCapability   Capability (GL_BLEND, GL_DEPTH_TEST...)
+ * @param[in] abEnabled     true to enable, false to disable
+ *
+ * @return true if glEnable() or glDisable() was called
+ */
+bool StateCache::enable(GLenum aCapability, bool abEnabled) {
+    const size_t idxCapability = getCapabilityIndex(aCapability);
+    bool bIssued = true;
+    if (idxCapability < _nbCapabilities) {
+        bIssued = update(_state.mCapabilities[idxCapability], abEnabled ? 1 : 0);
+    } else {
+        ++_nbIssued;
+    }
+    if (bIssued) {
+        if (abEnabled) {
+            glEnable(aCapability);
+        } else {
+            glDisable(aCapability);
+        }
+    }
+    return bIssued;
+}
+
+/**
+ * @brief Set the blending factors, unless unchanged
+ *
+ * @return true if glBlendFunc() was called
+ */
+bool StateCache::blendFunc(GLenum aSrcFactor, GLenum aDstFactor) {
+    const bool bChanged = (_state.mBlendFactors[0] != aSrcFactor) || (_state.mBlendFactors[1] != aDstFactor);
+    if (bChanged) {
+        _state.mBlendFactors[0] = aSrcFactor;
+        _state.mBlendFactors[1] = aDstFactor;
+        glBlendFunc(aSrcFactor, aDstFactor);
+        ++_nbIssued;
+    } else {
+        ++_nbElided;
+    }
+    return bChanged;
+}
+
+/**
+ * @brief Set the depth comparison function, unless unchanged
+ *
+ * @return true if glDepthFunc() was called
+ */
+bool StateCache::depthFunc(GLenum aFunc) {
+    const bool bIssued = update(_state.mDepthFunc, aFunc);
+    if (bIssued) {
+        glDepthFunc(aFunc);
+    }
+    return bIssued;
+}
+
+/**
+ * @brief Enable or disable depth writes, unless unchanged
+ *
+ * @return true if glDepthMask() was called
+ */
+bool StateCache::depthMask(bool abWrite) {
+    const bool bIssued = update(_state.mDepthMask, abWrite ? 1 : 0);
+    if (bIssued) {
+        glDepthMask(abWrite ? GL_TRUE : GL_FALSE);
+    }
+    return bIssued;
+}
+
+/**
+ * @brief Set the stencil comparison function, reference value and mask, unless unchanged
+ *
+ * @return true if glStencilFunc() was called
+ */
+bool StateCache::stencilFunc(GLenum aFunc, GLint aRef, GLuint aMask) {
+    const bool bChanged = (_state.mStencilFunc != aFunc) || (_state.mStencilRef != aRef)
+                       || (_state.mStencilMask != aMask);
+    if (bChanged) {
+        _state.mStencilFunc = aFunc;
+        _state.mStencilRef = aRef;
+        _state.mStencilMask = aMask;
+        glStencilFunc(aFunc, aRef, aMask);
+        ++_nbIssued;
+    } else {
+        ++_nbElided;
+    }
+    return bChanged;
+}
+
+/**
+ * @brief Set the stencil actions, unless unchanged
+ *
+ * @return true if glStencilOp() was called
+ */
+bool StateCache::stencilOp(GLenum aStencilFail, GLenum aDepthFail, GLenum aDepthPass) {
+    const bool bChanged = (_state.mStencilOps[0] != aStencilFail) || (_state.mStencilOps[1] != aDepthFail)
+                       || (_state.mStencilOps[2] != aDepthPass);
+    if (bChanged) {
+        _state.mStencilOps[0] = aStencilFail;
+        _state.mStencilOps[1] = aDepthFail;
+        _state.mStencilOps[2] = aDepthPass;
+        glStencilOp(aStencilFail, aDepthFail, aDepthPass);
+        ++_nbIssued;
+    } else {
+        ++_nbElided;
+    }
+    return bChanged;
+}
+
+/**
+ * @brief Enable or disable the writes of all the color components, unless unchanged
+ *
+ * @return true if glColorMask() was called
+ */
+bool StateCache::colorMask(bool abWrite) {
+    const bool bIssued = update(_state.mColorMask, abWrite ? 1 : 0);
+    if (bIssued) {
+        const GLboolean write = abWrite ? GL_TRUE : GL_FALSE;
+        glColorMask(write, write, write, write);
+    }
+    return bIssued;
+}
+
+/**
+ * @brief Set the faces culled, unless unchanged
+ *
+ * @return true if glCullFace() was called
+ */
+bool StateCache::cullFace(GLenum aMode) {
+    const bool bIssued = update(_state.mCullFace, aMode);
+    if (bIssued) {
+        glCullFace(aMode);
+    }
+    return bIssued;
+}
+
+/**
+ * @brief Delete a buffer, forgetting its bindings (OpenGL unbinds it, and can give its name to a new buffer)
+ *
+ * @param[in,out] aBuffer   Buffer to delete, set to 0
+ */
+void StateCache::deleteBuffer(GLuint& aBuffer) {
+    for (size_t idxTarget = 0; idxTarget < _nbBufferTargets; ++idxTarget) {
+        if (_state.mBuffers[idxTarget] == aBuffer) {
+            _state.mBuffers[idxTarget] = 0;
+        }
+    }
+    glDeleteBuffers(1, &aBuffer);
+    aBuffer = 0;
+}
+
+/**
+ * @brief Delete a Vertex Array Object, forgetting its binding
+ *
+ * @param[in,out] aVertexArray  Vertex Array Object to delete, set to 0
+ */
+void StateCache::deleteVertexArray(GLuint& aVertexArray) {
+    if (_state.mVertexArray == aVertexArray) {
+        _state.mVertexArray = 0;
+    }
+    glDeleteVertexArrays(1, &aVertexArray);
+    aVertexArray = 0;
+}
+
+/**
+ * @brief Forget all the shadow state, so that the next call of each method is issued
+ */
+void StateCache::invalidate() {
+    _state.mProgram = _unknown;
+    _state.mVertexArray = _unknown;
+    for (size_t idxTarget = 0; idxTarget < _nbBufferTargets; ++idxTarget) {
+        _state.mBuffers[idxTarget] = _unknown;
+    }
+    _state.mViewport[2] = -1;
+    for (size_t idxCapability = 0; idxCapability < _nbCapabilities; ++idxCapability) {
+        _state.mCapabilities[idxCapability] = -1;
+    }
+    _state.mBlendFactors[0] = _unknown;
+    _state.mBlendFactors[1] = _unknown;
+    _state.mDepthFunc = _unknown;
+    _state.mDepthMask = -1;
+    _state.mStencilFunc = _unknown;
+    _state.mStencilOps[0] = _unknown;
+    _state.mStencilOps[1] = _unknown;
+    _state.mStencilOps[2] = _unknown;
+    _state.mColorMask = -1;
+    _state.mCullFace = _unknown;
+}
+
+/**
+ * @brief Number of OpenGL calls issued since the last resetCounters()
+ */
+unsigned int StateCache::getNbIssued() {
+    return _nbIssued;
+}
+
+/**
+ * @brief Number of OpenGL calls elided since the last resetCounters()
+ */
+unsigned int StateCache::getNbElided() {
+    return _nbElided;
+}
+
+/**
+ * @brief Reset the counters of OpenGL calls issued and elided
+ */
+void StateCache::resetCounters() {
+    _nbIssued = 0;
+    _nbElided = 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file    StateCache.h
+ * @ingroup Main
+ * @brief   Shadow copy of the OpenGL bindings and fixed function states, skipping redundant calls
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+
+/**
+ * @brief   Shadow copy of the OpenGL bindings and fixed function states, skipping redundant calls
+ * @ingroup Main
+ *
+ *  Keeps the last value given to OpenGL for the program in use, the Vertex Array Object, the buffer
+ * bindings, the viewport and the blend, depth, stencil, color mask, cull and scissor states, and only calls OpenGL
+ * when a value changes: objects are thus left bound after use (no more binding of 0 after each draw call), the next
+ * bind of the same object being elided. Uniform values are filtered the same way by ProgramInterface.
+ *
+ *  There is only one OpenGL context, used by the render thread: the shadow state is static, and all
+ * the code changing these states has to go through this class, or else call invalidate().
+ *  The GL_ELEMENT_ARRAY_BUFFER binding is part of the Vertex Array Object: it is never cached,
+ * and has to be bound after bindVertexArray() of the VAO it belongs to (or of 0 to upload indices).
+ * Buffers and VAOs have to be deleted by deleteBuffer() and deleteVertexArray(), since OpenGL reuses names.
+ *
+ *  Each method returns true if the OpenGL call was issued, and counts the issued and elided calls,
+ * reported in the statistics each frame.
+ */
+class StateCache {
+public:
+    // Bindings
+    static bool useProgram(GLuint aProgram);
+    static bool bindVertexArray(GLuint aVertexArray);
+    static bool bindBuffer(GLenum aTarget, GLuint aBuffer);
+
+    // Fixed function states
+    static bool viewport(GLint aX, GLint aY, GLsizei aWidth, GLsizei aHeight);
+    static bool enable(GLenum aCapability, bool abEnabled);
+    static bool blendFunc(GLenum aSrcFactor, GLenum aDstFactor);
+    static bool depthFunc(GLenum aFunc);
+    static bool depthMask(bool abWrite);
+    static bool stencilFunc(GLenum aFunc, GLint aRef, GLuint aMask);
+    static bool stencilOp(GLenum aStencilFail, GLenum aDepthFail, GLenum aDepthPass);
+    static bool colorMask(bool abWrite);
+    static bool cullFace(GLenum aMode);
+
+    // Delete objects, forgetting their bindings
+    static void deleteBuffer(GLuint& aBuffer);
+    static void deleteVertexArray(GLuint& aVertexArray);
+
+    // Forget all the shadow state (after OpenGL calls made outside of this class)
+    static void invalidate();
+
+    // Counters of OpenGL calls issued and elided since the last resetCounters()
+    static unsigned int getNbIssued();
+    static unsigned int getNbElided();
+    static void resetCounters();
+};
@@ -0,0 +1,198 @@
+/**
+ * @file    UploadRing.cpp
+ * @ingroup Main
+ * @brief   Ring buffer streaming per-frame dynamic data to the GPU
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/UploadRing.h"
+#include "Main/StateCache.h"
+#include "Utils/Exception.h"
+
+#include <GLFW/glfw3.h>     // glfwGetProcAddress
+
+#include <cstring>          // strcmp
+
+// ARB_buffer_storage (core since OpenGL 4.4) is not part of the OpenGL 3.3 API
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT   0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT     0x0080
+#endif
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+/// Prototype of the glBufferStorage() function of ARB_buffer_storage
+typedef void (APIENTRY* BufferStorageProc)(GLenum aTarget, GLsizeiptr aSize, const void* apData, GLbitfield aFlags);
+
+/// Pointer to the glBufferStorage() function, loaded at runtime (nullptr if not supported)
+static BufferStorageProc _glBufferStorage = nullptr;
+
+/**
+ * @brief Tell if ARB_buffer_storage is supported, and load its glBufferStorage() function
+ */
+static bool loadBufferStorage() {
+    if (nullptr == _glBufferStorage) {
+        GLint nbExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &nbExtensions);
+        for (GLint idxExtension = 0; idxExtension < nbExtensions; ++idxExtension) {
+            const char* pExtension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, idxExtension));
+            if ((nullptr != pExtension) && (0 == strcmp(pExtension, "GL_ARB_buffer_storage"))) {
+                _glBufferStorage = reinterpret_cast<BufferStorageProc>(glfwGetProcAddress("glBufferStorage"));
+                break;
+            }
+        }
+    }
+    return (nullptr != _glBufferStorage);
+}
+
+/**
+ * @brief Constructor
+ *
+ * @param[in] aTarget       Target used to bind the buffer (GL_ARRAY_BUFFER, GL_TEXTURE_BUFFER, GL_UNIFORM_BUFFER...)
+ * @param[in] aNbSegments   Number of segments (number of frames in flight)
+ * @param[in] aSegmentSize  Initial size of each segment, in bytes
+ * @param[in] aAlignment    Alignment of each allocation, in bytes (power of two)
+ */
+UploadRing::UploadRing(GLenum aTarget, unsigned int aNbSegments, size_t aSegmentSize, size_t aAlignment) :
+    mLog("UploadRing"),
+    mTarget(aTarget),
+    mNbSegments(aNbSegments),
+    mAlignment(aAlignment),
+    mSegmentSize((aSegmentSize + aAlignment - 1) & ~(aAlignment - 1)),
+    mbPersistent(loadBufferStorage()),
+    mBuffer(0),
+    mpMapped(nullptr),
+    mpSegment(nullptr),
+    mSegmentOffset(0),
+    mAllocated(0),
+    mRequiredSize(0) {
+    create();
+}
+
+/**
+ * @brief Destructor
+ */
+UploadRing::~UploadRing() {
+    destroy();
+}
+
+/**
+ * @brief Create the buffer object and its storage, and map it if persistent
+ */
+void UploadRing::create() {
+    const GLsizeiptr bufferSize = static_cast<GLsizeiptr>(mSegmentSize * mNbSegments);
+
+    glGenBuffers(1, &mBuffer);
+    StateCache::bindBuffer(mTarget, mBuffer);
+    if (mbPersistent) {
+        // Immutable storage, mapped once for all: coherent so that no explicit flush is needed
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        _glBufferStorage(mTarget, bufferSize, nullptr, flags);
+        mpMapped = static_cast<char*>(glMapBufferRange(mTarget, 0, bufferSize, flags));
+        if (nullptr == mpMapped) {
+            UTILS_THROW("UploadRing: persistent mapping of " << bufferSize << " bytes failed");
+        }
+    } else {
+        glBufferData(mTarget, bufferSize, nullptr, GL_STREAM_DRAW);
+    }
+
+    mLog.notice() << mNbSegments << " segments of " << mSegmentSize / 1024 << "KB"
+                  << (mbPersistent ? " (persistent mapping)" : " (unsynchronized mapping)");
+}
+
+/**
+ * @brief Delete the buffer object
+ */
+void UploadRing::destroy() {
+    if (nullptr != mpMapped) {
+        StateCache::bindBuffer(mTarget, mBuffer);
+        glUnmapBuffer(mTarget);
+        mpMapped = nullptr;
+    }
+    StateCache::deleteBuffer(mBuffer);
+}
+
+/**
+ * @brief Grow the segments to a new size, waiting for the GPU to finish using them
+ *
+ *  The content of the buffer is lost, and its name changes: this is to be done before any allocation in a frame.
+ *
+ * @param[in] aSegmentSize  New minimum size of each segment, in bytes
+ */
+void UploadRing::reserve(size_t aSegmentSize) {
+    if (aSegmentSize > mSegmentSize) {
+        // Rare event (scene growing): a full synchronization is acceptable
+        glFinish();
+        destroy();
+        mSegmentSize = (aSegmentSize + mAlignment - 1) & ~(mAlignment - 1);
+        create();
+    }
+}
+
+/**
+ * @brief Start a new frame: map the segment of the given frame slot
+ *
+ *  The fence of the frame previously rendered in the same slot must have been waited for (see FramePacer).
+ *
+ * @param[in] aFrameSlot    Slot of the current frame (between 0 and the number of segments - 1)
+ */
+void UploadRing::beginFrame(unsigned int aFrameSlot) {
+    // Grow the segments if the previous frame did not fit (with some margin)
+    if (mRequiredSize > mSegmentSize) {
+        mLog.warning() << "beginFrame: " << mRequiredSize / 1024 << "KB needed per frame, growing";
+        reserve(mRequiredSize + mRequiredSize / 4);
+    }
+    mRequiredSize = 0;
+
+    mSegmentOffset = (aFrameSlot % mNbSegments) * mSegmentSize;
+    mAllocated = 0;
+    if (mbPersistent) {
+        mpSegment = mpMapped + mSegmentOffset;
+    } else {
+        // No need to synchronize with the GPU (the FramePacer did), nor to preserve the previous content
+        StateCache::bindBuffer(mTarget, mBuffer);
+        mpSegment = static_cast<char*>(glMapBufferRange(mTarget, mSegmentOffset, mSegmentSize,
+                                        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+        if (nullptr == mpSegment) {
+            mLog.error() << "beginFrame: mapping of " << mSegmentSize << " bytes failed";
+        }
+    }
+}
+
+/**
+ * @brief End the upload phase of the frame: unmap the segment, before any draw call using it
+ */
+void UploadRing::endFrame() {
+    mRequiredSize = mAllocated;
+    if ((false == mbPersistent) && (nullptr != mpSegment)) {
+        StateCache::bindBuffer(mTarget, mBuffer);
+        glUnmapBuffer(mTarget);
+    }
+    mpSegment = nullptr;
+}
+
+/**
+ * @brief Sub-allocate data in the segment of the current frame (lock-free, can be called from any thread)
+ *
+ * @param[in]  aSize    Size of the data to allocate, in bytes
+ * @param[out] aOffset  Offset of the allocated data from the start of the buffer, in bytes
+ *
+ * @return Address where to write the data, or nullptr if the segment is full (it will grow at the next frame)
+ */
+void* UploadRing::allocate(size_t aSize, size_t& aOffset) {
+    void* pData = nullptr;
+    const size_t alignedSize = (aSize + mAlignment - 1) & ~(mAlignment - 1);
+    const size_t offset = mAllocated.fetch_add(alignedSize);
+    if ((nullptr != mpSegment) && (offset + alignedSize <= mSegmentSize)) {
+        pData   = mpSegment + offset;
+        aOffset = mSegmentOffset + offset;
+    }
+    return pData;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file    UploadRing.h
+ * @ingroup Main
+ * @brief   Ring buffer streaming per-frame dynamic data to the GPU
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "LoggerCpp/LoggerCpp.h"
+
+#include "Utils/Utils.h"
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+
+#include <atomic>           // std::atomic
+#include <cstddef>          // size_t
+
+/**
+ * @brief   Ring buffer streaming per-frame dynamic data to the GPU
+ * @ingroup Main
+ *
+ *  The buffer is split into one segment per frame in flight (see FramePacer): the segment of a frame slot
+ * is only rewritten when the fence of the frame previously rendered in the same slot has been signaled,
+ * so there is never any implicit synchronization nor any copy by the driver.
+ *
+ *  The buffer is persistently mapped where ARB_buffer_storage is available (write-only coherent mapping,
+ * made once for all), else each segment is mapped with glMapBufferRange(UNSYNCHRONIZED | INVALIDATE_RANGE)
+ * at the beginning of the frame and unmapped at the end of the upload phase, before the draw calls using it.
+ *
+ *  Between beginFrame() and endFrame(), allocate() is lock-free, so data can be written from worker threads.
+ * An allocation failing because the segment is full is remembered, and the buffer is grown at the next frame.
+ */
+class UploadRing {
+public:
+    UploadRing(GLenum aTarget, unsigned int aNbSegments, size_t aSegmentSize, size_t aAlignment);
+    ~UploadRing(); // not virtual because no virtual methods and class not derived
+
+    // Frame boundaries: map the segment of the frame slot, and unmap it before the draw calls
+    void beginFrame(unsigned int aFrameSlot);
+    void endFrame();
+
+    // Sub-allocate data in the segment of the current frame (thread-safe)
+    void* allocate(size_t aSize, size_t& aOffset);
+
+    // Grow the segments to a new size, waiting for the GPU to finish using them
+    void reserve(size_t aSegmentSize);
+
+    // Getters
+    inline GLuint   getBuffer() const;
+    inline size_t   getSegmentSize() const;
+    inline bool     isPersistent() const;
+
+private:
+    // Create the buffer object and its storage
+    void create();
+    // Delete the buffer object
+    void destroy();
+
+private:
+    Log::Logger         mLog;               ///< Logger object to output runtime information
+
+    const GLenum        mTarget;            ///< Target used to bind the buffer (GL_ARRAY_BUFFER, GL_TEXTURE_BUFFER...)
+    const unsigned int  mNbSegments;        ///< Number of segments (number of frames in flight)
+    const size_t        mAlignment;         ///< Alignment of each allocation, in bytes
+    size_t              mSegmentSize;       ///< Size of a segment, in bytes
+    const bool          mbPersistent;       ///< Use a persistently mapped buffer (ARB_buffer_storage)
+
+    GLuint              mBuffer;            ///< OpenGL Buffer Object
+    char*               mpMapped;           ///< Mapped address of the whole buffer (persistent mapping)
+    char*               mpSegment;          ///< Mapped address of the segment of the current frame
+    size_t              mSegmentOffset;     ///< Offset of the segment of the current frame in the buffer
+
+    std::atomic<size_t> mAllocated;         ///< Bytes allocated (or requested) in the segment of the current frame
+    size_t              mRequiredSize;      ///< Greatest size requested in a frame, to grow the segments
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(UploadRing);
+};
+
+
+/**
+ * @brief Get the OpenGL Buffer Object
+ */
+inline GLuint UploadRing::getBuffer() const {
+    return mBuffer;
+}
+
+/**
+ * @brief Get the size of a segment, in bytes
+ */
+inline size_t UploadRing::getSegmentSize() const {
+    return mSegmentSize;
+}
+
+/**
+ * @brief Tell if the buffer is persistently mapped (ARB_buffer_storage)
+ */
+inline bool UploadRing::isPersistent() const {
+    return mbPersistent;
+}
@@ -0,0 +1,335 @@
+/**
+ * @file    VertexAttributes.cpp
+ * @ingroup Main
+ * @brief   Parallel generation of missing vertex attributes: welding of duplicate vertices and smooth normals
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Main/VertexAttributes.h"
+#include "Utils/Measure.h"
+
+#include <vector>
+#include <algorithm>    // std::min, std::max
+#include <functional>   // std::bind, std::ref, std::cref
+#include <cmath>        // floor
+
+/// Default tolerance of the welding, relative to the diagonal of the bounding box of the mesh
+static const float  _weldTolerance  = 1e-6f;
+/// Minimum number of items (vertices or triangles) processed by a thread (smaller meshes are not worth splitting)
+static const size_t _minChunkItems  = 64 * 1024;
+
+/**
+ * @brief Quantized position of a vertex: coordinates of the cell of the spatial hash
+ */
+struct Cell {
+    int mX; ///< Cell along the X axis
+    int mY; ///< Cell along the Y axis
+    int mZ; ///< Cell along the Z axis
+};
+
+/**
+ * @brief Hash of a cell (unsigned arithmetic, wrapping around)
+ */
+static inline size_t hashCell(int aX, int aY, int aZ) {
+    return (static_cast<unsigned int>(aX) * 73856093U) ^ (static_cast<unsigned int>(aY) * 19349663U)
+         ^ (static_cast<unsigned int>(aZ) * 83492791U);
+}
+
+/**
+ * @brief Find a welding candidate of a vertex in a cell of the spatial hash
+ *
+ * @param[in] aRawMesh      Raw mesh being welded
+ * @param[in] aCells        Cell of each vertex
+ * @param[in] aTable        Open addressing hash table (of a power of 2 size) of the vertices kept, by cell
+ * @param[in] aIdxVertex    Vertex to weld
+ * @param[in] aX, aY, aZ    Cell to look into
+ * @param[in] aMaxDistance  Maximum distance of welded vertices
+ *
+ * @return Index of a vertex kept in the cell, close enough and with the same attributes, or -1 if none
+ */
+static int findVertex(const RawMesh& aRawMesh, const std::vector<Cell>& aCells, const std::vector<int>& aTable,
+                      size_t aIdxVertex, int aX, int aY, int aZ, float aMaxDistance) {
+    const bool bColors  = (aRawMesh.mColors.size() == aRawMesh.mPositions.size());
+    const bool bNormals = (aRawMesh.mNormals.size() == aRawMesh.mPositions.size());
+    const size_t mask = aTable.size() - 1;
+    for (size_t slot = hashCell(aX, aY, aZ) & mask; -1 != aTable[slot]; slot = (slot + 1) & mask) {
+        const int idxCandidate = aTable[slot];
+        const Cell& candidateCell = aCells[idxCandidate];
+        const glm::vec3 delta = aRawMesh.mPositions[idxCandidate] - aRawMesh.mPositions[aIdxVertex];
+        if ((aX == candidateCell.mX) && (aY == candidateCell.mY) && (aZ == candidateCell.mZ)
+            && (glm::dot(delta, delta) <= aMaxDistance * aMaxDistance)
+            && ((false == bColors) || (aRawMesh.mColors[idxCandidate] == aRawMesh.mColors[aIdxVertex]))
+            && ((false == bNormals) || (aRawMesh.mNormals[idxCandidate] == aRawMesh.mNormals[aIdxVertex]))) {
+            return idxCandidate;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Number of chunks to process a number of items in parallel: one per thread available, but not too small
+ */
+static size_t getNbChunks(size_t aNbItems) {
+    const size_t nbThreads = NativeLoader::getNbThreads();
+    return std::max(static_cast<size_t>(1), std::min(nbThreads, aNbItems / _minChunkItems));
+}
+
+/**
+ * @brief Quantize the positions of a range of vertices
+ */
+static void quantizeChunk(const std::vector<glm::vec3>& aPositions, const glm::vec3& aMin, float aCellSize,
+                          size_t aNbChunks, size_t aIdxChunk, std::vector<Cell>& aCells) {
+    const size_t end = (aPositions.size() * (aIdxChunk + 1)) / aNbChunks;
+    for (size_t idxVertex = (aPositions.size() * aIdxChunk) / aNbChunks; idxVertex < end; ++idxVertex) {
+        const glm::vec3 coords = (aPositions[idxVertex] - aMin) / aCellSize;
+        aCells[idxVertex].mX = static_cast<int>(floor(coords.x));
+        aCells[idxVertex].mY = static_cast<int>(floor(coords.y));
+        aCells[idxVertex].mZ = static_cast<int>(floor(coords.z));
+    }
+}
+
+/**
+ * @brief Remap the indices of a range of triangles to the welded vertices
+ */
+static void remapChunk(const std::vector<unsigned int>& aRemap, size_t aNbChunks, size_t aIdxChunk,
+                       std::vector<unsigned int>& aIndices) {
+    const size_t nbTriangles = aIndices.size() / 3;
+    const size_t end = ((nbTriangles * (aIdxChunk + 1)) / aNbChunks) * 3;
+    for (size_t idxIndex = ((nbTriangles * aIdxChunk) / aNbChunks) * 3; idxIndex < end; ++idxIndex) {
+        aIndices[idxIndex] = aRemap[aIndices[idxIndex]];
+    }
+}
+
+/**
+ * @brief Compute the (area weighted, non normalized) normals of a range of triangles
+ */
+static void faceNormalsChunk(const RawMesh& aRawMesh, size_t aNbChunks, size_t aIdxChunk,
+                             std::vector<glm::vec3>& aFaceNormals) {
+    const size_t end = (aFaceNormals.size() * (aIdxChunk + 1)) / aNbChunks;
+    for (size_t idxTriangle = (aFaceNormals.size() * aIdxChunk) / aNbChunks; idxTriangle < end; ++idxTriangle) {
+        const glm::vec3& position0 = aRawMesh.mPositions[aRawMesh.mIndices[idxTriangle * 3]];
+        const glm::vec3& position1 = aRawMesh.mPositions[aRawMesh.mIndices[idxTriangle * 3 + 1]];
+        const glm::vec3& position2 = aRawMesh.mPositions[aRawMesh.mIndices[idxTriangle * 3 + 2]];
+        // The length of the cross product is twice the area of the triangle
+        aFaceNormals[idxTriangle] = glm::cross(position1 - position0, position2 - position0);
+    }
+}
+
+/**
+ * @brief Sum and normalize the normals of the triangles of a range of vertices
+ */
+static void vertexNormalsChunk(const std::vector<glm::vec3>& aFaceNormals, const std::vector<unsigned int>& aOffsets,
+                               const std::vector<unsigned int>& aTriangles, size_t aNbChunks, size_t aIdxChunk,
+                               std::vector<glm::vec3>& aNormals) {
+    const size_t end = (aNormals.size() * (aIdxChunk + 1)) / aNbChunks;
+    for (size_t idxVertex = (aNormals.size() * aIdxChunk) / aNbChunks; idxVertex < end; ++idxVertex) {
+        glm::vec3 normal(0.0f, 0.0f, 0.0f);
+        for (unsigned int idxAdjacent = aOffsets[idxVertex]; idxAdjacent < aOffsets[idxVertex + 1]; ++idxAdjacent) {
+            normal += aFaceNormals[aTriangles[idxAdjacent]];
+        }
+        if (0.0f < glm::dot(normal, normal)) {
+            aNormals[idxVertex] = glm::normalize(normal);
+        } else {
+            // NOTE unused or degenerated vertex: use an arbitrary normal
+            aNormals[idxVertex] = glm::vec3(1.0f, 0.0f, 0.0f);
+        }
+    }
+}
+
+
+/**
+ * @brief Constructor
+ */
+VertexAttributes::VertexAttributes() :
+    mLog("VertexAttributes") {
+}
+
+/**
+ * @brief Destructor
+ */
+VertexAttributes::~VertexAttributes() {
+}
+
+/**
+ * @brief Weld duplicate vertices, and then generate smooth normals (logging the time of each step)
+ *
+ * @param[in,out] aRawMesh  Raw mesh without normals, getting welded vertices and new normals
+ */
+void VertexAttributes::generateNormals(RawMesh& aRawMesh) const {
+    const size_t nbVertices = aRawMesh.mPositions.size();
+    Utils::Measure measure;
+    const size_t nbWelded = weld(aRawMesh, _weldTolerance);
+    const time_t weldUs = measure.diff();
+    measure.restart();
+    computeNormals(aRawMesh);
+    const time_t normalsUs = measure.diff();
+    mLog.info() << "generateNormals: " << nbVertices << " vertices (" << nbWelded << " welded in "
+                << weldUs / 1000 << "ms), " << aRawMesh.mIndices.size() / 3 << " triangles, normals in "
+                << normalsUs / 1000 << "ms";
+}
+
+/**
+ * @brief Weld the vertices closer than a tolerance
+ *
+ *  Vertices are quantized into cells of 4 times the tolerance, in parallel. Then, in order, each vertex
+ * looks for a vertex already kept in its cell, and in the neighbor cells closer than the tolerance,
+ * with the same color and normal (if any); if there is none, the vertex is kept.
+ * The kept vertices are compacted in their original order, and triangles collapsed by the welding are removed.
+ *
+ * @param[in,out] aRawMesh              Raw mesh, getting welded vertices
+ * @param[in]     aRelativeTolerance    Maximum distance of welded vertices, relative to the size of the mesh
+ *
+ * @return Number of vertices removed
+ */
+size_t VertexAttributes::weld(RawMesh& aRawMesh, float aRelativeTolerance) {
+    const size_t nbVertices = aRawMesh.mPositions.size();
+    if (0 == nbVertices) {
+        return 0;
+    }
+    const bool bColors  = (aRawMesh.mColors.size() == nbVertices);
+    const bool bNormals = (aRawMesh.mNormals.size() == nbVertices);
+
+    // Quantize the positions into cells of 4 times the tolerance (but not more than 10^7 cells per axis)
+    glm::vec3 min = aRawMesh.mPositions[0];
+    glm::vec3 max = aRawMesh.mPositions[0];
+    for (size_t idxVertex = 1; idxVertex < nbVertices; ++idxVertex) {
+        min = glm::min(min, aRawMesh.mPositions[idxVertex]);
+        max = glm::max(max, aRawMesh.mPositions[idxVertex]);
+    }
+    const float diagonal    = glm::length(max - min);
+    const float maxDistance = aRelativeTolerance * diagonal;
+    float cellSize = std::max(4.0f * maxDistance, diagonal * 1e-7f);
+    if (0.0f >= cellSize) {
+        cellSize = 1.0f;
+    }
+    std::vector<Cell> cells(nbVertices);
+    const size_t nbVertexChunks = getNbChunks(nbVertices);
+    NativeLoader::runChunks(nbVertexChunks, std::bind(quantizeChunk, std::cref(aRawMesh.mPositions), std::cref(min),
+                                                      cellSize, nbVertexChunks, std::placeholders::_1,
+                                                      std::ref(cells)));
+
+    // Open addressing hash table of the kept vertices (by their original index), by cell
+    size_t capacity = 1;
+    while (capacity < 2 * nbVertices) {
+        capacity *= 2;
+    }
+    std::vector<int> table(capacity, -1);
+
+    std::vector<unsigned int>   remap(nbVertices);
+    std::vector<glm::vec3>      positions;
+    std::vector<glm::vec3>      colors;
+    std::vector<glm::vec3>      normals;
+    positions.reserve(nbVertices);
+    for (size_t idxVertex = 0; idxVertex < nbVertices; ++idxVertex) {
+        const Cell& cell = cells[idxVertex];
+        const glm::vec3& position = aRawMesh.mPositions[idxVertex];
+        // Look first into the cell of the vertex (exact duplicates), then into the neighbor cells closer than
+        // the tolerance along each axis (at most 7 of them, but most often none)
+        int idxKept = findVertex(aRawMesh, cells, table, idxVertex, cell.mX, cell.mY, cell.mZ, maxDistance);
+        if ((-1 == idxKept) && (0.0f < maxDistance)) {
+            const glm::vec3 offset = (position - min) / cellSize;
+            const float margin = maxDistance / cellSize;
+            const int firstX = (offset.x - cell.mX < margin) ? -1 : 0;
+            const int lastX  = (cell.mX + 1 - offset.x < margin) ? 1 : 0;
+            const int firstY = (offset.y - cell.mY < margin) ? -1 : 0;
+            const int lastY  = (cell.mY + 1 - offset.y < margin) ? 1 : 0;
+            const int firstZ = (offset.z - cell.mZ < margin) ? -1 : 0;
+            const int lastZ  = (cell.mZ + 1 - offset.z < margin) ? 1 : 0;
+            for (int z = firstZ; (z <= lastZ) && (-1 == idxKept); ++z) {
+                for (int y = firstY; (y <= lastY) && (-1 == idxKept); ++y) {
+                    for (int x = firstX; (x <= lastX) && (-1 == idxKept); ++x) {
+                        if ((0 != x) || (0 != y) || (0 != z)) {
+                            idxKept = findVertex(aRawMesh, cells, table, idxVertex, cell.mX + x, cell.mY + y,
+                                                 cell.mZ + z, maxDistance);
+                        }
+                    }
+                }
+            }
+        }
+        if (-1 != idxKept) {
+            remap[idxVertex] = remap[idxKept];
+        } else {
+            const size_t mask = table.size() - 1;
+            size_t slot = hashCell(cell.mX, cell.mY, cell.mZ) & mask;
+            while (-1 != table[slot]) {
+                slot = (slot + 1) & mask;
+            }
+            table[slot] = static_cast<int>(idxVertex);
+            remap[idxVertex] = static_cast<unsigned int>(positions.size());
+            positions.push_back(position);
+            if (bColors) {
+                colors.push_back(aRawMesh.mColors[idxVertex]);
+            }
+            if (bNormals) {
+                normals.push_back(aRawMesh.mNormals[idxVertex]);
+            }
+        }
+    }
+    const size_t nbWelded = nbVertices - positions.size();
+
+    if (0 < nbWelded) {
+        aRawMesh.mPositions.swap(positions);
+        aRawMesh.mColors.swap(colors);
+        aRawMesh.mNormals.swap(normals);
+
+        const size_t nbTriangleChunks = getNbChunks(aRawMesh.mIndices.size() / 3);
+        NativeLoader::runChunks(nbTriangleChunks, std::bind(remapChunk, std::cref(remap), nbTriangleChunks,
+                                                            std::placeholders::_1, std::ref(aRawMesh.mIndices)));
+        // Remove the triangles collapsed by the welding
+        size_t nbKept = 0;
+        for (size_t idxIndex = 0; idxIndex + 2 < aRawMesh.mIndices.size(); idxIndex += 3) {
+            const unsigned int idx0 = aRawMesh.mIndices[idxIndex];
+            const unsigned int idx1 = aRawMesh.mIndices[idxIndex + 1];
+            const unsigned int idx2 = aRawMesh.mIndices[idxIndex + 2];
+            if ((idx0 != idx1) && (idx1 != idx2) && (idx2 != idx0)) {
+                aRawMesh.mIndices[nbKept]     = idx0;
+                aRawMesh.mIndices[nbKept + 1] = idx1;
+                aRawMesh.mIndices[nbKept + 2] = idx2;
+                nbKept += 3;
+            }
+        }
+        aRawMesh.mIndices.resize(nbKept);
+    }
+    return nbWelded;
+}
+
+/**
+ * @brief Generate smooth normals: each vertex gets the sum of the normals of its triangles, weighted by their area
+ *
+ * @param[in,out] aRawMesh  Raw mesh, getting new normals
+ */
+void VertexAttributes::computeNormals(RawMesh& aRawMesh) {
+    const size_t nbVertices  = aRawMesh.mPositions.size();
+    const size_t nbTriangles = aRawMesh.mIndices.size() / 3;
+
+    // Normal of each triangle, in parallel
+    std::vector<glm::vec3> faceNormals(nbTriangles);
+    const size_t nbTriangleChunks = getNbChunks(nbTriangles);
+    NativeLoader::runChunks(nbTriangleChunks, std::bind(faceNormalsChunk, std::cref(aRawMesh), nbTriangleChunks,
+                                                        std::placeholders::_1, std::ref(faceNormals)));
+
+    // Adjacency table: triangles of vertex N are aTriangles[aOffsets[N]] to aTriangles[aOffsets[N+1]-1]
+    std::vector<unsigned int> offsets(nbVertices + 1, 0);
+    for (size_t idxIndex = 0; idxIndex < nbTriangles * 3; ++idxIndex) {
+        ++offsets[aRawMesh.mIndices[idxIndex] + 1];
+    }
+    for (size_t idxVertex = 0; idxVertex < nbVertices; ++idxVertex) {
+        offsets[idxVertex + 1] += offsets[idxVertex];
+    }
+    std::vector<unsigned int> cursors(offsets.begin(), offsets.end() - 1);
+    std::vector<unsigned int> triangles(nbTriangles * 3);
+    for (size_t idxIndex = 0; idxIndex < nbTriangles * 3; ++idxIndex) {
+        triangles[cursors[aRawMesh.mIndices[idxIndex]]++] = static_cast<unsigned int>(idxIndex / 3);
+    }
+
+    // Normal of each vertex, in parallel
+    aRawMesh.mNormals.resize(nbVertices);
+    const size_t nbVertexChunks = getNbChunks(nbVertices);
+    NativeLoader::runChunks(nbVertexChunks, std::bind(vertexNormalsChunk, std::cref(faceNormals), std::cref(offsets),
+                                                      std::cref(triangles), nbVertexChunks, std::placeholders::_1,
+                                                      std::ref(aRawMesh.mNormals)));
+}
@@ -0,0 +1,56 @@
+/**
+ * @file    VertexAttributes.h
+ * @ingroup Main
+ * @brief   Parallel generation of missing vertex attributes: welding of duplicate vertices and smooth normals
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "LoggerCpp/LoggerCpp.h"
+
+#include "Main/NativeLoader.h"
+#include "Utils/Utils.h"
+
+#include <cstddef>          // size_t
+
+/**
+ * @brief   Parallel generation of missing vertex attributes: welding of duplicate vertices and smooth normals
+ * @ingroup Main
+ *
+ *  Replaces the Assimp "JoinIdenticalVertices" and "GenSmoothNormals" post-processing steps for meshes
+ * without normals (like big PLY scans), which are single threaded.
+ *
+ *  Welding merges the vertices closer than a tolerance relative to the size of the mesh (and of the same color),
+ * using a spatial hash of their quantized positions, so that triangles split by the exporter share vertices again
+ * and get a smooth normal. Then the area-weighted normal of each vertex is the sum of the (non normalized)
+ * cross products of its triangles: face normals are computed in parallel over chunks of triangles,
+ * and summed in parallel over chunks of vertices through a vertex to triangles adjacency table,
+ * so that no two threads write the same vertex. All passes read and write flat arrays.
+ *
+ *  There is no texture coordinates in the vertex data (see Mesh::VertexData), so no tangents are generated.
+ */
+class VertexAttributes {
+public:
+    VertexAttributes();
+    ~VertexAttributes(); // not virtual because no virtual methods and class not derived
+
+    // Weld duplicate vertices, and then generate smooth normals (logging the time of each step)
+    void generateNormals(RawMesh& aRawMesh) const;
+
+    // Weld the vertices closer than a tolerance (relative to the diagonal of the bounding box of the mesh)
+    static size_t weld(RawMesh& aRawMesh, float aRelativeTolerance);
+
+    // Generate smooth (area weighted) normals
+    static void computeNormals(RawMesh& aRawMesh);
+
+private:
+    Log::Logger mLog;   ///< Logger object to output runtime information
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(VertexAttributes);
+};
@@ -0,0 +1,274 @@
+/**
+ * @file    VertexFormat.h
+ * @ingroup Main
+ * @brief   Vertex structures of the Meshes, with their OpenGL attribute layout described at compile time
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+// NOTE: Needs to be included before any other gl/glfw/freeglut header
+#include <glload/gl_3_3.h>  // GLuint, GLenum, and OpenGL 3.3 core function APIs
+#include <glm/glm.hpp>      // glm::vec3 (GLM_FORCE_RADIANS defined at the project level)
+
+#include <vector>           // std::vector
+#include <algorithm>        // std::min, std::max
+#include <cstddef>          // size_t, offsetof
+
+/**
+ * @brief   Vertex structures of the Meshes, with their OpenGL attribute layout described at compile time
+ * @ingroup Main
+ *
+ *  Each vertex structure has a specialization of Layout listing its attributes: for each one, its shader input
+ * stream, its C++ type, and its offset in the structure. The OpenGL format of each C++ type (number of components,
+ * type of the components, normalization) is given by AttribType. So the setup of a Vertex Array Object is
+ * entirely generated by the compiler for each vertex structure: no runtime branch, no padding,
+ * and the stride is the size of the structure.
+ *
+ *  The Meshes are imported into the full floating point format (see Mesh::VertexData), and converted
+ * into a more compact one at upload time if required:
+ *  - PositionColorNormal: 36 bytes, floating point position, color and normal (same layout as Mesh::VertexData)
+ *  - PositionColorNormalPacked: 20 bytes, floating point position, 8 bits color and 10 bits normal
+ *  - Position: 12 bytes, for depth only passes
+ */
+namespace VertexFormat {
+
+/**
+ * @brief Vertex shader input streams fed by the vertex structures
+ */
+enum Attrib {
+    ePosition = 0,  ///< "position" vertex shader attribute
+    eColor,         ///< "diffuseColor" vertex shader attribute
+    eNormal,        ///< "normal" vertex shader attribute
+    eNbAttribs
+};
+
+/// Location of a vertex shader attribute not fed by a vertex structure (like glGetAttribLocation() of a missing one)
+static const GLuint NO_LOCATION = static_cast<GLuint>(-1);
+
+/**
+ * @brief RGBA color of 8 bits normalized components
+ */
+struct ColorUByte4 {
+    GLubyte mRed;   ///< Red component (0 to 255)
+    GLubyte mGreen; ///< Green component (0 to 255)
+    GLubyte mBlue;  ///< Blue component (0 to 255)
+    GLubyte mAlpha; ///< Alpha component (0 to 255)
+};
+
+/**
+ * @brief Normal of 10 bits signed normalized components, packed into 32 bits (GL_INT_2_10_10_10_REV)
+ */
+struct NormalPacked {
+    GLuint  mBits;  ///< X in bits 0 to 9, Y in bits 10 to 19, Z in bits 20 to 29
+};
+
+/**
+ * @brief OpenGL format of the type of an attribute (specialized for each type)
+ */
+template<typename T>
+struct AttribType;
+
+/**
+ * @brief Floating point vector: 3 floats
+ */
+template<>
+struct AttribType<glm::vec3> {
+    static const GLint      SIZE        = 3;            ///< Number of components
+    static const GLenum     TYPE        = GL_FLOAT;     ///< Type of the components
+    static const GLboolean  NORMALIZED  = GL_FALSE;     ///< Tell if integer components are normalized
+};
+
+/**
+ * @brief 8 bits color: 4 unsigned bytes normalized to [0, 1]
+ */
+template<>
+struct AttribType<ColorUByte4> {
+    static const GLint      SIZE        = 4;                    ///< Number of components
+    static const GLenum     TYPE        = GL_UNSIGNED_BYTE;     ///< Type of the components
+    static const GLboolean  NORMALIZED  = GL_TRUE;              ///< Tell if integer components are normalized
+};
+
+/**
+ * @brief 10 bits normal: 4 components (of 10, 10, 10 and 2 bits) normalized to [-1, 1], the last one unused
+ */
+template<>
+struct AttribType<NormalPacked> {
+    static const GLint      SIZE        = 4;                        ///< Number of components
+    static const GLenum     TYPE        = GL_INT_2_10_10_10_REV;    ///< Type of the components
+    static const GLboolean  NORMALIZED  = GL_TRUE;                  ///< Tell if integer components are normalized
+};
+
+/**
+ * @brief Attribute of a vertex structure: shader input stream, C++ type, and offset in the structure
+ */
+template<Attrib ATTRIB, typename T, size_t OFFSET>
+struct Field {
+    /**
+     * @brief Enable the attribute in the currently bound Vertex Array Object, reading the bound vertex buffer
+     *
+     * @param[in] aLocations    Location of each vertex shader attribute (see Attrib), or NO_LOCATION to skip it
+     * @param[in] aStride       Size of the vertex structure
+     */
+    static inline void enable(const GLuint aLocations[eNbAttribs], GLsizei aStride) {
+        if (NO_LOCATION != aLocations[ATTRIB]) {
+            glEnableVertexAttribArray(aLocations[ATTRIB]);
+            glVertexAttribPointer(aLocations[ATTRIB], AttribType<T>::SIZE, AttribType<T>::TYPE,
+                                  AttribType<T>::NORMALIZED, aStride, reinterpret_cast<void*>(OFFSET));
+        }
+    }
+};
+
+/**
+ * @brief Missing attribute of a vertex structure: the shader input stream keeps its constant default value
+ */
+struct NoField {
+    static inline void enable(const GLuint /* aLocations */[eNbAttribs], GLsizei /* aStride */) {
+    }
+};
+
+/**
+ * @brief Attributes of a vertex structure
+ */
+template<typename Vertex, typename Field0, typename Field1 = NoField, typename Field2 = NoField>
+struct Fields {
+    /**
+     * @brief Enable all the attributes in the currently bound Vertex Array Object, reading the bound vertex buffer
+     *
+     * @param[in] aLocations    Location of each vertex shader attribute (see Attrib)
+     */
+    static inline void enable(const GLuint aLocations[eNbAttribs]) {
+        Field0::enable(aLocations, sizeof(Vertex));
+        Field1::enable(aLocations, sizeof(Vertex));
+        Field2::enable(aLocations, sizeof(Vertex));
+    }
+};
+
+/**
+ * @brief Layout of a vertex structure (specialized for each vertex structure)
+ */
+template<typename Vertex>
+struct Layout;
+
+
+/**
+ * @brief Full floating point vertex: 36 bytes, same layout as Mesh::VertexData (3 consecutive glm::vec3)
+ */
+struct PositionColorNormal {
+    glm::vec3   mPosition;  ///< Position in model space
+    glm::vec3   mColor;     ///< Diffuse color
+    glm::vec3   mNormal;    ///< Normal in model space
+
+    /**
+     * @brief Make a vertex from its floating point attributes
+     */
+    static inline PositionColorNormal make(const glm::vec3& aPosition, const glm::vec3& aColor,
+                                           const glm::vec3& aNormal) {
+        PositionColorNormal vertex = {aPosition, aColor, aNormal};
+        return vertex;
+    }
+};
+
+static_assert(sizeof(PositionColorNormal) == 3 * sizeof(glm::vec3), "PositionColorNormal must have no padding");
+
+/// Layout of the full floating point vertex
+template<>
+struct Layout<PositionColorNormal> : Fields<PositionColorNormal,
+    Field<ePosition, glm::vec3, offsetof(PositionColorNormal, mPosition)>,
+    Field<eColor,    glm::vec3, offsetof(PositionColorNormal, mColor)>,
+    Field<eNormal,   glm::vec3, offsetof(PositionColorNormal, mNormal)> > {
+};
+
+/**
+ * @brief Compact vertex: 20 bytes, floating point position, 8 bits color, and 10 bits normal
+ */
+struct PositionColorNormalPacked {
+    glm::vec3       mPosition;  ///< Position in model space
+    ColorUByte4     mColor;     ///< Diffuse color (opaque)
+    NormalPacked    mNormal;    ///< Normal in model space
+
+    /**
+     * @brief Make a vertex from its floating point attributes, quantizing the color and the normal
+     */
+    static inline PositionColorNormalPacked make(const glm::vec3& aPosition, const glm::vec3& aColor,
+                                                 const glm::vec3& aNormal) {
+        PositionColorNormalPacked vertex;
+        vertex.mPosition     = aPosition;
+        vertex.mColor.mRed   = quantizeUnsigned(aColor.x);
+        vertex.mColor.mGreen = quantizeUnsigned(aColor.y);
+        vertex.mColor.mBlue  = quantizeUnsigned(aColor.z);
+        vertex.mColor.mAlpha = 255;
+        vertex.mNormal.mBits = quantizeSigned(aNormal.x) | (quantizeSigned(aNormal.y) << 10)
+                             | (quantizeSigned(aNormal.z) << 20);
+        return vertex;
+    }
+
+    /**
+     * @brief Quantize a value in [0, 1] to 8 bits (rounding to the nearest)
+     */
+    static inline GLubyte quantizeUnsigned(float aValue) {
+        return static_cast<GLubyte>(std::min(std::max(aValue, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+    /**
+     * @brief Quantize a value in [-1, 1] to 10 bits in two's complement (rounding to the nearest)
+     */
+    static inline GLuint quantizeSigned(float aValue) {
+        const float scaled = std::min(std::max(aValue, -1.0f), 1.0f) * 511.0f;
+        const GLint value = static_cast<GLint>((0.0f <= scaled) ? (scaled + 0.5f) : (scaled - 0.5f));
+        return static_cast<GLuint>(value) & 0x3FF;
+    }
+};
+
+static_assert(sizeof(PositionColorNormalPacked) == 20, "PositionColorNormalPacked must have no padding");
+
+/// Layout of the compact vertex
+template<>
+struct Layout<PositionColorNormalPacked> : Fields<PositionColorNormalPacked,
+    Field<ePosition, glm::vec3,    offsetof(PositionColorNormalPacked, mPosition)>,
+    Field<eColor,    ColorUByte4,  offsetof(PositionColorNormalPacked, mColor)>,
+    Field<eNormal,   NormalPacked, offsetof(PositionColorNormalPacked, mNormal)> > {
+};
+
+/**
+ * @brief Position only vertex: 12 bytes, for depth only passes
+ */
+struct Position {
+    glm::vec3   mPosition;  ///< Position in model space
+
+    /**
+     * @brief Make a vertex from its floating point attributes, keeping only the position
+     */
+    static inline Position make(const glm::vec3& aPosition, const glm::vec3& /* aColor */,
+                                const glm::vec3& /* aNormal */) {
+        Position vertex = {aPosition};
+        return vertex;
+    }
+};
+
+/// Layout of the position only vertex
+template<>
+struct Layout<Position> : Fields<Position,
+    Field<ePosition, glm::vec3, offsetof(Position, mPosition)> > {
+};
+
+
+/**
+ * @brief Convert interleaved floating point vertex data (see Mesh::VertexData) into a vertex structure
+ *
+ * @param[in]  aVertexData  Vertex data: position, color, and normal of each vertex
+ * @param[out] aVertices    Vertices in the required format
+ */
+template<typename Vertex>
+inline void convert(const std::vector<glm::vec3>& aVertexData, std::vector<Vertex>& aVertices) {
+    aVertices.resize(aVertexData.size() / 3);
+    for (size_t idxVertex = 0; idxVertex < aVertices.size(); ++idxVertex) {
+        aVertices[idxVertex] = Vertex::make(aVertexData[idxVertex * 3], aVertexData[idxVertex * 3 + 1],
+                                            aVertexData[idxVertex * 3 + 2]);
+    }
+}
+
+} // namespace VertexFormat
@@ -24,7 +24,11 @@ FPS::FPS(float aCalculationInterval) :
     mElapsedTime(0),
     mCalculatedFPS(0.0f),
     mAverageInterFrame(0),
-    mWorstInterFrame(0) {
+    mWorstInterFrame(0),
+    mLastRenderTime(0),
+    mAverageRenderTime(0),
+    mSumRenderTime(0),
+    mNbRenderTime(0) {
 }
 
 /**
@@ -69,6 +73,11 @@ bool FPS::start(double aStartFrameTime) {
         _firstTime = curTime;
         _nbFrames = 0;
         _worstFrame = 0;
+        if (0 < mNbRenderTime) {
+            mAverageRenderTime = static_cast<float>(mSumRenderTime / mNbRenderTime);
+        }
+        mSumRenderTime = 0;
+        mNbRenderTime = 0;
     }
 
     return bNewCalculatedFPS;
@@ -81,6 +90,8 @@ bool FPS::start(double aStartFrameTime) {
  */
 void FPS::end(double aEndRenderTime) {
     mLastRenderTime = static_cast<float>(aEndRenderTime - mStartFrameTime);
+    mSumRenderTime += mLastRenderTime;
+    ++mNbRenderTime;
 }
 
 } // namespace Utils
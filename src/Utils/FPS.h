@@ -37,6 +37,7 @@ public:
     inline float getAverageInterFrame() const;
     inline float getWorstInterFrame()   const;
     inline float getLastRenderTime()    const;
+    inline float getAverageRenderTime() const;
 
 private:
     const float mCalculationInterval;   ///< Configured duration between FPS calculations
@@ -50,6 +51,9 @@ private:
 
     // Render time calculation
     float   mLastRenderTime;            ///< Duration of the last frame rendering
+    float   mAverageRenderTime;         ///< Average frame rendering duration during the last second
+    double  mSumRenderTime;             ///< Sum of the frame rendering durations since the last FPS calculation
+    int     mNbRenderTime;              ///< Number of frame rendering durations since the last FPS calculation
 
 private:
     /// disallow copy constructor and assignment operator
@@ -99,4 +103,11 @@ inline float FPS::getLastRenderTime() const {
     return mLastRenderTime;
 }
 
+/**
+ * @brief Get the average frame rendering duration during the last second
+ */
+inline float FPS::getAverageRenderTime() const {
+    return mAverageRenderTime;
+}
+
 } // namespace Utils
@@ -0,0 +1,106 @@
+/**
+ * @file    MappedFile.cpp
+ * @ingroup Utils
+ * @brief   Read-only memory mapping of a whole file.
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+
+#include "Utils/MappedFile.h"
+#include "Utils/Exception.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>   // mmap, munmap
+#include <sys/stat.h>   // fstat
+#include <fcntl.h>      // open
+#include <unistd.h>     // close
+#endif
+
+#include <string>
+
+namespace Utils {
+
+/**
+ * @brief Open and map the whole file in memory
+ *
+ * @param[in] aFilename Name of the file to map
+ *
+ * @throw a std::exception in case of error (std::runtime_error).
+ */
+MappedFile::MappedFile(const std::string& aFilename) :
+    mpData(""),
+    mSize(0) {
+#ifdef _WIN32
+    mMapping = nullptr;
+    mFile = CreateFileA(aFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (INVALID_HANDLE_VALUE == mFile) {
+        UTILS_THROW("MappedFile: unable to open \"" << aFilename << "\"");
+    }
+    LARGE_INTEGER size;
+    if (FALSE == GetFileSizeEx(mFile, &size)) {
+        CloseHandle(mFile);
+        UTILS_THROW("MappedFile: unable to get the size of \"" << aFilename << "\"");
+    }
+    mSize = static_cast<size_t>(size.QuadPart);
+    if (0 < mSize) {
+        mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* pData = (nullptr != mMapping) ? MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (nullptr == pData) {
+            if (nullptr != mMapping) {
+                CloseHandle(mMapping);
+            }
+            CloseHandle(mFile);
+            UTILS_THROW("MappedFile: unable to map \"" << aFilename << "\"");
+        }
+        mpData = static_cast<const char*>(pData);
+    }
+#else
+    mFile = open(aFilename.c_str(), O_RDONLY);
+    if (0 > mFile) {
+        UTILS_THROW("MappedFile: unable to open \"" << aFilename << "\"");
+    }
+    struct stat status;
+    if (0 != fstat(mFile, &status)) {
+        close(mFile);
+        UTILS_THROW("MappedFile: unable to get the size of \"" << aFilename << "\"");
+    }
+    mSize = static_cast<size_t>(status.st_size);
+    if (0 < mSize) {
+        void* pData = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+        if (MAP_FAILED == pData) {
+            close(mFile);
+            UTILS_THROW("MappedFile: unable to map \"" << aFilename << "\"");
+        }
+        // The whole file is going to be read (by chunks in parallel): start reading it ahead
+        madvise(pData, mSize, MADV_WILLNEED);
+        mpData = static_cast<const char*>(pData);
+    }
+#endif
+}
+
+/**
+ * @brief Unmap and close the file
+ */
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+    if (0 < mSize) {
+        UnmapViewOfFile(mpData);
+        CloseHandle(mMapping);
+    }
+    CloseHandle(mFile);
+#else
+    if (0 < mSize) {
+        munmap(const_cast<char*>(mpData), mSize);
+    }
+    close(mFile);
+#endif
+}
+
+} // namespace Utils
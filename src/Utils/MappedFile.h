@@ -0,0 +1,66 @@
+/**
+ * @file    MappedFile.h
+ * @ingroup Utils
+ * @brief   Read-only memory mapping of a whole file.
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include "Utils/Utils.h"
+
+#include <string>
+#include <cstddef>  // size_t
+
+namespace Utils {
+
+/**
+ * @brief   Read-only memory mapping of a whole file.
+ * @ingroup Utils
+ *
+ *  The content of the file is paged in on demand by the OS, without any copy into an intermediate buffer,
+ * and can be read concurrently by many threads. The file is unmapped and closed by the destructor.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& aFilename);
+    ~MappedFile(); // not virtual because no virtual methods and class not derived
+
+    // Getters
+    inline const char*  getData() const;
+    inline size_t       getSize() const;
+
+private:
+    const char* mpData;     ///< Address of the mapped content of the file
+    size_t      mSize;      ///< Size of the file, in bytes
+#ifdef _WIN32
+    void*       mFile;      ///< Windows HANDLE of the file
+    void*       mMapping;   ///< Windows HANDLE of the file mapping object
+#else
+    int         mFile;      ///< POSIX file descriptor
+#endif
+
+private:
+    /// disallow copy constructor and assignment operator
+    DISALLOW_COPY_AND_ASSIGN(MappedFile);
+};
+
+
+/**
+ * @brief Get the address of the mapped content of the file
+ */
+inline const char* MappedFile::getData() const {
+    return mpData;
+}
+
+/**
+ * @brief Get the size of the file, in bytes
+ */
+inline size_t MappedFile::getSize() const {
+    return mSize;
+}
+
+} // namespace Utils
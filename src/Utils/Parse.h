@@ -0,0 +1,204 @@
+/**
+ * @file    Parse.h
+ * @ingroup Utils
+ * @brief   Fast parsing of numbers from a text buffer, without any allocation nor locale.
+ *
+ * Copyright (c) 2014 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+ *
+ * Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+ * or copy at http://opensource.org/licenses/MIT)
+ */
+#pragma once
+
+#include <cstdint>  // uint64_t, uint32_t
+#include <cstring>  // memcpy, memchr
+#include <cmath>    // pow
+
+namespace Utils {
+
+/**
+ * @brief Tell if a character is a decimal digit
+ */
+inline bool isDigit(char aChar) {
+    return (static_cast<unsigned char>(aChar - '0') < 10);
+}
+
+/**
+ * @brief Skip spaces and tabs (but not end of lines)
+ *
+ * @param[in,out] apCursor  Current position in the buffer
+ * @param[in]     apEnd     End of the buffer
+ */
+inline void skipSpaces(const char*& apCursor, const char* apEnd) {
+    while ((apCursor < apEnd) && ((' ' == *apCursor) || ('\t' == *apCursor))) {
+        ++apCursor;
+    }
+}
+
+/**
+ * @brief Skip the rest of the line, including its end of line
+ *
+ * @param[in,out] apCursor  Current position in the buffer
+ * @param[in]     apEnd     End of the buffer
+ */
+inline void skipLine(const char*& apCursor, const char* apEnd) {
+    const char* pEol = static_cast<const char*>(memchr(apCursor, '\n', apEnd - apCursor));
+    apCursor = (nullptr != pEol) ? (pEol + 1) : apEnd;
+}
+
+/**
+ * @brief Tell if the 8 characters packed in a (little-endian) 64 bits word are all decimal digits
+ *
+ *  SWAR ("SIMD Within A Register"): the 8 characters are tested at once, without any branch.
+ */
+inline bool isEightDigits(uint64_t aChars) {
+    return (0 == (((aChars & 0xF0F0F0F0F0F0F0F0ULL) |
+                   (((aChars + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ^ 0x3333333333333333ULL));
+}
+
+/**
+ * @brief Convert 8 decimal digits packed in a (little-endian) 64 bits word into their value
+ *
+ *  SWAR: pairs of digits, then pairs of pairs are combined with 3 multiplications instead of 8.
+ */
+inline uint32_t parseEightDigits(uint64_t aChars) {
+    aChars -= 0x3030303030303030ULL;
+    aChars = (aChars * 10) + (aChars >> 8);
+    aChars = (((aChars & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+              (((aChars >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return static_cast<uint32_t>(aChars);
+}
+
+/**
+ * @brief Parse a decimal integer, after skipping leading spaces
+ *
+ * @param[in,out] apCursor  Current position in the buffer (after the number on success)
+ * @param[in]     apEnd     End of the buffer
+ * @param[out]    aValue    Value parsed
+ *
+ * @return true if a number has been parsed
+ */
+inline bool parseInt(const char*& apCursor, const char* apEnd, int& aValue) {
+    skipSpaces(apCursor, apEnd);
+    const char* pCursor = apCursor;
+    const bool bNegative = (pCursor < apEnd) && ('-' == *pCursor);
+    if ((pCursor < apEnd) && (('-' == *pCursor) || ('+' == *pCursor))) {
+        ++pCursor;
+    }
+    const char* pDigits = pCursor;
+    int value = 0;
+    while ((pCursor < apEnd) && isDigit(*pCursor)) {
+        value = (value * 10) + (*pCursor - '0');
+        ++pCursor;
+    }
+    const bool bParsed = (pCursor != pDigits);
+    if (bParsed) {
+        aValue = bNegative ? -value : value;
+        apCursor = pCursor;
+    }
+    return bParsed;
+}
+
+/**
+ * @brief Accumulate the decimal digits of a number into a mantissa, 8 at a time when possible
+ *
+ * @param[in,out] apCursor      Current position in the buffer (after the digits)
+ * @param[in]     apEnd         End of the buffer
+ * @param[in,out] aMantissa     Mantissa accumulating the significant digits
+ * @param[in,out] aNbDigits     Number of digits accumulated into the mantissa (at most 19 to fit in 64 bits)
+ *
+ * @return Number of digits not accumulated because the mantissa is full
+ */
+inline int parseDigits(const char*& apCursor, const char* apEnd, uint64_t& aMantissa, int& aNbDigits) {
+    int nbIgnored = 0;
+    // Fast path: 8 digits at a time
+    while ((apCursor + 8 <= apEnd) && (aNbDigits + 8 <= 19)) {
+        uint64_t chars;
+        memcpy(&chars, apCursor, sizeof(chars));
+        if (false == isEightDigits(chars)) {
+            break;
+        }
+        aMantissa = (aMantissa * 100000000ULL) + parseEightDigits(chars);
+        aNbDigits += 8;
+        apCursor += 8;
+    }
+    // Remaining digits, one at a time
+    while ((apCursor < apEnd) && isDigit(*apCursor)) {
+        if (aNbDigits < 19) {
+            aMantissa = (aMantissa * 10) + (*apCursor - '0');
+            // Leading zeros are not significant
+            aNbDigits += (0 != aMantissa) ? 1 : 0;
+        } else {
+            ++nbIgnored;
+        }
+        ++apCursor;
+    }
+    return nbIgnored;
+}
+
+/**
+ * @brief Parse a decimal floating point number ("-1.5", "2", "3.5e-2"...), after skipping leading spaces
+ *
+ *  Up to 19 significant digits are accumulated into a 64 bits integer mantissa, which is then scaled once
+ * by an exact power of ten in double precision, rounding only once more to a float (same result as strtof()
+ * on the usual mesh data, with about 10 times less work).
+ *
+ * @param[in,out] apCursor  Current position in the buffer (after the number on success)
+ * @param[in]     apEnd     End of the buffer
+ * @param[out]    aValue    Value parsed
+ *
+ * @return true if a number has been parsed
+ */
+inline bool parseFloat(const char*& apCursor, const char* apEnd, float& aValue) {
+    /// Exact powers of ten representable by a double
+    static const double _powersOfTen[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    skipSpaces(apCursor, apEnd);
+    const char* pCursor = apCursor;
+    const bool bNegative = (pCursor < apEnd) && ('-' == *pCursor);
+    if ((pCursor < apEnd) && (('-' == *pCursor) || ('+' == *pCursor))) {
+        ++pCursor;
+    }
+
+    uint64_t    mantissa = 0;
+    int         nbDigits = 0;
+    const char* pDigits = pCursor;
+    // Integer part: digits beyond the mantissa capacity scale the number up
+    int exponent = parseDigits(pCursor, apEnd, mantissa, nbDigits);
+    bool bParsed = (pCursor != pDigits);
+    if ((pCursor < apEnd) && ('.' == *pCursor)) {
+        // Fractional part: each digit accumulated into the mantissa (even a leading zero) scales the number down
+        ++pCursor;
+        const char* pFraction = pCursor;
+        const int nbIgnored = parseDigits(pCursor, apEnd, mantissa, nbDigits);
+        exponent -= static_cast<int>(pCursor - pFraction) - nbIgnored;
+        bParsed = bParsed || (pCursor != pFraction);
+    }
+    if (bParsed && (pCursor < apEnd) && (('e' == *pCursor) || ('E' == *pCursor))) {
+        const char* pExponent = pCursor + 1;
+        int explicitExponent = 0;
+        if (parseInt(pExponent, apEnd, explicitExponent)) {
+            exponent += explicitExponent;
+            pCursor = pExponent;
+        }
+    }
+
+    if (bParsed) {
+        double value = static_cast<double>(mantissa);
+        if ((0 <= exponent) && (exponent <= 22)) {
+            value *= _powersOfTen[exponent];
+        } else if ((0 > exponent) && (exponent >= -22)) {
+            value /= _powersOfTen[-exponent];
+        } else if (0 != mantissa) {
+            value *= pow(10.0, exponent);
+        }
+        aValue = static_cast<float>(bNegative ? -value : value);
+        apCursor = pCursor;
+    }
+    return bParsed;
+}
+
+} // namespace Utils